@@ -0,0 +1,432 @@
+/*******************************************************************************
+* Function Name  : main
+* Description    : Benchmark of the drawing and touch primitives
+*                  Prints a table and writes JSON results, one case per line,
+*                  that a later run can be compared against with -b
+* Input          : -H real panel, default is the emulated transport
+*                  -F emulated panel written through the SPI0 FIFO code
+*                  -n repeat each case n times more
+*                  -o JSON results file, default bench.json
+*                  -b baseline JSON to compare with, exit 1 on regression
+*                  -r tolerated regression in percent, default 10
+*                  -i BMP for LCD_PutImage, default test2.bmp
+*                  -t sample the touch panel on the real panel too
+*                  -l label stored in the results
+*                  -w worker threads of the scene case, default 3
+* Output         : None
+* Return         : 0 success, 1 regression or failure
+* Compile/link   : gcc -DLCD_STATS -o bench -lrt bench.c lcd.c lcd_sprite.c lcd_layer.c lcd_ui.c lcd_scene.c lcd_blit.c lcd_textmode.c lcd_trace.c lcd_stats.c lcd_emu.c lcd_spi0.c lcd_bcm2835.c -lbcm2835 -lm -lpthread
+*                  gcc -DLCD_STATS -DLCD_NO_BCM2835 -o bench -lrt bench.c lcd.c lcd_sprite.c lcd_layer.c lcd_ui.c lcd_scene.c lcd_blit.c lcd_textmode.c lcd_trace.c lcd_stats.c lcd_emu.c lcd_spi0.c -lm -lpthread
+* Execute        : ./bench       sudo ./bench -H
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "lcd.h"
+#include "lcd_emu.h"
+#include "lcd_stats.h"
+#include "lcd_sprite.h"
+#include "lcd_layer.h"
+#include "lcd_ui.h"
+#include "lcd_scene.h"
+#include "lcd_blit.h"
+#include "lcd_textmode.h"
+
+#ifndef LCD_STATS
+#error "bench needs the SPI traffic counters, build it with -DLCD_STATS"
+#endif
+
+
+/* Defines */
+#define BENCH_MAX 32
+#define PLOT_POINTS (4 * 2 * MAX_X)   /* 4 channels, 2 pixels thick */
+
+
+/* Types */
+typedef struct
+{
+    const char *name;
+    StatsApi api;               /* top level API whose counters are read */
+    int iterations;
+    unsigned long pixels;       /* pixels drawn or read by one operation */
+    void (*run)(int i);
+} BenchCase;
+
+typedef struct
+{
+    char name[32];
+    int iterations;
+    unsigned long pixels;
+    double seconds;
+    double opsPerS;
+    double pixelsPerS;
+    double bytesPerPixel;
+    double transactionsPerOp;
+    double busSeconds;
+} BenchResult;
+
+
+/* Public declarations */
+static char *ImageFile = "test2.bmp";
+static char TextLine[] = "0123456789 ABCDEFGHIJ abcdefgh";
+static unsigned short ScreenBuf[MAX_X * MAX_Y];
+static unsigned short SpritePixels[32 * 32];
+static Sprite BenchSprite;
+static unsigned short BackPixels[MAX_X * MAX_Y];
+static unsigned short PopupPixels[120 * 80];
+static Layer BenchBack, BenchPopup;
+static Coordinate PlotPoints[PLOT_POINTS];
+static UiWidget BenchRoot, BenchBar;
+static Scene BenchScene;
+static BlitImage BenchAsset = { BackPixels, MAX_X, MAX_Y, 0 };
+static BlitRect BenchThumb = { 30, 40, 180, 240 };
+static TextMode BenchText;
+
+
+static void Run_Clear(int i)       { LCD_Clear(i & 1 ? White : Black); }
+static void Run_Text(int i)        { LCD_Text(0, 16 * (i % 20), TextLine, White, Blue); }
+static void Run_LineH(int i)       { LCD_DrawLine(0, i % MAX_Y, MAX_X - 1, i % MAX_Y, Yellow); }
+static void Run_LineV(int i)       { LCD_DrawLine(i % MAX_X, 0, i % MAX_X, MAX_Y - 1, Cyan); }
+static void Run_LineD(int i)       { LCD_DrawLine(0, 0, MAX_X - 1, MAX_Y - 1, i & 1 ? Red : Green); }
+static void Run_Box(int i)         { LCD_DrawBox(20, 20, 219, 299, White, i & 1 ? Blue : Red); }
+static void Run_Circle(int i)      { LCD_DrawCircle(120, 160, 100, i & 1 ? Magenta : Green); }
+static void Run_CircleFill(int i)  { LCD_DrawCircleFill(120, 160, 100, White, i & 1 ? Blue : Red); }
+static void Run_Points(int i)      { LCD_SetPoints(PlotPoints, PLOT_POINTS, i & 1 ? Green : Yellow); }
+static void Run_FillRect(int i)    { LCD_FillRect(20, 20, 200, 280, i & 1 ? Blue : Red); }
+static void Run_Image(int i)       { LCD_PutImage(70, 110 + (i & 1), ImageFile); }
+static void Run_GetPoint(int i)    { LCD_GetPoint(i % MAX_X, (i / MAX_X) % MAX_Y); }
+static void Run_ReadRect(int i)    { (void)i; LCD_ReadRect(0, 0, MAX_X, MAX_Y, ScreenBuf); }
+static void Run_SpriteMove(int i)  { LCD_SpriteShow(&BenchSprite, 100 + (i & 1) * 3, 140 + (i & 1) * 2); }
+static void Run_Compose(int i)     { (void)i; LCD_LayerDamage(&BenchPopup, 0, 0, 120, 80); LCD_Compose(); }
+static void Run_UiUpdate(int i)    { UI_SetValue(&BenchBar, i & 1 ? 70 : 30); UI_Update(); }
+static void Run_Scene(int i)       { (void)i; LCD_SceneRender(&BenchScene, 0, 0, MAX_X, MAX_Y); }
+static void Run_BlitScaled(int i)  { LCD_BlitScaled(&BenchAsset, 0, &BenchThumb, BLIT_BILINEAR | (i & 1 ? BLIT_FLIP_X : 0)); }
+static void Run_TextCells(int i)   { TM_Print(&BenchText, 20, 10, i & 1 ? "1243" : "1234", Green, Black); TM_Flush(&BenchText); }
+static void Run_Touch(int i)       { (void)i; Read_Ads7846(); }
+
+
+/*******************************************************************************
+* Function Name  : Bench_Now
+* Description    : Monotonic time
+* Input          : None
+* Output         : None
+* Return         : seconds
+* Attention      : None
+*******************************************************************************/
+static double Bench_Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*******************************************************************************
+* Function Name  : Bench_Run
+* Description    : Run one case and collect its figures
+* Input          : - bc: case to run
+*                  - scale: iterations multiplier
+*                  - emulated: 1 if the bus time can be read from the emulation
+* Output         : - res: figures of the case
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Bench_Run(const BenchCase *bc, int scale, int emulated, BenchResult *res)
+{
+    StatsCounter c;
+    unsigned long long bus0 = 0;
+    double t0, total;
+    int i, n = bc->iterations * scale;
+
+    LCD_StatsReset();
+    if (emulated)
+        bus0 = LCD_EmuBusNs();
+    t0 = Bench_Now();
+    for (i = 0; i < n; i++)
+        bc->run(i);
+    res->seconds = Bench_Now() - t0;
+    res->busSeconds = emulated ? (LCD_EmuBusNs() - bus0) / 1e9 : 0;
+    LCD_StatsGet(bc->api, &c);
+
+    strncpy(res->name, bc->name, sizeof(res->name) - 1);
+    res->name[sizeof(res->name) - 1] = 0;
+    res->iterations = n;
+    res->pixels = bc->pixels;
+    total = (double)bc->pixels * n;
+    res->opsPerS = res->seconds > 0 ? n / res->seconds : 0;
+    res->pixelsPerS = res->seconds > 0 ? total / res->seconds : 0;
+    res->bytesPerPixel = total > 0 ? c.bytes / total : 0;
+    res->transactionsPerOp = (double)c.transactions / n;
+}
+
+
+/*******************************************************************************
+* Function Name  : Bench_Write
+* Description    : Write the results as JSON, one case per line
+* Input          : - out: destination stream
+*                  - label: free text identifying the run
+*                  - transport: transport name
+*                  - res, count: results
+* Output         : None
+* Return         : None
+* Attention      : Bench_Compare relies on the one case per line layout
+*******************************************************************************/
+static void Bench_Write(FILE *out, const char *label, const char *transport,
+                        const BenchResult *res, int count)
+{
+    int i;
+
+    fprintf(out, "{\"label\": \"%s\", \"transport\": \"%s\", \"results\": [\n", label, transport);
+    for (i = 0; i < count; i++)
+    {
+        fprintf(out, "  {\"name\": \"%s\", \"iterations\": %d, \"pixels_per_op\": %lu, "
+                "\"seconds\": %.6f, \"ops_per_s\": %.3f, \"pixels_per_s\": %.1f, "
+                "\"bytes_per_pixel\": %.4f, \"transactions_per_op\": %.2f, \"bus_seconds\": %.6f}%s\n",
+                res[i].name, res[i].iterations, res[i].pixels, res[i].seconds,
+                res[i].opsPerS, res[i].pixelsPerS, res[i].bytesPerPixel,
+                res[i].transactionsPerOp, res[i].busSeconds, i + 1 < count ? "," : "");
+    }
+    fprintf(out, "]}\n");
+}
+
+
+/*******************************************************************************
+* Function Name  : Bench_Compare
+* Description    : Compare the results with a baseline written by Bench_Write
+* Input          : - file: baseline JSON
+*                  - res, count: results of this run
+*                  - tolerance: accepted regression in percent
+* Output         : None
+* Return         : number of regressions, -1 if the baseline can't be read
+* Attention      : Speed is compared on the modeled bus time when both runs
+*                  have one, on wall time otherwise
+*******************************************************************************/
+static int Bench_Compare(const char *file, const BenchResult *res, int count, double tolerance)
+{
+    FILE *in;
+    char line[512];
+    BenchResult b;
+    double k = 1 + tolerance / 100, speed, baseSpeed;
+    int i, regressions = 0;
+
+    in = fopen(file, "r");
+    if (!in)
+        return -1;
+    while (fgets(line, sizeof(line), in))
+    {
+        if (sscanf(line, " {\"name\": \"%31[^\"]\", \"iterations\": %d, \"pixels_per_op\": %lu, "
+                   "\"seconds\": %lf, \"ops_per_s\": %lf, \"pixels_per_s\": %lf, "
+                   "\"bytes_per_pixel\": %lf, \"transactions_per_op\": %lf, \"bus_seconds\": %lf",
+                   b.name, &b.iterations, &b.pixels, &b.seconds, &b.opsPerS, &b.pixelsPerS,
+                   &b.bytesPerPixel, &b.transactionsPerOp, &b.busSeconds) != 9)
+            continue;
+        for (i = 0; i < count && strcmp(res[i].name, b.name); i++)
+            ;
+        if (i == count)
+            continue;
+        if (res[i].busSeconds > 0 && b.busSeconds > 0)
+        {
+            speed = res[i].iterations / res[i].busSeconds;
+            baseSpeed = b.iterations / b.busSeconds;
+        }
+        else
+        {
+            speed = res[i].opsPerS;
+            baseSpeed = b.opsPerS;
+        }
+        if (speed * k < baseSpeed)
+        {
+            printf("REGRESSION %-12s ops/s %.1f -> %.1f\n", b.name, baseSpeed, speed);
+            regressions++;
+        }
+        if (res[i].bytesPerPixel > b.bytesPerPixel * k)
+        {
+            printf("REGRESSION %-12s bytes/pixel %.3f -> %.3f\n", b.name, b.bytesPerPixel, res[i].bytesPerPixel);
+            regressions++;
+        }
+        if (res[i].transactionsPerOp > b.transactionsPerOp * k)
+        {
+            printf("REGRESSION %-12s transactions/op %.1f -> %.1f\n", b.name, b.transactionsPerOp, res[i].transactionsPerOp);
+            regressions++;
+        }
+    }
+    fclose(in);
+    return regressions;
+}
+
+
+int main(int argc, char *argv[])
+{
+    const LCD_Transport *transport = &LCD_EmuTransport;
+    const char *outFile = "bench.json", *baseFile = 0, *label = "";
+    double tolerance = 10;
+    int scale = 1, touch = 0, workers = 3, emulated, opt, i, count = 0, regressions = 0;
+    unsigned long imagePixels;
+    BenchResult res[BENCH_MAX];
+    BenchCase cases[BENCH_MAX];
+    FILE *f;
+
+    while ((opt = getopt(argc, argv, "HFn:o:b:r:i:tl:w:")) != -1)
+    {
+        switch (opt)
+        {
+#ifndef LCD_NO_BCM2835
+        case 'H': transport = &LCD_Bcm2835Transport; break;
+#endif
+        case 'F': transport = &LCD_EmuSpi0Transport; break;
+        case 'n': scale = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+        case 'o': outFile = optarg; break;
+        case 'b': baseFile = optarg; break;
+        case 'r': tolerance = atof(optarg); break;
+        case 'i': ImageFile = optarg; break;
+        case 't': touch = 1; break;
+        case 'l': label = optarg; break;
+        case 'w': workers = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-H] [-F] [-n scale] [-o out.json] [-b baseline.json] "
+                    "[-r percent] [-i image.bmp] [-t] [-l label] [-w workers]\n", argv[0]);
+            return 1;
+        }
+    }
+    emulated = transport == &LCD_EmuTransport || transport == &LCD_EmuSpi0Transport;
+
+    f = fopen(ImageFile, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "can't open %s\n", ImageFile);
+        return 1;
+    }
+    imagePixels = getImageInfo(f, 18, 4) * getImageInfo(f, 22, 4);
+    fclose(f);
+
+    if (!LCD_Open(transport)) return 1;
+    LCD_Reset();
+    TP_Init();
+    LCD_Init(PORTRAIT);
+    for (i = 0; i < 32 * 32; i++)
+        SpritePixels[i] = (i % 32 + i / 32) & 8 ? Red : Black;
+    if (!LCD_SpriteCreate(&BenchSprite, SpritePixels, 32, 32, Black)) return 1;
+    /* half transparent popup over the screen read back as a layer */
+    LCD_ReadRect(0, 0, MAX_X, MAX_Y, BackPixels);
+    for (i = 0; i < 120 * 80; i++)
+        PopupPixels[i] = i % 120 < 2 || i / 120 < 2 ? White : Blue;
+    LCD_LayerInit(&BenchBack, BackPixels, MAX_X, MAX_Y);
+    LCD_LayerInit(&BenchPopup, PopupPixels, 120, 80);
+    LCD_LayerMove(&BenchPopup, 60, 120);
+    LCD_LayerSetAlpha(&BenchPopup, 128, 0);
+    LCD_LayerAdd(&BenchBack);
+    LCD_LayerAdd(&BenchPopup);
+    LCD_Compose();
+    /* progress bar of a widget tree */
+    UI_Init(&BenchRoot, Black);
+    UI_ProgressInit(&BenchBar, 20, 150, 200, 14, 0, 100, 50);
+    UI_Add(&BenchRoot, &BenchBar);
+    UI_Update();
+    /* data logger plot */
+    for (i = 0; i < PLOT_POINTS; i++)
+    {
+        PlotPoints[i].x = i / 2 % MAX_X;
+        PlotPoints[i].y = 40 + 80 * (i / (2 * MAX_X)) + i % 2
+                          + (int)(30 * sin(i / 2 % MAX_X * (i / (2 * MAX_X) + 1) * 0.05));
+    }
+    /* dashboard: the plot as lines, gauges, text and the popup */
+    LCD_SceneInit(&BenchScene, Black);
+    for (i = 0; i + 2 < PLOT_POINTS; i += 2)
+        if (PlotPoints[i].x < PlotPoints[i + 2].x)
+            LCD_SceneLine(&BenchScene, PlotPoints[i].x, PlotPoints[i].y,
+                          PlotPoints[i + 2].x, PlotPoints[i + 2].y, i & 4 ? Green : Yellow);
+    for (i = 0; i < 4; i++)
+        LCD_SceneCircleFill(&BenchScene, 30 + 60 * i, 250, 25, White, i & 1 ? Blue : Red);
+    for (i = 0; i < 20; i += 4)
+        LCD_SceneText(&BenchScene, 0, 16 * i, TextLine, White, Blue);
+    LCD_SceneImage(&BenchScene, 60, 120, 120, 80, PopupPixels);
+    LCD_SceneWorkers(workers);
+    /* status table in text mode, a counter changes 2 digits */
+    TM_Init(&BenchText, 0, 0, White, Black);
+    for (i = 0; i < TM_ROWS; i++)
+        TM_Print(&BenchText, 0, i, TextLine, White, i & 1 ? Blue : Black);
+    TM_Flush(&BenchText);
+
+#define BENCH_CASE(n, a, it, px, fn) \
+    do { cases[count].name = n; cases[count].api = a; cases[count].iterations = it; \
+         cases[count].pixels = px; cases[count].run = fn; count++; } while (0)
+    BENCH_CASE("clear",       STATS_LCD_CLEAR,          2,    MAX_X * MAX_Y,   Run_Clear);
+    BENCH_CASE("text",        STATS_LCD_TEXT,           20,   30 * 8 * 16,     Run_Text);
+    BENCH_CASE("line_h",      STATS_LCD_DRAWLINE,       100,  MAX_X,           Run_LineH);
+    BENCH_CASE("line_v",      STATS_LCD_DRAWLINE,       100,  MAX_Y,           Run_LineV);
+    BENCH_CASE("line_d",      STATS_LCD_DRAWLINE,       100,  MAX_Y,           Run_LineD);
+    BENCH_CASE("box",         STATS_LCD_DRAWBOX,        2,    200 * 280,       Run_Box);
+    BENCH_CASE("circle",      STATS_LCD_DRAWCIRCLE,     20,   628,             Run_Circle);
+    BENCH_CASE("circle_fill", STATS_LCD_DRAWCIRCLEFILL, 2,    31416,           Run_CircleFill);
+    BENCH_CASE("points",      STATS_LCD_SETPOINTS,      20,   PLOT_POINTS,     Run_Points);
+    BENCH_CASE("fill_rect",   STATS_LCD_FILLRECT,       2,    200 * 280,       Run_FillRect);
+    BENCH_CASE("image",       STATS_LCD_PUTIMAGE,       3,    imagePixels,     Run_Image);
+    BENCH_CASE("get_point",   STATS_LCD_GETPOINT,       1000, 1,               Run_GetPoint);
+    BENCH_CASE("read_rect",   STATS_LCD_READRECT,       2,    MAX_X * MAX_Y,   Run_ReadRect);
+    BENCH_CASE("sprite_move", STATS_LCD_SPRITEMOVE,     100,  32 * 32,         Run_SpriteMove);
+    BENCH_CASE("compose",     STATS_LCD_COMPOSE,        20,   120 * 80,        Run_Compose);
+    BENCH_CASE("ui_update",   STATS_UI_UPDATE,          100,  200 * 14,        Run_UiUpdate);
+    BENCH_CASE("scene",       STATS_LCD_SCENERENDER,    5,    MAX_X * MAX_Y,   Run_Scene);
+    BENCH_CASE("blit_scaled", STATS_LCD_BLITSCALED,     5,    180 * 240,       Run_BlitScaled);
+    BENCH_CASE("text_cells",  STATS_TM_FLUSH,           100,  2 * 8 * 16,      Run_TextCells);
+    if (emulated || touch)
+    {
+        if (emulated)
+            LCD_EmuTouch(120, 160, 1);
+        BENCH_CASE("touch",   STATS_READ_ADS7846,       100,  0,               Run_Touch);
+    }
+#undef BENCH_CASE
+
+    for (i = 0; i < count; i++)
+        Bench_Run(&cases[i], scale, emulated, &res[i]);
+
+    if (emulated)
+        LCD_EmuTouch(0, 0, 0);
+    LCD_SpriteFree(&BenchSprite);
+    LCD_SceneWorkers(0);
+    LCD_SceneFree(&BenchScene);
+    IRQ_Clear();
+    LCD_Close();
+
+    printf("%-12s %6s %12s %12s %10s %10s %10s\n",
+           "case", "iter", "pixels/s", "bus px/s", "bytes/px", "xfers/op", "ms/op");
+    for (i = 0; i < count; i++)
+    {
+        printf("%-12s %6d %12.0f %12.0f %10.3f %10.1f %10.3f\n",
+               res[i].name, res[i].iterations, res[i].pixelsPerS,
+               res[i].busSeconds > 0 ? res[i].pixels * res[i].iterations / res[i].busSeconds : 0,
+               res[i].bytesPerPixel, res[i].transactionsPerOp,
+               res[i].seconds * 1000 / res[i].iterations);
+    }
+
+    f = fopen(outFile, "w");
+    if (!f)
+    {
+        fprintf(stderr, "can't write %s\n", outFile);
+        return 1;
+    }
+    Bench_Write(f, label, transport->name, res, count);
+    fclose(f);
+
+    if (baseFile)
+    {
+        regressions = Bench_Compare(baseFile, res, count, tolerance);
+        if (regressions < 0)
+        {
+            fprintf(stderr, "can't read %s\n", baseFile);
+            return 1;
+        }
+        printf("%d regression(s) against %s\n", regressions, baseFile);
+    }
+    return regressions ? 1 : 0;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
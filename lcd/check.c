@@ -0,0 +1,3341 @@
+/*******************************************************************************
+* Function Name  : main
+* Description    : Regression checks on the emulated panel
+*                  Each case draws the same picture two ways, one of them the
+*                  plain drawing functions, and compares the GRAM pixel by
+*                  pixel
+* Input          : names of the cases to run, default all of them
+*                  -l list the cases
+*                  -v print every difference, default the first one per case
+* Output         : None
+* Return         : 0 all cases pass, 1 a difference or failure
+* Compile/link   : gcc -DLCD_NO_BCM2835 -o check -lrt check.c lcd.c lcd_scene.c lcd_blit.c lcd_sprite.c lcd_layer.c lcd_video.c lcd_gesture.c lcd_ingest.c lcd_textmode.c lcd_ui.c lcd_trace.c lcd_emu.c lcd_spi0.c -lm -lpthread
+* Execute        : ./check       ./check scene_workers blit_scaled
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "lcd.h"
+#include "lcd_emu.h"
+#include "lcd_scene.h"
+#include "lcd_blit.h"
+#include "lcd_sprite.h"
+#include "lcd_layer.h"
+#include "lcd_video.h"
+#include "lcd_gesture.h"
+#include "lcd_ingest.h"
+#include "lcd_textmode.h"
+#include "lcd_ui.h"
+#include "lcd_spi0.h"
+#include "AsciiLib.h"
+
+
+/* Defines */
+#define SCENE_FRAMES 20             /* renders per worker count */
+#define DEVICES 4                   /* panels drawn by a thread each */
+#define SHARED_ROUNDS 200           /* drawings of each thread on one panel */
+#define SHADOW_OPS 600              /* operations of the shadow case */
+#define CLIP_ROUNDS 80              /* clip stacks of the clip case, per orientation */
+#define CLIP_PUSHES 3               /* deepest stack of the clip case */
+#define CLIP_OPS 8                  /* primitives drawn in a stack */
+#define CLIP_STACK 8                /* CLIP_DEPTH of lcd.c */
+#define UI_SMALL 10                 /* buttons of the ui case in one grid cell */
+#define UI_POISON 0x1234            /* screen color before a UI_Update */
+#define READ_RECTS 40               /* rectangles read back per orientation */
+#define POINTS_ROUNDS 12            /* point sets of the points case, per orientation */
+#define POINTS_MAX 1500             /* largest point set */
+#define SPI0_ROUNDS 6               /* drawings of the spi0 case, per orientation */
+#define SPI0_TRANSFER_MAX 5000      /* longest transfer sent to the SPI0 stand-in */
+#define SPRITE_SIZE 16              /* sprite of the shared sprite case */
+#define VIDEO_W 100                 /* animation of the shared video case */
+#define VIDEO_H 120
+#define VIDEO_FRAMES 40
+#define BLIT_W 97                   /* source image of the blit case */
+#define BLIT_H 71
+#define BLIT_STRIDE 128             /* pixels from one line to the next */
+#define BLEND_ROUNDS 60             /* compositions of the layer blend case */
+#define BLEND_W 203                 /* largest blended layer */
+#define BLEND_H 37
+#define GESTURE_STEPS 8             /* samples and ticks of a gesture script */
+#define GESTURE_TICK 2              /* GestureStep pen: GS_Tick, no sample */
+#define INGEST_ROUNDS 200           /* rectangles of the ingest case */
+#define BMP_FILE_MAX 8192           /* BMP written by Check_Bmp */
+#define BMP_COLORS_MAX 16           /* colors of the palette images */
+#define ORIENTATIONS_TOP 8          /* first orientations, origin upper left */
+#define ORIENTATIONS (int)(sizeof(Orientations) / sizeof(Orientations[0]))
+
+
+/* Types */
+typedef struct
+{
+    const char *name;
+    int (*run)(void);               /* returns the number of differences */
+} CheckCase;
+
+typedef struct
+{
+    unsigned char pen;              /* 1 down, 0 up, GESTURE_TICK */
+    short x, y;
+    unsigned long tUs;              /* from the start of the script, 0 ends it */
+} GestureStep;
+
+typedef struct
+{
+    const char *name;
+    unsigned char exclusive;        /* GS_Init */
+    GestureStep steps[GESTURE_STEPS];
+    const char *events;             /* Gesture_Record letters, '.' after a tick */
+} GestureScript;
+
+/* BMP format written by Check_Bmp */
+typedef struct
+{
+    const char *name;
+    unsigned char bpp;              /* 1, 4, 8, 16, 24 or 32 */
+    unsigned char header;           /* 12 OS/2, 40 or 108 bytes */
+    unsigned char bitfields;        /* 1: the masks below, 0: the default ones */
+    unsigned long mask[3];          /* red, green, blue in a 16 or 32 bits pixel */
+} BmpCheck;
+
+/* Clip and viewport of the clip case, as LCD_PushClip should make them */
+typedef struct
+{
+    int x0, y0, x1, y1;             /* screen coordinates, x1, y1 excluded */
+    int ox, oy;                     /* origin of the viewport */
+} ClipModel;
+
+/* Panel limits of the dividers case and what LCD_TuneDividers should find */
+typedef struct
+{
+    unsigned long writeHz, readHz;  /* LCD_EmuSpiLimit */
+    unsigned short writeFastest, readFastest;
+    unsigned short write, read;     /* set, one step slower */
+} TuneCheck;
+
+/* Screen rectangle of the ui case, x1, y1 excluded */
+typedef struct
+{
+    int x0, y0, x1, y1;
+} UiArea;
+
+/* LCD bus traffic seen by Count_Transport */
+typedef struct
+{
+    unsigned char cs;               /* slave selected */
+    unsigned char index;            /* last index written */
+    unsigned long windows;          /* index 0x22 written: GRAM writes begin */
+    unsigned long bursts;           /* transfers of GRAM data */
+    unsigned long pixels;           /* words of GRAM data */
+} BusCount;
+
+typedef struct
+{
+    unsigned short *out;            /* decoded values */
+    unsigned int done, n;           /* values decoded, room in out */
+} IngestCheck;
+
+
+/* Public declarations */
+static int Verbose;
+static unsigned short Expected[MAX_X * MAX_Y];
+static unsigned short DeviceExpected[DEVICES][MAX_X * MAX_Y];
+static LCD_Device *Devices[DEVICES];
+static LCD_Device *Shared;
+static unsigned short BlitSource[BLIT_H * BLIT_STRIDE];
+static unsigned short BlitScreen[MAX_X * MAX_Y];
+static unsigned char BmpFile[BMP_FILE_MAX];
+static unsigned short ReadScreen[MAX_X * MAX_Y];
+static unsigned short ReadBack[MAX_X * MAX_Y];
+static char Spi0Sent[SPI0_TRANSFER_MAX], Spi0Got[SPI0_TRANSFER_MAX];
+static unsigned int Spi0GotLen, Spi0Transfers;
+static Coordinate Points[POINTS_MAX];
+static UiWidget UiRoot, UiTitle, UiOk, UiCancel, UiPanel, UiSlider, UiProgress, UiList, UiEdge;
+static UiWidget UiSmall[UI_SMALL];
+static const char * const UiItems[] = { "zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine" };
+static char UiEvents[32];
+static unsigned short PointColors[POINTS_MAX];
+static LCD_Transport CountTransport;
+static BusCount Count;
+static TextMode Text, TextFull;
+
+/* Formats of the bmp case, the 24 bits one also for the landscape case */
+static const BmpCheck BmpFormats[] =
+{
+    { "24 bits",                24, 40, 0, { 0 } },
+    { "1 bit",                  1, 40, 0, { 0 } },
+    { "4 bits",                 4, 40, 0, { 0 } },
+    { "8 bits",                 8, 40, 0, { 0 } },
+    { "8 bits OS/2",            8, 12, 0, { 0 } },
+    { "16 bits 555",            16, 40, 0, { 0 } },
+    { "16 bits 565",            16, 40, 1, { 0xF800, 0x07E0, 0x001F } },
+    { "16 bits 444",            16, 40, 1, { 0x0F00, 0x00F0, 0x000F } },
+    { "32 bits",                32, 40, 0, { 0 } },
+    { "32 bits RGBX",           32, 40, 1, { 0x0000FF, 0x00FF00, 0xFF0000 } },
+    { "32 bits 10 bits, V4",    32, 108, 1, { 0x3FF00000, 0x000FFC00, 0x000003FF } },
+};
+
+/* LCD_Init values of the cases, LANDSCAPE the layout of the first driver */
+static const unsigned char Orientations[] =
+{
+    LANDSCAPE_TOP, PORTRAIT_FLIP, LANDSCAPE_FLIP, PORTRAIT,
+    LANDSCAPE_TOP | LCD_MIRROR, PORTRAIT_FLIP | LCD_MIRROR, LANDSCAPE_FLIP | LCD_MIRROR, PORTRAIT | LCD_MIRROR,
+    LANDSCAPE, LANDSCAPE | LCD_MIRROR,
+};
+
+
+/*******************************************************************************
+* Function Name  : Check_Rand
+* Description    : Pseudo random numbers of a fixed sequence, the same on
+*                  every C library
+* Input          : - seed: state
+* Output         : - seed: next state
+* Return         : 0 to 32767
+* Attention      : None
+*******************************************************************************/
+static unsigned int Check_Rand(unsigned int *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 16 & 0x7FFF;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_Gram
+* Description    : Compare the GRAM with the expected pixels
+* Input          : - name: case and step, for the report
+*                  - expected: MAX_X * MAX_Y pixels in GRAM order
+* Output         : None
+* Return         : number of pixels that differ
+* Attention      : None
+*******************************************************************************/
+static int Check_Gram(const char *name, const unsigned short *expected)
+{
+    const unsigned short *gram = LCD_EmuGram();
+    int i, diff = 0;
+
+    for (i = 0; i < MAX_X * MAX_Y; i++)
+    {
+        if (gram[i] != expected[i])
+        {
+            if (!diff || Verbose)
+                printf("  %s: GRAM %d,%d is %04X, expected %04X\n",
+                       name, i % MAX_X, i / MAX_X, gram[i], expected[i]);
+            diff++;
+        }
+    }
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Scene_Random
+* Description    : Random display list over the screen, and the same drawn
+*                  straight on the panel
+* Input          : - scene: empty display list
+*                  - seed: picture
+*                  - image: 40x30 pixels for the image commands
+* Output         : - scene: commands
+* Return         : None
+* Attention      : Partly off screen lines, circles and fills test the
+*                  clipping at the tile edges
+*******************************************************************************/
+static void Scene_Random(Scene *scene, unsigned int seed, const unsigned short *image)
+{
+    int w = LCD_GetWidth(), h = LCD_GetHeight();
+    int k, x, y, x2, y2, cw, ch, r, cx, cy;
+    unsigned short c, c2;
+
+    for (k = 0; k < 200; k++)
+    {
+        x = Check_Rand(&seed) % (w + 40) - 20;
+        y = Check_Rand(&seed) % (h + 40) - 20;
+        x2 = Check_Rand(&seed) % (w + 40) - 20;
+        y2 = Check_Rand(&seed) % (h + 40) - 20;
+        cw = Check_Rand(&seed) % 80 + 1;
+        ch = Check_Rand(&seed) % 80 + 1;
+        c = Check_Rand(&seed) << 1 ^ Check_Rand(&seed);
+        c2 = Check_Rand(&seed) << 1 ^ Check_Rand(&seed);
+        r = Check_Rand(&seed) % 40;
+        cx = r + Check_Rand(&seed) % (w - 2 * r);
+        cy = r + Check_Rand(&seed) % (h - 2 * r);
+        switch (Check_Rand(&seed) % 6)
+        {
+        case 0:
+            if (x >= 0 && y >= 0)
+            {
+                LCD_FillRect(x, y, cw, ch, c);
+                LCD_SceneFill(scene, x, y, cw, ch, c);
+            }
+            break;
+        case 1:
+            if (Check_Rand(&seed) % 2)
+                y2 = y;
+            else
+                x2 = x;
+            /* fall through, horizontal or vertical */
+        case 2:
+            LCD_DrawLine(x, y, x2, y2, c);
+            LCD_SceneLine(scene, x, y, x2, y2, c);
+            break;
+        case 3:
+            LCD_DrawCircle(cx, cy, r, c);
+            LCD_SceneCircle(scene, cx, cy, r, c);
+            break;
+        case 4:
+            LCD_DrawCircleFill(cx, cy, r, c, c2);
+            LCD_SceneCircleFill(scene, cx, cy, r, c, c2);
+            break;
+        default:
+            if (x >= 0 && y >= 0 && x < w - 48 && y < h - 16)
+            {
+                LCD_Text(x, y, "Hi 42!", c, c2);
+                LCD_SceneText(scene, x, y, "Hi 42!", c, c2);
+            }
+            else if (x >= 0 && y >= 0 && x < w - 40 && y < h - 30)
+            {
+                LCD_SetWindow(x, y, 40, 30);
+                LCD_WritePixels(image, 40 * 30);
+                LCD_SceneImage(scene, x, y, 40, 30, image);
+            }
+            break;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_SceneWorkers
+* Description    : A display list rendered by 0 to SCENE_WORKERS_MAX workers
+*                  gives the same GRAM as the plain drawing functions, frame
+*                  after frame, in every orientation
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : Many frames with many workers: a tile sent before it was
+*                  rendered, or twice, shows as a difference. Not LANDSCAPE,
+*                  whose text is turned by LCD_Text only
+*******************************************************************************/
+static int Check_SceneWorkers(void)
+{
+    unsigned short image[40 * 30];
+    char name[64];
+    unsigned int seed = 1;
+    int k, orientation, workers, frame, diff = 0;
+    Scene scene;
+
+    for (frame = 0; frame < 40 * 30; frame++)
+        image[frame] = Check_Rand(&seed) << 1 ^ Check_Rand(&seed);
+    LCD_SceneInit(&scene, 0x1234);
+    for (k = 0; k < ORIENTATIONS_TOP; k++)
+    {
+        orientation = Orientations[k];
+        LCD_Init(orientation);
+        LCD_SceneReset(&scene);
+        LCD_Clear(0x1234);
+        Scene_Random(&scene, orientation * 77 + 1, image);
+        memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+        for (workers = 0; workers <= SCENE_WORKERS_MAX; workers++)
+        {
+            LCD_SceneWorkers(workers);
+            for (frame = 0; frame < (workers ? SCENE_FRAMES : 1); frame++)
+            {
+                LCD_Clear(frame & 1 ? Black : White);
+                LCD_SceneRender(&scene, 0, 0, LCD_GetWidth(), LCD_GetHeight());
+                sprintf(name, "orientation %d, %d workers, frame %d", orientation, workers, frame);
+                diff += Check_Gram(name, Expected);
+            }
+        }
+        LCD_SceneWorkers(0);
+    }
+    LCD_SceneFree(&scene);
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Device_Draw
+* Description    : Picture of panel k, every primitive reading the clip and
+*                  the viewport
+* Input          : - k: panel
+* Output         : None
+* Return         : None
+* Attention      : Draws on the device of the calling thread
+*******************************************************************************/
+static void Device_Draw(int k)
+{
+    int i;
+
+    LCD_Clear(k * 1111);
+    for (i = 0; i < 200; i++)
+    {
+        LCD_DrawLine(i % 240, 0, 239 - i % 240, 319, i * k + 7);
+        LCD_DrawCircle(120, 160, 10 + i % 100, i * 31 + k);
+        LCD_SetPoint(i, 2 * i, k);
+    }
+    LCD_PushViewport(10 + k * 5, 20, 100, 100);
+    LCD_Text(0, 0, "hello world hello world", White, k);
+    LCD_DrawCircleFill(50, 50, 60, Red, k * 99);
+    LCD_PopClip();
+    LCD_FillRect(k * 10, k * 20, 50, 30, k * 999);
+}
+
+
+/*******************************************************************************
+* Function Name  : Device_Thread
+* Description    : Draw panel k on its own device
+* Input          : - arg: k
+* Output         : None
+* Return         : 0
+* Attention      : None
+*******************************************************************************/
+static void *Device_Thread(void *arg)
+{
+    int k = (int)(long)arg;
+
+    LCD_Select(Devices[k]);
+    LCD_Reset();
+    LCD_Init(k & 1 ? LANDSCAPE_TOP : PORTRAIT);
+    Device_Draw(k);
+    return 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_Devices
+* Description    : DEVICES panels drawn at the same time by a thread each
+*                  end as the same panels drawn one after the other
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : None
+*******************************************************************************/
+static int Check_Devices(void)
+{
+    EmuPanel *panels[DEVICES], *prevPanel;
+    LCD_Device *prev;
+    pthread_t threads[DEVICES];
+    char name[32];
+    int k, opened, diff = 0;
+
+    for (opened = 0; opened < DEVICES; opened++)
+    {
+        panels[opened] = LCD_EmuCreate();
+        Devices[opened] = panels[opened] ? LCD_DeviceOpen(&LCD_EmuTransport, panels[opened]) : 0;
+        if (!Devices[opened])
+        {
+            if (panels[opened])
+                LCD_EmuDestroy(panels[opened]);
+            break;
+        }
+    }
+    prevPanel = LCD_EmuSelect(0);
+    if (opened < DEVICES)
+    {
+        printf("  can't open %d panels\n", DEVICES);
+        diff = 1;
+    }
+    else
+    {
+        for (k = 0; k < DEVICES; k++)
+        {
+            Device_Thread((void *)(long)k);
+            LCD_EmuSelect(panels[k]);
+            memcpy(DeviceExpected[k], LCD_EmuGram(), sizeof(DeviceExpected[k]));
+            LCD_Clear(Black);
+        }
+        prev = LCD_Select(0);
+        for (k = 0; k < DEVICES; k++)
+            pthread_create(&threads[k], 0, Device_Thread, (void *)(long)k);
+        for (k = 0; k < DEVICES; k++)
+            pthread_join(threads[k], 0);
+        LCD_Select(prev);
+        for (k = 0; k < DEVICES; k++)
+        {
+            LCD_EmuSelect(panels[k]);
+            sprintf(name, "panel %d", k);
+            diff += Check_Gram(name, DeviceExpected[k]);
+        }
+    }
+    LCD_Select(0);
+    LCD_EmuSelect(prevPanel);
+    for (k = 0; k < opened; k++)
+    {
+        LCD_DeviceClose(Devices[k]);
+        LCD_EmuDestroy(panels[k]);
+    }
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Shared_Left ... Shared_Right
+* Description    : Two threads on one device: the left one draws in a
+*                  viewport it pushes and pops, the right one draws without
+*                  any, in the other half of the screen
+* Input          : - arg: rounds
+* Output         : None
+* Return         : 0
+* Attention      : A right drawing that saw the viewport of the left thread
+*                  is clipped away or moved
+*******************************************************************************/
+static void *Shared_Left(void *arg)
+{
+    int i, rounds = (int)(long)arg;
+
+    LCD_Select(Shared);
+    for (i = 0; i < rounds; i++)
+    {
+        LCD_Lock();
+        LCD_PushViewport(10, 10, 100, 300);
+        LCD_DrawLine(0, 0, 99, 299, Yellow);
+        LCD_DrawCircleFill(50, 150, 40, White, Blue);
+        LCD_SetPoint(i % 100, 5, Green);
+        LCD_PopClip();
+        LCD_Unlock();
+    }
+    return 0;
+}
+
+
+static void *Shared_Right(void *arg)
+{
+    int i, rounds = (int)(long)arg;
+
+    LCD_Select(Shared);
+    for (i = 0; i < rounds; i++)
+    {
+        LCD_DrawLine(130, 0, 239, 319, Cyan);
+        LCD_DrawCircle(180, 100, 50, Magenta);
+        LCD_DrawCircleFill(180, 250, 40, Red, Green);
+        LCD_SetPoint(130 + i % 100, 5, Red);
+        if (LCD_GetPoint(130, 5) != Red)
+            LCD_SetPoint(239, 319, White);      /* read with the wrong viewport */
+    }
+    return 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_SharedDevice
+* Description    : Two threads drawing on one device end as the same
+*                  drawings made one after the other
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : Each function reads the clip and the viewport under the
+*                  lock of the device
+*******************************************************************************/
+static int Check_SharedDevice(void)
+{
+    pthread_t left, right;
+
+    Shared = LCD_Select(0);
+    LCD_Clear(Black);
+    Shared_Left((void *)100L);
+    Shared_Right((void *)100L);
+    memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+    LCD_Clear(Black);
+    pthread_create(&left, 0, Shared_Left, (void *)(long)SHARED_ROUNDS);
+    pthread_create(&right, 0, Shared_Right, (void *)(long)SHARED_ROUNDS);
+    pthread_join(left, 0);
+    pthread_join(right, 0);
+    return Check_Gram("shared device", Expected);
+}
+
+
+/*******************************************************************************
+* Function Name  : Sprite_Thread
+* Description    : Move a sprite over the left half of the shared device
+* Input          : - arg: number of moves
+* Output         : None
+* Return         : 0
+* Attention      : Ends shown at 40, 200
+*******************************************************************************/
+static void *Sprite_Thread(void *arg)
+{
+    static unsigned short pixels[SPRITE_SIZE * SPRITE_SIZE];
+    int i, moves = (int)(long)arg;
+    Sprite sprite;
+
+    LCD_Select(Shared);
+    for (i = 0; i < SPRITE_SIZE * SPRITE_SIZE; i++)
+        pixels[i] = i % 5 ? (unsigned short)(i * 977) : Black;     /* Black is the key */
+    if (!LCD_SpriteCreate(&sprite, pixels, SPRITE_SIZE, SPRITE_SIZE, Black))
+        return 0;
+    LCD_SpriteShow(&sprite, 10, 10);
+    for (i = 0; i < moves; i++)
+        LCD_SpriteMove(&sprite, 10 + i % 80, 10 + i * 7 % 280);
+    LCD_SpriteMove(&sprite, 40, 200);
+    LCD_SpriteFree(&sprite);
+    return 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_SharedSprite
+* Description    : A sprite moved by one thread while another draws on the
+*                  same device ends as the same drawings made one after the
+*                  other
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : A window set by the other thread between the read, the
+*                  window and the burst of a move shows as a difference
+*******************************************************************************/
+static int Check_SharedSprite(void)
+{
+    pthread_t left, right;
+    int x, y;
+
+    Shared = LCD_Select(0);
+    for (y = 0; y < 2; y++)
+    {
+        LCD_Clear(Black);
+        for (x = 0; x < 120; x++)
+            LCD_DrawLine(x, 0, x, 319, (unsigned short)(x * 523 + 7));
+        if (!y)
+        {
+            Sprite_Thread((void *)100L);
+            Shared_Right((void *)100L);
+            memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+        }
+    }
+    pthread_create(&left, 0, Sprite_Thread, (void *)(long)SHARED_ROUNDS);
+    pthread_create(&right, 0, Shared_Right, (void *)(long)SHARED_ROUNDS);
+    pthread_join(left, 0);
+    pthread_join(right, 0);
+    return Check_Gram("shared sprite", Expected);
+}
+
+
+/*******************************************************************************
+* Function Name  : Layer_Thread
+* Description    : Move a half transparent layer over a background layer
+*                  on the left half of the shared device, composing each
+*                  move
+* Input          : - arg: number of moves
+* Output         : None
+* Return         : 0
+* Attention      : Ends with both layers taken out of the stack and the
+*                  left half composed black
+*******************************************************************************/
+static void *Layer_Thread(void *arg)
+{
+    static unsigned short back[120 * 320], front[24 * 24];
+    int i, moves = (int)(long)arg;
+    Layer bottom, top;
+
+    LCD_Select(Shared);
+    for (i = 0; i < 120 * 320; i++)
+        back[i] = (unsigned short)(i * 523 + 7);
+    for (i = 0; i < 24 * 24; i++)
+        front[i] = (unsigned short)(i * 977);
+    LCD_LayerInit(&bottom, back, 120, 320);
+    LCD_LayerInit(&top, front, 24, 24);
+    LCD_LayerSetAlpha(&top, 128, 0);
+    LCD_LayerAdd(&bottom);
+    LCD_LayerAdd(&top);
+    for (i = 0; i < moves; i++)
+    {
+        LCD_LayerMove(&top, i % 96, i * 7 % 296);
+        LCD_Compose();
+    }
+    LCD_LayerRemove(&top);
+    LCD_LayerRemove(&bottom);
+    LCD_Compose();
+    return 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_SharedLayers
+* Description    : Layers composed by one thread while another draws on the
+*                  same device end as the same drawings made one after the
+*                  other
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : A window set by the other thread between the window and
+*                  the bursts of a damaged rectangle shows as a difference
+*******************************************************************************/
+static int Check_SharedLayers(void)
+{
+    pthread_t left, right;
+
+    Shared = LCD_Select(0);
+    LCD_Clear(Black);
+    Layer_Thread((void *)100L);
+    Shared_Right((void *)100L);
+    memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+    LCD_Clear(Black);
+    pthread_create(&left, 0, Layer_Thread, (void *)(long)SHARED_ROUNDS);
+    pthread_create(&right, 0, Shared_Right, (void *)(long)SHARED_ROUNDS);
+    pthread_join(left, 0);
+    pthread_join(right, 0);
+    return Check_Gram("shared layers", Expected);
+}
+
+
+/*******************************************************************************
+* Function Name  : Video_Thread
+* Description    : Play an animation on the left half of the shared device
+* Input          : - arg: path of the file
+* Output         : None
+* Return         : 0
+* Attention      : Played as fast as the bus goes, no frame is dropped
+*******************************************************************************/
+static void *Video_Thread(void *arg)
+{
+    VideoPlayer player;
+
+    LCD_Select(Shared);
+    if (!LCD_VideoOpen(&player, (const char *)arg))
+        return 0;
+    LCD_VideoPlay(&player, 10, 100, 0, 0);
+    LCD_VideoClose(&player);
+    return 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_SharedVideo
+* Description    : An animation played by one thread while another draws on
+*                  the same device ends as the same drawings made one after
+*                  the other
+* Input          : None
+* Output         : None
+* Return         : number of differences, 1 if the file cannot be written
+* Attention      : A window set by the other thread between the window and
+*                  the burst of a frame shows as a difference
+*******************************************************************************/
+static int Check_SharedVideo(void)
+{
+    static unsigned short pixels[VIDEO_W * VIDEO_H];
+    char path[] = "/tmp/checkXXXXXX";
+    VideoWriter writer;
+    pthread_t left, right;
+    int f, i, fd, ok;
+
+    fd = mkstemp(path);
+    if (fd < 0)
+        return 1;
+    close(fd);
+    ok = LCD_VideoCreate(&writer, path, VIDEO_W, VIDEO_H, 25);
+    for (f = 0; ok && f < VIDEO_FRAMES; f++)
+    {
+        /* a square moving over a still background */
+        for (i = 0; i < VIDEO_W * VIDEO_H; i++)
+            pixels[i] = (unsigned short)(i * 523 + 7);
+        for (i = 0; i < 20 * 20; i++)
+            pixels[(f * 5 % 100 + i / 20) * VIDEO_W + f * 3 % 80 + i % 20] = (unsigned short)(f * 977);
+        ok = LCD_VideoAddFrame(&writer, pixels);
+    }
+    if (ok)
+        ok = LCD_VideoFinish(&writer);
+    if (!ok)
+    {
+        unlink(path);
+        printf("  cannot write %s\n", path);
+        return 1;
+    }
+
+    Shared = LCD_Select(0);
+    LCD_Clear(Black);
+    Video_Thread(path);
+    Shared_Right((void *)100L);
+    memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+    LCD_Clear(Black);
+    pthread_create(&left, 0, Video_Thread, path);
+    pthread_create(&right, 0, Shared_Right, (void *)(long)SHARED_ROUNDS);
+    pthread_join(left, 0);
+    pthread_join(right, 0);
+    unlink(path);
+    return Check_Gram("shared video", Expected);
+}
+
+
+/*******************************************************************************
+* Function Name  : Shadow_Ops
+* Description    : Random drawing and reading back, the reads checked
+*                  against what was drawn
+* Input          : - seed: sequence
+*                  - invalidate: 1 to forget the register shadow before
+*                    each operation, so that every register goes to the panel
+* Output         : - sum: checksum of what was read back
+* Return         : number of points read back with another color than drawn
+* Attention      : Points next to each other, reads between writes and
+*                  windows left behind exercise the address counter model
+*******************************************************************************/
+static int Shadow_Ops(unsigned int seed, int invalidate, unsigned long *sum)
+{
+    unsigned short line[64], colors[32];
+    Coordinate points[32];
+    int w = LCD_GetWidth(), h = LCD_GetHeight();
+    int k, i, x, y, n, bad = 0;
+    unsigned short c;
+
+    *sum = 0;
+    for (k = 0; k < SHADOW_OPS; k++)
+    {
+        x = Check_Rand(&seed) % w;
+        y = Check_Rand(&seed) % h;
+        c = Check_Rand(&seed) << 1 ^ Check_Rand(&seed);
+        n = Check_Rand(&seed) % 32 + 1;
+        if (invalidate)
+            LCD_ShadowInvalidate();
+        switch (Check_Rand(&seed) % 8)
+        {
+        case 0:                         /* a run of points along x */
+            for (i = 0; i < n && x + i < w; i++)
+                LCD_SetPoint(x + i, y, c + i);
+            break;
+        case 1:
+            LCD_SetPoint(x, y, c);
+            if (LCD_GetPoint(x, y) != c)
+                bad++;
+            break;
+        case 2:
+            for (i = 0; i < n; i++)
+            {
+                points[i].x = (x + i * 7) % w;
+                points[i].y = (y + i / 3) % h;
+                colors[i] = c ^ i;
+            }
+            LCD_SetPointsColors(points, colors, n);
+            break;
+        case 3:
+            LCD_DrawLine(x, y, Check_Rand(&seed) % w, Check_Rand(&seed) % h, c);
+            break;
+        case 4:
+            LCD_FillRect(x, y, n, n / 2 + 1, c);
+            break;
+        case 5:
+            if (x + n <= w)
+            {
+                LCD_ReadRect(x, y, n, 1, line);
+                for (i = 0; i < n; i++)
+                    *sum = *sum * 31 + line[i];
+            }
+            break;
+        case 6:
+            if (x + 16 <= w && y + 16 <= h)
+            {
+                LCD_SetWindow(x, y, 16, 4);
+                for (i = 0; i < 64; i++)
+                    line[i] = c + i;
+                LCD_WritePixels(line, 64);
+            }
+            break;
+        default:
+            *sum = *sum * 31 + LCD_GetPoint(x, y);
+            break;
+        }
+    }
+    return bad;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_Shadow
+* Description    : The same drawing and reading with the register shadow
+*                  and without it give the same GRAM and read the same
+*                  colors, in every orientation
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : Without the shadow every cursor and window register is
+*                  written, as before the shadow was there
+*******************************************************************************/
+static int Check_Shadow(void)
+{
+    unsigned long sumAll, sumCached;
+    char name[48];
+    int k, orientation, diff = 0;
+
+    for (k = 0; k < ORIENTATIONS; k++)
+    {
+        orientation = Orientations[k];
+        LCD_Init(orientation);
+        LCD_Clear(Black);
+        diff += Shadow_Ops(orientation + 11, 1, &sumAll);
+        memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+        LCD_Clear(Black);
+        diff += Shadow_Ops(orientation + 11, 0, &sumCached);
+        sprintf(name, "orientation %d", orientation);
+        diff += Check_Gram(name, Expected);
+        if (sumAll != sumCached)
+        {
+            printf("  %s: read back differs\n", name);
+            diff++;
+        }
+    }
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Tune_Dividers
+* Description    : LCD_TuneDividers on the selected device and panel, for
+*                  one line of the dividers case
+* Input          : - t: limits of the panel and dividers expected
+* Output         : None
+* Return         : number of differences
+* Attention      : The probe window must be put back, and the screen must
+*                  read back right at the dividers found
+*******************************************************************************/
+static int Tune_Dividers(const TuneCheck *t)
+{
+    unsigned int seed = t->writeHz / 1000 + 31;
+    unsigned short write, read;
+    LCD_Dividers found;
+    int i, diff = 0;
+
+    LCD_EmuSpiLimit(0, 0);
+    LCD_SetDividers(64, 64);
+    for (i = 0; i < MAX_X * MAX_Y; i++)
+        ReadScreen[i] = (unsigned short)Check_Rand(&seed);
+    LCD_SetWindow(0, 0, MAX_X, MAX_Y);
+    LCD_WritePixels(ReadScreen, MAX_X * MAX_Y);
+    memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+
+    LCD_EmuSpiLimit(t->writeHz, t->readHz);
+    if (!LCD_TuneDividers(&found) || found.writeFastest != t->writeFastest || found.readFastest != t->readFastest
+        || found.write != t->write || found.read != t->read)
+    {
+        printf("  limits %lu/%lu Hz: found %u/%u, set %u/%u, expected %u/%u, %u/%u\n", t->writeHz, t->readHz,
+               found.writeFastest, found.readFastest, found.write, found.read,
+               t->writeFastest, t->readFastest, t->write, t->read);
+        return 1;
+    }
+    LCD_GetDividers(&write, &read);
+    if (write != t->write || read != t->read)
+    {
+        printf("  limits %lu/%lu Hz: dividers in use %u/%u, expected %u/%u\n", t->writeHz, t->readHz,
+               write, read, t->write, t->read);
+        diff++;
+    }
+    diff += Check_Gram("probe window put back", Expected);
+
+    /* the whole screen, written and read at the dividers found */
+    for (i = 0; i < MAX_X * MAX_Y; i++)
+        ReadScreen[i] = (unsigned short)Check_Rand(&seed);
+    LCD_SetWindow(0, 0, MAX_X, MAX_Y);
+    LCD_WritePixels(ReadScreen, MAX_X * MAX_Y);
+    LCD_ReadRect(0, 0, MAX_X, MAX_Y, ReadBack);
+    for (i = 0; i < MAX_X * MAX_Y && ReadBack[i] == ReadScreen[i]; i++)
+        ;
+    if (i < MAX_X * MAX_Y)
+    {
+        printf("  limits %lu/%lu Hz: pixel %d,%d read %04X at the dividers found, written %04X\n",
+               t->writeHz, t->readHz, i % MAX_X, i / MAX_X, ReadBack[i], ReadScreen[i]);
+        diff++;
+    }
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_Dividers
+* Description    : LCD_TuneDividers finds the fastest clocks the emulated
+*                  panel takes, the writes and the reads apart, keeps a step
+*                  of margin, and fails without change on a panel too slow
+*                  even at the safe divider; the dividers belong to the
+*                  device and are saved and loaded
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : SPI clock = EMU_CORE_CLOCK / divider, 3.9 MHz at 64 up to
+*                  125 MHz at 2
+*******************************************************************************/
+static int Check_Dividers(void)
+{
+    static const TuneCheck tunes[] =
+    {
+        { 0, 0, 2, 2, 4, 4 },
+        { 40000000, 10000000, 8, 32, 16, 64 },
+        { 15625000, 15625000, 16, 16, 32, 32 },
+        { 62500000, 125000000, 4, 2, 8, 4 },
+        { 4000000, 200000000, 64, 2, 64, 4 },
+    };
+    char path[] = "/tmp/checkXXXXXX";
+    unsigned short write, read;
+    LCD_Dividers found;
+    EmuPanel *panel, *prevPanel;
+    LCD_Device *dev, *prev;
+    FILE *f;
+    int k, fd, diff = 0;
+
+    LCD_Init(PORTRAIT);
+    for (k = 0; k < (int)(sizeof(tunes) / sizeof(tunes[0])); k++)
+        diff += Tune_Dividers(&tunes[k]);
+
+    /* too slow even at the safe divider: unchanged */
+    LCD_EmuSpiLimit(0, 0);
+    LCD_SetDividers(8, 16);
+    LCD_EmuSpiLimit(3000000, 0);
+    if (LCD_TuneDividers(&found) || found.writeFastest || (LCD_GetDividers(&write, &read), write != 8 || read != 16))
+    {
+        printf("  panel too slow: tuning did not fail, or changed the dividers to %u/%u\n", write, read);
+        diff++;
+    }
+    LCD_EmuSpiLimit(0, 0);
+
+    /* saved and loaded; a file that is not a dividers one changes nothing */
+    fd = mkstemp(path);
+    if (fd < 0)
+        return diff + 1;
+    close(fd);
+    LCD_SetDividers(16, 32);
+    if (!LCD_SaveDividers(path))
+        diff++;
+    LCD_SetDividers(0, 0);
+    if (!LCD_LoadDividers(path) || (LCD_GetDividers(&write, &read), write != 16 || read != 32))
+    {
+        printf("  LCD_LoadDividers did not give back 16/32\n");
+        diff++;
+    }
+    f = fopen(path, "w");
+    if (f)
+    {
+        fprintf(f, "write 1 read 8\n");
+        fclose(f);
+    }
+    if (LCD_LoadDividers(path) || (LCD_GetDividers(&write, &read), write != 16 || read != 32))
+    {
+        printf("  LCD_LoadDividers took a divider of 1\n");
+        diff++;
+    }
+    remove(path);
+
+    /* a second panel, tuned on its own device */
+    panel = LCD_EmuCreate();
+    dev = panel ? LCD_DeviceOpen(&LCD_EmuTransport, panel) : 0;
+    if (!dev)
+    {
+        if (panel)
+            LCD_EmuDestroy(panel);
+        return diff + 1;
+    }
+    prev = LCD_Select(dev);
+    prevPanel = LCD_EmuSelect(panel);
+    LCD_Reset();
+    LCD_Init(PORTRAIT);
+    diff += Tune_Dividers(&tunes[1]);
+    LCD_EmuSpiLimit(0, 0);
+    LCD_Select(prev);
+    LCD_EmuSelect(prevPanel);
+    LCD_GetDividers(&write, &read);
+    if (write != 16 || read != 32)
+    {
+        printf("  tuning another device changed these dividers to %u/%u\n", write, read);
+        diff++;
+    }
+    LCD_DeviceClose(dev);
+    LCD_EmuDestroy(panel);
+    LCD_SetDividers(0, 0);
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Spi0_Sink
+* Description    : Sink of the SPI0 stand-in of the spi0 case, keeps the
+*                  bytes of the last transfer
+* Input          : - ctx: unused
+*                  - buf, len: bytes clocked out
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Spi0_Sink(void *ctx, char *buf, unsigned int len)
+{
+    Spi0GotLen = len < SPI0_TRANSFER_MAX ? len : SPI0_TRANSFER_MAX;
+    if (len)
+        memcpy(Spi0Got, buf, Spi0GotLen);
+    Spi0Transfers++;
+}
+
+
+/*******************************************************************************
+* Function Name  : Spi0_Transfers
+* Description    : SPI0_Write on registers in memory clocks out the head
+*                  then the buffer, each byte once and in order, whatever the
+*                  lengths against the FIFO depth
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : At least one FIFO write per byte, the cost of polled mode
+*******************************************************************************/
+static int Spi0_Transfers(void)
+{
+    static const unsigned int lens[] =
+    {
+        0, 1, 2, 3, SPI0_RX_BULK - 1, SPI0_RX_BULK, SPI0_RX_BULK + 1,
+        SPI0_FIFO_DEPTH - 1, SPI0_FIFO_DEPTH, SPI0_FIFO_DEPTH + 1, 2 * SPI0_FIFO_DEPTH + 5,
+        1000, SPI0_TRANSFER_MAX - 3,
+    };
+    unsigned int seed = 77, headLen, i, k, before;
+    SPI0_Standin standin;
+    SPI0_Port port;
+    int diff = 0;
+
+    for (i = 0; i < SPI0_TRANSFER_MAX; i++)
+        Spi0Sent[i] = (char)Check_Rand(&seed);
+    SPI0_StandinInit(&standin, &port, Spi0_Sink, 0);
+    for (headLen = 0; headLen <= 3; headLen++)
+    {
+        for (k = 0; k < sizeof(lens) / sizeof(lens[0]); k++)
+        {
+            before = Spi0Transfers;
+            Spi0GotLen = SPI0_TRANSFER_MAX;
+            standin.reads = standin.writes = 0;
+            SPI0_Write(&port, Spi0Sent, headLen, lens[k] ? Spi0Sent + headLen : 0, lens[k]);
+            if (Spi0Transfers != before + 1 || Spi0GotLen != headLen + lens[k]
+                || memcmp(Spi0Got, Spi0Sent, Spi0GotLen) || standin.writes < headLen + lens[k])
+            {
+                printf("  SPI0_Write %u + %u bytes: %u transfer(s) of %u bytes, %lu register writes\n",
+                       headLen, lens[k], Spi0Transfers - before, Spi0GotLen, standin.writes);
+                diff++;
+            }
+            if (standin.txCount || standin.rxCount || (standin.regs[SPI0_CS] & SPI0_CS_TA))
+            {
+                printf("  SPI0_Write %u + %u bytes: FIFOs not empty or TA left set\n", headLen, lens[k]);
+                diff++;
+            }
+        }
+    }
+    SPI0_StandinFree(&standin);
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Spi0_Draw
+* Description    : Random drawing of the spi0 case on the selected device:
+*                  register writes, fills, bursts of pixels in both byte
+*                  orders, points and text
+* Input          : - seed: picture
+*                  - w, h: screen size in the orientation
+* Output         : - pixels: number of pixels sent in bursts
+* Return         : number of bursts not read back as sent
+* Attention      : The window sizes are odd, and some bursts are longer than
+*                  one transfer of LCD_WritePixels
+*******************************************************************************/
+static int Spi0_Draw(unsigned int seed, int w, int h, unsigned long *pixels)
+{
+    static const unsigned short windows[][2] = { { 1, 1 }, { 3, 1 }, { 7, 5 }, { 61, 35 }, { 45, 91 } };
+    unsigned short *be = ReadBack;
+    int i, k, x, y, ww, wh, n, diff = 0;
+
+    *pixels = 0;
+    LCD_Clear((unsigned short)Check_Rand(&seed));
+    for (k = 0; k < 6; k++)
+    {
+        x = Check_Rand(&seed) % (w + 40) - 20;
+        y = Check_Rand(&seed) % (h + 40) - 20;
+        LCD_FillRect(x, y, Check_Rand(&seed) % 90 + 1, Check_Rand(&seed) % 70 + 1, (unsigned short)Check_Rand(&seed));
+    }
+    for (k = 0; k < (int)(sizeof(windows) / sizeof(windows[0])); k++)
+    {
+        ww = windows[k][0];
+        wh = windows[k][1];
+        n = ww * wh;
+        x = Check_Rand(&seed) % (w - ww + 1);
+        y = Check_Rand(&seed) % (h - wh + 1);
+        for (i = 0; i < n; i++)
+        {
+            ReadScreen[i] = (unsigned short)Check_Rand(&seed);
+            be[i] = (unsigned short)(ReadScreen[i] << 8 | ReadScreen[i] >> 8);
+        }
+        LCD_SetWindow(x, y, ww, wh);
+        if (k & 1)
+            LCD_WritePixelsBE(be, n);
+        else
+            LCD_WritePixels(ReadScreen, n);
+        *pixels += n;
+        LCD_ReadRect(x, y, ww, wh, be);
+        if (memcmp(be, ReadScreen, n * sizeof(be[0])))
+        {
+            printf("  burst %dx%d at %d,%d read back differs\n", ww, wh, x, y);
+            diff++;
+        }
+    }
+    for (k = 0; k < 20; k++)
+        LCD_SetPoint(Check_Rand(&seed) % w, Check_Rand(&seed) % h, (unsigned short)Check_Rand(&seed));
+    LCD_Text(Check_Rand(&seed) % (w / 2), Check_Rand(&seed) % (h - 16), (char *)"SPI0 FIFO", White, Blue);
+
+    /* raw registers: GRAM address, then data words */
+    LCD_WriteReg(0x0020, Check_Rand(&seed) % MAX_X);
+    LCD_WriteReg(0x0021, Check_Rand(&seed) % MAX_Y);
+    LCD_WriteIndex(0x0022);
+    for (k = 0; k < 5; k++)
+        LCD_WriteData((unsigned short)Check_Rand(&seed));
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_Spi0
+* Description    : The write only transport, LCD_EmuSpi0Transport, leaves
+*                  the same GRAM as LCD_EmuTransport for the same drawing, in
+*                  every orientation, and reads back the same screen
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : The reads of the SPI0 device still go through spiTransfer,
+*                  the bursts are read back against the pixels sent
+*******************************************************************************/
+static int Check_Spi0(void)
+{
+    EmuPanel *refPanel, *spi0Panel, *prevPanel;
+    LCD_Device *ref, *spi0, *prev;
+    unsigned long pixels, accesses, before;
+    char name[48];
+    int o, k, w, h, diff;
+
+    diff = Spi0_Transfers();
+    refPanel = LCD_EmuCreate();
+    spi0Panel = LCD_EmuCreate();
+    ref = refPanel ? LCD_DeviceOpen(&LCD_EmuTransport, refPanel) : 0;
+    spi0 = spi0Panel ? LCD_DeviceOpen(&LCD_EmuSpi0Transport, spi0Panel) : 0;
+    if (!ref || !spi0)
+    {
+        if (ref)
+            LCD_DeviceClose(ref);
+        if (spi0)
+            LCD_DeviceClose(spi0);
+        if (refPanel)
+            LCD_EmuDestroy(refPanel);
+        if (spi0Panel)
+            LCD_EmuDestroy(spi0Panel);
+        return diff + 1;
+    }
+    prev = LCD_Select(ref);
+    prevPanel = LCD_EmuSelect(spi0Panel);
+    LCD_Select(spi0);
+    LCD_Reset();
+    LCD_Select(ref);
+    LCD_Reset();
+    accesses = LCD_EmuSpi0Accesses();
+    for (o = 0; o < ORIENTATIONS; o++)
+    {
+        for (k = 0; k < SPI0_ROUNDS; k++)
+        {
+            LCD_Select(ref);
+            LCD_Init(Orientations[o]);
+            w = LCD_GetWidth();
+            h = LCD_GetHeight();
+            diff += Spi0_Draw(o * SPI0_ROUNDS + k + 1, w, h, &pixels);
+            LCD_EmuSelect(refPanel);
+            memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+
+            LCD_Select(spi0);
+            LCD_Init(Orientations[o]);
+            diff += Spi0_Draw(o * SPI0_ROUNDS + k + 1, w, h, &pixels);
+            LCD_EmuSelect(spi0Panel);
+            sprintf(name, "orientation %d, drawing %d", Orientations[o], k);
+            diff += Check_Gram(name, Expected);
+
+            /* a FIFO write and a FIFO read per byte at least */
+            before = accesses;
+            accesses = LCD_EmuSpi0Accesses();
+            if (accesses < before + 4 * pixels)
+            {
+                printf("  %s: %lu SPI0 register accesses for %lu pixels\n", name, accesses - before, pixels);
+                diff++;
+            }
+            LCD_ReadRect(0, 0, w, h, ReadBack);
+            LCD_Select(ref);
+            LCD_ReadRect(0, 0, w, h, ReadScreen);
+            if (memcmp(ReadBack, ReadScreen, (size_t)w * h * sizeof(ReadBack[0])))
+            {
+                printf("  %s: screen read back differs\n", name);
+                diff++;
+            }
+        }
+    }
+    LCD_EmuSelect(refPanel);
+    if (LCD_EmuSpi0Accesses())
+    {
+        printf("  LCD_EmuTransport went through the SPI0 registers\n");
+        diff++;
+    }
+    LCD_Select(prev);
+    LCD_EmuSelect(prevPanel);
+    LCD_DeviceClose(spi0);
+    LCD_DeviceClose(ref);
+    LCD_EmuDestroy(spi0Panel);
+    LCD_EmuDestroy(refPanel);
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Ui_Event
+* Description    : Handler of the ui case widgets, notes the events
+* Input          : - widget: widget, user holds its letter
+*                  - event: UI_EVENT_x
+* Output         : None
+* Return         : None
+* Attention      : Appends the letter, lower case for UI_EVENT_CHANGE
+*******************************************************************************/
+static void Ui_Event(UiWidget *widget, int event)
+{
+    size_t n = strlen(UiEvents);
+    char c = *(const char *)widget->user;
+
+    if (n + 1 < sizeof(UiEvents))
+    {
+        UiEvents[n] = event == UI_EVENT_CHANGE ? c - 'A' + 'a' : c;
+        UiEvents[n + 1] = 0;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Ui_Area
+* Description    : Part of a widget its parents let it show on the screen
+* Input          : - widget: widget of the tree
+* Output         : - area: screen rectangle
+* Return         : None
+* Attention      : The widget is assumed visible
+*******************************************************************************/
+static void Ui_Area(const UiWidget *widget, UiArea *area)
+{
+    const UiWidget *p;
+    int ax = 0, ay = 0, px, py;
+
+    for (p = widget; p->parent; p = p->parent)
+    {
+        ax += p->x;
+        ay += p->y;
+    }
+    area->x0 = ax;
+    area->y0 = ay;
+    area->x1 = ax + widget->w;
+    area->y1 = ay + widget->h;
+    px = ax;
+    py = ay;
+    for (p = widget; p->parent; p = p->parent)
+    {
+        px -= p->x;
+        py -= p->y;
+        if (px > area->x0) area->x0 = px;
+        if (py > area->y0) area->y0 = py;
+        if (px + p->parent->w < area->x1) area->x1 = px + p->parent->w;
+        if (py + p->parent->h < area->y1) area->y1 = py + p->parent->h;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Ui_Hit
+* Description    : Top touchable widget at a point, walking the whole tree
+* Input          : - widget: visible widget
+*                  - ax, ay: its upper left corner on the screen
+*                  - area: screen rectangle of its parents
+*                  - x, y: screen point
+* Output         : - hit: last widget at the point in drawing order
+* Return         : None
+* Attention      : The reference of UI_HitTest
+*******************************************************************************/
+static void Ui_Hit(const UiWidget *widget, int ax, int ay, const UiArea *area, int x, int y, const UiWidget **hit)
+{
+    const UiWidget *c;
+    UiArea r;
+
+    r.x0 = ax > area->x0 ? ax : area->x0;
+    r.y0 = ay > area->y0 ? ay : area->y0;
+    r.x1 = ax + widget->w < area->x1 ? ax + widget->w : area->x1;
+    r.y1 = ay + widget->h < area->y1 ? ay + widget->h : area->y1;
+    if (r.x0 >= r.x1 || r.y0 >= r.y1)
+        return;
+    if ((widget->type == UI_BUTTON || widget->type == UI_SLIDER || widget->type == UI_LIST)
+        && x >= r.x0 && x < r.x1 && y >= r.y0 && y < r.y1)
+        *hit = widget;
+    for (c = widget->child; c; c = c->next)
+        if (c->visible)
+            Ui_Hit(c, ax + c->x, ay + c->y, &r, x, y, hit);
+}
+
+
+/*******************************************************************************
+* Function Name  : Ui_HitAll
+* Description    : UI_HitTest against Ui_Hit over the screen
+* Input          : - name: step
+* Output         : None
+* Return         : number of differences
+* Attention      : Every other pixel, and the points off the screen
+*******************************************************************************/
+static int Ui_HitAll(const char *name)
+{
+    static const short off[][2] = { { -1, 0 }, { 0, -1 }, { MAX_X, 0 }, { 0, MAX_Y } };
+    const UiWidget *hit, *got;
+    UiArea screen = { 0, 0, MAX_X, MAX_Y };
+    int x, y, k, diff = 0;
+
+    for (y = 0; y < MAX_Y; y += 2)
+    {
+        for (x = 0; x < MAX_X; x += 2)
+        {
+            hit = 0;
+            Ui_Hit(&UiRoot, 0, 0, &screen, x, y, &hit);
+            got = UI_HitTest(x, y);
+            if (got != hit)
+            {
+                if (!diff || Verbose)
+                    printf("  %s: UI_HitTest(%d, %d) is %s, expected %s\n", name, x, y,
+                           got && got->text ? got->text : got ? "a widget" : "none",
+                           hit && hit->text ? hit->text : hit ? "a widget" : "none");
+                diff++;
+            }
+        }
+    }
+    for (k = 0; k < (int)(sizeof(off) / sizeof(off[0])); k++)
+    {
+        if (UI_HitTest(off[k][0], off[k][1]))
+        {
+            printf("  %s: UI_HitTest(%d, %d) off the screen hit\n", name, off[k][0], off[k][1]);
+            diff++;
+        }
+    }
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Ui_Repaint
+* Description    : UI_Update after a change repaints the screen inside the
+*                  rectangles the change touched, as a full repaint does,
+*                  and nothing outside them
+* Input          : - name: step
+*                  - areas: rectangles the change may repaint
+*                  - n: number of rectangles, 0 for nothing
+* Output         : None
+* Return         : number of differences
+* Attention      : The screen is filled with UI_POISON before the update;
+*                  the full repaint of the tree is left on the screen
+*******************************************************************************/
+static int Ui_Repaint(const char *name, const UiArea *areas, int n)
+{
+    int x, y, k, inside, diff = 0;
+    unsigned short got, full;
+
+    LCD_FillRect(0, 0, MAX_X, MAX_Y, UI_POISON);
+    UI_Update();
+    LCD_ReadRect(0, 0, MAX_X, MAX_Y, ReadScreen);
+    LCD_FillRect(0, 0, MAX_X, MAX_Y, UI_POISON);
+    UI_Invalidate(&UiRoot);
+    UI_Update();
+    LCD_ReadRect(0, 0, MAX_X, MAX_Y, ReadBack);
+    for (y = 0; y < MAX_Y; y++)
+    {
+        for (x = 0; x < MAX_X; x++)
+        {
+            for (k = inside = 0; k < n && !inside; k++)
+                inside = x >= areas[k].x0 && x < areas[k].x1 && y >= areas[k].y0 && y < areas[k].y1;
+            got = ReadScreen[y * MAX_X + x];
+            full = inside ? ReadBack[y * MAX_X + x] : UI_POISON;
+            if (got != full)
+            {
+                if (!diff || Verbose)
+                    printf("  %s: %d,%d is %04X, expected %04X%s\n", name, x, y, got, full,
+                           inside ? "" : ", not repainted");
+                diff++;
+            }
+        }
+    }
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_Ui
+* Description    : UI_Update repaints only what each change touched, the way
+*                  a full repaint draws it; UI_HitTest finds the widget a
+*                  walk of the tree finds; UI_Touch sends the events
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : The tree has overlapping siblings, a child partly outside
+*                  its parent and more widgets in one grid cell than
+*                  UI_CELL_WIDGETS
+*******************************************************************************/
+static int Check_Ui(void)
+{
+    UiArea areas[2];
+    int k, diff = 0;
+
+    LCD_Init(PORTRAIT);
+    UI_Init(&UiRoot, Blue);
+    UI_LabelInit(&UiTitle, 0, 0, MAX_X, 20, "Title");
+    UI_ButtonInit(&UiOk, 10, 30, 100, 30, "OK", Ui_Event);
+    UI_ButtonInit(&UiCancel, 80, 45, 100, 30, "Cancel", Ui_Event);
+    UI_LabelInit(&UiPanel, 20, 100, 200, 150, 0);
+    UI_SliderInit(&UiSlider, 10, 10, 150, 20, 0, 100, 30, Ui_Event);
+    UI_ProgressInit(&UiProgress, 10, 40, 180, 12, 0, 10, 3);
+    UI_ListInit(&UiList, 10, 60, 120, 72, UiItems, 10, Ui_Event);
+    UI_ButtonInit(&UiEdge, 150, 120, 80, 40, "Edge", Ui_Event);
+    UiOk.user = "O";
+    UiCancel.user = "C";
+    UiSlider.user = "S";
+    UiList.user = "L";
+    UiEdge.user = "E";
+    UI_SetColors(&UiPanel, White, Grey);
+    UI_SetColors(&UiCancel, Yellow, Red);
+    UI_Add(&UiRoot, &UiTitle);
+    UI_Add(&UiRoot, &UiOk);
+    UI_Add(&UiRoot, &UiCancel);
+    UI_Add(&UiRoot, &UiPanel);
+    UI_Add(&UiPanel, &UiSlider);
+    UI_Add(&UiPanel, &UiProgress);
+    UI_Add(&UiPanel, &UiList);
+    UI_Add(&UiPanel, &UiEdge);
+    for (k = 0; k < UI_SMALL; k++)
+    {
+        UI_ButtonInit(&UiSmall[k], 194 + k % 5 * 5, 258 + k / 5 * 5, 8, 8, 0, 0);
+        UI_Add(&UiRoot, &UiSmall[k]);
+    }
+    areas[0].x0 = areas[0].y0 = 0;
+    areas[0].x1 = MAX_X;
+    areas[0].y1 = MAX_Y;
+    diff += Ui_Repaint("first update", areas, 1);
+    diff += Ui_HitAll("first update");
+
+    diff += Ui_Repaint("nothing changed", areas, 0);
+    UI_SetValue(&UiProgress, 3);
+    UI_SetText(&UiTitle, UiTitle.text);
+    UI_SetColors(&UiOk, UiOk.fg, UiOk.bg);
+    UI_Move(&UiCancel, UiCancel.x, UiCancel.y);
+    UI_Show(&UiEdge, 1);
+    diff += Ui_Repaint("changes to the same", areas, 0);
+
+    UI_SetValue(&UiProgress, 7);
+    Ui_Area(&UiProgress, &areas[0]);
+    diff += Ui_Repaint("UI_SetValue progress", areas, 1);
+    UI_SetText(&UiTitle, "Other title");
+    Ui_Area(&UiTitle, &areas[0]);
+    diff += Ui_Repaint("UI_SetText", areas, 1);
+    UI_SetColors(&UiOk, Green, Black);
+    Ui_Area(&UiOk, &areas[0]);
+    diff += Ui_Repaint("UI_SetColors under a sibling", areas, 1);
+    Ui_Area(&UiCancel, &areas[0]);
+    UI_Move(&UiCancel, 130, 50);
+    Ui_Area(&UiCancel, &areas[1]);
+    diff += Ui_Repaint("UI_Move", areas, 2);
+    diff += Ui_HitAll("UI_Move");
+    Ui_Area(&UiEdge, &areas[0]);
+    UI_Show(&UiEdge, 0);
+    diff += Ui_Repaint("UI_Show hidden", areas, 1);
+    diff += Ui_HitAll("UI_Show hidden");
+    UI_Show(&UiEdge, 1);
+    Ui_Area(&UiEdge, &areas[0]);
+    diff += Ui_Repaint("UI_Show shown", areas, 1);
+    UI_SetValue(&UiList, 8);
+    Ui_Area(&UiList, &areas[0]);
+    diff += Ui_Repaint("UI_SetValue list", areas, 1);
+    if (UiList.top != 5)
+    {
+        printf("  UI_SetValue list: first item shown %d, expected 5\n", UiList.top);
+        diff++;
+    }
+    Ui_Area(&UiOk, &areas[0]);
+    UI_Remove(&UiOk);
+    diff += Ui_Repaint("UI_Remove", areas, 1);
+    diff += Ui_HitAll("UI_Remove");
+    UI_Add(&UiRoot, &UiOk);
+    Ui_Area(&UiOk, &areas[0]);
+    diff += Ui_Repaint("UI_Add on top", areas, 1);
+    diff += Ui_HitAll("UI_Add on top");
+    UI_Invalidate(&UiSlider);
+    Ui_Area(&UiSlider, &areas[0]);
+    diff += Ui_Repaint("UI_Invalidate", areas, 1);
+
+    /* click, click cancelled by leaving, slider drag, list tap */
+    UiEvents[0] = 0;
+    UI_Touch(30, 45, 1);
+    UI_Touch(30, 45, 0);
+    UI_Touch(30, 45, 1);
+    UI_Touch(30, 90, 1);
+    UI_Touch(30, 90, 0);
+    UI_Touch(20 + 10 + 6 + 69, 115, 1);
+    UI_Touch(20 + 10 + 6 + 138, 115, 1);
+    UI_Touch(20 + 10 + 6 + 138, 115, 0);
+    UI_SetValue(&UiList, 0);
+    UI_Touch(50, 160 + 2 * UI_LINE + 3, 1);
+    UI_Touch(50, 160 + 2 * UI_LINE + 3, 0);
+    if (strcmp(UiEvents, "Ossl") || UiSlider.value != 100 || UiList.value != 2)
+    {
+        printf("  UI_Touch: events \"%s\", slider %d, list %d, expected \"Ossl\", 100, 2\n",
+               UiEvents, UiSlider.value, UiList.value);
+        diff++;
+    }
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Clip_Push
+* Description    : Clip rectangle or viewport pushed on the model
+* Input          : - m: clip and viewport
+*                  - x, y, w, h: rectangle, relative to the viewport
+*                  - viewport: 1 to move the origin too
+* Output         : - m: clip and viewport after the push
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Clip_Push(ClipModel *m, int x, int y, int w, int h, int viewport)
+{
+    x += m->ox;
+    y += m->oy;
+    if (x > m->x0) m->x0 = x;
+    if (y > m->y0) m->y0 = y;
+    if (x + w < m->x1) m->x1 = x + w;
+    if (y + h < m->y1) m->y1 = y + h;
+    if (m->x1 < m->x0) m->x1 = m->x0;
+    if (m->y1 < m->y0) m->y1 = m->y0;
+    if (viewport)
+    {
+        m->ox = x;
+        m->oy = y;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Clip_Draw
+* Description    : Random primitive of the clip case
+* Input          : - op: random numbers of the primitive
+*                  - m: clip and viewport it is drawn for
+*                  - ox, oy: added to its screen coordinates
+*                  - turned: LANDSCAPE, where PutChar takes y then x
+*                  - image: 40x30 pixels
+* Output         : None
+* Return         : None
+* Attention      : Coordinates off the screen on every side; most lines end
+*                  around the clip, so that they cross its edges, the others
+*                  far away
+*******************************************************************************/
+static void Clip_Draw(const unsigned int *op, const ClipModel *m, int ox, int oy, int turned,
+                      const unsigned short *image)
+{
+    int w = LCD_GetWidth(), h = LCD_GetHeight();
+    int x = (int)(op[1] % (w + 160)) - 80 + ox, y = (int)(op[2] % (h + 160)) - 80 + oy;
+    int lx = m->x0 - m->ox - 20 + ox, ly = m->y0 - m->oy - 20 + oy;
+    int lw = m->x1 - m->x0 + 40, lh = m->y1 - m->y0 + 40;
+    unsigned short c = (unsigned short)op[5];
+    LCD_ImageSpan span;
+    int j;
+
+    switch (op[0] % 10)
+    {
+    case 0:
+        LCD_SetPoint(x, y, c);
+        break;
+    case 1:
+        LCD_FillRect(x, y, op[3] % 200, op[4] % 200, c);
+        break;
+    case 2:
+        LCD_DrawLine(x, y, (int)(op[3] % 1100) - 400 + ox, (int)(op[4] % 1100) - 400 + oy, c);
+        break;
+    case 3: case 4:
+        LCD_DrawLine(lx + op[1] % lw, ly + op[2] % lh, lx + op[3] % lw, ly + op[4] % lh, c);
+        break;
+    case 5:
+        LCD_DrawBox(x, y, x + op[3] % 150, y + op[4] % 150, c, op[3] & 1 ? -1 : (int)(c ^ 0xFFFF));
+        break;
+    case 6:
+        LCD_DrawCircle(x, y, op[3] % 150, c);
+        break;
+    case 7:
+        LCD_DrawCircleFill(x, y, op[3] % 150, c, c ^ 0x1234);
+        break;
+    case 8:
+        if (turned)
+            PutChar(x - ox + oy, y - oy + ox, ' ' + op[3] % 95, c, c ^ 0xFFFF);
+        else
+            PutChar(x, y, ' ' + op[3] % 95, c, c ^ 0xFFFF);
+        break;
+    default:
+        if (LCD_ImageWindow(x, y, 40, 30, &span))
+            for (j = 0; j < span.h; j++)
+                LCD_WritePixels(image + (span.sy + j) * 40 + span.sx, span.w);
+        break;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_Clip
+* Description    : Primitives drawn through nested clips and viewports give
+*                  the GRAM of the same primitives drawn without any, moved
+*                  to the origin of the viewport, with the screen outside
+*                  the clip blanked, in every orientation
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : The clips and viewports are off the screen, empty or
+*                  nested; the stack model is Clip_Push
+*******************************************************************************/
+static int Check_Clip(void)
+{
+    unsigned short image[40 * 30];
+    unsigned int seed = 29, ops[CLIP_OPS][6], pushes[CLIP_PUSHES][5];
+    char name[80];
+    int k, r, i, n, depth, orientation, turned, w, h, diff = 0;
+    ClipModel m;
+
+    for (i = 0; i < 40 * 30; i++)
+        image[i] = (unsigned short)(i * 2654435761u >> 16);
+    for (k = 0; k < ORIENTATIONS; k++)
+    {
+        orientation = Orientations[k];
+        turned = orientation == LANDSCAPE || orientation == (LANDSCAPE | LCD_MIRROR);
+        LCD_Init(orientation);
+        w = LCD_GetWidth();
+        h = LCD_GetHeight();
+        for (r = 0; r < CLIP_ROUNDS; r++)
+        {
+            depth = Check_Rand(&seed) % (CLIP_PUSHES + 1);
+            m.x0 = m.y0 = m.ox = m.oy = 0;
+            m.x1 = w;
+            m.y1 = h;
+            for (i = 0; i < depth; i++)
+            {
+                pushes[i][0] = Check_Rand(&seed) % 2;
+                pushes[i][1] = (int)(Check_Rand(&seed) % (w + 60)) - 60;
+                pushes[i][2] = (int)(Check_Rand(&seed) % (h + 60)) - 60;
+                pushes[i][3] = Check_Rand(&seed) % w;
+                pushes[i][4] = Check_Rand(&seed) % h;
+                Clip_Push(&m, (int)pushes[i][1], (int)pushes[i][2], pushes[i][3], pushes[i][4], pushes[i][0]);
+            }
+            n = Check_Rand(&seed) % CLIP_OPS + 1;
+            for (i = 0; i < n * 6; i++)
+                ops[i / 6][i % 6] = Check_Rand(&seed);
+
+            /* without clip, moved, the outside blanked */
+            LCD_Clear(Black);
+            for (i = 0; i < n; i++)
+                Clip_Draw(ops[i], &m, m.ox, m.oy, turned, image);
+            LCD_FillRect(0, 0, w, m.y0, Black);
+            LCD_FillRect(0, m.y1, w, h - m.y1, Black);
+            LCD_FillRect(0, m.y0, m.x0, m.y1 - m.y0, Black);
+            LCD_FillRect(m.x1, m.y0, w - m.x1, m.y1 - m.y0, Black);
+            memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+
+            LCD_Clear(Black);
+            for (i = 0; i < depth; i++)
+            {
+                if (pushes[i][0])
+                    LCD_PushViewport((int)pushes[i][1], (int)pushes[i][2], pushes[i][3], pushes[i][4]);
+                else
+                    LCD_PushClip((int)pushes[i][1], (int)pushes[i][2], pushes[i][3], pushes[i][4]);
+            }
+            for (i = 0; i < n; i++)
+                Clip_Draw(ops[i], &m, 0, 0, turned, image);
+            for (i = 0; i < depth; i++)
+                LCD_PopClip();
+            sprintf(name, "orientation %d, round %d, clip %d,%d-%d,%d, origin %d,%d",
+                    orientation, r, m.x0, m.y0, m.x1, m.y1, m.ox, m.oy);
+            diff += Check_Gram(name, Expected);
+        }
+
+        /* the stack is full after CLIP_STACK pushes, and empty pops do nothing */
+        for (i = 0; i < CLIP_STACK; i++)
+            LCD_PushViewport(1, 1, w, h);
+        if (LCD_PushClip(0, 0, 1, 1) || LCD_PushViewport(0, 0, 1, 1))
+        {
+            printf("  orientation %d: a push on a full stack did not fail\n", orientation);
+            diff++;
+        }
+        for (i = 0; i < CLIP_STACK + 2; i++)
+            LCD_PopClip();
+        LCD_Clear(Black);
+        LCD_FillRect(0, 0, w, h, White);
+        for (i = 0; i < MAX_X * MAX_Y; i++)
+            Expected[i] = White;
+        sprintf(name, "orientation %d, after the pops", orientation);
+        diff += Check_Gram(name, Expected);
+    }
+    LCD_Init(PORTRAIT);
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Read_Ppm
+* Description    : Compare a PPM screenshot with the screen it was taken of
+* Input          : - path: file
+*                  - name: for the messages
+*                  - w, h: screen size
+*                  - screen: w * h colors, line by line
+* Output         : None
+* Return         : number of differences
+* Attention      : Each channel must be the RGB565 one with its top bits
+*                  replicated in the low ones
+*******************************************************************************/
+static int Read_Ppm(const char *path, const char *name, int w, int h, const unsigned short *screen)
+{
+    unsigned char rgb[3], expected[3];
+    unsigned int pw, ph, max;
+    unsigned short c;
+    int i, diff = 0;
+    FILE *f;
+
+    f = fopen(path, "rb");
+    if (!f || fscanf(f, "P6\n%u %u\n%u", &pw, &ph, &max) != 3 || fgetc(f) != '\n'
+        || pw != (unsigned int)w || ph != (unsigned int)h || max != 255)
+    {
+        printf("  %s: bad PPM header\n", name);
+        if (f)
+            fclose(f);
+        return 1;
+    }
+    for (i = 0; i < w * h; i++)
+    {
+        if (fread(rgb, 1, 3, f) != 3)
+        {
+            printf("  %s: PPM cut short at pixel %d\n", name, i);
+            diff++;
+            break;
+        }
+        c = screen[i];
+        expected[0] = (c >> 11) << 3 | (c >> 13);
+        expected[1] = (c >> 5 & 0x3F) << 2 | (c >> 9 & 3);
+        expected[2] = (c & 0x1F) << 3 | (c >> 2 & 7);
+        if (memcmp(rgb, expected, 3))
+        {
+            if (!diff || Verbose)
+                printf("  %s: PPM %d,%d is %02X%02X%02X, expected %02X%02X%02X\n", name, i % w, i / w,
+                       rgb[0], rgb[1], rgb[2], expected[0], expected[1], expected[2]);
+            diff++;
+        }
+    }
+    if (fgetc(f) != EOF)
+    {
+        printf("  %s: PPM too long\n", name);
+        diff++;
+    }
+    fclose(f);
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_ReadRect
+* Description    : LCD_ReadRect reads back what was written, and the
+*                  screenshots hold the screen, in every orientation
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : Rectangles wider than a burst, along the edges and of a
+*                  pixel. The BMP screenshot is shown again with
+*                  LCD_PutImage, which must give the same GRAM; LANDSCAPE
+*                  turns the images it shows, so there only the PPM one
+*******************************************************************************/
+static int Check_ReadRect(void)
+{
+    static const unsigned short rects[][4] =
+    {
+        { 0, 0, 1, 1 }, { 0, 0, 240, 9 }, { 3, 5, 200, 20 }, { 239, 0, 1, 240 }, { 0, 239, 240, 1 },
+        { 17, 33, 3, 101 }, { 100, 100, 140, 140 },
+    };
+    char bmp[] = "/tmp/checkXXXXXX", ppm[] = "/tmp/checkXXXXXX.ppm", name[64];
+    unsigned int seed = 23;
+    int k, r, i, orientation, x, y, w, h, rw, rh, fd, diff = 0;
+
+    fd = mkstemp(bmp);
+    if (fd < 0)
+        return 1;
+    close(fd);
+    fd = mkstemps(ppm, 4);
+    if (fd < 0)
+    {
+        remove(bmp);
+        return 1;
+    }
+    close(fd);
+    for (k = 0; k < ORIENTATIONS; k++)
+    {
+        orientation = Orientations[k];
+        LCD_Init(orientation);
+        w = LCD_GetWidth();
+        h = LCD_GetHeight();
+        for (i = 0; i < w * h; i++)
+            ReadScreen[i] = (unsigned short)Check_Rand(&seed);
+        LCD_SetWindow(0, 0, w, h);
+        LCD_WritePixels(ReadScreen, w * h);
+
+        /* the fixed rectangles, then random ones */
+        for (r = 0; r < READ_RECTS; r++)
+        {
+            if (r < (int)(sizeof(rects) / sizeof(rects[0])))
+            {
+                x = rects[r][0];
+                y = rects[r][1];
+                rw = rects[r][2];
+                rh = rects[r][3];
+            }
+            else
+            {
+                x = Check_Rand(&seed) % w;
+                y = Check_Rand(&seed) % h;
+                rw = Check_Rand(&seed) % (w - x) + 1;
+                rh = Check_Rand(&seed) % (h - y) + 1;
+            }
+            sprintf(name, "orientation %d, %dx%d at %d,%d", orientation, rw, rh, x, y);
+            memset(ReadBack, 0, rw * rh * sizeof(ReadBack[0]));
+            if (!LCD_ReadRect(x, y, rw, rh, ReadBack))
+            {
+                printf("  %s: LCD_ReadRect failed\n", name);
+                diff++;
+                continue;
+            }
+            for (i = 0; i < rw * rh; i++)
+            {
+                if (ReadBack[i] != ReadScreen[(y + i / rw) * w + x + i % rw])
+                {
+                    if (Verbose)
+                        printf("  %s: %d,%d read %04X, expected %04X\n", name, x + i % rw, y + i / rw,
+                               ReadBack[i], ReadScreen[(y + i / rw) * w + x + i % rw]);
+                    diff++;
+                }
+            }
+        }
+        if (LCD_ReadRect(0, 0, 0, 1, ReadBack) || LCD_ReadRect(w - 3, 0, 4, 1, ReadBack)
+            || LCD_ReadRect(0, h - 1, 1, 2, ReadBack))
+        {
+            printf("  orientation %d: LCD_ReadRect read off the screen\n", orientation);
+            diff++;
+        }
+
+        sprintf(name, "orientation %d, screenshot", orientation);
+        if (LCD_Screenshot(ppm) || LCD_Screenshot(bmp))
+        {
+            printf("  %s: LCD_Screenshot failed\n", name);
+            diff++;
+            continue;
+        }
+        diff += Read_Ppm(ppm, name, w, h, ReadScreen);
+        if (orientation == LANDSCAPE || orientation == (LANDSCAPE | LCD_MIRROR))
+            continue;
+        memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+        LCD_Clear(Black);
+        if (LCD_PutImage(0, 0, bmp))
+        {
+            printf("  %s: LCD_PutImage failed\n", name);
+            diff++;
+        }
+        diff += Check_Gram(name, Expected);
+    }
+    LCD_Init(PORTRAIT);
+    remove(bmp);
+    remove(ppm);
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Points_Random
+* Description    : Random point set of the points case
+* Input          : - seed: sequence
+*                  - w, h: screen size
+* Output         : - Points, PointColors: the set
+*                  - seed: next state
+* Return         : number of points
+* Attention      : Runs along x that end on the right edge, points drawn
+*                  twice in other colors, and points off the screen, some
+*                  of them at negative coordinates
+*******************************************************************************/
+static unsigned int Points_Random(unsigned int *seed, int w, int h)
+{
+    unsigned int n = 0, len, i, max = Check_Rand(seed) % POINTS_MAX + 1;
+    int x, y;
+
+    while (n < max)
+    {
+        x = (int)(Check_Rand(seed) % (w + 40)) - 20;
+        y = (int)(Check_Rand(seed) % (h + 40)) - 20;
+        switch (Check_Rand(seed) % 4)
+        {
+        case 0:                         /* a run to the right edge */
+            x = w - 1 - Check_Rand(seed) % 20;
+            /* fall through */
+        case 1:                         /* a run along x */
+            len = Check_Rand(seed) % 40 + 1;
+            break;
+        case 2:                         /* a point drawn earlier, again */
+            if (n)
+            {
+                i = Check_Rand(seed) % n;
+                x = (short)Points[i].x;
+                y = (short)Points[i].y;
+            }
+            len = 1;
+            break;
+        default:
+            len = 1;
+            break;
+        }
+        for (i = 0; i < len && n < max; i++, n++)
+        {
+            Points[n].x = (unsigned short)(x + i);
+            Points[n].y = (unsigned short)y;
+            PointColors[n] = (unsigned short)Check_Rand(seed);
+        }
+    }
+    return n;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_Points
+* Description    : LCD_SetPoints and LCD_SetPointsColors give the GRAM of
+*                  the same points drawn one by one with LCD_SetPoint, in
+*                  every orientation, with and without a clip or a viewport
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : The one by one drawing draws the points in array order,
+*                  so a point drawn twice ends in its last color
+*******************************************************************************/
+static int Check_Points(void)
+{
+    unsigned int seed = 17, n, i;
+    char name[64];
+    int k, r, pass, orientation, clip, diff = 0;
+
+    for (k = 0; k < ORIENTATIONS; k++)
+    {
+        orientation = Orientations[k];
+        LCD_Init(orientation);
+        for (r = 0; r < POINTS_ROUNDS; r++)
+        {
+            n = Points_Random(&seed, LCD_GetWidth(), LCD_GetHeight());
+            clip = r / 2 % 3;
+            for (pass = 0; pass < 2; pass++)
+            {
+                LCD_Clear(Black);
+                if (clip == 1)
+                    LCD_PushClip(15, 25, 90, 70);
+                else if (clip == 2)
+                    LCD_PushViewport(-10, 20, 120, 60);
+                if (!pass)
+                    for (i = 0; i < n; i++)
+                        LCD_SetPoint(Points[i].x, Points[i].y, r & 1 ? PointColors[i] : Cyan);
+                else if (r & 1)
+                    LCD_SetPointsColors(Points, PointColors, n);
+                else
+                    LCD_SetPoints(Points, n, Cyan);
+                if (clip)
+                    LCD_PopClip();
+                if (!pass)
+                    memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+            }
+            sprintf(name, "orientation %d, %u points%s%s", orientation, n,
+                    r & 1 ? " in colors" : "", clip == 1 ? ", clip" : clip == 2 ? ", viewport" : "");
+            diff += Check_Gram(name, Expected);
+        }
+    }
+    LCD_Init(PORTRAIT);
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Bmp_Put
+* Description    : Little endian field of a BMP being written
+* Input          : - p: first byte
+*                  - v: value
+*                  - n: bytes
+* Output         : - p: field
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Bmp_Put(unsigned char *p, unsigned long v, int n)
+{
+    int k;
+
+    for (k = 0; k < n; k++)
+        p[k] = v >> (8 * k) & 0xFF;
+}
+
+
+/*******************************************************************************
+* Function Name  : Bmp_Mask
+* Description    : Mask of a channel of a 16 or 32 bits format
+* Input          : - fmt: format
+*                  - c: 0 red, 1 green, 2 blue
+* Output         : None
+* Return         : mask in the pixel
+* Attention      : Without bitfields 5-5-5 for 16 bits, 8-8-8 for 32
+*******************************************************************************/
+static unsigned long Bmp_Mask(const BmpCheck *fmt, int c)
+{
+    if (fmt->bitfields)
+        return fmt->mask[c];
+    return fmt->bpp == 16 ? 0x1FUL << (10 - 5 * c) : 0xFFUL << (16 - 8 * c);
+}
+
+
+/*******************************************************************************
+* Function Name  : Bmp_Channel
+* Description    : 8 bits channel as a 16 or 32 bits format stores it, and
+*                  as it is read back
+* Input          : - fmt: format
+*                  - c: 0 red, 1 green, 2 blue
+*                  - v: 8 bits value
+* Output         : - back: the 8 bits read back, may be 0
+* Return         : bits of the channel in the pixel
+* Attention      : A narrow channel keeps the high bits of v; a wide one
+*                  gets v in its high bits and junk in the low ones, which
+*                  the reader drops
+*******************************************************************************/
+static unsigned long Bmp_Channel(const BmpCheck *fmt, int c, int v, unsigned char *back)
+{
+    unsigned long mask = Bmp_Mask(fmt, c), field;
+    int shift, bits;
+
+    for (shift = 0; !(mask >> shift & 1); shift++)
+        ;
+    for (bits = 0; shift + bits < 32 && mask >> (shift + bits) & 1; bits++)
+        ;
+    if (bits < 8)
+    {
+        field = v >> (8 - bits);
+        if (back) *back = (unsigned char)(field << (8 - bits));
+    }
+    else
+    {
+        field = (unsigned long)v << (bits - 8) | (v * 7 & ((1UL << (bits - 8)) - 1));
+        if (back) *back = (unsigned char)v;
+    }
+    return field << shift;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_Bmp
+* Description    : Build a BMP file in memory and write it
+* Input          : - path: file
+*                  - fmt: format
+*                  - w, h: size
+*                  - rgb: w * h * 3 bytes red, green, blue, top line first;
+*                    at most 2^bpp and BMP_COLORS_MAX colors for a palette
+*                  - topDown: 1 to store the lines top down
+*                  - cut: bytes of the file written, 0 all of them
+* Output         : None
+* Return         : 1 success, 0 fail
+* Attention      : Lines padded to 4 bytes. The palette holds the colors of
+*                  the image, in the order met, and is counted in the 40 and
+*                  108 bytes headers; OS/2 gets the whole palette
+*******************************************************************************/
+static int Check_Bmp(const char *path, const BmpCheck *fmt, int w, int h, const unsigned char *rgb,
+                     int topDown, long cut)
+{
+    unsigned char palette[BMP_COLORS_MAX][3], *line;
+    int stride = (w * fmt->bpp + 31) / 32 * 4, entry = fmt->header == 12 ? 3 : 4;
+    int colors = 0, slots = 0, offset, x, y, k, i, c, ok;
+    unsigned long v;
+    const unsigned char *p;
+    FILE *f;
+
+    /* palette of the image */
+    if (fmt->bpp <= 8)
+    {
+        for (i = 0; i < w * h; i++)
+        {
+            for (c = 0; c < colors && memcmp(palette[c], rgb + 3 * i, 3); c++)
+                ;
+            if (c == colors)
+            {
+                if (colors == BMP_COLORS_MAX || colors == 1 << fmt->bpp)
+                    return 0;
+                memcpy(palette[colors++], rgb + 3 * i, 3);
+            }
+        }
+        slots = fmt->header == 12 ? 1 << fmt->bpp : colors;
+    }
+    offset = 14 + fmt->header + (fmt->header == 40 && fmt->bitfields ? 12 : 0) + slots * entry;
+    if (offset + stride * h > BMP_FILE_MAX)
+        return 0;
+    memset(BmpFile, 0, offset + stride * h);
+
+    BmpFile[0] = 'B';
+    BmpFile[1] = 'M';
+    Bmp_Put(BmpFile + 2, offset + stride * h, 4);
+    Bmp_Put(BmpFile + 10, offset, 4);
+    Bmp_Put(BmpFile + 14, fmt->header, 4);
+    if (fmt->header == 12)
+    {
+        Bmp_Put(BmpFile + 18, w, 2);
+        Bmp_Put(BmpFile + 20, h, 2);
+        Bmp_Put(BmpFile + 22, 1, 2);
+        Bmp_Put(BmpFile + 24, fmt->bpp, 2);
+    }
+    else
+    {
+        Bmp_Put(BmpFile + 18, w, 4);
+        Bmp_Put(BmpFile + 22, topDown ? -h : h, 4);
+        Bmp_Put(BmpFile + 26, 1, 2);
+        Bmp_Put(BmpFile + 28, fmt->bpp, 2);
+        Bmp_Put(BmpFile + 30, fmt->bitfields ? 3 : 0, 4);
+        Bmp_Put(BmpFile + 34, stride * h, 4);
+        Bmp_Put(BmpFile + 46, colors, 4);
+        if (fmt->bitfields)
+            for (c = 0; c < 3; c++)
+                Bmp_Put(BmpFile + 54 + 4 * c, fmt->mask[c], 4);
+    }
+    for (c = 0; c < colors; c++)
+    {
+        k = 14 + fmt->header + c * entry;
+        BmpFile[k] = palette[c][2];
+        BmpFile[k + 1] = palette[c][1];
+        BmpFile[k + 2] = palette[c][0];
+    }
+
+    for (y = 0; y < h; y++)
+    {
+        line = BmpFile + offset + (topDown ? y : h - 1 - y) * stride;
+        for (x = 0; x < w; x++)
+        {
+            p = rgb + (y * w + x) * 3;
+            switch (fmt->bpp)
+            {
+            case 1: case 4: case 8:
+                for (c = 0; memcmp(palette[c], p, 3); c++)
+                    ;
+                k = x * fmt->bpp;
+                line[k / 8] |= c << (8 - fmt->bpp - k % 8);
+                break;
+            case 24:
+                line[3 * x] = p[2];
+                line[3 * x + 1] = p[1];
+                line[3 * x + 2] = p[0];
+                break;
+            default:
+                v = Bmp_Channel(fmt, 0, p[0], 0) | Bmp_Channel(fmt, 1, p[1], 0) | Bmp_Channel(fmt, 2, p[2], 0);
+                Bmp_Put(line + x * fmt->bpp / 8, v, fmt->bpp / 8);
+                break;
+            }
+        }
+    }
+
+    f = fopen(path, "wb");
+    if (!f)
+        return 0;
+    k = offset + stride * h;
+    if (cut && cut < k)
+        k = cut;
+    ok = fwrite(BmpFile, 1, k, f) == (size_t)k;
+    return fclose(f) == 0 && ok;
+}
+
+
+/*******************************************************************************
+* Function Name  : Landscape_Char
+* Description    : Character drawn point by point as the first driver did
+*                  in LANDSCAPE
+* Input          : - Xpos, Ypos: position
+*                  - ch: character
+*                  - fg, bg: colors
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Landscape_Char(unsigned short Xpos, unsigned short Ypos, char ch, unsigned short fg, unsigned short bg)
+{
+    unsigned char glyph[16];
+    int i, j;
+
+    GetASCIICode(glyph, (unsigned char)ch);
+    for (i = 0; i < 16; i++)
+        for (j = 0; j < 8; j++)
+            LCD_SetPoint(Ypos - i, Xpos + j, (glyph[i] >> (7 - j)) & 1 ? fg : bg);
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_Landscape
+* Description    : LANDSCAPE keeps the layout of the first driver: drawing
+*                  in GRAM coordinates, characters and BMP images turned
+*                  with the origin in the lower left corner
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : The expected pixels are drawn one by one with the
+*                  formulas of the first driver
+*******************************************************************************/
+static int Check_Landscape(void)
+{
+    static const short chars[][2] = { { 0, 0 }, { 100, 200 }, { 310, 230 }, { 315, 100 }, { 50, 245 } };
+    static unsigned char rgb[13 * 7 * 3];
+    char path[] = "/tmp/checkXXXXXX";
+    const char *text = "Landscape";
+    int k, i, x, y, fd, diff = 0;
+
+    LCD_Init(LANDSCAPE);
+    if (LCD_GetWidth() != MAX_X || LCD_GetHeight() != MAX_Y)
+    {
+        printf("  LANDSCAPE is %dx%d, expected %dx%d\n", LCD_GetWidth(), LCD_GetHeight(), MAX_X, MAX_Y);
+        diff++;
+    }
+
+    /* characters, partly off the GRAM too, and through a viewport */
+    LCD_Clear(Blue);
+    for (k = 0; k < (int)(sizeof(chars) / sizeof(chars[0])); k++)
+        Landscape_Char(chars[k][0], chars[k][1], 'A' + k, White, Red);
+    for (i = 0; text[i]; i++)
+        Landscape_Char(20 + 8 * i, 120, text[i], Yellow, Black);
+    LCD_PushViewport(30, 40, 100, 200);
+    Landscape_Char(60, 50, 'v', Green, Black);
+    LCD_PopClip();
+    memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+    LCD_Clear(Blue);
+    for (k = 0; k < (int)(sizeof(chars) / sizeof(chars[0])); k++)
+        PutChar(chars[k][0], chars[k][1], 'A' + k, White, Red);
+    LCD_Text(20, 120, (char *)text, Yellow, Black);
+    LCD_PushViewport(30, 40, 100, 200);
+    PutChar(60, 50, 'v', Green, Black);
+    LCD_PopClip();
+    diff += Check_Gram("characters", Expected);
+
+    /* a 13x7 image, lines padded, bottom up and top down, once partly off */
+    for (i = 0; i < 13 * 7 * 3; i++)
+        rgb[i] = (unsigned char)(i * 37 + 11);
+    fd = mkstemp(path);
+    if (fd < 0)
+        return diff + 1;
+    close(fd);
+    LCD_Clear(Black);
+    for (y = 0; y < 7; y++)
+    {
+        for (x = 0; x < 13; x++)
+        {
+            i = ((6 - y) * 13 + x) * 3;        /* line y from the bottom */
+            LCD_SetPoint(100 + y, 50 + x, RGB565CONVERT(rgb[i], rgb[i + 1], rgb[i + 2]));
+            LCD_SetPoint(235 + y, 310 + x, RGB565CONVERT(rgb[i], rgb[i + 1], rgb[i + 2]));
+        }
+    }
+    memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+    for (k = 0; k < 2; k++)
+    {
+        LCD_Clear(Black);
+        if (!Check_Bmp(path, &BmpFormats[0], 13, 7, rgb, k, 0) || LCD_PutImage(100, 50, path) || LCD_PutImage(235, 310, path))
+        {
+            printf("  image %s: LCD_PutImage failed\n", k ? "top down" : "bottom up");
+            diff++;
+        }
+        diff += Check_Gram(k ? "image top down" : "image bottom up", Expected);
+    }
+    remove(path);
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Bmp_Image
+* Description    : Random image of the bmp case, and its colors as
+*                  LCD_PutImage must draw them
+* Input          : - fmt: format
+*                  - w, h: size
+*                  - seed: sequence
+* Output         : - rgb: w * h * 3 bytes, top line first
+*                  - expected: w * h RGB565 colors
+*                  - seed: next state
+* Return         : None
+* Attention      : Palette images use 2^bpp colors, BMP_COLORS_MAX at most
+*******************************************************************************/
+static void Bmp_Image(const BmpCheck *fmt, int w, int h, unsigned int *seed,
+                      unsigned char *rgb, unsigned short *expected)
+{
+    unsigned char colors[BMP_COLORS_MAX][3], back[3];
+    int i, c, n = fmt->bpp <= 8 && 1 << fmt->bpp < BMP_COLORS_MAX ? 1 << fmt->bpp : BMP_COLORS_MAX;
+
+    for (c = 0; c < n * 3; c++)
+        colors[c / 3][c % 3] = (unsigned char)Check_Rand(seed);
+    for (i = 0; i < w * h; i++)
+    {
+        if (fmt->bpp <= 8)
+            memcpy(rgb + 3 * i, colors[Check_Rand(seed) % n], 3);
+        else
+            for (c = 0; c < 3; c++)
+                rgb[3 * i + c] = (unsigned char)Check_Rand(seed);
+        if (fmt->bpp == 16 || fmt->bpp == 32)
+        {
+            for (c = 0; c < 3; c++)
+                Bmp_Channel(fmt, c, rgb[3 * i + c], &back[c]);
+            expected[i] = RGB565CONVERT(back[0], back[1], back[2]);
+        }
+        else
+            expected[i] = RGB565CONVERT(rgb[3 * i], rgb[3 * i + 1], rgb[3 * i + 2]);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_BmpFormats
+* Description    : BMP files of every format read by LCD_PutImage, built in
+*                  memory, against their pixels drawn one by one; and files
+*                  cut short, which must fail
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : Widths are not multiples of 4 or 8, so the lines are
+*                  padded and the packed formats end inside a byte; the
+*                  images are shown whole and through a viewport that cuts
+*                  all their sides
+*******************************************************************************/
+static int Check_BmpFormats(void)
+{
+    static const unsigned char sizes[][2] = { { 1, 1 }, { 3, 2 }, { 9, 5 }, { 13, 7 }, { 17, 3 } };
+    static unsigned char rgb[17 * 7 * 3];
+    static unsigned short expected[17 * 7];
+    char path[] = "/tmp/checkXXXXXX", name[80];
+    unsigned int seed = 3;
+    int f, k, t, x, y, w, h, stride, fd, diff = 0;
+    const BmpCheck *fmt;
+
+    fd = mkstemp(path);
+    if (fd < 0)
+        return 1;
+    close(fd);
+    for (f = 0; f < (int)(sizeof(BmpFormats) / sizeof(BmpFormats[0])); f++)
+    {
+        fmt = &BmpFormats[f];
+        for (k = 0; k < (int)(sizeof(sizes) / sizeof(sizes[0])); k++)
+        {
+            w = sizes[k][0];
+            h = sizes[k][1];
+            Bmp_Image(fmt, w, h, &seed, rgb, expected);
+            for (t = 0; t < (fmt->header == 12 ? 1 : 2); t++)
+            {
+                LCD_Clear(Black);
+                for (y = 0; y < h; y++)
+                    for (x = 0; x < w; x++)
+                        LCD_SetPoint(5 + x, 7 + y, expected[y * w + x]);
+                LCD_PushViewport(20, 30, 10, 4);
+                for (y = 0; y < h; y++)
+                    for (x = 0; x < w; x++)
+                        LCD_SetPoint(x - 3, y - 2, expected[y * w + x]);
+                LCD_PopClip();
+                memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+
+                sprintf(name, "%s %dx%d %s", fmt->name, w, h, t ? "top down" : "bottom up");
+                LCD_Clear(Black);
+                if (!Check_Bmp(path, fmt, w, h, rgb, t, 0) || LCD_PutImage(5, 7, path))
+                {
+                    printf("  %s: LCD_PutImage failed\n", name);
+                    diff++;
+                }
+                LCD_PushViewport(20, 30, 10, 4);
+                if (LCD_PutImage((unsigned short)-3, (unsigned short)-2, path))
+                {
+                    printf("  %s: LCD_PutImage in the viewport failed\n", name);
+                    diff++;
+                }
+                LCD_PopClip();
+                diff += Check_Gram(name, Expected);
+            }
+        }
+    }
+
+    /* cut in the fourth line of the file: its first three are the bottom
+       lines of the image, drawn before the read fails */
+    fmt = &BmpFormats[0];
+    stride = (13 * 3 + 3) & ~3;
+    Bmp_Image(fmt, 13, 7, &seed, rgb, expected);
+    LCD_Clear(Black);
+    for (y = 4; y < 7; y++)
+        for (x = 0; x < 13; x++)
+            LCD_SetPoint(5 + x, 7 + y, expected[y * 13 + x]);
+    memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+    LCD_Clear(Black);
+    if (!Check_Bmp(path, fmt, 13, 7, rgb, 0, 54 + 3 * stride + 5) || LCD_PutImage(5, 7, path) != -1)
+    {
+        printf("  file cut short: LCD_PutImage did not fail\n");
+        diff++;
+    }
+    diff += Check_Gram("file cut short", Expected);
+    LCD_Init(LANDSCAPE);
+    if (LCD_PutImage(5, 7, path) != -1)
+    {
+        printf("  file cut short in LANDSCAPE: LCD_PutImage did not fail\n");
+        diff++;
+    }
+    LCD_Init(PORTRAIT);
+    Bmp_Image(&BmpFormats[3], 13, 7, &seed, rgb, expected);
+    if (!Check_Bmp(path, &BmpFormats[3], 13, 7, rgb, 0, 14 + 40 + 10) || LCD_PutImage(5, 7, path) != -1)
+    {
+        printf("  palette cut short: LCD_PutImage did not fail\n");
+        diff++;
+    }
+    remove(path);
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Count_Bytes
+* Description    : Count the LCD transfer of a Count_Transport call
+* Input          : - head, headLen: first bytes
+*                  - buf, len: next bytes, may be 0
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Count_Bytes(const char *head, unsigned int headLen, const char *buf, unsigned int len)
+{
+    unsigned int n = headLen + len;
+
+    if (Count.cs != LCD_CS_LCD || !n)
+        return;
+    if ((unsigned char)head[0] == 0x70 && n == 3)
+    {
+        Count.index = (unsigned char)(headLen > 2 ? head[2] : buf[2 - headLen]);
+        Count.windows += Count.index == 0x22;
+    }
+    else if ((unsigned char)head[0] == 0x72 && Count.index == 0x22)
+    {
+        Count.bursts++;
+        Count.pixels += (n - 1) / 2;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Count_Select ... Count_Write
+* Description    : LCD_EmuTransport calls that also count into Count
+* Input          : See LCD_Transport
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Count_Select(void *ctx, unsigned char cs, unsigned short divider)
+{
+    Count.cs = cs;
+    LCD_EmuTransport.spiSelect(ctx, cs, divider);
+}
+
+
+static void Count_Transfer(void *ctx, char *buf, unsigned int len)
+{
+    Count_Bytes(buf, len, 0, 0);
+    LCD_EmuTransport.spiTransfer(ctx, buf, len);
+}
+
+
+static void Count_Write(void *ctx, const char *head, unsigned int headLen, const char *buf, unsigned int len)
+{
+    Count_Bytes(head, headLen, buf, len);
+    LCD_EmuTransport.spiWrite(ctx, head, headLen, buf, len);
+}
+
+
+/*******************************************************************************
+* Function Name  : Text_Flush
+* Description    : TM_Flush of the text mode case against the cells, windows
+*                  and bursts it should take
+* Input          : - name: step
+*                  - cells: cells TM_Flush should return
+*                  - windows, bursts: GRAM windows and transfers it should
+*                    send
+* Output         : None
+* Return         : number of differences
+* Attention      : Every cell drawn is visible: 128 pixels each
+*******************************************************************************/
+static int Text_Flush(const char *name, unsigned int cells, unsigned long windows, unsigned long bursts)
+{
+    unsigned int drawn;
+
+    memset(&Count, 0, sizeof(Count));
+    Count.cs = LCD_CS_LCD;
+    drawn = TM_Flush(&Text);
+    if (drawn == cells && Count.windows == windows && Count.bursts == bursts && Count.pixels == cells * 128UL)
+        return 0;
+    printf("  %s: %u cells, %lu windows, %lu bursts, %lu pixels, expected %u, %lu, %lu, %lu\n",
+           name, drawn, Count.windows, Count.bursts, Count.pixels, cells, windows, bursts, cells * 128UL);
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_TextMode
+* Description    : TM_Flush sends the changed cells only, a run of them on a
+*                  row in one window, and leaves the GRAM a full redraw of
+*                  the grid gives
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : The grid is drawn on a panel of its own, through a
+*                  transport counting its bus traffic; a row of 30 cells is
+*                  3840 pixels, two bursts
+*******************************************************************************/
+static int Check_TextMode(void)
+{
+    EmuPanel *panel, *prevPanel;
+    LCD_Device *dev, *prev;
+    int diff = 0;
+
+    CountTransport = LCD_EmuTransport;
+    CountTransport.name = "count";
+    CountTransport.spiSelect = Count_Select;
+    CountTransport.spiTransfer = Count_Transfer;
+    CountTransport.spiWrite = Count_Write;
+    panel = LCD_EmuCreate();
+    dev = panel ? LCD_DeviceOpen(&CountTransport, panel) : 0;
+    if (!dev)
+    {
+        printf("  can't open a panel\n");
+        if (panel)
+            LCD_EmuDestroy(panel);
+        return 1;
+    }
+    prev = LCD_Select(dev);
+    LCD_Reset();
+    LCD_Init(PORTRAIT);
+
+    TM_Init(&Text, 0, 0, White, Blue);
+    diff += Text_Flush("first flush", TM_ROWS * TM_COLS, TM_ROWS, 2 * TM_ROWS);
+    diff += Text_Flush("nothing changed", 0, 0, 0);
+
+    TM_Put(&Text, 3, 2, 'A', Yellow, Blue);
+    TM_Put(&Text, 4, 2, 'B', Yellow, Blue);
+    TM_Put(&Text, 10, 2, 'C', Yellow, Blue);
+    TM_Put(&Text, 0, 5, 'x', Red, Black);
+    TM_Put(&Text, TM_COLS, 5, 'y', Red, Black);
+    TM_Put(&Text, 0, TM_ROWS, 'z', Red, Black);
+    diff += Text_Flush("TM_Put", 4, 3, 3);
+
+    TM_Put(&Text, 3, 2, 'A', Yellow, Blue);
+    TM_Put(&Text, 7, 9, ' ', Green, Blue);
+    TM_Put(&Text, 8, 9, '\n', Green, Blue);
+    diff += Text_Flush("TM_Put, same pixels", 0, 0, 0);
+
+    TM_Put(&Text, 4, 2, 'B', Green, Blue);
+    TM_Put(&Text, 10, 2, 'C', Yellow, Red);
+    diff += Text_Flush("TM_Put, colors only", 2, 2, 2);
+
+    if (TM_Print(&Text, TM_COLS - 5, 7, "Hello, world", Cyan, Black) != 5)
+    {
+        printf("  TM_Print did not stop at the end of the row\n");
+        diff++;
+    }
+    TM_Print(&Text, 0, 7, "ab", Cyan, Black);
+    TM_Print(&Text, 1, 11, "0123456789", Magenta, Blue);
+    TM_Print(&Text, 3, 11, "23", Magenta, Blue);
+    diff += Text_Flush("TM_Print", 5 + 2 + 10, 3, 3);
+
+    /* the same cells drawn whole on the default panel */
+    LCD_Select(prev);
+    TextFull = Text;
+    TM_Invalidate(&TextFull);
+    LCD_Clear(Black);
+    TM_Flush(&TextFull);
+    memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+    prevPanel = LCD_EmuSelect(panel);
+    diff += Check_Gram("against a full redraw", Expected);
+    LCD_EmuSelect(prevPanel);
+    LCD_Select(dev);
+
+    TM_Invalidate(&Text);
+    diff += Text_Flush("TM_Invalidate", TM_ROWS * TM_COLS, TM_ROWS, 2 * TM_ROWS);
+    TM_Print(&Text, 0, 0, "abc", Black, White);
+    TM_Invalidate(&Text);
+    diff += Text_Flush("TM_Print and TM_Invalidate", TM_ROWS * TM_COLS, TM_ROWS, 2 * TM_ROWS);
+
+    LCD_Select(prev);
+    LCD_DeviceClose(dev);
+    LCD_EmuDestroy(panel);
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Blit_Mix
+* Description    : Blend two RGB565 colors channel by channel, as the
+*                  scaler's kernels do
+* Input          : - a, b: colors
+*                  - k: weight of b, 0 to 256
+* Output         : None
+* Return         : RGB565 color
+* Attention      : None
+*******************************************************************************/
+static unsigned short Blit_Mix(int a, int b, int k)
+{
+    int r, g, bl;
+
+    r = (a >> 11) + ((((b >> 11) - (a >> 11)) * k) >> 8);
+    g = ((a >> 5) & 0x3F) + (((((b >> 5) & 0x3F) - ((a >> 5) & 0x3F)) * k) >> 8);
+    bl = (a & 0x1F) + ((((b & 0x1F) - (a & 0x1F)) * k) >> 8);
+    return (unsigned short)(r << 11 | g << 5 | bl);
+}
+
+
+/*******************************************************************************
+* Function Name  : Blit_Sample
+* Description    : Color of one destination pixel of a scaled copy, from
+*                  the sampling position computed in floating point
+* Input          : - src: source rectangle, inside BlitSource
+*                  - dw, dh: destination size
+*                  - dx, dy: pixel in the destination rectangle
+*                  - filter: BLIT_NEAREST or BLIT_BILINEAR, | BLIT_FLIP_X
+*                    | BLIT_FLIP_Y
+* Output         : None
+* Return         : RGB565 color
+* Attention      : Pixel centers are sampled; bilinear clamps at the edges
+*                  of the source rectangle
+*******************************************************************************/
+static unsigned short Blit_Sample(const BlitRect *src, int dw, int dh, int dx, int dy, unsigned int filter)
+{
+    const unsigned short *line0, *line1;
+    double u = (dx + 0.5) * src->w / dw, v = (dy + 0.5) * src->h / dh;
+    int a, b, c, d, fx, fy;
+
+    if (!(filter & BLIT_BILINEAR))
+    {
+        a = (int)u < src->w - 1 ? (int)u : src->w - 1;
+        c = (int)v < src->h - 1 ? (int)v : src->h - 1;
+        if (filter & BLIT_FLIP_X) a = src->w - 1 - a;
+        if (filter & BLIT_FLIP_Y) c = src->h - 1 - c;
+        return BlitSource[(src->y + c) * BLIT_STRIDE + src->x + a];
+    }
+    u = u > 0.5 ? u - 0.5 : 0;
+    v = v > 0.5 ? v - 0.5 : 0;
+    a = (int)u;
+    c = (int)v;
+    fx = (int)((u - a) * 256);
+    fy = (int)((v - c) * 256);
+    if (a >= src->w - 1) { a = src->w - 1; fx = 0; }
+    if (c >= src->h - 1) { c = src->h - 1; fy = 0; }
+    b = fx ? a + 1 : a;
+    d = fy ? c + 1 : c;
+    if (filter & BLIT_FLIP_X) { a = src->w - 1 - a; b = src->w - 1 - b; }
+    if (filter & BLIT_FLIP_Y) { c = src->h - 1 - c; d = src->h - 1 - d; }
+    line0 = BlitSource + (src->y + c) * BLIT_STRIDE + src->x;
+    line1 = BlitSource + (src->y + d) * BLIT_STRIDE + src->x;
+    return Blit_Mix(Blit_Mix(line0[a], line0[b], fx), Blit_Mix(line1[a], line1[b], fx), fy);
+}
+
+
+/*******************************************************************************
+* Function Name  : Blit_Expected
+* Description    : Draw the expected screen of a scaled copy straight
+*                  through a window, and keep the GRAM as the expected one
+* Input          : - src: source rectangle, already clipped to the image
+*                  - dst: destination rectangle
+*                  - filter: as LCD_BlitScaled
+*                  - vx, vy, vw, vh: part of the screen drawn, the viewport
+*                  - back: color of the rest of the screen
+* Output         : None
+* Return         : None
+* Attention      : dst is relative to vx, vy
+*******************************************************************************/
+static void Blit_Expected(const BlitRect *src, const BlitRect *dst, unsigned int filter,
+                          int vx, int vy, int vw, int vh, unsigned short back)
+{
+    int w = LCD_GetWidth(), h = LCD_GetHeight();
+    int x, y, dx, dy;
+
+    for (y = 0; y < h; y++)
+    {
+        for (x = 0; x < w; x++)
+        {
+            dx = x - vx - dst->x;
+            dy = y - vy - dst->y;
+            if (x >= vx && x < vx + vw && y >= vy && y < vy + vh &&
+                dx >= 0 && dx < dst->w && dy >= 0 && dy < dst->h)
+                BlitScreen[y * w + x] = Blit_Sample(src, dst->w, dst->h, dx, dy, filter);
+            else
+                BlitScreen[y * w + x] = back;
+        }
+    }
+    LCD_SetWindow(0, 0, w, h);
+    LCD_WritePixels(BlitScreen, w * h);
+    memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_BlitScaled
+* Description    : Scaled, cropped and flipped copies, nearest and bilinear,
+*                  against the pixels sampled in floating point, in three
+*                  orientations and through a viewport
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : The source rectangles go past the image, the destination
+*                  ones past the screen, to test the clipping of both
+*******************************************************************************/
+static int Check_BlitScaled(void)
+{
+    static const short rects[][8] =
+    {
+        /* source x, y, w, h, destination x, y, w, h */
+        { 0, 0, BLIT_W, BLIT_H,     0, 0, BLIT_W, BLIT_H },
+        { 0, 0, BLIT_W, BLIT_H,     10, 10, 200, 150 },
+        { 5, 7, 40, 30,             -20, -10, 300, 260 },
+        { 0, 0, BLIT_W, BLIT_H,     30, 40, 33, 21 },
+        { -5, -5, 200, 200,         0, 0, 240, 320 },
+        { 10, 10, 1, 1,             5, 5, 50, 50 },
+        { 0, 0, BLIT_W, BLIT_H,     200, 300, 100, 100 },
+        { 3, 2, 80, 60,             1, 2, 239, 150 },
+    };
+    static const unsigned int filters[] =
+    {
+        BLIT_NEAREST, BLIT_BILINEAR,
+        BLIT_NEAREST | BLIT_FLIP_X, BLIT_BILINEAR | BLIT_FLIP_X,
+        BLIT_NEAREST | BLIT_FLIP_Y, BLIT_BILINEAR | BLIT_FLIP_Y,
+        BLIT_NEAREST | BLIT_FLIP_X | BLIT_FLIP_Y, BLIT_BILINEAR | BLIT_FLIP_X | BLIT_FLIP_Y,
+    };
+    BlitImage image = { BlitSource, BLIT_W, BLIT_H, BLIT_STRIDE };
+    BlitRect src, dst, clipped, whole = { 0, 0, BLIT_W, BLIT_H };
+    char name[64];
+    int x, y, t, f, k, orientation, diff = 0;
+
+    for (y = 0; y < BLIT_H; y++)
+        for (x = 0; x < BLIT_STRIDE; x++)
+            BlitSource[y * BLIT_STRIDE + x] = RGB565CONVERT((x * 13) & 255, (y * 29) & 255, ((x + y) * 7) & 255);
+
+    for (k = 0; k < ORIENTATIONS_TOP; k += 3)
+    {
+        orientation = Orientations[k];
+        LCD_Init(orientation);
+        for (t = 0; t < (int)(sizeof(rects) / sizeof(rects[0])); t++)
+        {
+            src.x = rects[t][0]; src.y = rects[t][1]; src.w = rects[t][2]; src.h = rects[t][3];
+            dst.x = rects[t][4]; dst.y = rects[t][5]; dst.w = rects[t][6]; dst.h = rects[t][7];
+            clipped = src;
+            if (clipped.x < 0) { clipped.w += clipped.x; clipped.x = 0; }
+            if (clipped.y < 0) { clipped.h += clipped.y; clipped.y = 0; }
+            if (clipped.x + clipped.w > BLIT_W) clipped.w = BLIT_W - clipped.x;
+            if (clipped.y + clipped.h > BLIT_H) clipped.h = BLIT_H - clipped.y;
+            for (f = 0; f < (int)(sizeof(filters) / sizeof(filters[0])); f++)
+            {
+                Blit_Expected(&clipped, &dst, filters[f], 0, 0, LCD_GetWidth(), LCD_GetHeight(), 0x1234);
+                LCD_Clear(0x1234);
+                LCD_BlitScaled(&image, &src, &dst, filters[f]);
+                sprintf(name, "orientation %d rectangle %d filter %02X", orientation, t, filters[f]);
+                diff += Check_Gram(name, Expected);
+            }
+        }
+    }
+
+    LCD_Init(PORTRAIT);
+    dst.x = -10; dst.y = -10; dst.w = 100; dst.h = 100;
+    Blit_Expected(&whole, &dst, BLIT_BILINEAR, 20, 30, 50, 40, Black);
+    LCD_Clear(Black);
+    LCD_PushViewport(20, 30, 50, 40);
+    LCD_BlitScaled(&image, 0, &dst, BLIT_BILINEAR);
+    LCD_ResetClip();
+    diff += Check_Gram("viewport", Expected);
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Blend_Layer
+* Description    : Fill a layer of the blend case with random pixels,
+*                  position, alpha and color key
+* Input          : - layer: layer
+*                  - pixels, map: its buffers, BLEND_W * BLEND_H
+*                  - seed: sequence
+* Output         : - layer: ready to add
+*                  - seed: next state
+* Return         : None
+* Attention      : About a quarter of the pixels are the key color; the
+*                  layer goes past the screen edges now and then
+*******************************************************************************/
+static void Blend_Layer(Layer *layer, unsigned short *pixels, unsigned char *map, unsigned int *seed)
+{
+    int i, w, h, mode;
+    unsigned short key;
+
+    w = Check_Rand(seed) % BLEND_W + 1;
+    h = Check_Rand(seed) % BLEND_H + 1;
+    key = (unsigned short)(Check_Rand(seed) << 1 ^ Check_Rand(seed));
+    for (i = 0; i < w * h; i++)
+    {
+        pixels[i] = Check_Rand(seed) % 4 ? (unsigned short)(Check_Rand(seed) << 1 ^ Check_Rand(seed)) : key;
+        map[i] = (unsigned char)Check_Rand(seed);
+    }
+    LCD_LayerInit(layer, pixels, w, h);
+    LCD_LayerMove(layer, Check_Rand(seed) % (MAX_X + 20) - 20, Check_Rand(seed) % (MAX_Y + 20) - 20);
+    mode = Check_Rand(seed) % 4;
+    LCD_LayerSetAlpha(layer, mode == 0 ? 255 : (unsigned char)Check_Rand(seed), mode == 3 ? map : 0);
+    LCD_LayerSetKey(layer, Check_Rand(seed) % 2, key);
+}
+
+
+/*******************************************************************************
+* Function Name  : Blend_Expected
+* Description    : Blend a layer over the expected screen, one pixel at a
+*                  time in plain C
+* Input          : - layer: layer
+* Output         : None
+* Return         : None
+* Attention      : Written from the description of the compositor, not from
+*                  its kernels: alpha v + (v >> 7) from the 8-bit alpha
+*                  scaled by the map, 0 for key colored pixels
+*******************************************************************************/
+static void Blend_Expected(const Layer *layer)
+{
+    int x, y, sx, sy, v, s;
+
+    for (sy = 0; sy < layer->h; sy++)
+    {
+        for (sx = 0; sx < layer->w; sx++)
+        {
+            x = layer->x + sx;
+            y = layer->y + sy;
+            if (x < 0 || x >= MAX_X || y < 0 || y >= MAX_Y)
+                continue;
+            s = layer->pixels[sy * layer->w + sx];
+            v = layer->alphaMap ? (layer->alphaMap[sy * layer->w + sx] * layer->alpha + 127) / 255 : layer->alpha;
+            if (layer->keyed && s == layer->key)
+                v = 0;
+            BlitScreen[y * MAX_X + x] = Blit_Mix(BlitScreen[y * MAX_X + x], s, v + (v >> 7));
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_LayerBlend
+* Description    : Random stacks of layers composed through the blending
+*                  kernel of the build, against the same blend computed one
+*                  pixel at a time
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : The widths and offsets are not multiples of the vector
+*                  length, so the vector loops and their plain C tails are
+*                  both covered; build with -DLAYER_SCALAR to check the
+*                  plain C kernel the same way
+*******************************************************************************/
+static int Check_LayerBlend(void)
+{
+    static unsigned short back[MAX_X * MAX_Y], pixels[2][BLEND_W * BLEND_H];
+    static unsigned char maps[2][BLEND_W * BLEND_H];
+    unsigned int seed = 42;
+    Layer bottom, layers[2];
+    char name[64];
+    int i, r, diff = 0;
+
+    for (i = 0; i < MAX_X * MAX_Y; i++)
+        back[i] = (unsigned short)(i * 2654435761u >> 16);
+    LCD_LayerInit(&bottom, back, MAX_X, MAX_Y);
+    for (r = 0; r < BLEND_ROUNDS; r++)
+    {
+        memcpy(BlitScreen, back, sizeof(back));
+        LCD_LayerAdd(&bottom);
+        for (i = 0; i < 2; i++)
+        {
+            Blend_Layer(&layers[i], pixels[i], maps[i], &seed);
+            LCD_LayerAdd(&layers[i]);
+            Blend_Expected(&layers[i]);
+        }
+        LCD_SetWindow(0, 0, MAX_X, MAX_Y);
+        LCD_WritePixels(BlitScreen, MAX_X * MAX_Y);
+        memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+        LCD_Clear(Black);
+        LCD_Compose();
+        sprintf(name, "%s kernel round %d", LCD_LayerKernel(), r);
+        diff += Check_Gram(name, Expected);
+        LCD_LayerRemove(&layers[1]);
+        LCD_LayerRemove(&layers[0]);
+        LCD_LayerRemove(&bottom);
+        LCD_Compose();
+    }
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Gesture_Record
+* Description    : Handler of the gesture case, append the letter of the
+*                  event to the record
+* Input          : - gs: recognizer, user the record
+*                  - event: event
+* Output         : None
+* Return         : None
+* Attention      : P press, R release, T tap, D double tap, L long press,
+*                  S drag start, G drag, E drag end, F fling
+*******************************************************************************/
+static void Gesture_Record(GsRecognizer *gs, const GsEvent *event)
+{
+    char *record = (char *)gs->user;
+    size_t n = strlen(record);
+
+    if (n < 31)
+    {
+        record[n] = "PRTDLSGEF"[event->type];
+        record[n + 1] = 0;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_Gesture
+* Description    : Scripts of touch samples and ticks fed to the gesture
+*                  recognizer, against the events each must give
+* Input          : None
+* Output         : None
+* Return         : number of scripts with other events
+* Attention      : Each timeout is tried at its limit and one microsecond
+*                  past it. The scripts start 1 s after 0, the recognizer
+*                  takes time 0 for no tap
+*******************************************************************************/
+static int Check_Gesture(void)
+{
+    static const GestureScript scripts[] =
+    {
+        { "tap at the limit", 0,
+          { { 1, 100, 100, 1 }, { 0, 0, 0, GS_TAP_US + 1 } }, "PRT" },
+        { "press too long for a tap", 0,
+          { { 1, 100, 100, 1 }, { 0, 0, 0, GS_TAP_US + 2 } }, "PR" },
+        { "tap moving in the slop", 0,
+          { { 1, 100, 100, 1 }, { 1, 100 + GS_SLOP, 100 - GS_SLOP, 100000 }, { 0, 0, 0, 200000 } }, "PRT" },
+        { "long press by tick", 0,
+          { { 1, 100, 100, 1 }, { GESTURE_TICK, 0, 0, GS_LONG_US }, { GESTURE_TICK, 0, 0, GS_LONG_US + 1 },
+            { 0, 0, 0, GS_LONG_US + 100000 } }, "P.L.R" },
+        { "long press by sample", 0,
+          { { 1, 100, 100, 1 }, { 1, 101, 100, GS_LONG_US + 1 }, { 0, 0, 0, GS_LONG_US + 2 } }, "PLR" },
+        { "drag and fling", 0,
+          { { 1, 100, 100, 1 }, { 1, 101 + GS_SLOP, 100, 10001 }, { 1, 120, 100, 20001 },
+            { 1, 120, 100, 30001 }, { 0, 0, 0, 40001 } }, "PSGREF" },
+        { "slow drag", 0,
+          { { 1, 100, 100, 1 }, { 1, 100, 101 + GS_SLOP, 100001 }, { 1, 100, 110, 200001 },
+            { 1, 100, 110, 300001 }, { GESTURE_TICK, 0, 0, GS_LONG_US + 100000 },
+            { 0, 0, 0, GS_LONG_US + 110000 } }, "PSG.RE" },
+        { "double tap at the limit", 0,
+          { { 1, 100, 100, 1 }, { 0, 0, 0, 50001 }, { 1, 100 + GS_DOUBLE_SLOP, 100, 50001 + GS_DOUBLE_US },
+            { 0, 0, 0, 100001 + GS_DOUBLE_US } }, "PRTPRD" },
+        { "second tap too late", 0,
+          { { 1, 100, 100, 1 }, { 0, 0, 0, 50001 }, { 1, 100, 100, 50002 + GS_DOUBLE_US },
+            { 0, 0, 0, 100001 + GS_DOUBLE_US } }, "PRTPRT" },
+        { "second tap too far", 0,
+          { { 1, 100, 100, 1 }, { 0, 0, 0, 50001 }, { 1, 100, 101 + GS_DOUBLE_SLOP, 100001 },
+            { 0, 0, 0, 150001 } }, "PRTPRT" },
+        { "exclusive tap", 1,
+          { { 1, 100, 100, 1 }, { 0, 0, 0, 50001 }, { GESTURE_TICK, 0, 0, 50001 + GS_DOUBLE_US },
+            { GESTURE_TICK, 0, 0, 50002 + GS_DOUBLE_US } }, "PR.T." },
+        { "exclusive double tap", 1,
+          { { 1, 100, 100, 1 }, { 0, 0, 0, 50001 }, { 1, 100, 100, 250001 }, { 0, 0, 0, 300001 },
+            { GESTURE_TICK, 0, 0, 1000001 } }, "PRPRD." },
+        { "exclusive tap then drag", 1,
+          { { 1, 100, 100, 1 }, { 0, 0, 0, 50001 }, { 1, 100, 100, 200001 }, { 1, 130, 100, 210001 },
+            { 0, 0, 0, 220001 } }, "PRPTSREF" },
+    };
+    const GestureStep *step;
+    GsRecognizer gs;
+    TouchSample sample;
+    char record[32];
+    int k, i, diff = 0;
+
+    for (k = 0; k < (int)(sizeof(scripts) / sizeof(scripts[0])); k++)
+    {
+        record[0] = 0;
+        GS_Init(&gs, Gesture_Record, scripts[k].exclusive);
+        gs.user = record;
+        for (i = 0; i < GESTURE_STEPS && scripts[k].steps[i].tUs; i++)
+        {
+            step = &scripts[k].steps[i];
+            if (step->pen == GESTURE_TICK)
+            {
+                GS_Tick(&gs, 1000000ULL + step->tUs);
+                strcat(record, ".");
+                continue;
+            }
+            sample.x = step->x;
+            sample.y = step->y;
+            sample.pen = step->pen;
+            sample.tUs = 1000000ULL + step->tUs;
+            GS_Feed(&gs, &sample);
+        }
+        if (strcmp(record, scripts[k].events))
+        {
+            if (!diff || Verbose)
+                printf("  %s: events %s, expected %s\n", scripts[k].name, record, scripts[k].events);
+            diff++;
+        }
+    }
+    return diff;
+}
+
+
+/*******************************************************************************
+* Function Name  : Ingest_CheckRun
+* Description    : IngestRun of the ingest case: append the values
+* Input          : - target: IngestCheck
+*                  - values, count, repeat: run
+* Output         : None
+* Return         : None
+* Attention      : Values past the room are counted, not stored
+*******************************************************************************/
+static void Ingest_CheckRun(void *target, const unsigned short *values, unsigned int count, int repeat)
+{
+    IngestCheck *c = (IngestCheck *)target;
+
+    for (; count; count--, c->done++)
+        if (c->done < c->n)
+            c->out[c->done] = repeat ? values[0] : *values++;
+}
+
+
+/*******************************************************************************
+* Function Name  : Ingest_Decode
+* Description    : Decode a payload in the ingest case
+* Input          : - encoding, w, h: rectangle
+*                  - data, words: payload
+*                  - out: room for w * h values
+* Output         : - out: values
+*                  - passed: number of values passed, may be more than w * h
+* Return         : LCD_IngestDecode result
+* Attention      : None
+*******************************************************************************/
+static int Ingest_Decode(unsigned short encoding, int w, int h, const unsigned short *data,
+                         unsigned int words, unsigned short *out, unsigned int *passed)
+{
+    IngestHeader head;
+    IngestCheck c;
+    int ok;
+
+    memset(&head, 0, sizeof(head));
+    head.encoding = encoding;
+    head.w = w;
+    head.h = h;
+    head.length = words * 2;
+    c.out = out;
+    c.done = 0;
+    c.n = w * h;
+    ok = LCD_IngestDecode(&head, data, Ingest_CheckRun, &c);
+    *passed = c.done;
+    return ok;
+}
+
+
+/*******************************************************************************
+* Function Name  : Check_Ingest
+* Description    : Rectangles of random runs encoded raw, run length and
+*                  XOR the previous frame, decoded as ingestd does, against
+*                  the pixels sent; and payloads cut short, too long or with
+*                  runs past the rectangle, which must be refused
+* Input          : None
+* Output         : None
+* Return         : number of differences
+* Attention      : The first two rectangles are the whole screen, in one
+*                  color then in random pixels: their runs are cut at
+*                  INGEST_RUN_MAX
+*******************************************************************************/
+static int Check_Ingest(void)
+{
+    static unsigned short sent[MAX_X * MAX_Y], pixels[MAX_X * MAX_Y], delta[MAX_X * MAX_Y];
+    static unsigned short out[MAX_X * MAX_Y], runs[INGEST_RLE_WORDS(MAX_X * MAX_Y) + 1];
+    static const unsigned short encodings[] = { INGEST_RAW, INGEST_RLE, INGEST_XOR };
+    static const struct
+    {
+        const char *name;
+        unsigned short words, data[8];
+        unsigned short passed;      /* pixels of the runs before the bad one */
+    } bad[] =
+    {
+        /* 5x1 rectangles */
+        { "repeat run without its pixel",   4, { 1, 1, 2, 0x8000 | 2 },     2 },
+        { "literal run one pixel short",    6, { 0x8000, 1, 3, 1, 2, 3 },   1 },
+        { "repeat run past w * h",          4, { 0, 1, 0x8000 | 4, 7 },     1 },
+        { "literal run past w * h",         7, { 5, 1, 2, 3, 4, 5, 6 },     0 },
+        { "runs short of w * h",            2, { 0x8000 | 3, 7 },           4 },
+        { "word after the runs",            3, { 0x8000 | 4, 7, 0 },        5 },
+        { "empty payload",                  0, { 0 },                       0 },
+    };
+    unsigned int seed = 7, words, measured, passed;
+    char name[64];
+    int r, e, i, k, x, y, w, h, len, mode, ok, diff = 0;
+    unsigned short color;
+
+    for (r = 0; r < INGEST_ROUNDS; r++)
+    {
+        if (r < 2)
+        {
+            x = y = 0;
+            w = MAX_X;
+            h = MAX_Y;
+        }
+        else
+        {
+            w = Check_Rand(&seed) % 120 + 1;
+            h = Check_Rand(&seed) % 80 + 1;
+            x = Check_Rand(&seed) % (MAX_X - w + 1);
+            y = Check_Rand(&seed) % (MAX_Y - h + 1);
+        }
+        /* runs of one color and of random pixels, some of them the
+           pixels sent before for XOR */
+        for (i = 0; i < w * h; i += len)
+        {
+            len = r > 1 ? Check_Rand(&seed) % 40 + 1 : w * h;
+            if (len > w * h - i)
+                len = w * h - i;
+            mode = r > 1 ? Check_Rand(&seed) % 3 : r;
+            color = (unsigned short)(Check_Rand(&seed) << 1 ^ Check_Rand(&seed));
+            for (k = 0; k < len; k++)
+            {
+                if (mode == 0)
+                    pixels[i + k] = color;
+                else if (mode == 1)
+                    pixels[i + k] = (unsigned short)(Check_Rand(&seed) << 1 ^ Check_Rand(&seed));
+                else
+                    pixels[i + k] = sent[(y + (i + k) / w) * MAX_X + x + (i + k) % w];
+            }
+        }
+        for (i = 0; i < w * h; i++)
+            delta[i] = pixels[i] ^ sent[(y + i / w) * MAX_X + x + i % w];
+
+        for (e = 0; e < 3; e++)
+        {
+            if (encodings[e] == INGEST_RAW)
+            {
+                memcpy(runs, pixels, w * h * sizeof(unsigned short));
+                words = w * h;
+            }
+            else
+            {
+                words = LCD_IngestRle(encodings[e] == INGEST_RLE ? pixels : delta, w * h, runs);
+                measured = LCD_IngestRle(encodings[e] == INGEST_RLE ? pixels : delta, w * h, 0);
+                if (words != measured || words > INGEST_RLE_WORDS((unsigned int)(w * h)))
+                {
+                    printf("  rectangle %d encoding %d: %u words, measured %u\n", r, encodings[e], words, measured);
+                    diff++;
+                }
+            }
+            ok = Ingest_Decode(encodings[e], w, h, runs, words, out, &passed);
+            if (encodings[e] == INGEST_XOR)
+                for (i = 0; i < w * h; i++)
+                    out[i] ^= sent[(y + i / w) * MAX_X + x + i % w];
+            sprintf(name, "rectangle %d %dx%d encoding %d", r, w, h, encodings[e]);
+            if (ok != 1 || memcmp(out, pixels, w * h * sizeof(unsigned short)))
+            {
+                if (!diff || Verbose)
+                    printf("  %s: decoded %s\n", name, ok == 1 ? "other pixels" : "as malformed");
+                diff++;
+            }
+            if (e && words > 1)
+            {
+                /* the same runs cut short and with a word more */
+                runs[words] = 0;
+                if (Ingest_Decode(encodings[e], w, h, runs, words - 1, out, &passed)
+                    || Ingest_Decode(encodings[e], w, h, runs, words + 1, out, &passed))
+                {
+                    if (!diff || Verbose)
+                        printf("  %s: runs cut short or too long decoded\n", name);
+                    diff++;
+                }
+            }
+        }
+        for (i = 0; i < w * h; i++)
+            sent[(y + i / w) * MAX_X + x + i % w] = pixels[i];
+    }
+
+    if (Ingest_Decode(INGEST_RAW, 5, 1, runs, 4, out, &passed) || Ingest_Decode(INGEST_RAW, 5, 1, runs, 6, out, &passed))
+    {
+        printf("  raw payload of the wrong size decoded\n");
+        diff++;
+    }
+    for (k = 0; k < (int)(sizeof(bad) / sizeof(bad[0])); k++)
+    {
+        ok = Ingest_Decode(INGEST_RLE, 5, 1, bad[k].data, bad[k].words, out, &passed);
+        if (ok || passed != bad[k].passed)
+        {
+            printf("  %s: %s, %u pixels passed, expected %u\n",
+                   bad[k].name, ok ? "decoded" : "refused", passed, bad[k].passed);
+            diff++;
+        }
+    }
+    return diff;
+}
+
+
+/* Cases, in the order they run */
+static const CheckCase Cases[] =
+{
+    { "scene_workers",  Check_SceneWorkers },
+    { "shadow",         Check_Shadow },
+    { "points",         Check_Points },
+    { "read_rect",      Check_ReadRect },
+    { "clip",           Check_Clip },
+    { "ui",             Check_Ui },
+    { "dividers",       Check_Dividers },
+    { "spi0",           Check_Spi0 },
+    { "landscape",      Check_Landscape },
+    { "bmp",            Check_BmpFormats },
+    { "devices",        Check_Devices },
+    { "shared_device",  Check_SharedDevice },
+    { "shared_sprite",  Check_SharedSprite },
+    { "shared_layers",  Check_SharedLayers },
+    { "shared_video",   Check_SharedVideo },
+    { "blit_scaled",    Check_BlitScaled },
+    { "layer_blend",    Check_LayerBlend },
+    { "gesture",        Check_Gesture },
+    { "ingest",         Check_Ingest },
+    { "text_mode",      Check_TextMode },
+};
+#define CHECK_CASES (int)(sizeof(Cases) / sizeof(Cases[0]))
+
+
+int main(int argc, char *argv[])
+{
+    int opt, i, j, diff, run, failed = 0;
+
+    while ((opt = getopt(argc, argv, "lv")) != -1)
+    {
+        switch (opt)
+        {
+        case 'l':
+            for (i = 0; i < CHECK_CASES; i++)
+                printf("%s\n", Cases[i].name);
+            return 0;
+        case 'v': Verbose = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-l] [-v] [case ...]\n", argv[0]);
+            return 1;
+        }
+    }
+    for (j = optind; j < argc; j++)
+    {
+        for (i = 0; i < CHECK_CASES && strcmp(Cases[i].name, argv[j]); i++)
+            ;
+        if (i == CHECK_CASES)
+        {
+            fprintf(stderr, "no case %s\n", argv[j]);
+            return 1;
+        }
+    }
+
+    if (!LCD_Open(&LCD_EmuTransport)) return 1;
+    LCD_Reset();
+    for (i = 0; i < CHECK_CASES; i++)
+    {
+        for (j = optind, run = optind == argc; j < argc && !run; j++)
+            run = !strcmp(Cases[i].name, argv[j]);
+        if (!run)
+            continue;
+        LCD_Init(PORTRAIT);
+        diff = Cases[i].run();
+        printf("%-16s %s", Cases[i].name, diff ? "FAIL" : "ok");
+        if (diff)
+            printf(", %d difference(s)", diff);
+        printf("\n");
+        failed += diff != 0;
+    }
+    LCD_Init(PORTRAIT);
+    LCD_Close();
+    return failed ? 1 : 0;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,187 @@
+/*******************************************************************************
+* Function Name  : main
+* Description    : Regression check of the C++ Display template on the
+*                  emulated panel
+*                  For every orientation, a Display on a panel of its own
+*                  and the C driver on the default panel draw the same
+*                  picture, the GRAMs are compared pixel by pixel
+* Input          : -v print every difference, default the first one per
+*                  orientation
+* Output         : None
+* Return         : 0 all orientations pass, 1 a difference
+* Compile/link   : gcc -DLCD_NO_BCM2835 -c lcd.c lcd_trace.c lcd_emu.c lcd_spi0.c
+*                  g++ -std=c++17 -DLCD_NO_BCM2835 -o check_display check_display.cpp lcd.o lcd_trace.o lcd_emu.o lcd_spi0.o -lrt -lm -lpthread
+* Execute        : ./check_display
+*******************************************************************************/
+/* Includes */
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include "lcd_display.hpp"
+extern "C" {
+#include "lcd_emu.h"
+}
+
+
+/* Defines */
+#define IMAGE_W 37                  /* RGB565 image, odd sizes */
+#define IMAGE_H 23
+#define RGB_W 10                    /* Rgb888 image */
+#define RGB_H 10
+
+
+/* Public declarations */
+static int Verbose;
+static unsigned short Image[IMAGE_W * IMAGE_H];
+static lcd::Rgb888 Rgb[RGB_W * RGB_H];
+static unsigned short Expected[MAX_X * MAX_Y];
+
+
+/*******************************************************************************
+* Function Name  : Display_Images
+* Description    : Fill the test images with fixed pseudo random colors
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Display_Images(void)
+{
+    int i;
+
+    for (i = 0; i < IMAGE_W * IMAGE_H; i++)
+        Image[i] = (unsigned short)(i * 2654435761u >> 16);
+    for (i = 0; i < RGB_W * RGB_H; i++)
+    {
+        Rgb[i].r = (unsigned char)(i * 7);
+        Rgb[i].g = (unsigned char)(i * 3);
+        Rgb[i].b = (unsigned char)(i * 11);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Display_Reference
+* Description    : Draw the picture with the C driver on the selected panel
+* Input          : - width, height: screen size in the orientation
+* Output         : None
+* Return         : None
+* Attention      : The clipped blits are drawn point by point, the C driver
+*                  has no clipped image call
+*******************************************************************************/
+static void Display_Reference(int width, int height)
+{
+    unsigned short rgb[RGB_W * RGB_H];
+    int x, y, i;
+
+    LCD_Clear(Blue);
+    LCD_FillRect(-5, 10, 50, 30, Red);
+    LCD_SetPoint(3, 4, Green);
+    LCD_SetWindow(20, 50, IMAGE_W, IMAGE_H);
+    LCD_WritePixels(Image, IMAGE_W * IMAGE_H);
+    for (y = 0; y < IMAGE_H; y++)
+    {
+        for (x = 0; x < IMAGE_W; x++)
+        {
+            LCD_SetPoint(x - 3, y - 2, Image[y * IMAGE_W + x]);
+            LCD_SetPoint(width - 10 + x, height - 5 + y, Image[y * IMAGE_W + x]);
+        }
+    }
+    for (i = 0; i < RGB_W * RGB_H; i++)
+        rgb[i] = RGB565CONVERT(Rgb[i].r, Rgb[i].g, Rgb[i].b);
+    LCD_SetWindow(100, 100, RGB_W, RGB_H);
+    LCD_WritePixels(rgb, RGB_W * RGB_H);
+    LCD_Text(200, 60, (char *)"Hello, Display", White, Black);
+}
+
+
+/*******************************************************************************
+* Function Name  : Display_Check
+* Description    : Draw the picture with a Display of one orientation on a
+*                  panel of its own, and with the C driver on the default
+*                  panel, and compare the GRAMs
+* Input          : Rotation: template argument, orientation of both
+* Output         : None
+* Return         : number of pixels that differ
+* Attention      : None
+*******************************************************************************/
+template <unsigned Rotation>
+static int Display_Check(void)
+{
+    EmuPanel *panel = LCD_EmuCreate();
+    lcd::Display<MAX_X, MAX_Y, Rotation, lcd::BusTransport> display(lcd::BusTransport(&LCD_EmuTransport, panel));
+    const unsigned short *gram;
+    int i, diff = 0;
+
+    LCD_EmuSelect(0);
+    LCD_Init(Rotation);
+    Display_Reference(LCD_GetWidth(), LCD_GetHeight());
+    memcpy(Expected, LCD_EmuGram(), sizeof(Expected));
+
+    display.Init();
+    display.Clear(Blue);
+    display.FillRect(-5, 10, 50, 30, Red);
+    display.SetPoint(3, 4, Green);
+    display.Blit(20, 50, IMAGE_W, IMAGE_H, Image);
+    display.Blit(-3, -2, IMAGE_W, IMAGE_H, Image);
+    display.Blit(display.width - 10, display.height - 5, IMAGE_W, IMAGE_H, Image);
+    display.Blit(100, 100, RGB_W, RGB_H, Rgb);
+    display.Text(200, 60, "Hello, Display", White, Black);
+
+    LCD_EmuSelect(panel);
+    gram = LCD_EmuGram();
+    for (i = 0; i < MAX_X * MAX_Y; i++)
+    {
+        if (gram[i] != Expected[i])
+        {
+            if (!diff || Verbose)
+                printf("  orientation %u: GRAM %d,%d is %04X, expected %04X\n",
+                       Rotation, i % MAX_X, i / MAX_X, gram[i], Expected[i]);
+            diff++;
+        }
+    }
+    LCD_EmuSelect(0);
+    LCD_EmuDestroy(panel);
+    printf("orientation %-4u %s", Rotation, diff ? "FAIL" : "ok");
+    if (diff)
+        printf(", %d difference(s)", diff);
+    printf("\n");
+    return diff;
+}
+
+
+int main(int argc, char *argv[])
+{
+    int opt, failed = 0;
+
+    while ((opt = getopt(argc, argv, "v")) != -1)
+    {
+        switch (opt)
+        {
+        case 'v': Verbose = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (!LCD_Open(&LCD_EmuTransport)) return 1;
+    LCD_Reset();
+    Display_Images();
+    failed += Display_Check<LANDSCAPE_TOP>() != 0;
+    failed += Display_Check<PORTRAIT_FLIP>() != 0;
+    failed += Display_Check<LANDSCAPE_FLIP>() != 0;
+    failed += Display_Check<PORTRAIT>() != 0;
+    failed += Display_Check<LANDSCAPE_TOP | LCD_MIRROR>() != 0;
+    failed += Display_Check<PORTRAIT_FLIP | LCD_MIRROR>() != 0;
+    failed += Display_Check<LANDSCAPE_FLIP | LCD_MIRROR>() != 0;
+    failed += Display_Check<PORTRAIT | LCD_MIRROR>() != 0;
+    LCD_Init(PORTRAIT);
+    LCD_Close();
+    return failed ? 1 : 0;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
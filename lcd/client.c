@@ -0,0 +1,123 @@
+/*******************************************************************************
+* Function Name  : main
+* Description    : Example client of the framebuffer daemon fbd: a stripe
+*                  sweeping across its surface, only the columns that
+*                  changed damaged, each frame waited for before the next
+* Input          : -s socket path, default FB_SOCKET
+*                  -x, -y upper left corner, default 20 20
+*                  -w, -h surface size, default 200 100
+*                  -n frames, default 240
+*                  -m move the surface down a line every frame too
+* Output         : None
+* Return         : 0 success, 1 fail
+* Compile/link   : gcc -o client client.c lcd_fb.c
+* Execute        : sudo ./fbd -H &      ./client      ./client -x 60 -y 180 -m
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "lcd_fb.h"
+
+
+/* Defines */
+#define STRIPE 8                    /* stripe width */
+#define BACK 0x001F                 /* RGB565 blue */
+#define FORE 0xFFE0                 /* RGB565 yellow */
+
+
+/*******************************************************************************
+* Function Name  : Client_Columns
+* Description    : Paint columns of the surface
+* Input          : - client: connection
+*                  - x0, x1: first and last column + 1, clipped to the surface
+*                  - color: RGB565
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Client_Columns(FbClient *client, int x0, int x1, unsigned short color)
+{
+    unsigned int x, y;
+
+    if (x0 < 0) x0 = 0;
+    if (x1 > client->w) x1 = client->w;
+    for (y = 0; y < client->h; y++)
+        for (x = x0; (int)x < x1; x++)
+            client->pixels[y * client->w + x] = color;
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char *path = FB_SOCKET;
+    int x = 20, y = 20, w = 200, h = 100, frames = 240, move = 0, opt, i, pos, prev;
+    unsigned int seq;
+    struct timespec t0, t1;
+    double s;
+    FbClient client;
+
+    while ((opt = getopt(argc, argv, "s:x:y:w:h:n:m")) != -1)
+    {
+        switch (opt)
+        {
+        case 's': path = optarg; break;
+        case 'x': x = atoi(optarg); break;
+        case 'y': y = atoi(optarg); break;
+        case 'w': w = atoi(optarg); break;
+        case 'h': h = atoi(optarg); break;
+        case 'n': frames = atoi(optarg); break;
+        case 'm': move = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-s socket] [-x X] [-y Y] [-w W] [-h H] [-n frames] [-m]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (!FB_Connect(&client, path, x, y, w, h))
+    {
+        fprintf(stderr, "can't get a surface from fbd on %s\n", path);
+        return 1;
+    }
+    printf("surface %ux%u at %d,%d\n", client.w, client.h, client.x, client.y);
+
+    /* whole surface once, then the stripe's old and new columns */
+    Client_Columns(&client, 0, client.w, BACK);
+    seq = FB_Damage(&client, 0, 0, client.w, client.h);
+    prev = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < frames && seq; i++)
+    {
+        pos = i * 2 % (client.w > STRIPE ? client.w - STRIPE : 1);
+        if (!FB_Wait(&client, seq))
+            break;
+        Client_Columns(&client, prev, prev + STRIPE, BACK);
+        Client_Columns(&client, pos, pos + STRIPE, FORE);
+        if (pos > prev)
+            seq = FB_Damage(&client, prev, 0, pos + STRIPE - prev, client.h);
+        else
+        {
+            FB_Damage(&client, prev, 0, STRIPE, client.h);
+            seq = FB_Damage(&client, pos, 0, STRIPE, client.h);
+        }
+        if (move && seq)
+            seq = FB_Move(&client, client.x, client.y + 1);
+        prev = pos;
+    }
+    if (seq)
+        FB_Wait(&client, seq);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    if (!seq || i < frames)
+        fprintf(stderr, "connection to fbd lost\n");
+    else
+        printf("%d frames in %.2f s, %.1f frames/s\n", frames, s, s > 0 ? frames / s : 0);
+    FB_Disconnect(&client);
+    return !seq || i < frames;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,381 @@
+/*******************************************************************************
+* Function Name  : main
+* Description    : Framebuffer daemon: owns the panel and lends each client
+*                  process a POSIX shared memory RGB565 surface, see lcd_fb.h
+*                  Surfaces are layers over a black background; the damage
+*                  of all the clients that is waiting is read, then flushed
+*                  with one LCD_Compose and acknowledged to each client
+* Input          : -H real panel, default is the emulated one
+*                  -s socket path, default FB_SOCKET
+*                  -o orientation for LCD_Init, default PORTRAIT
+* Output         : None
+* Return         : 0 stopped by SIGINT or SIGTERM, 1 fail
+* Compile/link   : gcc -o fbd -lrt fbd.c lcd.c lcd_layer.c lcd_trace.c lcd_emu.c lcd_spi0.c lcd_bcm2835.c -lbcm2835 -lm -lpthread
+*                  gcc -DLCD_NO_BCM2835 -o fbd -lrt fbd.c lcd.c lcd_layer.c lcd_trace.c lcd_emu.c lcd_spi0.c -lm -lpthread
+* Execute        : sudo ./fbd -H &      then the clients, linked with lcd_fb.c
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "lcd.h"
+#include "lcd_emu.h"
+#include "lcd_layer.h"
+#include "lcd_fb.h"
+
+#if FB_CLIENTS + 1 > LAYER_MAX
+#error "FB_CLIENTS surfaces and the background don't fit in LAYER_MAX layers"
+#endif
+
+
+/* Types */
+typedef struct
+{
+    int sock;                   /* -1 free */
+    Layer layer;                /* on the stack once the surface is lent */
+    unsigned short *pixels;     /* surface, 0 until FB_HELLO */
+    unsigned int seq;           /* last damage or move received */
+    unsigned char pending;      /* received since the last flush */
+} FbdClient;
+
+
+/* Public declarations */
+static FbdClient Clients[FB_CLIENTS];
+static unsigned short Background[MAX_X * MAX_Y];
+static Layer BackLayer;
+static volatile sig_atomic_t Quit;
+
+
+/*******************************************************************************
+* Function Name  : Fbd_Stop
+* Description    : SIGINT and SIGTERM handler
+* Input          : - sig: signal
+* Output         : None
+* Return         : None
+* Attention      : poll is interrupted, the main loop exits
+*******************************************************************************/
+static void Fbd_Stop(int sig)
+{
+    (void)sig;
+    Quit = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : Fbd_Send
+* Description    : Send one message to a client
+* Input          : - c: client
+*                  - type: FB_x
+*                  - fd: descriptor passed with it, -1 for none
+* Output         : None
+* Return         : 1 success, 0 fail
+* Attention      : Never blocks: an acknowledgement a client does not read
+*                  is dropped, the next one covers it
+*******************************************************************************/
+static int Fbd_Send(FbdClient *c, unsigned int type, int fd)
+{
+    struct msghdr mh;
+    struct iovec iov;
+    struct cmsghdr *cm;
+    char control[CMSG_SPACE(sizeof(int))];
+    FbMsg msg;
+
+    msg.type = type;
+    msg.seq = c->seq;
+    msg.x = c->layer.x;
+    msg.y = c->layer.y;
+    msg.w = c->layer.w;
+    msg.h = c->layer.h;
+    memset(&mh, 0, sizeof(mh));
+    iov.iov_base = &msg;
+    iov.iov_len = sizeof(msg);
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    if (fd >= 0)
+    {
+        mh.msg_control = control;
+        mh.msg_controllen = sizeof(control);
+        cm = CMSG_FIRSTHDR(&mh);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cm), &fd, sizeof(int));
+    }
+    return sendmsg(c->sock, &mh, MSG_DONTWAIT | MSG_NOSIGNAL) == sizeof(msg);
+}
+
+
+/*******************************************************************************
+* Function Name  : Fbd_Drop
+* Description    : Forget a client and take its surface off the screen
+* Input          : - c: client
+* Output         : None
+* Return         : None
+* Attention      : What the surface covered is flushed by the next compose
+*******************************************************************************/
+static void Fbd_Drop(FbdClient *c)
+{
+    if (c->pixels)
+    {
+        LCD_LayerRemove(&c->layer);
+        munmap(c->pixels, (size_t)c->layer.w * c->layer.h * 2);
+    }
+    close(c->sock);
+    memset(c, 0, sizeof(*c));
+    c->sock = -1;
+}
+
+
+/*******************************************************************************
+* Function Name  : Fbd_Hello
+* Description    : Lend a surface to a client
+* Input          : - c: client
+*                  - msg: FB_HELLO
+* Output         : None
+* Return         : 1 success, 0 refused
+* Attention      : The shared memory object is unlinked at once: the client
+*                  gets it only through the descriptor, and it goes away
+*                  with the last mapping
+*******************************************************************************/
+static int Fbd_Hello(FbdClient *c, const FbMsg *msg)
+{
+    char name[64];
+    int x0 = msg->x, y0 = msg->y, x1 = msg->x + msg->w, y1 = msg->y + msg->h, fd;
+    size_t size;
+    void *map;
+
+    if (!msg->w || !msg->h)
+    {
+        x0 = y0 = 0;
+        x1 = LCD_GetWidth();
+        y1 = LCD_GetHeight();
+    }
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > LCD_GetWidth()) x1 = LCD_GetWidth();
+    if (y1 > LCD_GetHeight()) y1 = LCD_GetHeight();
+    if (c->pixels || x0 >= x1 || y0 >= y1)
+        return 0;
+
+    size = (size_t)(x1 - x0) * (y1 - y0) * 2;
+    snprintf(name, sizeof(name), "/lcd-fb-%d-%d", (int)getpid(), (int)(c - Clients));
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+        return 0;
+    shm_unlink(name);
+    map = ftruncate(fd, size) ? MAP_FAILED : mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        close(fd);
+        return 0;
+    }
+    c->pixels = map;
+    LCD_LayerInit(&c->layer, c->pixels, x1 - x0, y1 - y0);
+    LCD_LayerMove(&c->layer, x0, y0);
+    LCD_LayerAdd(&c->layer);
+    c->pending = 1;
+    if (!Fbd_Send(c, FB_SURFACE, fd))
+    {
+        close(fd);
+        return 0;
+    }
+    close(fd);
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : Fbd_Read
+* Description    : Read all the messages waiting from a client
+* Input          : - c: client
+* Output         : None
+* Return         : 1 client still there, 0 gone or misbehaving
+* Attention      : Damage is clipped to the surface and only recorded, the
+*                  flush comes after all the clients are read
+*******************************************************************************/
+static int Fbd_Read(FbdClient *c)
+{
+    FbMsg msg;
+    ssize_t n;
+
+    for (;;)
+    {
+        n = recv(c->sock, &msg, sizeof(msg), MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 1;
+        if (n != sizeof(msg))
+            return 0;
+        if (msg.type == FB_HELLO)
+        {
+            if (!Fbd_Hello(c, &msg))
+            {
+                Fbd_Send(c, FB_REFUSED, -1);
+                return 0;
+            }
+            continue;
+        }
+        if (!c->pixels)
+            return 0;
+        switch (msg.type)
+        {
+        case FB_DAMAGE:
+            if (msg.x < 0 || msg.y < 0 || msg.x >= c->layer.w || msg.y >= c->layer.h)
+                break;
+            if (msg.w > c->layer.w - msg.x) msg.w = c->layer.w - msg.x;
+            if (msg.h > c->layer.h - msg.y) msg.h = c->layer.h - msg.y;
+            LCD_LayerDamage(&c->layer, msg.x, msg.y, msg.w, msg.h);
+            break;
+        case FB_MOVE:
+            LCD_LayerMove(&c->layer, msg.x, msg.y);
+            break;
+        default:
+            return 0;
+        }
+        c->seq = msg.seq;
+        c->pending = 1;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Fbd_Listen
+* Description    : Create the socket of the clients
+* Input          : - path: socket path, replaced if it exists
+* Output         : None
+* Return         : socket, -1 fail
+* Attention      : Any user may connect: the clients need not be root
+*******************************************************************************/
+static int Fbd_Listen(const char *path)
+{
+    struct sockaddr_un addr;
+    int sock;
+
+    sock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (sock < 0)
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0
+        || chmod(path, 0666) < 0 || listen(sock, FB_CLIENTS) < 0)
+    {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+
+int main(int argc, char *argv[])
+{
+    const LCD_Transport *transport = &LCD_EmuTransport;
+    const char *path = FB_SOCKET;
+    struct pollfd fds[FB_CLIENTS + 1];
+    struct sigaction sa;
+    FbdClient *slot[FB_CLIENTS + 1];
+    FbMsg refused;
+    int orientation = PORTRAIT, listener, sock, opt, i, n;
+
+    while ((opt = getopt(argc, argv, "Hs:o:")) != -1)
+    {
+        switch (opt)
+        {
+#ifndef LCD_NO_BCM2835
+        case 'H': transport = &LCD_Bcm2835Transport; break;
+#endif
+        case 's': path = optarg; break;
+        case 'o': orientation = atoi(optarg) & 7; break;
+        default:
+            fprintf(stderr, "usage: %s [-H] [-s socket] [-o orientation]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = Fbd_Stop;
+    sigaction(SIGINT, &sa, 0);
+    sigaction(SIGTERM, &sa, 0);
+    signal(SIGPIPE, SIG_IGN);
+
+    listener = Fbd_Listen(path);
+    if (listener < 0)
+    {
+        fprintf(stderr, "can't listen on %s\n", path);
+        return 1;
+    }
+    if (!LCD_Open(transport)) return 1;
+    LCD_Reset();
+    TP_Init();
+    LCD_Init(orientation);
+    LCD_LayerInit(&BackLayer, Background, LCD_GetWidth(), LCD_GetHeight());
+    LCD_LayerAdd(&BackLayer);
+    LCD_Compose();
+    for (i = 0; i < FB_CLIENTS; i++)
+        Clients[i].sock = -1;
+
+    while (!Quit)
+    {
+        fds[0].fd = listener;
+        fds[0].events = POLLIN;
+        for (i = 0, n = 1; i < FB_CLIENTS; i++)
+            if (Clients[i].sock >= 0)
+            {
+                fds[n].fd = Clients[i].sock;
+                fds[n].events = POLLIN;
+                slot[n++] = &Clients[i];
+            }
+        if (poll(fds, n, -1) < 0)
+            continue;           /* EINTR: Quit is checked */
+
+        if (fds[0].revents & POLLIN)
+        {
+            sock = accept(listener, 0, 0);
+            for (i = 0; sock >= 0 && i < FB_CLIENTS && Clients[i].sock >= 0; i++)
+                ;
+            if (sock >= 0 && i < FB_CLIENTS)
+                Clients[i].sock = sock;
+            else if (sock >= 0)
+            {
+                memset(&refused, 0, sizeof(refused));
+                refused.type = FB_REFUSED;
+                send(sock, &refused, sizeof(refused), MSG_DONTWAIT | MSG_NOSIGNAL);
+                close(sock);
+            }
+        }
+        for (i = 1; i < n; i++)
+            if (fds[i].revents && !Fbd_Read(slot[i]))
+                Fbd_Drop(slot[i]);
+
+        /* one flush for the damage of every client read */
+        LCD_Compose();
+        for (i = 0; i < FB_CLIENTS; i++)
+            if (Clients[i].sock >= 0 && Clients[i].pending)
+            {
+                Fbd_Send(&Clients[i], FB_DONE, -1);
+                Clients[i].pending = 0;
+            }
+    }
+
+    for (i = 0; i < FB_CLIENTS; i++)
+        if (Clients[i].sock >= 0)
+            Fbd_Drop(&Clients[i]);
+    close(listener);
+    unlink(path);
+    LCD_Close();
+    return 0;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,259 @@
+/*******************************************************************************
+* Function Name  : main
+* Description    : Frame ingest daemon: owns the panel and draws the dirty
+*                  rectangles a renderer process streams with lcd_ingest.c
+*                  Each rectangle is decoded straight into the burst of its
+*                  window, BURST_PIXELS at a time, keeping the previous
+*                  frame for INGEST_XOR; one renderer at a time, the next
+*                  connection waits for the last to leave
+* Input          : -H real panel, default is the emulated one
+*                  -s socket path, default INGEST_SOCKET
+*                  -o orientation for LCD_Init, default PORTRAIT
+* Output         : None
+* Return         : 0 stopped by SIGINT or SIGTERM, 1 fail
+* Compile/link   : gcc -o ingestd -lrt ingestd.c lcd.c lcd_ingest.c lcd_trace.c lcd_emu.c lcd_spi0.c lcd_bcm2835.c -lbcm2835 -lm -lpthread
+*                  gcc -DLCD_NO_BCM2835 -o ingestd -lrt ingestd.c lcd.c lcd_ingest.c lcd_trace.c lcd_emu.c lcd_spi0.c -lm -lpthread
+* Execute        : sudo ./ingestd -H &      then the renderer, linked with lcd_ingest.c
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "lcd.h"
+#include "lcd_emu.h"
+#include "lcd_ingest.h"
+
+
+/* Defines */
+#define BURST_PIXELS 2048       /* pixels per LCD_WritePixelsBE */
+#define PAYLOAD_MAX (INGEST_RLE_WORDS(MAX_X * MAX_Y) * 2)
+
+/* RGB565 in the byte order of the bus, for LCD_WritePixelsBE */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define BUS_ORDER(c) ((unsigned short)(c))
+#else
+#define BUS_ORDER(c) ((unsigned short)((c) << 8 | (c) >> 8))
+#endif
+
+
+/* Types */
+typedef struct
+{
+    unsigned short *prev;       /* line of the previous frame being written */
+    unsigned int col, w;        /* column in the rectangle, its width */
+    unsigned int fill;          /* pixels waiting in Burst */
+    unsigned char xor;          /* INGEST_XOR: values are XOR prev */
+} IngestOut;
+
+
+/* Public declarations */
+static unsigned short Prev[MAX_X * MAX_Y];      /* what the panel shows */
+static unsigned short Burst[BURST_PIXELS];      /* bus order */
+static unsigned short Payload[PAYLOAD_MAX / 2];
+static volatile sig_atomic_t Quit;
+
+
+/*******************************************************************************
+* Function Name  : Ingest_Stop
+* Description    : SIGINT and SIGTERM handler
+* Input          : - sig: signal
+* Output         : None
+* Return         : None
+* Attention      : The blocking calls are interrupted, the main loop exits
+*******************************************************************************/
+static void Ingest_Stop(int sig)
+{
+    (void)sig;
+    Quit = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : Ingest_Put
+* Description    : Next pixel of the rectangle
+* Input          : - o: decoder
+*                  - value: pixel, or pixel XOR previous for INGEST_XOR
+* Output         : None
+* Return         : None
+* Attention      : Burst is sent when full
+*******************************************************************************/
+static inline void Ingest_Put(IngestOut *o, unsigned short value)
+{
+    unsigned short pixel = o->xor ? o->prev[o->col] ^ value : value;
+
+    o->prev[o->col] = pixel;
+    if (++o->col == o->w)
+    {
+        o->col = 0;
+        o->prev += LCD_GetWidth();
+    }
+    Burst[o->fill++] = BUS_ORDER(pixel);
+    if (o->fill == BURST_PIXELS)
+    {
+        LCD_WritePixelsBE(Burst, BURST_PIXELS);
+        o->fill = 0;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Ingest_Run
+* Description    : IngestRun of the decoder: the pixels of a run
+* Input          : - target: IngestOut
+*                  - values, count, repeat: run
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Ingest_Run(void *target, const unsigned short *values, unsigned int count, int repeat)
+{
+    IngestOut *o = (IngestOut *)target;
+
+    if (repeat)
+        for (; count; count--)
+            Ingest_Put(o, values[0]);
+    else
+        for (; count; count--)
+            Ingest_Put(o, *values++);
+}
+
+
+/*******************************************************************************
+* Function Name  : Ingest_Rect
+* Description    : Decode a rectangle into its window
+* Input          : - head: rectangle
+*                  - data: payload, head->length bytes
+* Output         : None
+* Return         : 1 success, 0 malformed payload
+* Attention      : A malformed payload leaves part of the window written
+*******************************************************************************/
+static int Ingest_Rect(const IngestHeader *head, const unsigned short *data)
+{
+    IngestOut o;
+    int ok;
+
+    if (!LCD_SetWindow(head->x, head->y, head->w, head->h))
+        return 0;
+    o.prev = Prev + head->y * LCD_GetWidth() + head->x;
+    o.col = 0;
+    o.w = head->w;
+    o.fill = 0;
+    o.xor = head->encoding == INGEST_XOR;
+    ok = LCD_IngestDecode(head, data, Ingest_Run, &o);
+    if (o.fill)
+        LCD_WritePixelsBE(Burst, o.fill);
+    return ok;
+}
+
+
+/*******************************************************************************
+* Function Name  : Ingest_Serve
+* Description    : Draw the rectangles of a renderer until it leaves
+* Input          : - sock: connection
+* Output         : None
+* Return         : None
+* Attention      : The renderer is dropped on a malformed rectangle
+*******************************************************************************/
+static void Ingest_Serve(int sock)
+{
+    IngestHeader head;
+    unsigned long rects = 0, bytes = 0, pixels = 0;
+
+    memset(&head, 0, sizeof(head));
+    head.encoding = INGEST_SYNC;
+    head.w = LCD_GetWidth();
+    head.h = LCD_GetHeight();
+    LCD_Clear(Black);
+    memset(Prev, 0, sizeof(Prev));
+    if (send(sock, &head, sizeof(head), MSG_NOSIGNAL) != sizeof(head))
+        return;
+
+    while (!Quit && recv(sock, &head, sizeof(head), MSG_WAITALL) == sizeof(head))
+    {
+        if (head.encoding == INGEST_SYNC)
+        {
+            if (send(sock, &head, sizeof(head), MSG_NOSIGNAL) != sizeof(head))
+                break;
+            continue;
+        }
+        if (head.encoding > INGEST_XOR || head.length > PAYLOAD_MAX || head.length & 1
+            || (head.length && recv(sock, Payload, head.length, MSG_WAITALL) != (ssize_t)head.length)
+            || !Ingest_Rect(&head, Payload))
+            break;
+        rects++;
+        bytes += head.length;
+        pixels += head.w * head.h;
+    }
+    printf("renderer left: %lu rectangles, %lu pixels in %lu bytes\n", rects, pixels, bytes);
+}
+
+
+int main(int argc, char *argv[])
+{
+    const LCD_Transport *transport = &LCD_EmuTransport;
+    const char *path = INGEST_SOCKET;
+    struct sockaddr_un addr;
+    struct sigaction sa;
+    int orientation = PORTRAIT, listener, sock, opt;
+
+    while ((opt = getopt(argc, argv, "Hs:o:")) != -1)
+    {
+        switch (opt)
+        {
+#ifndef LCD_NO_BCM2835
+        case 'H': transport = &LCD_Bcm2835Transport; break;
+#endif
+        case 's': path = optarg; break;
+        case 'o': orientation = atoi(optarg) & 7; break;
+        default:
+            fprintf(stderr, "usage: %s [-H] [-s socket] [-o orientation]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = Ingest_Stop;
+    sigaction(SIGINT, &sa, 0);
+    sigaction(SIGTERM, &sa, 0);
+    signal(SIGPIPE, SIG_IGN);
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0
+        || chmod(path, 0666) < 0 || listen(listener, 1) < 0)
+    {
+        fprintf(stderr, "can't listen on %s\n", path);
+        return 1;
+    }
+    if (!LCD_Open(transport)) return 1;
+    LCD_Reset();
+    TP_Init();
+    LCD_Init(orientation);
+
+    while (!Quit)
+    {
+        sock = accept(listener, 0, 0);
+        if (sock < 0)
+            continue;           /* EINTR: Quit is checked */
+        Ingest_Serve(sock);
+        close(sock);
+    }
+
+    close(listener);
+    unlink(path);
+    LCD_Close();
+    return 0;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
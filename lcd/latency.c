@@ -0,0 +1,235 @@
+/*******************************************************************************
+* Function Name  : main
+* Description    : Touch-to-photon latency harness: each touch sample is
+*                  drawn with TP_DrawPoint and followed through the driver,
+*                  the histograms of the stages are printed at the end
+*                  The emulated panel plays a scripted trace of taps and
+*                  drags on the modeled clock, so a run gives the same
+*                  numbers on any host
+* Input          : -H real panel, calibrated with TP_Cal, default is the
+*                     emulated one
+*                  -n strokes of the emulated trace, default 50
+*                  -s seconds to sample the real panel, default 10
+*                  -p poll period in ms while the pen is up, default 1
+*                  -o JSON histograms file
+*                  -l limit of the total p99 in us, exit 1 above it
+* Output         : None
+* Return         : 0 success, 1 fail or limit exceeded
+* Compile/link   : gcc -DLCD_LATENCY -o latency -lrt latency.c lcd.c lcd_trace.c lcd_stats.c lcd_latency.c lcd_emu.c lcd_spi0.c lcd_bcm2835.c -lbcm2835 -lm -lpthread
+*                  gcc -DLCD_LATENCY -DLCD_NO_BCM2835 -o latency -lrt latency.c lcd.c lcd_trace.c lcd_stats.c lcd_latency.c lcd_emu.c lcd_spi0.c -lm -lpthread
+* Execute        : ./latency -l 20000      sudo ./latency -H
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "lcd.h"
+#include "lcd_emu.h"
+#include "lcd_latency.h"
+
+#ifndef LCD_LATENCY
+#error "latency needs the latency records, build it with -DLCD_LATENCY"
+#endif
+
+
+/* Defines */
+#define TRACE_MOVES 60          /* pen moves of a drag */
+#define TRACE_MOVE_NS 4000000   /* between two moves, a 250 Hz finger */
+#define TRACE_TAP_NS 80000000   /* pen down time of a tap */
+#define TRACE_GAP_NS 120000000  /* pen up time between two strokes */
+
+
+/*******************************************************************************
+* Function Name  : Latency_Trace
+* Description    : Script of alternated taps and drags at pseudo random places
+* Input          : - strokes: number of taps and drags
+* Output         : - count: number of pen changes
+* Return         : pen changes, 0 if out of memory
+* Attention      : Same script on every run
+*******************************************************************************/
+static EmuTouchEvent *Latency_Trace(int strokes, unsigned int *count)
+{
+    EmuTouchEvent *trace, *e;
+    unsigned long seed = 1;
+    unsigned long long t = TRACE_GAP_NS;
+    int i, j, x, y, dx, dy;
+
+    trace = malloc(sizeof(*trace) * strokes * (TRACE_MOVES + 2));
+    if (!trace)
+        return 0;
+    e = trace;
+    for (i = 0; i < strokes; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        x = 40 + (seed >> 8) % (MAX_X - 80);
+        y = 40 + (seed >> 20) % (MAX_Y - 80);
+        e->tNs = t; e->x = x; e->y = y; e->pressed = 1; e++;
+        if (i % 2 == 0)
+        {
+            t += TRACE_TAP_NS;
+        }
+        else
+        {
+            /* drag toward the middle of the screen */
+            dx = x < MAX_X / 2 ? 1 : -1;
+            dy = y < MAX_Y / 2 ? 2 : -2;
+            for (j = 0; j < TRACE_MOVES; j++)
+            {
+                t += TRACE_MOVE_NS;
+                x += dx;
+                y += dy;
+                e->tNs = t; e->x = x; e->y = y; e->pressed = 1; e++;
+            }
+            t += TRACE_MOVE_NS;
+        }
+        e->tNs = t; e->x = x; e->y = y; e->pressed = 0; e++;
+        t += TRACE_GAP_NS;
+    }
+    *count = e - trace;
+    return trace;
+}
+
+
+/*******************************************************************************
+* Function Name  : Latency_EmuCal
+* Description    : Calibrate on three points touched with the emulated pen
+* Input          : None
+* Output         : None
+* Return         : 1 success, 0 fail
+* Attention      : The portrait screen is the GRAM, no rotation
+*******************************************************************************/
+static int Latency_EmuCal(void)
+{
+    Coordinate points[3] = { { 30, 40 }, { 210, 160 }, { 120, 290 } };
+    Coordinate raw[3], *p;
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        LCD_EmuTouch(points[i].x, points[i].y, 1);
+        p = Read_Ads7846();
+        if (!p)
+            return 0;
+        raw[i] = *p;
+    }
+    LCD_EmuTouch(0, 0, 0);
+    return setCalibrationMatrix(points, raw, &matrix) == ENABLE;
+}
+
+
+/*******************************************************************************
+* Function Name  : Latency_Now
+* Description    : CLOCK_MONOTONIC time
+* Input          : None
+* Output         : None
+* Return         : nanoseconds
+* Attention      : None
+*******************************************************************************/
+static unsigned long long Latency_Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+int main(int argc, char *argv[])
+{
+    const LCD_Transport *transport = &LCD_EmuTransport;
+    const char *outFile = 0;
+    int strokes = 50, seconds = 10, poll = 1, emulated, opt;
+    long limit = 0;
+    unsigned long long end;
+    unsigned int count = 0;
+    EmuTouchEvent *trace = 0;
+    TouchSample sample;
+    LatHistogram total;
+    FILE *f;
+
+    while ((opt = getopt(argc, argv, "Hn:s:p:o:l:")) != -1)
+    {
+        switch (opt)
+        {
+#ifndef LCD_NO_BCM2835
+        case 'H': transport = &LCD_Bcm2835Transport; break;
+#endif
+        case 'n': strokes = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+        case 's': seconds = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+        case 'p': poll = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+        case 'o': outFile = optarg; break;
+        case 'l': limit = atol(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-H] [-n strokes] [-s seconds] [-p ms] "
+                    "[-o out.json] [-l p99 us]\n", argv[0]);
+            return 1;
+        }
+    }
+    emulated = transport == &LCD_EmuTransport;
+
+    if (!LCD_Open(transport)) return 1;
+    LCD_Reset();
+    TP_Init();
+    LCD_Init(PORTRAIT);
+    LCD_Clear(Black);
+
+    if (emulated)
+    {
+        trace = Latency_Trace(strokes, &count);
+        if (!trace || !Latency_EmuCal())
+        {
+            fprintf(stderr, "emulated calibration failed\n");
+            return 1;
+        }
+        LCD_LatencyClock(LCD_EmuClockNs, LCD_EmuTouchNs);
+        LCD_EmuTouchTrace(trace, count);
+        end = trace[count - 1].tNs + TRACE_GAP_NS;
+    }
+    else
+    {
+        TP_Cal();
+        LCD_Clear(Black);
+        end = Latency_Now() + seconds * 1000000000ULL;
+    }
+    LCD_LatencyReset();
+
+    /* the application loop: draw every sample the pen is down */
+    while ((emulated ? LCD_EmuClockNs() : Latency_Now()) < end)
+    {
+        if (TP_ReadSample(&sample) && sample.pen)
+            TP_DrawPoint(sample.x, sample.y);
+        else if (emulated)
+            LCD_EmuTransport.delay(0, poll);
+        else
+            usleep(poll * 1000);
+    }
+
+    LCD_LatencyDumpText(stdout);
+    if (outFile)
+    {
+        f = fopen(outFile, "w");
+        if (!f)
+        {
+            fprintf(stderr, "can't write %s\n", outFile);
+            return 1;
+        }
+        LCD_LatencyDumpJSON(f);
+        fclose(f);
+    }
+    LCD_Close();
+    free(trace);
+
+    LCD_LatencyGet(LAT_STAGE_TOTAL, &total);
+    if (limit > 0 && LCD_LatencyPercentile(&total, 99) > (unsigned long long)limit * 1000)
+    {
+        fprintf(stderr, "total p99 above %ld us\n", limit);
+        return 1;
+    }
+    return 0;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,3436 @@
+/*******************************************************************************
+* File Name      : lcd.c
+* Description    : Driver for LCD HY28A-LCDB using:
+*                  ILI9320 for LCD & ADS7843 for Touch Panel
+*                  All bus and GPIO accesses go through the LCD_Transport
+*                  given to LCD_Open or LCD_DeviceOpen
+*                  The state of a panel is an LCD_Device; the functions draw
+*                  on the device selected by the calling thread and hold its
+*                  lock, so threads may drive separate panels in parallel
+*******************************************************************************/
+/* Includes */
+#define _GNU_SOURCE        /* PTHREAD_MUTEX_RECURSIVE */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "fonts.h"
+#include "lcd.h"
+#include "lcd_ili9320.h"
+#include "lcd_stats.h"
+#include "lcd_trace.h"
+#include "lcd_latency.h"
+
+
+/* Defines */ 
+#define	CHY 0x90           /* channel Y+ selection command */
+#define	CHX 0xd0	       /* channel X+ selection command */
+
+#define SPI_START (0x70)   /* Start byte for SPI transfer */
+#define SPI_RD (0x01)      /* WR bit 1 within start */
+#define SPI_WR (0x00)      /* WR bit 0 within start */
+#define SPI_DATA (0x02)    /* RS bit 1 within start byte */
+#define SPI_INDEX (0x00)   /* RS bit 0 within start byte */
+
+#define DIVIDER_CS0 8      /* BCM2835_SPI_CLOCK_DIVIDER_8 */
+#define DIVIDER_CS1 64     /* BCM2835_SPI_CLOCK_DIVIDER_64 */
+
+/* LCD_TuneDividers */
+#define TUNE_SAFE 64       /* divider trusted without error, reference of the probe */
+#define TUNE_FASTEST 2     /* fastest divider tried */
+#define TUNE_MARGIN 1      /* steps of 2 kept below the fastest divider without error */
+#define TUNE_W 64          /* probe window, in the upper left corner */
+#define TUNE_H 16
+#define TUNE_PATTERNS 4    /* pseudo random patterns per divider */
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define THRESHOLD 2   /* threshold */
+
+#define BURST_PIXELS 2048     /* pixels sent per transfer by LCD_WritePixels */
+
+#define CLIP_DEPTH 8          /* nested clip rectangles and viewports */
+#define CIRCLE_POINTS 512     /* points of LCD_DrawCircle per LCD_SetPoints */
+
+/* BMP compression field, LCD_PutImage */
+#define BMP_RGB 0             /* none */
+#define BMP_BITFIELDS 3       /* red, green, blue masks after the header */
+#define BMP_ALPHABITFIELDS 6  /* and an alpha mask */
+#define BMP_HEADER (14 + 124 + 16)  /* file header, V5 header, masks */
+
+/* Cohen-Sutherland outcodes */
+#define OUT_LEFT   1
+#define OUT_RIGHT  2
+#define OUT_TOP    4
+#define OUT_BOTTOM 8
+
+/* Each public API holds the lock of the device for its whole run */
+#define DEV_LOCK()          pthread_mutex_lock(&Dev->lock)
+#define DEV_UNLOCK()        pthread_mutex_unlock(&Dev->lock)
+#define API_ENTER(api)      do { DEV_LOCK(); STATS_ENTER(api); } while (0)
+#define API_LEAVE()         do { STATS_LEAVE(); DEV_UNLOCK(); } while (0)
+
+#define INDEX_UNKNOWN 0x100   /* index register not known, after reset */
+#define AC_X 0x01             /* address counter column known */
+#define AC_Y 0x02             /* address counter row known */
+
+
+/* Function declarations */
+static unsigned short LCD_BGR2RGB(unsigned short);
+static void LCD_SetCursor(unsigned short, unsigned short);
+static void LCD_MapPoint(unsigned short, unsigned short, unsigned short *, unsigned short *);
+static void LCD_Window(unsigned short, unsigned short, unsigned short, unsigned short, int);
+static void LCD_FullWindow(void);
+static void LCD_Pixel(int, int, unsigned short);
+static int LCD_ClipSpan(int *, int *, int *, int *, int *, int *);
+static void LCD_Fill(int, int, int, int, unsigned short);
+static void LCD_Blit(int, int, int, int, const unsigned short *);
+static void LCD_Points(const Coordinate *, const unsigned short *, unsigned int, unsigned short);
+static void LCD_WriteColor(unsigned short, unsigned long);
+static void SPI_Transfer(char *, unsigned int);
+static void SPI_Write(char *, unsigned int, const char *, unsigned int);
+static void SPI_ChipSelect(unsigned char, unsigned short);
+static void SPI_ReadSpeed(int);
+static void Tune_Write(unsigned short, const unsigned short *);
+static void Tune_Read(unsigned short, unsigned short *);
+static unsigned long Tune_Errors(unsigned short, int);
+static void GPIO_Write(unsigned char, unsigned char);
+static void Shadow_Data(unsigned short);
+static void Shadow_Advance(void);
+static void Shadow_AdvanceN(unsigned long);
+static int Shadow_Redundant(unsigned short, unsigned short);
+
+
+/* Types */
+/* Clip rectangle and viewport of the drawing primitives, in screen
+   coordinates of the orientation; x1, y1 excluded */
+typedef struct
+{
+    int x0, y0, x1, y1;
+    int ox, oy, ow, oh;
+} ClipFrame;
+
+/* Points of LCD_DrawCircle, gathered for LCD_Points */
+typedef struct
+{
+    Coordinate pts[CIRCLE_POINTS];
+    unsigned int n;
+    unsigned short color;
+} RasterPoints;
+
+/* Pixel format of a BMP, for LCD_PutImage */
+typedef struct
+{
+    int bpp;                        /* 1, 4, 8, 16, 24 or 32 */
+    unsigned short lut[256];        /* palette in RGB565, 1 to 8 bits */
+    int rgb565;                     /* 16 bits already RGB565 */
+    int bgr888;                     /* 32 bits with the bytes of 24 bits */
+    unsigned char rs[3], ls[3];     /* 16 and 32 bits: red, green, blue */
+    unsigned char mask[3];          /* to 8 bits: (v >> rs & mask) << ls */
+} BmpFormat;
+
+/* Driver state of one panel */
+struct LCD_Device
+{
+    const LCD_Transport *bus;
+    void *busContext;                       /* first argument of the bus calls */
+    pthread_mutex_t lock;                   /* recursive, held by each API */
+    unsigned char orient;
+    unsigned char mirror;
+    unsigned char turned;                   /* LANDSCAPE: text and images turned */
+    unsigned short width, height;           /* as seen in orient */
+    unsigned short entry;                   /* entry mode of orient */
+    unsigned char windowFull;               /* window is the screen */
+    unsigned short writeDivider;            /* SPI clock divider of the LCD */
+    unsigned short readDivider;             /* of its reads, may be slower */
+
+    ClipFrame clip;
+    ClipFrame clipStack[CLIP_DEPTH];
+    int clipDepth;
+
+    /* Scan order keys of LCD_SetPoints: row, column, index of the point */
+    unsigned long long *pointKeys;
+    unsigned int pointKeysSize;
+    unsigned short runBuf[MAX_Y];           /* colors of one run */
+
+    Matrix *matrix;                         /* calibration set by TP_Cal */
+    Coordinate *display;                    /* last point of getDisplayPoint */
+    Matrix matrixData;
+    Coordinate displayData;
+    Coordinate screen;                      /* last point of Read_Ads7846 */
+    Coordinate sample;                      /* returned by Read_Ads7846 */
+
+    /* Register shadow: last value written to each ILI9320 register, the
+       index register and a model of the GRAM address counter */
+    unsigned short shadowReg[256];
+    unsigned char shadowValid[256];
+    unsigned short shadowIndex;
+    unsigned short acX, acY;
+    unsigned char acValid;
+
+    /* start byte, dummy byte and word of a read, then the pixels of a burst */
+    char burstBuf[4 + 2 * BURST_PIXELS];
+};
+
+
+/* Public declarations */
+Matrix matrix;
+Coordinate display;
+static const Coordinate DisplaySamplePortrait[3] = { {45, 45}, {45, 270}, {190, 190} };
+
+/* Device of LCD_Open, and the one each thread draws on */
+static LCD_Device DefaultDevice;
+static unsigned char DefaultReady;
+static __thread LCD_Device *Dev = &DefaultDevice;
+
+
+/*******************************************************************************
+* Function Name  : Device_Init
+* Description    : Power on state of a device
+* Input          : - dev: device
+*                  - transport: bus of the panel
+*                  - context: first argument of the bus calls
+* Output         : None
+* Return         : None
+* Attention      : Calibration and touch point are left to the caller
+*******************************************************************************/
+static void Device_Init(LCD_Device *dev, const LCD_Transport *transport, void *context)
+{
+    pthread_mutexattr_t attr;
+    LCD_Device *prev = Dev;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&dev->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    dev->bus = transport;
+    dev->busContext = context;
+    dev->orient = PORTRAIT;
+    dev->width = MAX_X;
+    dev->height = MAX_Y;
+    dev->entry = 0x1030;
+    dev->writeDivider = dev->readDivider = DIVIDER_CS0;
+    Dev = dev;
+    LCD_ResetClip();
+    LCD_ShadowInvalidate();
+    Dev = prev;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Open
+* Description    : Select the transport used by the driver and open it
+* Input          : - transport: LCD_Bcm2835Transport or LCD_EmuTransport
+* Output         : None
+* Return         : 1 success, 0 fail
+* Attention      : Must be called before any other function of the driver
+*                  Opens the default device, whose calibration and touch
+*                  point are matrix and display, and selects it
+*******************************************************************************/
+int LCD_Open(const LCD_Transport *transport)
+{
+    if (!DefaultReady)
+    {
+        Device_Init(&DefaultDevice, transport, 0);
+        DefaultDevice.matrix = &matrix;
+        DefaultDevice.display = &display;
+        DefaultReady = 1;
+    }
+    Dev = &DefaultDevice;
+    DEV_LOCK();
+    Dev->bus = transport;
+    LCD_ShadowInvalidate();
+    DEV_UNLOCK();
+    return Dev->bus->open(Dev->busContext);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Close
+* Description    : Close the transport of the default device
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_Close(void)
+{
+    DefaultDevice.bus->close(DefaultDevice.busContext);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_DeviceOpen
+* Description    : Open one more panel
+* Input          : - transport: bus of the panel
+*                  - context: passed to each call of the transport, e.g. an
+*                    EmuPanel of LCD_EmuCreate; 0 for the default one
+* Output         : None
+* Return         : device, 0 fail
+* Attention      : The device is not selected: see LCD_Select
+*******************************************************************************/
+LCD_Device *LCD_DeviceOpen(const LCD_Transport *transport, void *context)
+{
+    LCD_Device *dev;
+
+    dev = calloc(1, sizeof(*dev));
+    if (!dev)
+        return 0;
+    Device_Init(dev, transport, context);
+    dev->matrix = &dev->matrixData;
+    dev->display = &dev->displayData;
+    if (!transport->open(context))
+    {
+        pthread_mutex_destroy(&dev->lock);
+        free(dev);
+        return 0;
+    }
+    return dev;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_DeviceClose
+* Description    : Close a panel of LCD_DeviceOpen and free it
+* Input          : - dev: device
+* Output         : None
+* Return         : None
+* Attention      : No thread may still have it selected; the calling thread
+*                  is moved back to the default device
+*******************************************************************************/
+void LCD_DeviceClose(LCD_Device *dev)
+{
+    if (!dev || dev == &DefaultDevice)
+        return;
+    if (Dev == dev)
+        Dev = &DefaultDevice;
+    dev->bus->close(dev->busContext);
+    pthread_mutex_destroy(&dev->lock);
+    free(dev->pointKeys);
+    free(dev);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Select
+* Description    : Device the calling thread draws on
+* Input          : - dev: device, 0 for the default device
+* Output         : None
+* Return         : device selected before
+* Attention      : Each thread starts on the default device
+*******************************************************************************/
+LCD_Device *LCD_Select(LCD_Device *dev)
+{
+    LCD_Device *prev = Dev;
+
+    Dev = dev ? dev : &DefaultDevice;
+    return prev;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Calibration
+* Description    : Calibration of the selected device
+* Input          : None
+* Output         : None
+* Return         : matrix set by TP_Cal, may be saved and written back
+* Attention      : matrix itself for the default device
+*******************************************************************************/
+Matrix *LCD_Calibration(void)
+{
+    return Dev->matrix;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Lock ... LCD_Unlock
+* Description    : Hold the selected device across several calls
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : Each function holds it already; a thread sharing a
+*                  device with others holds it around the calls that must
+*                  not be split, e.g. LCD_SetWindow then LCD_WritePixels
+*******************************************************************************/
+void LCD_Lock(void)
+{
+    DEV_LOCK();
+}
+
+
+void LCD_Unlock(void)
+{
+    DEV_UNLOCK();
+}
+
+
+/*******************************************************************************
+* Function Name  : IRQ_Clear
+* Description    : Test if LCD is touched
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void IRQ_Clear()
+{
+    DEV_LOCK();
+    Dev->bus->irqClear(Dev->busContext);
+    DEV_UNLOCK();
+}
+
+
+/*******************************************************************************
+* Function Name  : IRQ_Test
+* Description    : Test if LCD is touched
+* Input          : None
+* Output         : None
+* Return         : 1 if you touch display 0 normal condition
+* Attention      : None
+*******************************************************************************/
+unsigned char IRQ_Test()
+{
+    unsigned char level;
+
+    DEV_LOCK();
+    level = Dev->bus->irqTest(Dev->busContext);
+    DEV_UNLOCK();
+    return level;
+}
+
+
+/*******************************************************************************
+* Function Name  : getImageInfo
+* Description    : sub for LCD_PutImage
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+long getImageInfo(FILE* inputFile, long offset, int numberOfChars)
+{
+    unsigned char *ptrC;
+    long value=0L;
+    int i;
+    unsigned char dummy;
+
+    dummy = '0';
+    ptrC = &dummy;
+
+    fseek(inputFile, offset, SEEK_SET);
+
+    for(i=1; i<=numberOfChars; i++)
+    {
+        fread(ptrC, sizeof(char), 1, inputFile);
+        // calculate value based on adding bytes
+        value = (long)(value + (*ptrC) * (pow(256, (i-1))));
+    }
+    return(value);
+}
+
+
+/*******************************************************************************
+* Function Name  : Bmp_Le
+* Description    : Little endian field of a BMP header
+* Input          : - p: first byte
+*                  - n: 2 or 4 bytes
+* Output         : None
+* Return         : value
+* Attention      : None
+*******************************************************************************/
+static unsigned long Bmp_Le(const unsigned char *p, int n)
+{
+    return n == 2 ? p[0] | (unsigned long)p[1] << 8
+                  : p[0] | (unsigned long)p[1] << 8 | (unsigned long)p[2] << 16 | (unsigned long)p[3] << 24;
+}
+
+
+/*******************************************************************************
+* Function Name  : Bmp_Masks
+* Description    : Shifts that take each channel of a 16 or 32 bits pixel to
+*                  8 bits
+* Input          : - fmt: format
+*                  - red, green, blue: masks of the channels in the pixel
+* Output         : - fmt: rs, ls, mask, rgb565, bgr888
+* Return         : None
+* Attention      : A channel wider than 8 bits keeps its 8 high bits, a
+*                  narrower one is shifted to the top; no mask is black
+*******************************************************************************/
+static void Bmp_Masks(BmpFormat *fmt, unsigned long red, unsigned long green, unsigned long blue)
+{
+    unsigned long masks[3];
+    int i, shift, bits;
+
+    masks[0] = red;
+    masks[1] = green;
+    masks[2] = blue;
+    for (i = 0; i < 3; i++)
+    {
+        for (shift = 0; shift < 32 && !(masks[i] >> shift & 1); shift++)
+            ;
+        for (bits = 0; shift + bits < 32 && masks[i] >> (shift + bits) & 1; bits++)
+            ;
+        fmt->rs[i] = bits > 8 ? shift + bits - 8 : shift < 32 ? shift : 0;
+        fmt->ls[i] = bits < 8 ? 8 - bits : 0;
+        fmt->mask[i] = bits > 8 ? 0xFF : (1 << bits) - 1;
+    }
+    fmt->rgb565 = fmt->bpp == 16 && red == 0xF800 && green == 0x07E0 && blue == 0x001F;
+    fmt->bgr888 = fmt->bpp == 32 && red == 0xFF0000 && green == 0xFF00 && blue == 0xFF;
+}
+
+
+/*******************************************************************************
+* Function Name  : Bmp_Row
+* Description    : Columns of a BMP row to RGB565
+* Input          : - fmt: format
+*                  - row: row as in the file
+*                  - sx: first column
+*                  - w: number of columns
+* Output         : - pixels: w colors
+* Return         : None
+* Attention      : Palettes are one lookup per pixel
+*******************************************************************************/
+static void Bmp_Row(const BmpFormat *fmt, const unsigned char *row, int sx, int w, unsigned short *pixels)
+{
+    const unsigned char *p;
+    unsigned long v;
+    unsigned char r, g, b;
+    int c, i;
+
+    switch (fmt->bpp)
+    {
+    case 1:
+        for (c = 0, i = sx; c < w; c++, i++)
+            pixels[c] = fmt->lut[row[i >> 3] >> (7 - (i & 7)) & 1];
+        break;
+    case 4:
+        for (c = 0, i = sx; c < w; c++, i++)
+            pixels[c] = fmt->lut[row[i >> 1] >> (i & 1 ? 0 : 4) & 0x0F];
+        break;
+    case 8:
+        for (c = 0, p = row + sx; c < w; c++)
+            pixels[c] = fmt->lut[*p++];
+        break;
+    case 24:
+        for (c = 0, p = row + 3 * sx; c < w; c++, p += 3)
+            pixels[c] = RGB565CONVERT(p[2], p[1], p[0]);
+        break;
+    default:                    /* 16 and 32 bits, masks */
+        for (c = 0, p = row + fmt->bpp / 8 * sx; c < w; c++, p += fmt->bpp / 8)
+        {
+            if (fmt->rgb565)
+            {
+                pixels[c] = p[0] | p[1] << 8;
+                continue;
+            }
+            if (fmt->bgr888)
+            {
+                pixels[c] = RGB565CONVERT(p[2], p[1], p[0]);
+                continue;
+            }
+            v = fmt->bpp == 16 ? Bmp_Le(p, 2) : Bmp_Le(p, 4);
+            r = (v >> fmt->rs[0] & fmt->mask[0]) << fmt->ls[0];
+            g = (v >> fmt->rs[1] & fmt->mask[1]) << fmt->ls[1];
+            b = (v >> fmt->rs[2] & fmt->mask[2]) << fmt->ls[2];
+            pixels[c] = RGB565CONVERT(r, g, b);
+        }
+        break;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_PutImage
+* Description    : Show BMP
+* Input          : x upper left corner image start
+*                  y upper left corner image start
+*                  file filename full qualified path
+* Output         : None
+* Return         : 0 success, -1 fail, also for a file cut short in the
+*                  rows shown: the rows read before the cut are drawn
+* Attention      : 1, 4 and 8 bits with a palette, 16 and 32 bits with or
+*                  without channel masks, 24 bits; bottom up or top down;
+*                  OS/2 and Windows headers. Not the RLE compressions
+*                  The palette is converted once to RGB565, rows are read
+*                  from the pixel data offset with their padding, in the
+*                  file order, and only the rows and columns inside the
+*                  clip are converted and sent
+*                  In LANDSCAPE the image is turned: its lines from the
+*                  bottom go up GRAM x from x, its columns along GRAM y
+*                  from y, one GRAM column per line
+*******************************************************************************/
+int LCD_PutImage(unsigned short x, unsigned short y, char* file)
+{
+    FILE *bmpInput;
+    BmpFormat fmt;
+    unsigned char head[BMP_HEADER], palette[256 * 4];
+    unsigned char *row = 0;
+    unsigned short *pixels = 0;
+    unsigned long header, offset, compression, nColors, entry, stride;
+    long cols, rows;
+    int r, i, X, Y, w, h, sx, sy, topDown, ok = 0;
+
+    API_ENTER(STATS_LCD_PUTIMAGE);
+
+    printf("Reading file %s\n", file);
+
+    /*----DECLARE INPUT AND OUTPUT FILES----*/
+    bmpInput = fopen(file, "rb");
+    if (!bmpInput)
+    {
+        API_LEAVE();
+        return -1;
+    }
+
+    /*-----GET BMP INFO-----*/
+    memset(head, 0, sizeof(head));
+    memset(&fmt, 0, sizeof(fmt));
+    if (fread(head, 1, sizeof(head), bmpInput) < 26 || head[0] != 'B' || head[1] != 'M')
+        goto done;
+    offset = Bmp_Le(head + 10, 4);
+    header = Bmp_Le(head + 14, 4);
+    if (header == 12)           /* OS/2 */
+    {
+        cols = Bmp_Le(head + 18, 2);
+        rows = Bmp_Le(head + 20, 2);
+        fmt.bpp = Bmp_Le(head + 24, 2);
+        compression = BMP_RGB;
+        nColors = 0;
+        entry = 3;
+    }
+    else if (header >= 40)
+    {
+        cols = (int)Bmp_Le(head + 18, 4);
+        rows = (int)Bmp_Le(head + 22, 4);
+        fmt.bpp = Bmp_Le(head + 28, 2);
+        compression = Bmp_Le(head + 30, 4);
+        nColors = Bmp_Le(head + 46, 4);
+        entry = 4;
+    }
+    else
+        goto done;
+    topDown = rows < 0;
+    if (topDown)
+        rows = -rows;
+
+    /*----PRINT BMP INFO TO SCREEN-----*/
+    printf("Width: %ld\n", cols);
+    printf("Height: %ld\n", rows);
+    printf("File size: %lu\n", Bmp_Le(head + 2, 4));
+    printf("Bits/pixel: %d\n", fmt.bpp);
+    printf("No. colors: %lu\n", nColors);
+
+    if (cols <= 0 || rows <= 0 || cols > 0x7FFF || rows > 0x7FFF)
+        goto done;
+    switch (fmt.bpp)
+    {
+    case 1: case 4: case 8:
+        /*----COLOR TABLE TO RGB565, ONCE-----*/
+        if (compression != BMP_RGB)
+            goto done;
+        if (!nColors || nColors > 1UL << fmt.bpp)
+            nColors = 1UL << fmt.bpp;
+        fseek(bmpInput, 14 + header, SEEK_SET);
+        if (fread(palette, entry, nColors, bmpInput) != nColors)
+            goto done;
+        for (i = 0; i < (int)nColors; i++)
+            fmt.lut[i] = RGB565CONVERT(palette[i * entry + 2], palette[i * entry + 1], palette[i * entry]);
+        break;
+    case 16: case 32:
+        /* masks right after the 40 bytes header, inside the larger ones */
+        if (compression == BMP_BITFIELDS || compression == BMP_ALPHABITFIELDS)
+            Bmp_Masks(&fmt, Bmp_Le(head + 54, 4), Bmp_Le(head + 58, 4), Bmp_Le(head + 62, 4));
+        else if (compression != BMP_RGB)
+            goto done;
+        else if (fmt.bpp == 16)
+            Bmp_Masks(&fmt, 0x7C00, 0x03E0, 0x001F);
+        else
+            Bmp_Masks(&fmt, 0xFF0000, 0xFF00, 0xFF);
+        break;
+    case 24:
+        if (compression != BMP_RGB)
+            goto done;
+        break;
+    default:
+        goto done;
+    }
+    /* rows are padded to 4 bytes */
+    stride = ((unsigned long)cols * fmt.bpp + 31) / 32 * 4;
+
+    /* Source rectangle of the visible part */
+    ok = 1;
+    X = (short)x + Dev->clip.ox;
+    Y = (short)y + Dev->clip.oy;
+    w = Dev->turned ? rows : cols;
+    h = Dev->turned ? cols : rows;
+    if (LCD_ClipSpan(&X, &Y, &w, &h, &sx, &sy))
+    {
+        row = malloc(stride);
+        pixels = malloc((Dev->turned ? h : w) * sizeof(unsigned short));
+        if (!row || !pixels)
+        {
+            ok = 0;
+            goto done;
+        }
+        if (Dev->turned)
+        {
+            /* line sx + r from the bottom to GRAM column X + r */
+            for (r = 0; r < w; r++)
+            {
+                if (topDown || !r)
+                    fseek(bmpInput, offset + (topDown ? rows - 1 - sx - r : sx) * stride, SEEK_SET);
+                if (fread(row, 1, stride, bmpInput) != stride)
+                {
+                    ok = 0;     /* file cut short */
+                    break;
+                }
+                Bmp_Row(&fmt, row, sy, h, pixels);
+                LCD_Window(X + r, Y, 1, h, 0);
+                LCD_WritePixels(pixels, h);
+            }
+            goto done;
+        }
+        /* bottom up rows: skip the rows below the clip, then fill the
+           window from its last line so that the file is streamed in its
+           own order */
+        fseek(bmpInput, offset + (topDown ? sy : rows - sy - h) * stride, SEEK_SET);
+        LCD_Window(X, Y, w, h, !topDown);
+
+        for(r=0; r<h; r++)
+        {
+            if (fread(row, 1, stride, bmpInput) != stride)
+            {
+                ok = 0;         /* file cut short */
+                break;
+            }
+            Bmp_Row(&fmt, row, sx, w, pixels);
+
+            /*---------PRINT ROW TO LCD---------*/
+            LCD_WritePixels(pixels, w);
+        }
+    }
+
+done:
+    free(row);
+    free(pixels);
+    fclose(bmpInput);
+    API_LEAVE();
+    return ok ? 0 : -1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Reset
+* Description    : LCD TFT Controller.
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_Reset()
+{
+    API_ENTER(STATS_LCD_RESET);
+
+    GPIO_Write(LCD_PIN_RESET, HIGH);   //reset is low active
+    DelayMicrosecondsNoSleep (5000);   //almost 1ms = 1000us
+    GPIO_Write(LCD_PIN_RESET, LOW);    //reset is low active
+    DelayMicrosecondsNoSleep (15000);  //almost 10ms = 10000us
+    GPIO_Write(LCD_PIN_RESET, HIGH);   //reset is low active
+    DelayMicrosecondsNoSleep (15000);  //almost 10ms = 10000us
+    API_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Init
+* Description    : Initialize TFT Controller.
+* Input          : ori LANDSCAPE_TOP, LANDSCAPE_FLIP, PORTRAIT or
+*                      PORTRAIT_FLIP, optionally | LCD_MIRROR; LANDSCAPE
+* Output         : None
+* Return         : None
+* Attention      : LANDSCAPE keeps the layout of the first driver: drawing
+*                  in GRAM coordinates as PORTRAIT, PutChar, LCD_Text and
+*                  LCD_PutImage turned a quarter, origin lower left corner
+*******************************************************************************/
+void LCD_Init(unsigned char ori)
+{
+    unsigned short DeviceCode;
+
+    API_ENTER(STATS_LCD_INIT);
+
+    GPIO_Write(LCD_PIN_BACKLIGHT, HIGH);   //HIGH=on, LOW=off;
+
+    Dev->bus->spiBegin(Dev->busContext);                          // MSB first, MODE3
+    SPI_ChipSelect(LCD_CS_LCD, Dev->writeDivider);                // 16 The default 4096
+
+    /* Send a some bytes to the slave and simultaneously read some bytes back
+       from the slave most SPI devices expect one or 2 bytes of command,
+       after which they will send back some data.
+       In such a case you will have the command bytes first in the buffer,
+       followed by as many 0 bytes as you expect returned data bytes.
+       after the transfer, you can the read the reply bytes from the buffer.
+       If you tie MISO to MOSI, you should read back what was sent. */
+
+    DeviceCode = LCD_ReadReg(0x0000);      /* Read ID   */
+    /* Different driver IC initialization */
+    if( DeviceCode == 0x9320 || DeviceCode == 0x9300 ) {
+	    printf("DeviceCode: %hu\n", DeviceCode);
+    } else {
+	    printf("other Code: %hu\n", DeviceCode);
+    }
+    /* The address counter follows the x axis of the orientation first,
+       then its y axis, so that blits stream in their natural order */
+    Dev->turned = (ori & 3) == LANDSCAPE && !(ori & LANDSCAPE_TOP);
+    Dev->orient = Dev->turned ? PORTRAIT : ori & 3;
+    Dev->mirror = (ori & LCD_MIRROR) != 0;
+    switch (Dev->orient) {
+    case 0:
+        Dev->entry = ILI9320_ENTRY_LANDSCAPE;
+        break;
+    case 1:
+        Dev->entry = ILI9320_ENTRY_PORTRAIT_FLIP;
+        break;
+    case 2:
+        Dev->entry = ILI9320_ENTRY_LANDSCAPE_FLIP;
+        break;
+    case 3:
+        Dev->entry = ILI9320_ENTRY_PORTRAIT;
+        break;
+    }
+    if (Dev->mirror)                    /* reverse the direction along a line */
+        Dev->entry ^= (Dev->entry & ENTRY_AM) ? ENTRY_ID1 : ENTRY_ID0;
+    Dev->width = (Dev->orient & 1) ? MAX_X : MAX_Y;
+    Dev->height = (Dev->orient & 1) ? MAX_Y : MAX_X;
+    LCD_ResetClip();
+
+#define LCD_INIT_WRITE(reg, value, ms) \
+    LCD_WriteReg(reg, value); \
+    if (ms) Dev->bus->delay(Dev->busContext, ms);
+    ILI9320_INIT_LIST(LCD_INIT_WRITE, Dev->entry, MAX_X - 1, MAX_Y - 1)
+#undef LCD_INIT_WRITE
+    Dev->windowFull = 1;
+    API_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_WriteReg
+* Description    : Writes to the selected LCD register.
+* Input          : - LCD_Reg: address of the selected register.
+*                  - LCD_RegValue: value to write to the selected register.
+* Output         : None
+* Return         : None
+* Attention      : Cursor, window and entry mode writes whose value is
+*                  already in place are skipped
+*******************************************************************************/
+void LCD_WriteReg( unsigned short LCD_Reg, unsigned short LCD_RegValue)
+{
+    DEV_LOCK();
+    if (!Shadow_Redundant(LCD_Reg, LCD_RegValue))
+    {
+        STATS_REGWRITE();
+        /* Write 16-bit Index, then Write Reg */
+        LCD_WriteIndex(LCD_Reg);
+        /* Write 16-bit Reg */
+        LCD_WriteData(LCD_RegValue);
+    }
+    DEV_UNLOCK();
+}
+
+
+/*******************************************************************************
+* Function Name  : SPI_Transfer
+* Description    : Send len bytes and read back len bytes on the selected CS
+* Input          : - buf: bytes to send
+*                  - len: number of bytes
+* Output         : - buf: bytes received
+* Return         : None
+* Attention      : Every bus access of the driver goes through here
+*******************************************************************************/
+static void SPI_Transfer(char *buf, unsigned int len)
+{
+    STATS_TRANSFER(len);
+    TRACE_TRANSFER_HOOK(buf, len);
+    Dev->bus->spiTransfer(Dev->busContext, buf, len);
+}
+
+
+/*******************************************************************************
+* Function Name  : SPI_Write
+* Description    : Send head then buf as one transfer on the selected CS,
+*                  nothing read back
+* Input          : - head: first bytes, the start byte
+*                  - headLen: number of bytes of head
+*                  - buf: bytes sent after head, 0 if len is 0
+*                  - len: number of bytes of buf
+* Output         : None
+* Return         : None
+* Attention      : Without spiWrite in the transport head and buf go through
+*                  spiTransfer, head in place when len is 0: the bytes
+*                  received may then overwrite it
+*******************************************************************************/
+static void SPI_Write(char *head, unsigned int headLen, const char *buf, unsigned int len)
+{
+    STATS_TRANSFER(headLen + len);
+    TRACE_WRITE_HOOK(head, headLen, buf, len);
+    if (Dev->bus->spiWrite)
+    {
+        Dev->bus->spiWrite(Dev->busContext, head, headLen, buf, len);
+        return;
+    }
+    if (len)
+    {
+        memmove(Dev->burstBuf, head, headLen);
+        memcpy(Dev->burstBuf + headLen, buf, len);
+        head = Dev->burstBuf;
+    }
+    Dev->bus->spiTransfer(Dev->busContext, head, headLen + len);
+}
+
+
+/*******************************************************************************
+* Function Name  : SPI_ChipSelect
+* Description    : Select the SPI slave and its clock divider
+* Input          : - cs: LCD_CS_LCD or LCD_CS_TOUCH
+*                  - divider: SPI clock divider for the slave
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void SPI_ChipSelect(unsigned char cs, unsigned short divider)
+{
+    STATS_CHIPSELECT(cs);
+    TRACE_SELECT_HOOK(cs, divider);
+    Dev->bus->spiSelect(Dev->busContext, cs, divider);
+}
+
+
+/*******************************************************************************
+* Function Name  : SPI_ReadSpeed
+* Description    : Clock of the LCD reads around a read transfer
+* Input          : - on: 1 before the read, 0 after it
+* Output         : None
+* Return         : None
+* Attention      : Nothing is sent while reads and writes share the divider
+*******************************************************************************/
+static void SPI_ReadSpeed(int on)
+{
+    if (Dev->readDivider != Dev->writeDivider)
+        SPI_ChipSelect(LCD_CS_LCD, on ? Dev->readDivider : Dev->writeDivider);
+}
+
+
+/*******************************************************************************
+* Function Name  : GPIO_Write
+* Description    : Drive the reset or the backlight pin
+* Input          : - pin: LCD_PIN_RESET or LCD_PIN_BACKLIGHT
+*                  - level: HIGH or LOW
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void GPIO_Write(unsigned char pin, unsigned char level)
+{
+    if (pin == LCD_PIN_RESET)
+        LCD_ShadowInvalidate();     /* registers back to their reset values */
+    TRACE_GPIO_HOOK(pin, level);
+    Dev->bus->gpioWrite(Dev->busContext, pin, level);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_WriteIndex
+* Description    : LCD write register address
+* Input          : - index: register address
+* Output         : None
+* Return         : None
+* Attention      : Skipped if the index register already holds it
+*******************************************************************************/
+void LCD_WriteIndex(unsigned char index)
+{
+    char buf[] = { SPI_START | SPI_WR | SPI_INDEX, 0, index};
+
+    DEV_LOCK();
+    if (Dev->shadowIndex != index)
+    {
+        SPI_Write(buf, sizeof(buf), 0, 0);
+        Dev->shadowIndex = index;
+    }
+    DEV_UNLOCK();
+    //uncomment for debug
+    //printf("SPI: WriteIndex: %02X  %02X  %02X \n", buf[0], buf[1], buf[2]);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_WriteData
+* Description    : LCD write register data
+* Input          : - data: register data
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_WriteData( unsigned short data)
+{
+    char buf[] = { SPI_START | SPI_WR | SPI_DATA, (data >>   8), (data & 0xFF)};
+
+    DEV_LOCK();
+    SPI_Write(buf, sizeof(buf), 0, 0);
+    Shadow_Data(data);
+    DEV_UNLOCK();
+    //uncomment for debug
+    //printf("SPI: WriteData: %02X  %02X  %02X \n", buf[0], buf[1], buf[2]);
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_SetPoint
+* Description    : Drawn at a specified point coordinates
+* Input          : - Xpos: Row Coordinate
+*                  - Ypos: Line Coordinate
+* Output         : None
+* Return         : None
+* Attention      : Coordinates are relative to the viewport and signed, so
+*                  that Xpos - 15 near the left edge is clipped, not wrapped.
+*                  Points following each other along the x axis cost the
+*                  data word only, the address counter is already there
+*******************************************************************************/
+void LCD_SetPoint( unsigned short Xpos, unsigned short Ypos, unsigned short point)
+{
+    int x, y;
+
+    API_ENTER(STATS_LCD_SETPOINT);
+    x = (short)Xpos + Dev->clip.ox;
+    y = (short)Ypos + Dev->clip.oy;
+    if( x >= Dev->clip.x0 && x < Dev->clip.x1 && y >= Dev->clip.y0 && y < Dev->clip.y1 )
+        LCD_Pixel(x, y, point);
+    API_LEAVE();
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_Pixel
+* Description    : Draw a point already clipped
+* Input          : - x, y: screen coordinates
+*                  - point: color
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void LCD_Pixel(int x, int y, unsigned short point)
+{
+    unsigned short gx, gy;
+
+    if (!Dev->windowFull)
+        LCD_FullWindow();
+    LCD_MapPoint(x, y, &gx, &gy);
+    LCD_SetCursor(gx,gy);
+    LCD_WriteReg(0x0022,point);   // (REG, VALUE)
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_SetPoints
+* Description    : Draw many points of one color
+* Input          : - points: coordinates, relative to the viewport
+*                  - n: number of points
+*                  - color: color of every point
+* Output         : None
+* Return         : None
+* Attention      : Points are sorted in scan order and horizontally adjacent
+*                  points are sent as one burst, so the order of the array
+*                  does not matter
+*******************************************************************************/
+void LCD_SetPoints(const Coordinate *points, unsigned int n, unsigned short color)
+{
+    API_ENTER(STATS_LCD_SETPOINTS);
+    LCD_Points(points, 0, n, color);
+    API_LEAVE();
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_SetPointsColors
+* Description    : Draw many points, each with its own color
+* Input          : - points: coordinates, relative to the viewport
+*                  - colors: color of each point
+*                  - n: number of points
+* Output         : None
+* Return         : None
+* Attention      : As LCD_SetPoints; of two points at the same place the
+*                  last one in the array is drawn
+*******************************************************************************/
+void LCD_SetPointsColors(const Coordinate *points, const unsigned short *colors, unsigned int n)
+{
+    API_ENTER(STATS_LCD_SETPOINTS);
+    LCD_Points(points, colors, n, 0);
+    API_LEAVE();
+}
+
+
+/******************************************************************************
+* Function Name  : Points_Compare
+* Description    : qsort order of the scan order keys
+* Input          : - a, b: keys
+* Output         : None
+* Return         : <0, 0, >0
+* Attention      : None
+*******************************************************************************/
+static int Points_Compare(const void *a, const void *b)
+{
+    unsigned long long ka = *(const unsigned long long *)a;
+    unsigned long long kb = *(const unsigned long long *)b;
+
+    return ka < kb ? -1 : ka > kb;
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_Points
+* Description    : Clip, sort and draw points as runs
+* Input          : - points: coordinates, relative to the viewport
+*                  - colors: color of each point, 0 to use color
+*                  - n: number of points
+*                  - color: color of every point when colors is 0
+* Output         : None
+* Return         : None
+* Attention      : A run is a burst from the cursor in the full window: the
+*                  address counter moves along the x axis of every
+*                  orientation and a run never crosses the right edge
+*******************************************************************************/
+static void LCD_Points(const Coordinate *points, const unsigned short *colors, unsigned int n, unsigned short color)
+{
+    unsigned long long *keys;
+    unsigned int i, k, m, len;
+    unsigned short gx, gy;
+    int x, y, runX, runY;
+
+    if (n > Dev->pointKeysSize)
+    {
+        keys = realloc(Dev->pointKeys, n * sizeof(*keys));
+        if (!keys)
+        {
+            for (i = 0; i < n; i++)     /* no memory, one by one */
+                LCD_SetPoint(points[i].x, points[i].y, colors ? colors[i] : color);
+            return;
+        }
+        Dev->pointKeys = keys;
+        Dev->pointKeysSize = n;
+    }
+    keys = Dev->pointKeys;
+
+    for (i = m = 0; i < n; i++)
+    {
+        x = (short)points[i].x + Dev->clip.ox;
+        y = (short)points[i].y + Dev->clip.oy;
+        if (x < Dev->clip.x0 || x >= Dev->clip.x1 || y < Dev->clip.y0 || y >= Dev->clip.y1)
+            continue;
+        keys[m++] = ((unsigned long long)(y << 9 | x) << 32) | i;
+    }
+    if (!m)
+        return;
+    qsort(keys, m, sizeof(*keys), Points_Compare);
+
+    if (!Dev->windowFull)
+        LCD_FullWindow();
+    for (k = 0; k < m; k += len)
+    {
+        runY = keys[k] >> 41;
+        runX = (keys[k] >> 32) & 0x1FF;
+        Dev->runBuf[0] = colors ? colors[keys[k] & 0xFFFFFFFF] : color;
+        len = 1;
+        x = runX;
+        while (k + len < m && (keys[k + len] >> 41) == (unsigned int)runY)
+        {
+            i = (keys[k + len] >> 32) & 0x1FF;
+            if ((int)i == x)
+            {
+                /* same place again, the later point wins */
+                if (colors)
+                    Dev->runBuf[x - runX] = colors[keys[k + len] & 0xFFFFFFFF];
+            }
+            else if ((int)i == x + 1)
+            {
+                x++;
+                Dev->runBuf[x - runX] = colors ? colors[keys[k + len] & 0xFFFFFFFF] : color;
+            }
+            else
+                break;
+            len++;
+        }
+        LCD_MapPoint(runX, runY, &gx, &gy);
+        LCD_SetCursor(gx, gy);
+        if (colors)
+            LCD_WritePixels(Dev->runBuf, x - runX + 1);
+        else
+            LCD_WriteColor(color, x - runX + 1);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_ReadReg
+* Description    : Reads the selected LCD Register.
+* Input          : None
+* Output         : None
+* Return         : LCD Register Value.
+* Attention       : Registers written since the last reset are answered
+*                   from the shadow, the device code and GRAM from the panel
+*******************************************************************************/
+unsigned short LCD_ReadReg( unsigned short LCD_Reg)
+{
+    unsigned short LCD_RAM;
+
+    API_ENTER(STATS_LCD_READREG);
+    if (LCD_Reg == 0x20 && (Dev->acValid & AC_X))
+    {
+        API_LEAVE();
+        return Dev->acX;
+    }
+    if (LCD_Reg == 0x21 && (Dev->acValid & AC_Y))
+    {
+        API_LEAVE();
+        return Dev->acY;
+    }
+    if (LCD_Reg > 0x00 && LCD_Reg < 0x20 && Dev->shadowValid[LCD_Reg])
+    {
+        API_LEAVE();
+        return Dev->shadowReg[LCD_Reg];
+    }
+    if (LCD_Reg > 0x22 && LCD_Reg < 256 && Dev->shadowValid[LCD_Reg])
+    {
+        API_LEAVE();
+        return Dev->shadowReg[LCD_Reg];
+    }
+    /* Write 16-bit Index (then Read Reg) */
+    LCD_WriteIndex(LCD_Reg);
+    /* Read 16-bit Reg */
+    LCD_RAM = LCD_ReadData();
+    API_LEAVE();
+
+    return LCD_RAM;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_ReadData
+* Description    : LCD read data
+* Input          : None
+* Output         : None
+* Return         : return data
+* Attention    : None
+*******************************************************************************/
+unsigned short LCD_ReadData(void)
+{
+    unsigned short value;
+    char buf[] = { SPI_START | SPI_RD | SPI_DATA, 0, 0,0}; // Data to send
+
+    DEV_LOCK();
+    SPI_ReadSpeed(1);
+    SPI_Transfer(buf, sizeof(buf));
+    SPI_ReadSpeed(0);
+    value = (unsigned char)buf[3] + ((unsigned char)buf[2]<<8);
+    if (Dev->shadowIndex == 0x22 || Dev->shadowIndex == INDEX_UNKNOWN)
+        Dev->acValid = 0;                /* GRAM reads are pipelined, AC is not modeled */
+    DEV_UNLOCK();
+
+    return value;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SetCursor
+* Description    : Sets the cursor position.
+* Input          : - Xpos: specifies the X position.
+*                  - Ypos: specifies the Y position.
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void LCD_SetCursor( unsigned short Xpos, unsigned short Ypos )
+{
+    /* 0x9320 */
+    LCD_WriteReg(0x0020, Xpos );
+    LCD_WriteReg(0x0021, Ypos );
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_MapPoint
+* Description    : Screen coordinates of the orientation to GRAM address
+* Input          : - Xpos: x, 0 to LCD_GetWidth() - 1
+*                  - Ypos: y, 0 to LCD_GetHeight() - 1
+* Output         : - gx: GRAM column, register 0x20
+*                  - gy: GRAM row, register 0x21
+* Return         : None
+* Attention      : Origin is the upper left corner in every orientation
+*******************************************************************************/
+static void LCD_MapPoint(unsigned short Xpos, unsigned short Ypos, unsigned short *gx, unsigned short *gy)
+{
+    if (Dev->mirror)
+        Xpos = Dev->width - 1 - Xpos;
+    switch (Dev->orient)
+    {
+    case 0:
+        *gx = MAX_X - 1 - Ypos;
+        *gy = Xpos;
+        break;
+    case 1:
+        *gx = MAX_X - 1 - Xpos;
+        *gy = MAX_Y - 1 - Ypos;
+        break;
+    case 2:
+        *gx = Ypos;
+        *gy = MAX_Y - 1 - Xpos;
+        break;
+    default:
+        *gx = Xpos;
+        *gy = Ypos;
+        break;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Window
+* Description    : Restrict GRAM writes to a rectangle of the screen and
+*                  place the cursor on its first pixel
+* Input          : - Xpos, Ypos: upper left corner
+*                  - w, h: size, inside the screen
+*                  - bottomUp: 1 to fill the lines from the last one up
+* Output         : None
+* Return         : None
+* Attention      : Only the registers that change are written
+*******************************************************************************/
+static void LCD_Window(unsigned short Xpos, unsigned short Ypos, unsigned short w, unsigned short h, int bottomUp)
+{
+    unsigned short x0, y0, x1, y1, gx, gy, mode = Dev->entry;
+
+    LCD_MapPoint(Xpos, Ypos, &x0, &y0);
+    LCD_MapPoint(Xpos + w - 1, Ypos + h - 1, &x1, &y1);
+    if (bottomUp)               /* reverse the direction from line to line */
+        mode ^= (mode & ENTRY_AM) ? ENTRY_ID0 : ENTRY_ID1;
+
+    LCD_WriteReg(0x03, mode);
+    LCD_WriteReg(0x50, x0 < x1 ? x0 : x1);
+    LCD_WriteReg(0x51, x0 < x1 ? x1 : x0);
+    LCD_WriteReg(0x52, y0 < y1 ? y0 : y1);
+    LCD_WriteReg(0x53, y0 < y1 ? y1 : y0);
+    Dev->windowFull = Xpos == 0 && Ypos == 0 && w == Dev->width && h == Dev->height && !bottomUp;
+
+    LCD_MapPoint(Xpos, bottomUp ? Ypos + h - 1 : Ypos, &gx, &gy);
+    LCD_SetCursor(gx, gy);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_FullWindow
+* Description    : Window back to the whole screen, entry mode of the
+*                  orientation
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : The cursor is not moved
+*******************************************************************************/
+static void LCD_FullWindow(void)
+{
+    LCD_WriteReg(0x03, Dev->entry);
+    LCD_WriteReg(0x50, 0);
+    LCD_WriteReg(0x51, MAX_X - 1);
+    LCD_WriteReg(0x52, 0);
+    LCD_WriteReg(0x53, MAX_Y - 1);
+    Dev->windowFull = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SetWindow
+* Description    : Restrict GRAM writes to a rectangle of the screen, for
+*                  LCD_WritePixels
+* Input          : - Xpos, Ypos: upper left corner
+*                  - w, h: size
+* Output         : None
+* Return         : 1 success, 0 rectangle not entirely on the screen
+* Attention      : Pixels are then written line by line, left to right and
+*                  top to bottom as seen in the orientation. Screen
+*                  coordinates, the clip and the viewport do not apply
+*******************************************************************************/
+int LCD_SetWindow(unsigned short Xpos, unsigned short Ypos, unsigned short w, unsigned short h)
+{
+    int ok;
+
+    DEV_LOCK();
+    ok = w && h && Xpos + w <= Dev->width && Ypos + h <= Dev->height;
+    if (ok)
+        LCD_Window(Xpos, Ypos, w, h, 0);
+    DEV_UNLOCK();
+    return ok;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_ImageWindow
+* Description    : Restrict GRAM writes to the visible part of an image, for
+*                  decoders streaming it line by line with LCD_WritePixels
+* Input          : - Xpos, Ypos: upper left corner of the image
+*                  - w, h: size of the image
+* Output         : - span: columns and lines of the image that are visible
+* Return         : 1 success, 0 nothing visible
+* Attention      : The clip and the viewport apply. The caller sends span->w
+*                  pixels of each line from span->sy to span->sy + span->h - 1,
+*                  starting at column span->sx, with nothing drawn in between
+*                  (LCD_Lock when the device is shared)
+*******************************************************************************/
+int LCD_ImageWindow(short Xpos, short Ypos, unsigned short w, unsigned short h, LCD_ImageSpan *span)
+{
+    int x, y, cw = w, ch = h, sx, sy, ok;
+
+    DEV_LOCK();
+    x = Xpos + Dev->clip.ox;
+    y = Ypos + Dev->clip.oy;
+    ok = LCD_ClipSpan(&x, &y, &cw, &ch, &sx, &sy);
+    if (ok)
+    {
+        span->sx = sx;
+        span->sy = sy;
+        span->w = cw;
+        span->h = ch;
+        LCD_Window(x, y, cw, ch, 0);
+    }
+    DEV_UNLOCK();
+    return ok;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_WritePixels
+* Description    : Stream pixels to GRAM from the address counter on
+* Input          : - pixels: RGB565 colors
+*                  - n: number of pixels
+* Output         : None
+* Return         : None
+* Attention      : One start byte per BURST_PIXELS pixels, no address
+*******************************************************************************/
+void LCD_WritePixels(const unsigned short *pixels, unsigned int n)
+{
+    char *buf;
+    unsigned int i, len;
+
+    DEV_LOCK();
+    buf = Dev->burstBuf;
+    LCD_WriteIndex(0x0022);
+    while (n)
+    {
+        len = n < BURST_PIXELS ? n : BURST_PIXELS;
+        buf[0] = SPI_START | SPI_WR | SPI_DATA;
+        for (i = 0; i < len; i++)
+        {
+            buf[1 + 2 * i] = pixels[i] >> 8;
+            buf[2 + 2 * i] = pixels[i] & 0xFF;
+        }
+        Shadow_AdvanceN(len);
+        SPI_Write(buf, 1 + 2 * len, 0, 0);
+        pixels += len;
+        n -= len;
+    }
+    DEV_UNLOCK();
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_WritePixelsBE
+* Description    : Stream pixels already in bus order to GRAM from the
+*                  address counter on
+* Input          : - pixels: RGB565 colors, high byte first in memory
+*                  - n: number of pixels
+* Output         : None
+* Return         : None
+* Attention      : Sent from the caller's memory, not copied, one start
+*                  byte per BURST_PIXELS pixels. On a little endian CPU
+*                  swap each word once, e.g. when a sprite is loaded
+*******************************************************************************/
+void LCD_WritePixelsBE(const unsigned short *pixels, unsigned int n)
+{
+    char start = SPI_START | SPI_WR | SPI_DATA;
+    unsigned int len;
+
+    DEV_LOCK();
+    LCD_WriteIndex(0x0022);
+    while (n)
+    {
+        len = n < BURST_PIXELS ? n : BURST_PIXELS;
+        Shadow_AdvanceN(len);
+        SPI_Write(&start, 1, (const char *)pixels, 2 * len);
+        pixels += len;
+        n -= len;
+    }
+    DEV_UNLOCK();
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_WriteColor
+* Description    : Stream one color to GRAM from the address counter on
+* Input          : - color: RGB565 color
+*                  - n: number of pixels
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void LCD_WriteColor(unsigned short color, unsigned long n)
+{
+    unsigned int i, len;
+
+    LCD_WriteIndex(0x0022);
+    Dev->burstBuf[0] = SPI_START | SPI_WR | SPI_DATA;
+    for (i = 0; i < BURST_PIXELS && i < n; i++)
+    {
+        Dev->burstBuf[1 + 2 * i] = color >> 8;
+        Dev->burstBuf[2 + 2 * i] = color & 0xFF;
+    }
+    while (n)
+    {
+        len = n < BURST_PIXELS ? n : BURST_PIXELS;
+        Shadow_AdvanceN(len);
+        SPI_Write(Dev->burstBuf, 1 + 2 * len, 0, 0);
+        n -= len;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_ClipSpan
+* Description    : Clip a screen rectangle to the clip rectangle
+* Input          : - x, y, w, h: rectangle in screen coordinates
+* Output         : - x, y, w, h: visible part
+*                  - sx, sy: offset of the visible part in the rectangle
+* Return         : 1 if something is visible
+* Attention      : None
+*******************************************************************************/
+static int LCD_ClipSpan(int *x, int *y, int *w, int *h, int *sx, int *sy)
+{
+    int x1 = *x + *w, y1 = *y + *h;
+
+    *sx = *x < Dev->clip.x0 ? Dev->clip.x0 - *x : 0;
+    *sy = *y < Dev->clip.y0 ? Dev->clip.y0 - *y : 0;
+    *x += *sx;
+    *y += *sy;
+    if (x1 > Dev->clip.x1) x1 = Dev->clip.x1;
+    if (y1 > Dev->clip.y1) y1 = Dev->clip.y1;
+    *w = x1 - *x;
+    *h = y1 - *y;
+    return *w > 0 && *h > 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Fill
+* Description    : Fill a screen rectangle, clipped first
+* Input          : - x, y, w, h: rectangle in screen coordinates
+*                  - color: fill color
+* Output         : None
+* Return         : None
+* Attention      : One window, the visible pixels only
+*******************************************************************************/
+static void LCD_Fill(int x, int y, int w, int h, unsigned short color)
+{
+    int sx, sy;
+
+    if (!LCD_ClipSpan(&x, &y, &w, &h, &sx, &sy))
+        return;
+    if (w == 1 && h == 1)
+    {
+        LCD_Pixel(x, y, color);
+        return;
+    }
+    LCD_Window(x, y, w, h, 0);
+    LCD_WriteColor(color, (unsigned long)w * h);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Blit
+* Description    : Copy pixels to a screen rectangle, clipped first
+* Input          : - x, y, w, h: rectangle in screen coordinates
+*                  - pixels: w * h colors, line by line
+* Output         : None
+* Return         : None
+* Attention      : Only the visible part of the source is sent
+*******************************************************************************/
+static void LCD_Blit(int x, int y, int w, int h, const unsigned short *pixels)
+{
+    int sx, sy, cw, ch, j;
+
+    cw = w;
+    ch = h;
+    if (!LCD_ClipSpan(&x, &y, &cw, &ch, &sx, &sy))
+        return;
+    LCD_Window(x, y, cw, ch, 0);
+    if (cw == w)
+    {
+        LCD_WritePixels(pixels + sy * w, cw * ch);
+        return;
+    }
+    for (j = 0; j < ch; j++)
+        LCD_WritePixels(pixels + (sy + j) * w + sx, cw);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_PushClip
+* Description    : Restrict drawing to a rectangle inside the current clip
+* Input          : - Xpos, Ypos: upper left corner, relative to the viewport
+*                  - w, h: size
+* Output         : None
+* Return         : 1 success, 0 too many nested clips
+* Attention      : Undo with LCD_PopClip
+*******************************************************************************/
+int LCD_PushClip(short Xpos, short Ypos, unsigned short w, unsigned short h)
+{
+    int x0, y0;
+
+    DEV_LOCK();
+    if (Dev->clipDepth == CLIP_DEPTH)
+    {
+        DEV_UNLOCK();
+        return 0;
+    }
+    x0 = Xpos + Dev->clip.ox;
+    y0 = Ypos + Dev->clip.oy;
+    Dev->clipStack[Dev->clipDepth++] = Dev->clip;
+    if (x0 > Dev->clip.x0) Dev->clip.x0 = x0;
+    if (y0 > Dev->clip.y0) Dev->clip.y0 = y0;
+    if (x0 + w < Dev->clip.x1) Dev->clip.x1 = x0 + w;
+    if (y0 + h < Dev->clip.y1) Dev->clip.y1 = y0 + h;
+    if (Dev->clip.x1 < Dev->clip.x0) Dev->clip.x1 = Dev->clip.x0;   /* empty, nothing drawn */
+    if (Dev->clip.y1 < Dev->clip.y0) Dev->clip.y1 = Dev->clip.y0;
+    DEV_UNLOCK();
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_PushViewport
+* Description    : Move the origin of the drawing primitives to a rectangle
+*                  and restrict drawing to it
+* Input          : - Xpos, Ypos: new origin, relative to the current viewport
+*                  - w, h: size
+* Output         : None
+* Return         : 1 success, 0 too many nested clips
+* Attention      : Undo with LCD_PopClip
+*******************************************************************************/
+int LCD_PushViewport(short Xpos, short Ypos, unsigned short w, unsigned short h)
+{
+    DEV_LOCK();
+    if (!LCD_PushClip(Xpos, Ypos, w, h))
+    {
+        DEV_UNLOCK();
+        return 0;
+    }
+    Dev->clip.ox += Xpos;
+    Dev->clip.oy += Ypos;
+    Dev->clip.ow = w;
+    Dev->clip.oh = h;
+    DEV_UNLOCK();
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_PopClip
+* Description    : Back to the clip and viewport before the last push
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_PopClip(void)
+{
+    DEV_LOCK();
+    if (Dev->clipDepth)
+        Dev->clip = Dev->clipStack[--Dev->clipDepth];
+    DEV_UNLOCK();
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_ResetClip
+* Description    : Whole screen, origin upper left corner, empty stack
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : Done by LCD_Init
+*******************************************************************************/
+void LCD_ResetClip(void)
+{
+    DEV_LOCK();
+    Dev->clip.x0 = Dev->clip.y0 = 0;
+    Dev->clip.x1 = Dev->width;
+    Dev->clip.y1 = Dev->height;
+    Dev->clip.ox = Dev->clip.oy = 0;
+    Dev->clip.ow = Dev->width;
+    Dev->clip.oh = Dev->height;
+    Dev->clipDepth = 0;
+    DEV_UNLOCK();
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_FillRect
+* Description    : Fill a rectangle
+* Input          : - Xpos, Ypos: upper left corner, relative to the viewport
+*                  - w, h: size
+*                  - color: fill color
+* Output         : None
+* Return         : None
+* Attention      : Clipped before anything is sent
+*******************************************************************************/
+void LCD_FillRect(short Xpos, short Ypos, unsigned short w, unsigned short h, unsigned short color)
+{
+    API_ENTER(STATS_LCD_FILLRECT);
+    LCD_Fill(Xpos + Dev->clip.ox, Ypos + Dev->clip.oy, w, h, color);
+    API_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_GetWidth
+* Description    : Width of the screen in the orientation of LCD_Init
+* Input          : None
+* Output         : None
+* Return         : MAX_X in portrait, MAX_Y in landscape
+* Attention      : None
+*******************************************************************************/
+unsigned short LCD_GetWidth(void)
+{
+    unsigned short width;
+
+    DEV_LOCK();
+    width = Dev->width;
+    DEV_UNLOCK();
+    return width;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_GetHeight
+* Description    : Height of the screen in the orientation of LCD_Init
+* Input          : None
+* Output         : None
+* Return         : MAX_Y in portrait, MAX_X in landscape
+* Attention      : None
+*******************************************************************************/
+unsigned short LCD_GetHeight(void)
+{
+    unsigned short height;
+
+    DEV_LOCK();
+    height = Dev->height;
+    DEV_UNLOCK();
+    return height;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_ShadowInvalidate
+* Description    : Forget the register shadow, the next writes all go to the
+*                  panel
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : Needed only if something else than the driver accessed
+*                  the panel; a reset through LCD_Reset does it already
+*******************************************************************************/
+void LCD_ShadowInvalidate(void)
+{
+    DEV_LOCK();
+    memset(Dev->shadowValid, 0, sizeof(Dev->shadowValid));
+    Dev->shadowIndex = INDEX_UNKNOWN;
+    Dev->acValid = 0;
+    DEV_UNLOCK();
+}
+
+
+/*******************************************************************************
+* Function Name  : Shadow_Advance
+* Description    : Move the modeled address counter after a GRAM write
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : Wraps inside the window 0x50-0x53 as the ILI9320 does;
+*                  the model is dropped if entry mode or window are unknown
+*******************************************************************************/
+static void Shadow_Advance(void)
+{
+    unsigned short mode = Dev->shadowReg[0x03];
+    unsigned short hsa = Dev->shadowReg[0x50], hea = Dev->shadowReg[0x51];
+    unsigned short vsa = Dev->shadowReg[0x52], vea = Dev->shadowReg[0x53];
+    int wrapH = 0, wrapV = 0;
+
+    if (Dev->acValid != (AC_X | AC_Y) || !Dev->shadowValid[0x03] || !Dev->shadowValid[0x50]
+        || !Dev->shadowValid[0x51] || !Dev->shadowValid[0x52] || !Dev->shadowValid[0x53])
+    {
+        Dev->acValid = 0;
+        return;
+    }
+
+    if (mode & ENTRY_AM)
+    {
+        if (mode & ENTRY_ID1) { if (Dev->acY >= vea) { Dev->acY = vsa; wrapV = 1; } else Dev->acY++; }
+        else                  { if (Dev->acY <= vsa) { Dev->acY = vea; wrapV = 1; } else Dev->acY--; }
+        if (wrapV)
+        {
+            if (mode & ENTRY_ID0) Dev->acX = Dev->acX >= hea ? hsa : Dev->acX + 1;
+            else                  Dev->acX = Dev->acX <= hsa ? hea : Dev->acX - 1;
+        }
+    }
+    else
+    {
+        if (mode & ENTRY_ID0) { if (Dev->acX >= hea) { Dev->acX = hsa; wrapH = 1; } else Dev->acX++; }
+        else                  { if (Dev->acX <= hsa) { Dev->acX = hea; wrapH = 1; } else Dev->acX--; }
+        if (wrapH)
+        {
+            if (mode & ENTRY_ID1) Dev->acY = Dev->acY >= vea ? vsa : Dev->acY + 1;
+            else                  Dev->acY = Dev->acY <= vsa ? vea : Dev->acY - 1;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Shadow_AdvanceN
+* Description    : Move the modeled address counter after n GRAM writes
+* Input          : - n: number of words written
+* Output         : None
+* Return         : None
+* Attention      : Same as n Shadow_Advance, in one step when the counter is
+*                  inside the window
+*******************************************************************************/
+static void Shadow_AdvanceN(unsigned long n)
+{
+    unsigned short mode = Dev->shadowReg[0x03];
+    unsigned short hsa = Dev->shadowReg[0x50], hea = Dev->shadowReg[0x51];
+    unsigned short vsa = Dev->shadowReg[0x52], vea = Dev->shadowReg[0x53];
+    unsigned short *along, *across;
+    unsigned short aStart, aEnd, bStart, bEnd;
+    int aUp, bUp;
+    unsigned long pos, line;
+
+    if (!n)
+        return;
+    if (Dev->acValid != (AC_X | AC_Y) || !Dev->shadowValid[0x03] || !Dev->shadowValid[0x50]
+        || !Dev->shadowValid[0x51] || !Dev->shadowValid[0x52] || !Dev->shadowValid[0x53])
+    {
+        Dev->acValid = 0;
+        return;
+    }
+    /* a counter outside the window comes in by single steps */
+    while (n && (Dev->acX < hsa || Dev->acX > hea || Dev->acY < vsa || Dev->acY > vea))
+    {
+        Shadow_Advance();
+        n--;
+    }
+    if (!n)
+        return;
+
+    if (mode & ENTRY_AM)
+    {
+        along = &Dev->acY; aStart = vsa; aEnd = vea; aUp = mode & ENTRY_ID1;
+        across = &Dev->acX; bStart = hsa; bEnd = hea; bUp = mode & ENTRY_ID0;
+    }
+    else
+    {
+        along = &Dev->acX; aStart = hsa; aEnd = hea; aUp = mode & ENTRY_ID0;
+        across = &Dev->acY; bStart = vsa; bEnd = vea; bUp = mode & ENTRY_ID1;
+    }
+    pos = (aUp ? *along - aStart : aEnd - *along) + n;
+    line = bUp ? *across - bStart : bEnd - *across;
+    line = (line + pos / (aEnd - aStart + 1)) % (bEnd - bStart + 1);
+    pos %= aEnd - aStart + 1;
+    *along = aUp ? aStart + pos : aEnd - pos;
+    *across = bUp ? bStart + line : bEnd - line;
+}
+
+
+/*******************************************************************************
+* Function Name  : Shadow_Data
+* Description    : Record a data word written to the register of the index
+* Input          : - data: word written
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Shadow_Data(unsigned short data)
+{
+    switch (Dev->shadowIndex)
+    {
+    case INDEX_UNKNOWN:
+        LCD_ShadowInvalidate();     /* any register may have changed */
+        break;
+    case 0x22:
+        Shadow_Advance();
+        break;
+    case 0x20:
+        Dev->acX = data & 0xFF;
+        Dev->acValid |= AC_X;
+        break;
+    case 0x21:
+        Dev->acY = data & 0x1FF;
+        Dev->acValid |= AC_Y;
+        break;
+    default:
+        Dev->shadowReg[Dev->shadowIndex] = data;
+        Dev->shadowValid[Dev->shadowIndex] = 1;
+        break;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Shadow_Redundant
+* Description    : Test if a register write would leave the panel unchanged
+* Input          : - reg: register address
+*                  - value: value to write
+* Output         : None
+* Return         : 1 if the write can be skipped
+* Attention      : Only cursor, window and entry mode writes are skipped,
+*                  other registers may start an action when written
+*******************************************************************************/
+static int Shadow_Redundant(unsigned short reg, unsigned short value)
+{
+    switch (reg)
+    {
+    case 0x20:
+        return (Dev->acValid & AC_X) && Dev->acX == (value & 0xFF);
+    case 0x21:
+        return (Dev->acValid & AC_Y) && Dev->acY == (value & 0x1FF);
+    case 0x03:
+    case 0x50:
+    case 0x51:
+    case 0x52:
+    case 0x53:
+        return Dev->shadowValid[reg] && Dev->shadowReg[reg] == value;
+    default:
+        return 0;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : DelayMicrosecondsNoSleep
+* Description    : Delay n microseconds
+* Input          : delay_us: specifies the n microseconds
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void DelayMicrosecondsNoSleep (int delay_us)
+{
+    long int start_time;
+    long int time_difference;
+    struct timespec gettime_now;
+
+    clock_gettime(CLOCK_REALTIME, &gettime_now);
+    start_time = gettime_now.tv_nsec;		 //Get nS value
+
+    while (1)
+    {
+        clock_gettime(CLOCK_REALTIME, &gettime_now);
+        time_difference = gettime_now.tv_nsec - start_time;
+        if (time_difference < 0)
+	    time_difference += 1000000000;	 //(Rolls over every 1 second)
+	if (time_difference > (delay_us * 1000)) //Delay for # nS
+	    break;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : GetASCIICode
+* Description    : get ASCII code data
+* Input          : - ASCII: Input ASCII code
+* Output         : - *pBuffer: Store data pointer
+* Return         : None
+* Attention	     : None
+*******************************************************************************/
+void GetASCIICode(unsigned char* pBuffer,unsigned char ASCII)
+{
+    memcpy(pBuffer,AsciiLib[(ASCII - 32)] ,16);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Clear
+* Description    : Fill the screen as the specified color
+* Input          : - Color: Screen Color
+* Output         : None
+* Return         : None
+* Attention	     : The whole screen, whatever the clip rectangle
+*******************************************************************************/
+void LCD_Clear(unsigned short Color)
+{
+    API_ENTER(STATS_LCD_CLEAR);
+    LCD_Window(0, 0, Dev->width, Dev->height, 0);
+    LCD_WriteColor(Color, (unsigned long)Dev->width * Dev->height);
+    API_LEAVE();
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_BGR2RGB
+* Description    : RRRRRGGGGGGBBBBB To BBBBBGGGGGGRRRRR
+* Input          : - color: BRG Color value
+* Output         : None
+* Return         : RGB Color value
+* Attention	 : None
+*******************************************************************************/
+static unsigned short LCD_BGR2RGB( unsigned short color)
+{
+   unsigned short  r, g, b, rgb;
+
+   b = ( color>>0 )  & 0x1f;
+   g = ( color>>5 )  & 0x3f;
+   r = ( color>>11 ) & 0x1f;
+
+   rgb =  (b<<11) + (g<<5) + (r<<0);
+
+   return( rgb );
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_GetPoint
+* Description    : Get color value for the specified coordinates
+* Input          : - Xpos: Row Coordinate
+*                  - Xpos: Line Coordinate
+* Output         : None
+* Return         : Screen Color, 0 off the screen
+* Attention	     : Relative to the viewport, not clipped
+*******************************************************************************/
+unsigned short LCD_GetPoint( unsigned short Xpos, unsigned short Ypos)
+{
+   unsigned short dummy, gx, gy;
+   int x, y;
+
+   API_ENTER(STATS_LCD_GETPOINT);
+   x = (short)Xpos + Dev->clip.ox;
+   y = (short)Ypos + Dev->clip.oy;
+   if (x < 0 || x >= Dev->width || y < 0 || y >= Dev->height)
+   {
+       API_LEAVE();
+       return 0;
+   }
+   if (!Dev->windowFull)
+       LCD_FullWindow();
+   LCD_MapPoint(x, y, &gx, &gy);
+   Dev->acValid = 0;                /* the cursor write restarts the read pipeline */
+   LCD_SetCursor(gx,gy);
+   LCD_WriteIndex(0x0022);
+   dummy = LCD_ReadData();   /* An empty read */
+   dummy = LCD_ReadData();
+   API_LEAVE();
+
+   return  LCD_BGR2RGB(dummy);
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_ReadRect
+* Description    : Read back a rectangle of the screen
+* Input          : - Xpos, Ypos: upper left corner
+*                  - w, h: size
+* Output         : - buf: w * h RGB565 colors, line by line
+* Return         : 1 success, 0 rectangle not entirely on the screen
+* Attention      : One window for the whole rectangle; each burst of
+*                  BURST_PIXELS pixels sets the cursor and starts with the
+*                  dummy word of the GRAM read pipeline
+*******************************************************************************/
+int LCD_ReadRect(unsigned short Xpos, unsigned short Ypos, unsigned short w, unsigned short h, unsigned short *buf)
+{
+    unsigned long done = 0, total = (unsigned long)w * h;
+    unsigned int i, len;
+    unsigned short gx, gy;
+
+    API_ENTER(STATS_LCD_READRECT);
+    if (!w || !h || Xpos + w > Dev->width || Ypos + h > Dev->height)
+    {
+        API_LEAVE();
+        return 0;
+    }
+    Dev->acValid = 0;                /* the cursor write restarts the read pipeline */
+    LCD_Window(Xpos, Ypos, w, h, 0);
+
+    while (done < total)
+    {
+        len = total - done < BURST_PIXELS ? total - done : BURST_PIXELS;
+        if (done)
+        {
+            Dev->acValid = 0;
+            LCD_MapPoint(Xpos + done % w, Ypos + done / w, &gx, &gy);
+            LCD_SetCursor(gx, gy);
+        }
+        LCD_WriteIndex(0x0022);
+
+        Dev->burstBuf[0] = SPI_START | SPI_RD | SPI_DATA;
+        memset(Dev->burstBuf + 1, 0, 3 + 2 * len);
+        SPI_ReadSpeed(1);
+        SPI_Transfer(Dev->burstBuf, 4 + 2 * len);
+        SPI_ReadSpeed(0);
+        for (i = 0; i < len; i++)    /* skip start, dummy byte and dummy word */
+            buf[done + i] = LCD_BGR2RGB(((unsigned char)Dev->burstBuf[4 + 2 * i] << 8)
+                                        | (unsigned char)Dev->burstBuf[5 + 2 * i]);
+        done += len;
+    }
+    Dev->acValid = 0;
+    API_LEAVE();
+    return 1;
+}
+
+
+/******************************************************************************
+* Function Name  : Tune_Write
+* Description    : Write the probe window of LCD_TuneDividers
+* Input          : - divider: SPI clock divider of the pixels
+*                  - pixels: TUNE_W * TUNE_H colors
+* Output         : None
+* Return         : None
+* Attention      : Registers are written at TUNE_SAFE, only the pixels at
+*                  the divider tried
+*******************************************************************************/
+static void Tune_Write(unsigned short divider, const unsigned short *pixels)
+{
+    unsigned int i;
+
+    LCD_Window(0, 0, TUNE_W, TUNE_H, 0);
+    LCD_WriteIndex(0x0022);
+    Dev->burstBuf[0] = SPI_START | SPI_WR | SPI_DATA;
+    for (i = 0; i < TUNE_W * TUNE_H; i++)
+    {
+        Dev->burstBuf[1 + 2 * i] = pixels[i] >> 8;
+        Dev->burstBuf[2 + 2 * i] = pixels[i] & 0xFF;
+    }
+    Shadow_AdvanceN(TUNE_W * TUNE_H);
+    SPI_ChipSelect(LCD_CS_LCD, divider);
+    SPI_Write(Dev->burstBuf, 1 + 2 * TUNE_W * TUNE_H, 0, 0);
+    SPI_ChipSelect(LCD_CS_LCD, TUNE_SAFE);
+}
+
+
+/******************************************************************************
+* Function Name  : Tune_Read
+* Description    : Read back the probe window of LCD_TuneDividers
+* Input          : - divider: SPI clock divider of the pixels
+* Output         : - pixels: TUNE_W * TUNE_H colors
+* Return         : None
+* Attention      : Registers are written at TUNE_SAFE, only the pixels are
+*                  read at the divider tried
+*******************************************************************************/
+static void Tune_Read(unsigned short divider, unsigned short *pixels)
+{
+    unsigned int i;
+
+    Dev->acValid = 0;                /* the cursor write restarts the read pipeline */
+    LCD_Window(0, 0, TUNE_W, TUNE_H, 0);
+    LCD_WriteIndex(0x0022);
+    Dev->burstBuf[0] = SPI_START | SPI_RD | SPI_DATA;
+    memset(Dev->burstBuf + 1, 0, 3 + 2 * TUNE_W * TUNE_H);
+    SPI_ChipSelect(LCD_CS_LCD, divider);
+    SPI_Transfer(Dev->burstBuf, 4 + 2 * TUNE_W * TUNE_H);
+    SPI_ChipSelect(LCD_CS_LCD, TUNE_SAFE);
+    for (i = 0; i < TUNE_W * TUNE_H; i++)    /* skip start, dummy byte and dummy word */
+        pixels[i] = LCD_BGR2RGB(((unsigned char)Dev->burstBuf[4 + 2 * i] << 8)
+                                | (unsigned char)Dev->burstBuf[5 + 2 * i]);
+    Dev->acValid = 0;
+}
+
+
+/******************************************************************************
+* Function Name  : Tune_Errors
+* Description    : Words wrong in the probe window at one divider
+* Input          : - divider: SPI clock divider tried
+*                  - write: 1 to try it on the writes, 0 on the reads; the
+*                    other direction runs at TUNE_SAFE
+* Output         : None
+* Return         : number of words wrong over TUNE_PATTERNS patterns
+* Attention      : The patterns are pseudo random, the same on every run
+*******************************************************************************/
+static unsigned long Tune_Errors(unsigned short divider, int write)
+{
+    unsigned short pattern[TUNE_W * TUNE_H], back[TUNE_W * TUNE_H];
+    unsigned long seed = divider * 2 + write, errors = 0;
+    int i, k;
+
+    for (k = 0; k < TUNE_PATTERNS; k++)
+    {
+        for (i = 0; i < TUNE_W * TUNE_H; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            pattern[i] = seed >> 16;
+        }
+        Tune_Write(write ? divider : TUNE_SAFE, pattern);
+        Tune_Read(write ? TUNE_SAFE : divider, back);
+        for (i = 0; i < TUNE_W * TUNE_H; i++)
+            errors += pattern[i] != back[i];
+    }
+    return errors;
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_TuneDividers
+* Description    : Find the fastest SPI clocks of the panel: pseudo random
+*                  patterns are written to a window and read back at
+*                  dividers halved from TUNE_SAFE down to TUNE_FASTEST,
+*                  the writes and the reads are tried apart
+* Input          : None
+* Output         : - result: dividers found and set, may be 0
+* Return         : 1 success, 0 errors even at TUNE_SAFE, dividers unchanged
+* Attention      : Each divider set is TUNE_MARGIN steps slower than the
+*                  fastest one without error. The window in the upper left
+*                  corner of the screen is saved and put back. The dividers
+*                  belong to the device, LCD_SaveDividers keeps them
+*******************************************************************************/
+int LCD_TuneDividers(LCD_Dividers *result)
+{
+    unsigned short saved[TUNE_W * TUNE_H];
+    unsigned short oldWrite, oldRead, write = 0, read = 0, d;
+    int ok;
+
+    API_ENTER(STATS_LCD_TUNEDIVIDERS);
+    oldWrite = Dev->writeDivider;
+    oldRead = Dev->readDivider;
+    Dev->writeDivider = Dev->readDivider = TUNE_SAFE;
+    SPI_ChipSelect(LCD_CS_LCD, TUNE_SAFE);
+    Tune_Read(TUNE_SAFE, saved);
+
+    for (d = TUNE_SAFE; d >= TUNE_FASTEST && !Tune_Errors(d, 1); d /= 2)
+        write = d;
+    for (d = TUNE_SAFE; d >= TUNE_FASTEST && !Tune_Errors(d, 0); d /= 2)
+        read = d;
+    Tune_Write(TUNE_SAFE, saved);
+
+    ok = write && read;
+    if (ok)
+    {
+        Dev->writeDivider = write << TUNE_MARGIN < TUNE_SAFE ? write << TUNE_MARGIN : TUNE_SAFE;
+        Dev->readDivider = read << TUNE_MARGIN < TUNE_SAFE ? read << TUNE_MARGIN : TUNE_SAFE;
+    }
+    else
+    {
+        Dev->writeDivider = oldWrite;
+        Dev->readDivider = oldRead;
+    }
+    SPI_ChipSelect(LCD_CS_LCD, Dev->writeDivider);
+    if (result)
+    {
+        result->write = Dev->writeDivider;
+        result->read = Dev->readDivider;
+        result->writeFastest = write;
+        result->readFastest = read;
+    }
+    API_LEAVE();
+    return ok;
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_SetDividers
+* Description    : SPI clock dividers of the LCD
+* Input          : - write: divider of the writes, 0 for the default
+*                  - read: divider of the reads, 0 for the write one
+* Output         : None
+* Return         : None
+* Attention      : Kept by the device across LCD_Init
+*******************************************************************************/
+void LCD_SetDividers(unsigned short write, unsigned short read)
+{
+    DEV_LOCK();
+    Dev->writeDivider = write ? write : DIVIDER_CS0;
+    Dev->readDivider = read ? read : Dev->writeDivider;
+    SPI_ChipSelect(LCD_CS_LCD, Dev->writeDivider);
+    DEV_UNLOCK();
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_GetDividers
+* Description    : SPI clock dividers of the LCD in use
+* Input          : None
+* Output         : - write, read: dividers of the writes and of the reads
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_GetDividers(unsigned short *write, unsigned short *read)
+{
+    DEV_LOCK();
+    *write = Dev->writeDivider;
+    *read = Dev->readDivider;
+    DEV_UNLOCK();
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_SaveDividers
+* Description    : Save the SPI clock dividers of the device to a file
+* Input          : - path: file of this panel
+* Output         : None
+* Return         : 1 success, 0 fail
+* Attention      : One text line, "write 4 read 8"
+*******************************************************************************/
+int LCD_SaveDividers(const char *path)
+{
+    unsigned short write, read;
+    FILE *f;
+    int ok;
+
+    LCD_GetDividers(&write, &read);
+    f = fopen(path, "w");
+    if (!f)
+        return 0;
+    ok = fprintf(f, "write %hu read %hu\n", write, read) > 0;
+    return fclose(f) == 0 && ok;
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_LoadDividers
+* Description    : Set the SPI clock dividers saved by LCD_SaveDividers
+* Input          : - path: file of this panel
+* Output         : None
+* Return         : 1 success, 0 no file or not a dividers file
+* Attention      : Dividers are unchanged on failure
+*******************************************************************************/
+int LCD_LoadDividers(const char *path)
+{
+    unsigned short write, read;
+    FILE *f;
+    int n;
+
+    f = fopen(path, "r");
+    if (!f)
+        return 0;
+    n = fscanf(f, "write %hu read %hu", &write, &read);
+    fclose(f);
+    if (n != 2 || write < TUNE_FASTEST || read < TUNE_FASTEST)
+        return 0;
+    LCD_SetDividers(write, read);
+    return 1;
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_Screenshot
+* Description    : Save the screen, as seen in the orientation, to a file
+* Input          : - file: name ending in .ppm for binary PPM, BMP otherwise
+* Output         : None
+* Return         : 0 success, -1 fail
+* Attention      : BMP is 24 bits bottom up, the format LCD_PutImage reads
+*******************************************************************************/
+int LCD_Screenshot(char *file)
+{
+    FILE *out;
+    unsigned short *screen, *line;
+    unsigned char *row, header[54], r, g, b;
+    unsigned long rowSize, imageSize;
+    int x, y, ppm, ret = 0;
+    size_t len;
+
+    API_ENTER(STATS_LCD_SCREENSHOT);
+    len = strlen(file);
+    ppm = len > 4 && !strcmp(file + len - 4, ".ppm");
+    rowSize = (Dev->width * 3 + 3) & ~3UL;
+    screen = malloc((unsigned long)Dev->width * Dev->height * sizeof(unsigned short));
+    row = malloc(rowSize);
+    out = fopen(file, "wb");
+    if (!screen || !row || !out || !LCD_ReadRect(0, 0, Dev->width, Dev->height, screen))
+    {
+        free(screen);
+        free(row);
+        if (out)
+            fclose(out);
+        API_LEAVE();
+        return -1;
+    }
+
+    if (ppm)
+    {
+        fprintf(out, "P6\n%u %u\n255\n", Dev->width, Dev->height);
+    }
+    else
+    {
+        imageSize = rowSize * Dev->height;
+        memset(header, 0, sizeof(header));
+        header[0] = 'B';
+        header[1] = 'M';
+        for (x = 0; x < 4; x++)
+        {
+            header[2 + x] = ((54 + imageSize) >> (8 * x)) & 0xFF;    /* file size */
+            header[18 + x] = (Dev->width >> (8 * x)) & 0xFF;
+            header[22 + x] = (Dev->height >> (8 * x)) & 0xFF;
+            header[34 + x] = (imageSize >> (8 * x)) & 0xFF;
+        }
+        header[10] = 54;        /* pixel data offset */
+        header[14] = 40;        /* info header size */
+        header[26] = 1;         /* planes */
+        header[28] = 24;        /* bits per pixel */
+        fwrite(header, 1, sizeof(header), out);
+    }
+
+    for (y = 0; y < Dev->height; y++)
+    {
+        line = screen + (unsigned long)(ppm ? y : Dev->height - 1 - y) * Dev->width;
+        memset(row, 0, rowSize);
+        for (x = 0; x < Dev->width; x++)
+        {
+            /* replicate the top bits in the low ones, RGB for PPM, BGR for BMP */
+            r = (line[x] >> 11) << 3;
+            g = ((line[x] >> 5) & 0x3F) << 2;
+            b = (line[x] & 0x1F) << 3;
+            r |= r >> 5;
+            g |= g >> 6;
+            b |= b >> 5;
+            row[3 * x] = ppm ? r : b;
+            row[3 * x + 1] = g;
+            row[3 * x + 2] = ppm ? b : r;
+        }
+        if (fwrite(row, 1, ppm ? Dev->width * 3UL : rowSize, out) != (ppm ? Dev->width * 3UL : rowSize))
+            ret = -1;
+    }
+    if (fclose(out))
+        ret = -1;
+    free(screen);
+    free(row);
+    API_LEAVE();
+    return ret;
+}
+
+
+/******************************************************************************
+* Function Name  : PutChar
+* Description    : Lcd screen displays a character
+* Input          : - Xpos: Horizontal coordinate
+*                  - Ypos: Vertical coordinate
+*		   - ASCI: Displayed character
+*		   - charColor: Character color
+*		   - bkColor: Background color
+* Output         : None
+* Return         : None
+* Attention	 : In LANDSCAPE the character is turned: its lines go
+*                  down GRAM x from Ypos, its columns along GRAM y from Xpos
+*******************************************************************************/
+void PutChar(unsigned short Xpos, unsigned short Ypos, unsigned char ASCI, unsigned short charColor, unsigned short bkColor )
+{
+    unsigned short i, j;
+    unsigned char buffer[16], tmp_char;
+    unsigned short pixels[16 * 8], turned[8 * 16];
+
+    API_ENTER(STATS_PUTCHAR);
+    GetASCIICode(buffer,ASCI);  /* get font data */
+
+    for( i=0; i<16; i++ )
+    {
+        tmp_char = buffer[i];
+        for( j=0; j<8; j++ )
+        {
+            if( ((tmp_char >> (7 - j)) & 0x01) == 0x01 )
+            {
+                pixels[i * 8 + j] = charColor; /* Character color */
+            }
+            else
+            {
+                pixels[i * 8 + j] = bkColor;   /* Background color */
+            }
+        }
+    }
+
+    if (Dev->turned)
+    {
+        /* GRAM window 16 x 8, its column k is line 15 - k of the character */
+        for( i=0; i<16; i++ )
+            for( j=0; j<8; j++ )
+                turned[j * 16 + 15 - i] = pixels[i * 8 + j];
+        LCD_Blit((short)Ypos - 15 + Dev->clip.ox, (short)Xpos + Dev->clip.oy, 16, 8, turned);
+    }
+    else
+        LCD_Blit((short)Xpos + Dev->clip.ox, (short)Ypos + Dev->clip.oy, 8, 16, pixels);
+    API_LEAVE();
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_Text
+* Description    : Displays the string
+* Input          : - Xpos: Horizontal coordinate
+*                  - Ypos: Vertical coordinate
+*		   - str: Displayed string
+*		   - charColor: Character color
+*		   - bkColor: Background color
+* Output         : None
+* Return         : None
+* Attention      : Wraps at the right and bottom edges of the viewport
+*******************************************************************************/
+void LCD_Text(unsigned short Xpos, unsigned short Ypos, char *str, unsigned short Color, unsigned short bkColor)
+{
+    unsigned short TempChar;
+
+    API_ENTER(STATS_LCD_TEXT);
+    do
+    {
+        TempChar = *str++;
+        PutChar( Xpos, Ypos, TempChar, Color, bkColor );
+        if( (short)Xpos < Dev->clip.ow - 8 )
+        {
+            Xpos += 8;
+        }
+        else if ( (short)Ypos < Dev->clip.oh - 16 )
+        {
+            Xpos = 0;
+            Ypos += 16;
+        }
+        else
+        {
+            Xpos = 0;
+            Ypos = 0;
+        }
+    }
+    while ( *str != 0 );
+    API_LEAVE();
+}
+
+
+/******************************************************************************
+* Function Name  : sgn
+* Description    : return the sign of number
+* Input          : - nu: the number
+* Output         : None
+* Return         : 1 if > 0; -1 if < 0; 0 of = 0
+* Attention      : None
+*******************************************************************************/
+int sgn(int nu)
+{
+    if (nu > 0) return 1;
+    if (nu < 0) return -1;
+    if (nu == 0) return 0;
+
+    return 0;
+}
+
+
+/******************************************************************************
+* Function Name  : Raster_DivFloor
+* Description    : Division rounded down, for negative numerators too
+* Input          : - a: numerator
+*                  - b: denominator, > 0
+* Output         : None
+* Return         : floor(a / b)
+* Attention      : None
+*******************************************************************************/
+static long long Raster_DivFloor(long long a, long long b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+
+/******************************************************************************
+* Function Name  : Raster_OutCode
+* Description    : Cohen-Sutherland outcode of a point
+* Input          : - clip: rectangle
+*                  - x, y: screen coordinates
+* Output         : None
+* Return         : OUT_x bits of the clip edges the point is beyond
+* Attention      : None
+*******************************************************************************/
+static int Raster_OutCode(const LCD_RasterClip *clip, int x, int y)
+{
+    int code = 0;
+
+    if (x < clip->x0) code |= OUT_LEFT;
+    else if (x >= clip->x1) code |= OUT_RIGHT;
+    if (y < clip->y0) code |= OUT_TOP;
+    else if (y >= clip->y1) code |= OUT_BOTTOM;
+    return code;
+}
+
+
+/******************************************************************************
+* Function Name  : Raster_Span
+* Description    : Emit a rectangle clipped to the clip rectangle
+* Input          : - clip: rectangle
+*                  - x, y, w, h: rectangle in screen coordinates
+*                  - emit, target: output
+* Output         : None
+* Return         : None
+* Attention      : Nothing is emitted when no pixel is inside
+*******************************************************************************/
+static void Raster_Span(const LCD_RasterClip *clip, int x, int y, int w, int h,
+                        LCD_RasterEmit emit, void *target)
+{
+    int x1 = x + w, y1 = y + h;
+
+    if (x < clip->x0) x = clip->x0;
+    if (y < clip->y0) y = clip->y0;
+    if (x1 > clip->x1) x1 = clip->x1;
+    if (y1 > clip->y1) y1 = clip->y1;
+    if (x < x1 && y < y1)
+        emit(target, x, y, x1 - x, y1 - y);
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_RasterLine
+* Description    : Bresenham's line clipped to a rectangle, the rasterizer
+*                  of LCD_DrawLine and of the scene tiles
+* Input          : - clip: rectangle drawn in
+*                  - ax, ay: A point, screen coordinates
+*                  - bx, by: B point
+*                  - emit, target: output, called with the pixels inside
+*                    the clip
+* Output         : None
+* Return         : None
+* Attention      : Clipped before rasterization: the outcodes reject the
+*                  lines outside the clip, horizontal and vertical lines are
+*                  one span, the others get the range of Bresenham steps
+*                  that is inside the clip, so the visible pixels are the
+*                  ones of the whole line, emitted one by one
+*******************************************************************************/
+void LCD_RasterLine(const LCD_RasterClip *clip, int ax, int ay, int bx, int by,
+                    LCD_RasterEmit emit, void *target)
+{
+    int dM, dm, sM, sm, M, m, Mlo, Mhi, mlo, mhi, e, n, nEnd, xMajor;
+    long long h, lo, hi, k;
+
+    if (Raster_OutCode(clip, ax, ay) & Raster_OutCode(clip, bx, by))
+        return;                 /* both ends beyond the same edge */
+    if (ay == by)
+    {
+        Raster_Span(clip, ax < bx ? ax : bx, ay, abs(bx - ax) + 1, 1, emit, target);
+        return;
+    }
+    if (ax == bx)
+    {
+        Raster_Span(clip, ax, ay < by ? ay : by, 1, abs(by - ay) + 1, emit, target);
+        return;
+    }
+
+    /* Major axis M steps every pixel, minor axis m after n steps is
+       m + sm * floor((h + n * dm) / dM) */
+    xMajor = abs(bx - ax) >= abs(by - ay);
+    if (xMajor)
+    {
+        M = ax; m = ay; dM = abs(bx - ax); dm = abs(by - ay);
+        sM = sgn(bx - ax); sm = sgn(by - ay);
+        Mlo = clip->x0; Mhi = clip->x1 - 1; mlo = clip->y0; mhi = clip->y1 - 1;
+    }
+    else
+    {
+        M = ay; m = ax; dM = abs(by - ay); dm = abs(bx - ax);
+        sM = sgn(by - ay); sm = sgn(bx - ax);
+        Mlo = clip->y0; Mhi = clip->y1 - 1; mlo = clip->x0; mhi = clip->x1 - 1;
+    }
+    h = dM >> 1;
+
+    /* Steps inside the clip along the major axis */
+    lo = sM > 0 ? Mlo - M : M - Mhi;
+    hi = sM > 0 ? Mhi - M : M - Mlo;
+    if (lo < 0) lo = 0;
+    if (hi > dM) hi = dM;
+
+    /* and along the minor axis: floor((h + n * dm) / dM) within [k0, k1] */
+    k = sm > 0 ? mlo - m : m - mhi;
+    n = -Raster_DivFloor(h - k * dM, dm);           /* ceil((k * dM - h) / dm) */
+    if (n > lo) lo = n;
+    k = sm > 0 ? mhi - m : m - mlo;
+    n = Raster_DivFloor((k + 1) * dM - h - 1, dm);
+    if (n < hi) hi = n;
+    if (lo > hi)
+        return;
+
+    n = lo;
+    nEnd = hi;
+    M += sM * n;
+    m += sm * (int)((h + (long long)n * dm) / dM);
+    e = (h + (long long)n * dm) % dM;
+    for (; n <= nEnd; n++)
+    {
+        if (xMajor)
+            emit(target, M, m, 1, 1);
+        else
+            emit(target, m, M, 1, 1);
+        e += dm;
+        if (e >= dM)
+        {
+            e -= dM;
+            m += sm;
+        }
+        M += sM;
+    }
+}
+
+
+/******************************************************************************
+* Function Name  : Raster_Point
+* Description    : Emit a point if it is inside the clip rectangle
+* Input          : - clip: rectangle
+*                  - x, y: screen coordinates
+*                  - emit, target: output
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Raster_Point(const LCD_RasterClip *clip, int x, int y, LCD_RasterEmit emit, void *target)
+{
+    if (x >= clip->x0 && x < clip->x1 && y >= clip->y0 && y < clip->y1)
+        emit(target, x, y, 1, 1);
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_RasterCircle
+* Description    : Midpoint circle clipped to a rectangle, the rasterizer of
+*                  LCD_DrawCircle and of the scene tiles
+* Input          : - clip: rectangle drawn in
+*                  - cx, cy: center, screen coordinates
+*                  - r: radius
+*                  - emit, target: output, called with each point inside
+*                    the clip
+* Output         : None
+* Return         : None
+* Attention      : The 8 symmetric points before and after each step, some
+*                  of them twice
+*******************************************************************************/
+void LCD_RasterCircle(const LCD_RasterClip *clip, int cx, int cy, int r,
+                      LCD_RasterEmit emit, void *target)
+{
+    int x = 0, y = r, p = 1 - r, i;
+
+    if (cx + r < clip->x0 || cx - r >= clip->x1 || cy + r < clip->y0 || cy - r >= clip->y1)
+        return;                 /* bounding box outside the clip */
+    while (x < y)
+    {
+        for (i = 0; i < 2; i++)
+        {
+            Raster_Point(clip, cx + x, cy + y, emit, target);
+            Raster_Point(clip, cx - x, cy + y, emit, target);
+            Raster_Point(clip, cx + x, cy - y, emit, target);
+            Raster_Point(clip, cx - x, cy - y, emit, target);
+            Raster_Point(clip, cx + y, cy + x, emit, target);
+            Raster_Point(clip, cx - y, cy + x, emit, target);
+            Raster_Point(clip, cx + y, cy - x, emit, target);
+            Raster_Point(clip, cx - y, cy - x, emit, target);
+            if (i)
+                break;
+            x++;
+            if (p < 0)
+                p = p + 2 * x + 1;
+            else
+            {
+                y--;
+                p = p + 2 * (x - y) + 1;
+            }
+        }
+    }
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_RasterCircleFill
+* Description    : Inside of a circle clipped to a rectangle, the rasterizer
+*                  of LCD_DrawCircleFill and of the scene tiles
+* Input          : - clip: rectangle drawn in
+*                  - cx, cy: center, screen coordinates
+*                  - r: radius
+*                  - emit, target: output, called with one span per line
+* Output         : None
+* Return         : None
+* Attention      : xc*xc + yc*yc <= r*r for xc, yc in [-r, r-1]; only the
+*                  lines inside the clip are computed. The border is
+*                  LCD_RasterCircle
+*******************************************************************************/
+void LCD_RasterCircleFill(const LCD_RasterClip *clip, int cx, int cy, int r,
+                          LCD_RasterEmit emit, void *target)
+{
+    int yc, xmax, s, top, bottom;
+
+    top = clip->y0 - cy > -r ? clip->y0 - cy : -r;
+    bottom = clip->y1 - cy < r ? clip->y1 - cy : r;
+    for (yc = top; yc < bottom; yc++)
+    {
+        s = (int)sqrt((double)r * r - (double)yc * yc);
+        while ((s + 1) * (s + 1) + yc * yc <= r * r) s++;
+        while (s * s + yc * yc > r * r) s--;
+        xmax = s < r - 1 ? s : r - 1;
+        Raster_Span(clip, cx - s, cy + yc, xmax + s + 1, 1, emit, target);
+    }
+}
+
+
+/******************************************************************************
+* Function Name  : Raster_Clip
+* Description    : Clip rectangle of the selected device
+* Input          : None
+* Output         : - clip: its clip, screen coordinates
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Raster_Clip(LCD_RasterClip *clip)
+{
+    clip->x0 = Dev->clip.x0;
+    clip->y0 = Dev->clip.y0;
+    clip->x1 = Dev->clip.x1;
+    clip->y1 = Dev->clip.y1;
+}
+
+
+/******************************************************************************
+* Function Name  : Raster_Fill
+* Description    : LCD_RasterEmit of the drawing functions: fill on the panel
+* Input          : - target: color
+*                  - x, y, w, h: rectangle inside the clip
+* Output         : None
+* Return         : None
+* Attention      : A single point goes as a pixel
+*******************************************************************************/
+static void Raster_Fill(void *target, int x, int y, int w, int h)
+{
+    LCD_Fill(x, y, w, h, *(const unsigned short *)target);
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_DrawLine
+* Description    : Bresenham's line algorithm
+* Input          : - x1: A point line coordinates
+*                  - y1: A point column coordinates
+*                  - x2: B point line coordinates
+*                  - y2: B point column coordinates
+*                  - col: Line color
+* Output         : None
+* Return         : None
+* Attention      : LCD_RasterLine in the clip: horizontal and vertical
+*                  lines are filled as spans, the others drawn pixel by
+*                  pixel
+*******************************************************************************/
+void LCD_DrawLine(unsigned short x1, unsigned short y1, unsigned short x2, unsigned short y2, unsigned short col)
+{
+    LCD_RasterClip clip;
+
+    API_ENTER(STATS_LCD_DRAWLINE);
+    Raster_Clip(&clip);
+    LCD_RasterLine(&clip, (short)x1 + Dev->clip.ox, (short)y1 + Dev->clip.oy,
+                   (short)x2 + Dev->clip.ox, (short)y2 + Dev->clip.oy, Raster_Fill, &col);
+    API_LEAVE();
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_DrawBox
+* Description    : Multiple line  makes box
+* Input          : - x1: A point line coordinates upper left corner
+*                  - y1: A point column coordinates
+*                  - x2: B point line coordinates lower right corner
+*                  - y2: B point column coordinates
+*                  - col: Line color
+* Output         : None
+* Return         : None
+******************************************************************************/
+void LCD_DrawBox(unsigned short x0, unsigned short y0, unsigned short x1, unsigned short y1 , unsigned short col, int fcol )
+{
+    int w = (short)x1 - (short)x0 - 1, h = (short)y1 - (short)y0 - 1;
+
+    API_ENTER(STATS_LCD_DRAWBOX);
+    LCD_DrawLine(x0, y0, x1, y0, col);
+    LCD_DrawLine(x1, y0, x1, y1, col);
+    LCD_DrawLine(x0, y0, x0, y1, col);
+    LCD_DrawLine(x0, y1, x1, y1, col);
+
+    if  (fcol!=-1 && w > 0 && h > 0)
+    {
+        LCD_Fill((short)x0 + 1 + Dev->clip.ox, (short)y0 + 1 + Dev->clip.oy, w, h, (unsigned short)fcol);
+    }
+    API_LEAVE();
+}
+
+
+/******************************************************************************
+* Function Name  : Raster_Points
+* Description    : LCD_RasterEmit of LCD_DrawCircle: gather the points
+* Input          : - target: RasterPoints
+*                  - x, y: point inside the clip
+*                  - w, h: 1
+* Output         : None
+* Return         : None
+* Attention      : Sent to LCD_Points CIRCLE_POINTS at a time
+*******************************************************************************/
+static void Raster_Points(void *target, int x, int y, int w, int h)
+{
+    RasterPoints *p = (RasterPoints *)target;
+
+    if (p->n == CIRCLE_POINTS)
+    {
+        LCD_Points(p->pts, 0, p->n, p->color);
+        p->n = 0;
+    }
+    p->pts[p->n].x = x - Dev->clip.ox;
+    p->pts[p->n].y = y - Dev->clip.oy;
+    p->n++;
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_DrawCircle
+* Description    : Draw a circle
+* Input          : - xc: A point line coordinates center
+*                  - yc: A point column coordinates center
+*                  - r: radius of circle
+*                  - col: Line color
+* Output         : None
+* Return         : None
+* Attention      : LCD_RasterCircle in the clip, the points go to
+*                  LCD_SetPoints CIRCLE_POINTS at a time
+******************************************************************************/
+void LCD_DrawCircle(unsigned short xc, unsigned short yc, unsigned short r, unsigned short col)
+{
+    RasterPoints points;
+    LCD_RasterClip clip;
+
+    API_ENTER(STATS_LCD_DRAWCIRCLE);
+    points.n = 0;
+    points.color = col;
+    Raster_Clip(&clip);
+    LCD_RasterCircle(&clip, (short)xc + Dev->clip.ox, (short)yc + Dev->clip.oy, r, Raster_Points, &points);
+    if (points.n)
+        LCD_Points(points.pts, 0, points.n, col);
+    API_LEAVE();
+}
+
+
+/******************************************************************************
+* Function Name  : LCD_DrawCircleFill
+* Description    : Draw a circle filled
+* Input          : - xc: A point line coordinates center
+*                  - yc: A point column coordinates center
+*                  - r: radius of circle
+*                  - bcol: border color
+*                  - col: fill color
+* Output         : None
+* Return         : None
+* Attention      : LCD_RasterCircleFill in the clip, one span per line
+******************************************************************************/
+void LCD_DrawCircleFill(unsigned short x, unsigned short y, unsigned short r, unsigned short bcol, unsigned short col) {
+    LCD_RasterClip clip;
+
+    API_ENTER(STATS_LCD_DRAWCIRCLEFILL);
+    Raster_Clip(&clip);
+    LCD_RasterCircleFill(&clip, (short)x + Dev->clip.ox, (short)y + Dev->clip.oy, r, Raster_Fill, &col);
+    if (col != bcol) LCD_DrawCircle(x, y, r, bcol);
+    API_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name  : TP_Init
+* Description    : ADS7843 SPI Initialization
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention	 : None
+*******************************************************************************/
+void TP_Init(void)
+{
+    // CS1 polarity, IRQ pin as input with pullup and falling edge detect
+    DEV_LOCK();
+    Dev->bus->irqInit(Dev->busContext);
+    DEV_UNLOCK();
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_DisplayOn
+* Description    : Switch display on via software
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_DisplayOn(void)
+{
+    API_ENTER(STATS_LCD_DISPLAYON);
+    LCD_WriteReg(0x07, 0x0173);
+    API_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_DisplayOff
+* Description    : Switch display of via software
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_DisplayOff(void)
+{
+    API_ENTER(STATS_LCD_DISPLAYOFF);
+    LCD_WriteReg(0x07, 0x0000);
+    API_LEAVE();
+}
+
+
+/******************************************************************************
+* Function Name  : Read_X
+* Description    : Read display X position of touch panel
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+unsigned short Read_X(void)
+{
+    unsigned short x = 0;
+    char buf[3];
+
+    API_ENTER(STATS_READ_X);
+    SPI_ChipSelect(LCD_CS_TOUCH, DIVIDER_CS1);
+    buf[0] = CHX;
+    buf[1] = 0;
+    buf[2] = 0;
+    SPI_Transfer(buf, 3);
+    x = buf[1];
+    x <<= 8;
+    x += buf[2];
+    x >>= 4;
+    x &= 0x0fff;
+    SPI_ChipSelect(LCD_CS_LCD, Dev->writeDivider);
+    API_LEAVE();
+
+    return x;
+}
+
+
+/*******************************************************************************
+* Function Name  : Read_Y
+* Description    : Read display Y position of touch panel
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+unsigned short Read_Y(void)
+{
+    unsigned short y = 0;
+    char buf[3];
+
+    API_ENTER(STATS_READ_Y);
+    SPI_ChipSelect(LCD_CS_TOUCH, DIVIDER_CS1);
+    buf[0] = CHY;
+    buf[1] = 0;
+    buf[2] = 0;
+    SPI_Transfer(buf, 3);
+    y = buf[1];
+    y <<= 8;
+    y += buf[2];
+    y >>= 4;
+    y &= 0x0fff;
+    SPI_ChipSelect(LCD_CS_LCD, Dev->writeDivider);
+    API_LEAVE();
+
+    return y;
+}
+
+
+/*******************************************************************************
+* Function Name  : TP_GetAdXY
+* Description    : Read ADS7843 ADC value of X + Y + channel
+* Input          : None
+* Output         : None
+* Return         : return X + Y + channel ADC value
+* Attention	     : None
+*******************************************************************************/
+void TP_GetAdXY(int *x,int *y)
+{
+    int adx,ady;
+    DEV_LOCK();
+    adx = Read_X();
+    ady = Read_Y();
+    DEV_UNLOCK();
+    *x = adx;
+    *y = ady;
+}
+
+
+/*******************************************************************************
+* Function Name  : TP_DrawPoint
+* Description    : Draw point Must have a LCD driver
+* Input          : - Xpos: Row Coordinate
+*                  - Ypos: Line Coordinate
+* Output         : None
+* Return         : None
+* Attention	     : None
+*******************************************************************************/
+void TP_DrawPoint(unsigned short Xpos,unsigned short Ypos)
+{
+    Coordinate dot[4];
+
+    API_ENTER(STATS_TP_DRAWPOINT);
+    LAT_MARK(LAT_DRAW);
+    dot[0].x = Xpos;     dot[0].y = Ypos;       /* Center point */
+    dot[1].x = Xpos + 1; dot[1].y = Ypos;
+    dot[2].x = Xpos;     dot[2].y = Ypos + 1;
+    dot[3].x = Xpos + 1; dot[3].y = Ypos + 1;
+    LCD_SetPoints(dot, 4, 0xf800);
+    LAT_MARK(LAT_SPI);
+    API_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name  : DrawCross
+* Description    : specified coordinates painting crosshairs
+* Input          : - Xpos: Row Coordinate
+*                  - Ypos: Line Coordinate 
+* Output         : None
+* Return         : None
+* Attention	     : None
+*******************************************************************************/
+void DrawCross(unsigned short Xpos,unsigned short Ypos)
+{
+    API_ENTER(STATS_DRAWCROSS);
+    LCD_DrawLine(Xpos-15,Ypos,Xpos-2,Ypos,0xffff);
+
+    LCD_DrawLine(Xpos+2,Ypos,Xpos+15,Ypos,0xffff);
+
+    LCD_DrawLine(Xpos,Ypos-15,Xpos,Ypos-2,0xffff);
+
+    LCD_DrawLine(Xpos,Ypos+2,Xpos,Ypos+15,0xffff);
+    API_LEAVE();
+
+    //LCD_DrawLine(Xpos-15,Ypos+15,Xpos-7,Ypos+15,RGB565CONVERT(184,158,131));
+    //LCD_DrawLine(Xpos-15,Ypos+7,Xpos-15,Ypos+15,RGB565CONVERT(184,158,131));
+
+    //LCD_DrawLine(Xpos-15,Ypos-15,Xpos-7,Ypos-15,RGB565CONVERT(184,158,131));
+    //LCD_DrawLine(Xpos-15,Ypos-7,Xpos-15,Ypos-15,RGB565CONVERT(184,158,131));
+
+    //LCD_DrawLine(Xpos+7,Ypos+15,Xpos+15,Ypos+15,RGB565CONVERT(184,158,131));
+    //LCD_DrawLine(Xpos+15,Ypos+7,Xpos+15,Ypos+15,RGB565CONVERT(184,158,131));
+
+    //LCD_DrawLine(Xpos+7,Ypos-15,Xpos+15,Ypos-15,RGB565CONVERT(184,158,131));
+    //LCD_DrawLine(Xpos+15,Ypos-15,Xpos+15,Ypos-7,RGB565CONVERT(184,158,131));
+}
+
+
+/*******************************************************************************
+* Function Name  : Read_Ads7846
+* Description    : X Y obtained after filtering
+* Input          : None
+* Output         : None
+* Return         : Coordinate Structure address
+* Attention	     : None
+*******************************************************************************/
+Coordinate *Read_Ads7846(void)
+{
+    int m0,m1,m2,TP_X[1],TP_Y[1],temp[3];
+    unsigned char count = 0;
+    int buffer[2][9] = {{0},{0}};  /* Multiple sampling coordinates X and Y */
+
+    API_ENTER(STATS_READ_ADS7846);
+    do  /* Loop sampling 9 times */
+    {
+        if (! IRQ_Test())
+        {
+            if (count == 0)
+                LAT_MARK(LAT_IRQ);
+            TP_GetAdXY(TP_X,TP_Y);
+            LAT_MARK(LAT_SAMPLE);
+	    buffer[0][count] = TP_X[0];
+	    buffer[1][count] = TP_Y[0];
+	    count++;
+	}
+    }
+    /* when user clicks on the touch screen, IRQ_Test() 
+       touchscreen interrupt pin will be set to low */
+    while( ! IRQ_Test() && count < 9 );
+
+    if( count == 9 )   /* Successful sampling 9, filtering */
+    {
+    /* In order to reduce the amount of computation, were divided into three groups averaged */
+    temp[0] = ( buffer[0][0] + buffer[0][1] + buffer[0][2] ) / 3;
+	temp[1] = ( buffer[0][3] + buffer[0][4] + buffer[0][5] ) / 3;
+	temp[2] = ( buffer[0][6] + buffer[0][7] + buffer[0][8] ) / 3;
+	/* Calculate the three groups of data */
+	m0 = temp[0] - temp[1];
+	m1 = temp[1] - temp[2];
+	m2 = temp[2] - temp[0];
+	/* Absolute value of the above difference */
+	m0 = m0 > 0 ? m0 : (-m0);
+        m1 = m1 > 0 ? m1 : (-m1);
+	m2 = m2 > 0 ? m2 : (-m2);
+	/* Judge whether the absolute difference exceeds the difference between the threshold, 
+	   If these three absolute difference exceeds the threshold, 
+       The sampling point is judged as outliers, Discard sampling points */
+	if( m0 > THRESHOLD  &&  m1 > THRESHOLD  &&  m2 > THRESHOLD )
+	{
+	    API_LEAVE();
+	    return 0;
+	}
+	/* Calculating their average value */
+	if( m0 < m1 )
+	{
+	    if( m2 < m0 )
+	    {
+	        Dev->sample.x = ( temp[0] + temp[2] ) / 2;
+	    }
+	    else
+	    {
+ 	        Dev->sample.x = ( temp[0] + temp[1] ) / 2;
+	    }
+	}
+	else if(m2<m1)
+	{
+ 	    Dev->sample.x = ( temp[0] + temp[2] ) / 2;
+	}
+	else
+	{
+ 	    Dev->sample.x = ( temp[1] + temp[2] ) / 2;
+	}
+
+	/* calculate the average value of Y */
+    temp[0] = ( buffer[1][0] + buffer[1][1] + buffer[1][2] ) / 3;
+	temp[1] = ( buffer[1][3] + buffer[1][4] + buffer[1][5] ) / 3;
+	temp[2] = ( buffer[1][6] + buffer[1][7] + buffer[1][8] ) / 3;
+
+	m0 = temp[0] - temp[1];
+	m1 = temp[1] - temp[2];
+	m2 = temp[2] - temp[0];
+
+	m0 = m0 > 0 ? m0 : (-m0);
+	m1 = m1 > 0 ? m1 : (-m1);
+	m2 = m2 > 0 ? m2 : (-m2);
+	if( m0 > THRESHOLD && m1 > THRESHOLD && m2 > THRESHOLD )
+	{
+	    API_LEAVE();
+	    return 0;
+	}
+
+	if( m0 < m1 )
+	{
+	    if( m2 < m0 )
+	    {
+	        Dev->sample.y = ( temp[0] + temp[2] ) / 2;
+	    }
+	    else
+	    {
+    	        Dev->sample.y = ( temp[0] + temp[1] ) / 2;
+            }
+        }
+	else if( m2 < m1 )
+	{
+	    Dev->sample.y = ( temp[0] + temp[2] ) / 2;
+	}
+	else
+	{
+    	    Dev->sample.y = ( temp[1] + temp[2] ) / 2;
+        }
+
+        //printf("x: %4u -  y: %4u\n", Dev->sample.x, Dev->sample.y);
+       Dev->screen.x = Dev->sample.x;
+       Dev->screen.y = Dev->sample.y;
+
+       LAT_MARK(LAT_POINT);
+       API_LEAVE();
+       return &Dev->sample;
+    }
+
+    API_LEAVE();
+    return 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : setCalibrationMatrix
+* Description    : Calculated K A B C D E F
+* Input          : None
+* Output         : None
+* Return         : return 1 success , return 0 fail
+* Attention	     : None
+*******************************************************************************/
+FunctionalState setCalibrationMatrix( Coordinate * displayPtr, Coordinate * screenPtr, Matrix * matrixPtr)
+{
+
+    FunctionalState retTHRESHOLD = ENABLE ;
+
+    matrixPtr->Divider = ((screenPtr[0].x - screenPtr[2].x) * (screenPtr[1].y - screenPtr[2].y)) -
+                         ((screenPtr[1].x - screenPtr[2].x) * (screenPtr[0].y - screenPtr[2].y)) ;
+    if( matrixPtr->Divider == 0 )
+    {
+        retTHRESHOLD = DISABLE;
+    }
+    else
+    {
+
+        matrixPtr->An = ((displayPtr[0].x - displayPtr[2].x) * (screenPtr[1].y - screenPtr[2].y)) -
+                        ((displayPtr[1].x - displayPtr[2].x) * (screenPtr[0].y - screenPtr[2].y)) ;
+
+        matrixPtr->Bn = ((screenPtr[0].x - screenPtr[2].x) * (displayPtr[1].x - displayPtr[2].x)) -
+                        ((displayPtr[0].x - displayPtr[2].x) * (screenPtr[1].x - screenPtr[2].x)) ;
+
+        matrixPtr->Cn = (screenPtr[2].x * displayPtr[1].x - screenPtr[1].x * displayPtr[2].x) * screenPtr[0].y +
+                        (screenPtr[0].x * displayPtr[2].x - screenPtr[2].x * displayPtr[0].x) * screenPtr[1].y +
+                        (screenPtr[1].x * displayPtr[0].x - screenPtr[0].x * displayPtr[1].x) * screenPtr[2].y ;
+
+        matrixPtr->Dn = ((displayPtr[0].y - displayPtr[2].y) * (screenPtr[1].y - screenPtr[2].y)) -
+                        ((displayPtr[1].y - displayPtr[2].y) * (screenPtr[0].y - screenPtr[2].y)) ;
+
+        matrixPtr->En = ((screenPtr[0].x - screenPtr[2].x) * (displayPtr[1].y - displayPtr[2].y)) -
+                        ((displayPtr[0].y - displayPtr[2].y) * (screenPtr[1].x - screenPtr[2].x)) ;
+
+        matrixPtr->Fn = (screenPtr[2].x * displayPtr[1].y - screenPtr[1].x * displayPtr[2].y) * screenPtr[0].y +
+                        (screenPtr[0].x * displayPtr[2].y - screenPtr[2].x * displayPtr[0].y) * screenPtr[1].y +
+                        (screenPtr[1].x * displayPtr[0].y - screenPtr[0].x * displayPtr[1].y) * screenPtr[2].y ;
+    }
+    return( retTHRESHOLD ) ;
+}
+
+
+/*******************************************************************************
+* Function Name  : getDisplayPoint
+* Description    : channel XY via K A B C D E F value converted to the LCD screen coordinates
+* Input          : None
+* Output         : None
+* Return         : return 1 success , return 0 fail
+* Attention	     : None
+*******************************************************************************/
+FunctionalState getDisplayPoint(Coordinate * displayPtr, Coordinate * screenPtr, Matrix * matrixPtr)
+{
+    FunctionalState retTHRESHOLD = ENABLE ;
+    long double an, bn, cn, dn, en, fn, sx, sy, md;
+
+    /*an = matrixPtr->An;
+    bn = matrixPtr->Bn;
+    cn = matrixPtr->Cn;
+    dn = matrixPtr->Dn;
+    en = matrixPtr->En;
+    fn = matrixPtr->Fn;
+
+    sx = screenPtr->x;
+    sy = screenPtr->y;
+    md = matrixPtr->Divider;*/
+
+    DEV_LOCK();
+    an = Dev->matrix->An;
+    bn = Dev->matrix->Bn;
+    cn = Dev->matrix->Cn;
+    dn = Dev->matrix->Dn;
+    en = Dev->matrix->En;
+    fn = Dev->matrix->Fn;
+
+    sx = Dev->screen.x;
+    sy = Dev->screen.y;
+    md = Dev->matrix->Divider;
+
+    if( matrixPtr->Divider != 0 )
+    {
+        /* XD = AX+BY+C */
+        Dev->display->x = ( (an * sx) + (bn * sy) + cn) / md;
+   	    /* YD = DX+EY+F */
+        Dev->display->y = ( (dn * sx) + (en * sy) + fn) / md;
+        LAT_MARK(LAT_CAL);
+    }
+    else
+    {
+       retTHRESHOLD = DISABLE;
+    }
+    DEV_UNLOCK();
+    return(retTHRESHOLD);
+}
+
+
+/*******************************************************************************
+* Function Name  : TP_ReadSample
+* Description    : One timestamped sample of the touch panel
+* Input          : None
+* Output         : - sample: display point, pen state and time
+* Return         : 1 sample read, 0 no valid sample (pen lifted during
+*                  the read, or noise)
+* Attention      : The time is taken before the conversions, when the pen
+*                  was seen down; a pen up sample repeats the last point
+*******************************************************************************/
+int TP_ReadSample(TouchSample *sample)
+{
+    struct timespec now;
+    Coordinate *raw;
+    int ok = 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    sample->tUs = now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+    DEV_LOCK();
+    sample->pen = 0;
+    if (!IRQ_Test())           /* pen down */
+    {
+        raw = Read_Ads7846();
+        ok = raw && getDisplayPoint(Dev->display, raw, Dev->matrix);
+        sample->pen = 1;
+    }
+    sample->x = Dev->display->x;
+    sample->y = Dev->display->y;
+    DEV_UNLOCK();
+    return ok;
+}
+
+
+/*******************************************************************************
+* Function Name  : TP_Cal
+* Description    : calibrate touch screen
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention	 : None
+*******************************************************************************/
+void TP_Cal(void)
+{
+    unsigned char i;
+    Coordinate * Ptr;
+    Coordinate ScreenSample[3], DisplaySample[3];
+
+    API_ENTER(STATS_TP_CAL);
+    for(i=0;i<3;i++)
+    {
+        if (Dev->width > Dev->height)         /* landscape: same points, axes swapped */
+        {
+            DisplaySample[i].x = DisplaySamplePortrait[i].y;
+            DisplaySample[i].y = DisplaySamplePortrait[i].x;
+        }
+        else
+        {
+            DisplaySample[i] = DisplaySamplePortrait[i];
+        }
+        // LCD_Clear(Black);
+        LCD_Text(10,10,"Touch crosshair to calibrate", White,Black);
+
+        DrawCross(DisplaySample[i].x,DisplaySample[i].y);
+        do
+        {
+            Ptr = Read_Ads7846();
+        }
+        while( Ptr == (void*)0 );
+
+        ScreenSample[i].x = Ptr->x;
+        ScreenSample[i].y = Ptr->y;
+        printf("cal: %u  x: %4u y: %4u\n", i, ScreenSample[i].x, ScreenSample[i].y);
+    }
+
+    // get calibration parameters
+    setCalibrationMatrix(&DisplaySample[0], &ScreenSample[0], Dev->matrix);
+
+    Dev->screen.x = -1;
+    Dev->screen.y = -1;
+    LCD_Clear(Black);
+    API_LEAVE();
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,192 @@
+/*******************************************************************************
+* File Name      : lcd.h
+* Description    : Public defines, types and functions of the HY28A-LCDB driver
+*                  ILI9320 for LCD & ADS7843 for Touch Panel
+*******************************************************************************/
+#ifndef __LCD_H
+#define __LCD_H
+
+/* Includes */
+#include <stdio.h>
+#include "lcd_transport.h"
+
+
+/* Defines */
+#define MAX_X 240          /* GRAM size, LCD_GetWidth() depends on orientation */
+#define MAX_Y 320
+
+/*
+  There are 2 arrow on lcd pcb one left one right of the glass; arrow means up
+  start from landscape & rotate 90 degree clockwise
+
+  0 landscape         240 x 320 GRAM coordinates, text and images turned:
+                      xy origin lower left corner, as the first driver
+  8 landscape top     320 x 240
+  1 portrait flipped  240 x 320
+  2 landscape flipped 320 x 240
+  3 portrait          240 x 320
+  xy origin upper left corner in every orientation but LANDSCAPE
+  LCD_MIRROR added to an orientation mirrors the x axis
+*/
+#define LANDSCAPE 0
+#define PORTRAIT_FLIP 1
+#define LANDSCAPE_FLIP 2
+#define PORTRAIT 3
+#define LCD_MIRROR 0x04
+#define LANDSCAPE_TOP 0x08
+
+/* LCD colors */
+#define White 0xFFFF
+#define Black 0x0000
+#define Grey 0xF7DE
+#define Blue 0x001F
+#define Blue2 0x051F
+#define Red 0xF800
+#define Magenta 0xF81F
+#define Green 0x07E0
+#define Cyan 0x7FFF
+#define Yellow 0xFFE0
+
+#define RGB565CONVERT(red, green, blue)\
+(unsigned short)( (( red   >> 3 ) << 11 ) | \
+(( green >> 2 ) << 5  ) | \
+( blue  >> 3 ))
+
+
+/* Types */
+typedef struct {int rows; int cols; unsigned char* data;} sImage;
+
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+
+typedef	struct POINT
+{
+   unsigned short x;
+   unsigned short y;
+} Coordinate;
+
+typedef struct
+{
+   short x, y;                      /* display point, as getDisplayPoint */
+   unsigned char pen;               /* 1 pen down, 0 pen up */
+   unsigned long long tUs;          /* CLOCK_MONOTONIC microseconds */
+} TouchSample;
+
+typedef struct Matrix
+{
+long double An,
+            Bn,
+            Cn,
+            Dn,
+            En,
+            Fn,
+            Divider ;
+} Matrix;
+
+/* Driver state of one panel: transport, orientation, calibration, clip,
+   register shadow and lock */
+typedef struct LCD_Device LCD_Device;
+
+/* Visible part of an image, from LCD_ImageWindow */
+typedef struct
+{
+    unsigned short sx, sy;          /* first column and line shown */
+    unsigned short w, h;            /* columns and lines shown */
+} LCD_ImageSpan;
+
+/* SPI clock dividers of the LCD found by LCD_TuneDividers */
+typedef struct
+{
+    unsigned short write, read;                 /* set, safety margin included */
+    unsigned short writeFastest, readFastest;   /* fastest without error, 0 none */
+} LCD_Dividers;
+
+/* Rectangle a rasterizer draws in, screen coordinates, x1 and y1 excluded */
+typedef struct
+{
+    int x0, y0, x1, y1;
+} LCD_RasterClip;
+
+/* Output of a rasterizer: w * h pixels at x, y, inside its LCD_RasterClip.
+   The rasterizers touch no device, the scene workers run them too */
+typedef void (*LCD_RasterEmit)(void *target, int x, int y, int w, int h);
+
+
+/* Public declarations */
+extern Matrix matrix;               /* calibration of the default device */
+extern Coordinate display;          /* last point of the default device */
+
+
+/* Function declarations */
+int LCD_Open(const LCD_Transport *transport);
+void LCD_Close(void);
+LCD_Device *LCD_DeviceOpen(const LCD_Transport *transport, void *context);
+void LCD_DeviceClose(LCD_Device *dev);
+LCD_Device *LCD_Select(LCD_Device *dev);
+void LCD_Lock(void);
+void LCD_Unlock(void);
+Matrix *LCD_Calibration(void);
+int LCD_TuneDividers(LCD_Dividers *result);
+void LCD_SetDividers(unsigned short write, unsigned short read);
+void LCD_GetDividers(unsigned short *write, unsigned short *read);
+int LCD_SaveDividers(const char *path);
+int LCD_LoadDividers(const char *path);
+void TP_Init(void);
+void IRQ_Clear(void);
+unsigned char IRQ_Test(void);
+Coordinate *Read_Ads7846(void);
+int TP_ReadSample(TouchSample *sample);
+void TP_Cal(void);
+void DrawCross(unsigned short Xpos, unsigned short Ypos);
+void TP_DrawPoint(unsigned short Xpos, unsigned short Ypos);
+FunctionalState setCalibrationMatrix( Coordinate * displayPtr,Coordinate * screenPtr,Matrix * matrixPtr);
+FunctionalState getDisplayPoint(Coordinate * displayPtr,Coordinate * screenPtr,Matrix * matrixPtr );
+unsigned short Read_X(void);
+unsigned short Read_Y(void);
+long getImageInfo(FILE*, long, int);
+int LCD_PutImage(unsigned short, unsigned short, char*);
+void LCD_Reset(void);
+void LCD_Init(unsigned char);
+void LCD_WriteReg(unsigned short , unsigned short);
+void LCD_WriteIndex(unsigned char);
+void LCD_WriteData(unsigned short);
+void LCD_SetPoint(unsigned short, unsigned short, unsigned short);
+void LCD_SetPoints(const Coordinate *, unsigned int, unsigned short);
+void LCD_SetPointsColors(const Coordinate *, const unsigned short *, unsigned int);
+unsigned short LCD_ReadReg(unsigned short);
+unsigned short LCD_ReadData(void);
+void LCD_ShadowInvalidate(void);
+int LCD_SetWindow(unsigned short, unsigned short, unsigned short, unsigned short);
+int LCD_ImageWindow(short, short, unsigned short, unsigned short, LCD_ImageSpan *);
+void LCD_WritePixels(const unsigned short *, unsigned int);
+void LCD_WritePixelsBE(const unsigned short *, unsigned int);
+unsigned short LCD_GetWidth(void);
+unsigned short LCD_GetHeight(void);
+int LCD_PushClip(short, short, unsigned short, unsigned short);
+int LCD_PushViewport(short, short, unsigned short, unsigned short);
+void LCD_PopClip(void);
+void LCD_ResetClip(void);
+void LCD_FillRect(short, short, unsigned short, unsigned short, unsigned short);
+void LCD_Clear(unsigned short);
+void LCD_Text(unsigned short, unsigned short, char *, unsigned short, unsigned short);
+void PutChar(unsigned short, unsigned short, unsigned char, unsigned short, unsigned short);
+int sgn(int);
+void LCD_DrawLine(unsigned short, unsigned short, unsigned short, unsigned short, unsigned short);
+void LCD_DrawBox(unsigned short, unsigned short, unsigned short, unsigned short, unsigned short, int);
+void LCD_DrawCircle(unsigned short, unsigned short, unsigned short, unsigned short);
+void LCD_DrawCircleFill(unsigned short, unsigned short, unsigned short, unsigned short, unsigned short);
+void LCD_RasterLine(const LCD_RasterClip *, int, int, int, int, LCD_RasterEmit, void *);
+void LCD_RasterCircle(const LCD_RasterClip *, int, int, int, LCD_RasterEmit, void *);
+void LCD_RasterCircleFill(const LCD_RasterClip *, int, int, int, LCD_RasterEmit, void *);
+unsigned short LCD_GetPoint(unsigned short, unsigned short);
+int LCD_ReadRect(unsigned short, unsigned short, unsigned short, unsigned short, unsigned short *);
+int LCD_Screenshot(char *);
+void DelayMicrosecondsNoSleep(int delay_us);
+void LCD_DisplayOn(void);
+void LCD_DisplayOff(void);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,246 @@
+/*******************************************************************************
+* File Name      : lcd_bcm2835.c
+* Description    : Transport of the driver on the Raspberry Pi SPI0 and GPIOs
+*                  through the bcm2835 library
+*                  The library drives the one SPI0 of the chip: the context
+*                  of the calls is not used, a single device may use it
+*******************************************************************************/
+/* Includes */
+#include <bcm2835.h>
+#include "lcd_transport.h"
+#include "lcd_spi0.h"
+
+
+/* Defines */
+/* GPIOs */
+#define RESET RPI_GPIO_P1_22 // GPIO25
+#define BACKLIGHT RPI_GPIO_P1_12 // GPIO18
+#define IRQ RPI_V2_GPIO_P1_18 // GPIO24
+
+
+/*******************************************************************************
+* Function Name  : Bcm_Open
+* Description    : Map the peripherals
+* Input          : None
+* Output         : None
+* Return         : 1 success, 0 fail (not run as root)
+* Attention      : None
+*******************************************************************************/
+static int Bcm_Open(void *ctx)
+{
+    return bcm2835_init() ? 1 : 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : Bcm_Close
+* Description    : Release SPI pins and unmap the peripherals
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Bcm_Close(void *ctx)
+{
+    bcm2835_spi_end();
+    bcm2835_close();
+}
+
+
+/*******************************************************************************
+* Function Name  : Bcm_SpiBegin
+* Description    : Set SPI0 pins and mode for the ILI9320
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Bcm_SpiBegin(void *ctx)
+{
+    bcm2835_spi_begin();
+    bcm2835_spi_setBitOrder(BCM2835_SPI_BIT_ORDER_MSBFIRST);      // MSB The default
+    bcm2835_spi_setDataMode(BCM2835_SPI_MODE3);                   // MODE3
+    bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS0, LOW);      // the default
+}
+
+
+/*******************************************************************************
+* Function Name  : Bcm_SpiSelect
+* Description    : Select the SPI slave and its clock divider
+* Input          : - cs: LCD_CS_LCD or LCD_CS_TOUCH
+*                  - divider: BCM2835_SPI_CLOCK_DIVIDER_x
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Bcm_SpiSelect(void *ctx, unsigned char cs, unsigned short divider)
+{
+    bcm2835_spi_setClockDivider(divider);
+    bcm2835_spi_chipSelect(cs == LCD_CS_TOUCH ? BCM2835_SPI_CS1 : BCM2835_SPI_CS0);
+}
+
+
+/*******************************************************************************
+* Function Name  : Bcm_SpiTransfer
+* Description    : Full duplex transfer on the selected slave
+* Input          : - buf: bytes to send
+*                  - len: number of bytes
+* Output         : - buf: bytes received
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Bcm_SpiTransfer(void *ctx, char *buf, unsigned int len)
+{
+    bcm2835_spi_transfern(buf, len);
+}
+
+
+/*******************************************************************************
+* Function Name  : Bcm_SpiWrite
+* Description    : Write only transfer on the selected slave
+* Input          : - head: first bytes to send
+*                  - headLen: number of bytes of head
+*                  - buf: bytes sent after head
+*                  - len: number of bytes of buf
+* Output         : None
+* Return         : None
+* Attention      : The FIFO registers are driven directly (lcd_spi0.c), the
+*                  received bytes are thrown away
+*******************************************************************************/
+static void Bcm_SpiWrite(void *ctx, const char *head, unsigned int headLen,
+                         const char *buf, unsigned int len)
+{
+    SPI0_Port port = { bcm2835_spi0, 0, 0 };
+
+    SPI0_Write(&port, head, headLen, buf, len);
+}
+
+
+/*******************************************************************************
+* Function Name  : Bcm_GpioWrite
+* Description    : Drive an output pin of the panel
+* Input          : - pin: LCD_PIN_RESET or LCD_PIN_BACKLIGHT
+*                  - level: HIGH or LOW
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Bcm_GpioWrite(void *ctx, unsigned char pin, unsigned char level)
+{
+    unsigned char gpio = pin == LCD_PIN_RESET ? RESET : BACKLIGHT;
+
+    bcm2835_gpio_fsel(gpio, BCM2835_GPIO_FSEL_OUTP);
+    bcm2835_gpio_write(gpio, level);
+}
+
+
+/*******************************************************************************
+* Function Name  : Bcm_IrqInit
+* Description    : Touch IRQ input with pullup and falling edge detect
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Bcm_IrqInit(void *ctx)
+{
+    // Set polarity of CS1
+    bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS1, LOW);
+
+    // Set pin to be an input
+    bcm2835_gpio_fsel(IRQ, BCM2835_GPIO_FSEL_INPT);
+
+    // With a pullup
+    bcm2835_gpio_set_pud(IRQ, BCM2835_GPIO_PUD_UP);
+
+    // Disable ALL Detect Enables for pin
+    bcm2835_gpio_clr_ren(IRQ);
+    bcm2835_gpio_clr_fen(IRQ);
+    bcm2835_gpio_clr_hen(IRQ);
+    bcm2835_gpio_clr_len(IRQ);
+    bcm2835_gpio_clr_aren(IRQ);
+    bcm2835_gpio_clr_afen(IRQ);
+
+    bcm2835_gpio_afen(IRQ);
+}
+
+
+/*******************************************************************************
+* Function Name  : Bcm_IrqClear
+* Description    : Disable all event detects of the touch IRQ pin
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Bcm_IrqClear(void *ctx)
+{
+    bcm2835_gpio_clr_ren(IRQ);
+    bcm2835_gpio_clr_fen(IRQ);
+    bcm2835_gpio_clr_hen(IRQ);
+    bcm2835_gpio_clr_len(IRQ);
+    bcm2835_gpio_clr_aren(IRQ);
+    bcm2835_gpio_clr_afen(IRQ);
+}
+
+
+/*******************************************************************************
+* Function Name  : Bcm_IrqTest
+* Description    : Test if LCD is touched
+* Input          : None
+* Output         : None
+* Return         : 1 on a detected edge or idle pin, 0 while touched
+* Attention      : None
+*******************************************************************************/
+static unsigned char Bcm_IrqTest(void *ctx)
+{
+    unsigned char value, eds;
+
+    value = bcm2835_gpio_lev(IRQ);
+    //printf("pin value during loop: %d\r", value);
+    eds = bcm2835_gpio_eds(IRQ);
+    //printf("Event Detect Status: %d\n", eds);
+    if (0 != eds)
+    {
+        // Now clear the eds flag by setting it to 1
+        bcm2835_gpio_set_eds(IRQ);
+        // event detected for pin
+        return (1);
+    }
+    return value;
+}
+
+
+/*******************************************************************************
+* Function Name  : Bcm_Delay
+* Description    : Sleep n milliseconds
+* Input          : millis: specifies the n milliseconds
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Bcm_Delay(void *ctx, unsigned int millis)
+{
+    delay(millis);
+}
+
+
+const LCD_Transport LCD_Bcm2835Transport = {
+    "bcm2835",
+    Bcm_Open,
+    Bcm_Close,
+    Bcm_SpiBegin,
+    Bcm_SpiSelect,
+    Bcm_SpiTransfer,
+    Bcm_GpioWrite,
+    Bcm_IrqInit,
+    Bcm_IrqClear,
+    Bcm_IrqTest,
+    Bcm_Delay,
+    Bcm_SpiWrite
+};
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,314 @@
+/*******************************************************************************
+* File Name      : lcd_blit.c
+* Description    : Scaled, cropped and flipped blits of RGB565 images
+*                  Each destination pixel maps to the source in 16.16 fixed
+*                  point from its center. Column positions and weights are
+*                  computed once per blit for the visible columns; bilinear
+*                  filters the two source lines along x, each source line
+*                  once while consecutive destination lines share it, then
+*                  blends them along y
+*                  Blending kernels use NEON on ARM when the compiler targets
+*                  it (-mfpu=neon), SSE2 on x86, plain C otherwise; build
+*                  with -DBLIT_SCALAR to force plain C
+*                  Blend: a + ((b - a) * f >> 8) per channel, f = 0..255
+*******************************************************************************/
+/* Includes */
+#include <string.h>
+#include "lcd.h"
+#include "lcd_stats.h"
+#include "lcd_blit.h"
+
+#if !defined(BLIT_SCALAR) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define BLIT_NEON
+#include <arm_neon.h>
+#elif !defined(BLIT_SCALAR) && defined(__SSE2__)
+#define BLIT_SSE2
+#include <emmintrin.h>
+#endif
+
+
+/* Defines */
+#define LINE_MAX MAX_Y          /* longest line, landscape width */
+#define BLIT_PIXELS 2048        /* pixels per LCD_WritePixels, whole lines */
+
+
+/* Types */
+typedef struct
+{
+    int row;                        /* source line filtered, -1 none */
+    unsigned short px[LINE_MAX];    /* along x, visible columns */
+} BlitLine;
+
+
+/*******************************************************************************
+* Function Name  : Kernel_Lerp
+* Description    : Blend two lines of pixels
+* Input          : - a, b: pixels
+*                  - f: weight of b for each pixel, 0 to 255
+*                  - n: number of pixels
+* Output         : - dst: blended pixels
+* Return         : None
+* Attention      : Every kernel gives the same result as the C loop
+*******************************************************************************/
+static void Kernel_Lerp(unsigned short *dst, const unsigned short *a, const unsigned short *b,
+                        const unsigned short *f, unsigned int n)
+{
+    unsigned int i = 0;
+    int s, d, k, r, g, bl;
+
+#if defined(BLIT_NEON)
+    uint16x8_t a8, b8, m5 = vdupq_n_u16(0x1F), m6 = vdupq_n_u16(0x3F);
+    int16x8_t k8, ar, br, ag, bg, ab, bb, r8, g8, c8;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        a8 = vld1q_u16(a + i);
+        b8 = vld1q_u16(b + i);
+        k8 = vreinterpretq_s16_u16(vld1q_u16(f + i));
+        ar = vreinterpretq_s16_u16(vshrq_n_u16(a8, 11));
+        br = vreinterpretq_s16_u16(vshrq_n_u16(b8, 11));
+        ag = vreinterpretq_s16_u16(vandq_u16(vshrq_n_u16(a8, 5), m6));
+        bg = vreinterpretq_s16_u16(vandq_u16(vshrq_n_u16(b8, 5), m6));
+        ab = vreinterpretq_s16_u16(vandq_u16(a8, m5));
+        bb = vreinterpretq_s16_u16(vandq_u16(b8, m5));
+        r8 = vaddq_s16(ar, vshrq_n_s16(vmulq_s16(vsubq_s16(br, ar), k8), 8));
+        g8 = vaddq_s16(ag, vshrq_n_s16(vmulq_s16(vsubq_s16(bg, ag), k8), 8));
+        c8 = vaddq_s16(ab, vshrq_n_s16(vmulq_s16(vsubq_s16(bb, ab), k8), 8));
+        vst1q_u16(dst + i, vorrq_u16(vorrq_u16(vshlq_n_u16(vreinterpretq_u16_s16(r8), 11),
+                                               vshlq_n_u16(vreinterpretq_u16_s16(g8), 5)),
+                                     vreinterpretq_u16_s16(c8)));
+    }
+#elif defined(BLIT_SSE2)
+    __m128i a8, b8, k8, ar, br, ag, bg, ab, bb, r8, g8, c8;
+    __m128i m5 = _mm_set1_epi16(0x1F), m6 = _mm_set1_epi16(0x3F);
+
+    for (; i + 8 <= n; i += 8)
+    {
+        a8 = _mm_loadu_si128((const __m128i *)(a + i));
+        b8 = _mm_loadu_si128((const __m128i *)(b + i));
+        k8 = _mm_loadu_si128((const __m128i *)(f + i));
+        ar = _mm_srli_epi16(a8, 11);
+        br = _mm_srli_epi16(b8, 11);
+        ag = _mm_and_si128(_mm_srli_epi16(a8, 5), m6);
+        bg = _mm_and_si128(_mm_srli_epi16(b8, 5), m6);
+        ab = _mm_and_si128(a8, m5);
+        bb = _mm_and_si128(b8, m5);
+        r8 = _mm_add_epi16(ar, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(br, ar), k8), 8));
+        g8 = _mm_add_epi16(ag, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(bg, ag), k8), 8));
+        c8 = _mm_add_epi16(ab, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(bb, ab), k8), 8));
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r8, 11), _mm_slli_epi16(g8, 5)), c8));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        s = b[i];
+        d = a[i];
+        k = f[i];
+        r = (d >> 11) + ((((s >> 11) - (d >> 11)) * k) >> 8);
+        g = ((d >> 5) & 0x3F) + (((((s >> 5) & 0x3F) - ((d >> 5) & 0x3F)) * k) >> 8);
+        bl = (d & 0x1F) + ((((s & 0x1F) - (d & 0x1F)) * k) >> 8);
+        dst[i] = (r << 11) | (g << 5) | bl;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Blit_Axis
+* Description    : Source positions of destination pixels along one axis
+* Input          : - first: first destination pixel, from the start of the
+*                    destination rectangle
+*                  - n: number of destination pixels
+*                  - dst, src: sizes of the destination and source rectangles
+*                  - origin: start of the source rectangle in the image
+*                  - bilinear: 1 for two positions and a weight
+*                  - flip: 1 to mirror the source
+* Output         : - i0: source position of each pixel
+*                  - i1: next source position, bilinear
+*                  - f: weight of i1, 0 to 255, bilinear; 0 for nearest
+* Return         : None
+* Attention      : Sampled at pixel centers: u = (d + 1/2) * src / dst,
+*                  minus 1/2 for bilinear, clamped to the edges
+*******************************************************************************/
+static void Blit_Axis(unsigned int first, unsigned int n, unsigned int dst, unsigned int src, int origin,
+                      int bilinear, int flip, unsigned short *i0, unsigned short *i1, unsigned short *f)
+{
+    unsigned int k, a, b, w;
+    long long u;
+
+    for (k = 0; k < n; k++)
+    {
+        /* rounded down once, no step accumulated */
+        u = ((2LL * (first + k) + 1) * src << 16) / (2LL * dst);
+        if (bilinear)
+            u = u > 0x8000 ? u - 0x8000 : 0;
+        a = u >> 16;
+        w = bilinear ? (u >> 8) & 0xFF : 0;
+        if (a >= src - 1)
+        {
+            a = src - 1;
+            w = 0;
+        }
+        b = w ? a + 1 : a;
+        if (flip)
+        {
+            a = src - 1 - a;
+            b = src - 1 - b;
+        }
+        i0[k] = origin + a;
+        i1[k] = origin + b;
+        f[k] = w;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Blit_Filter
+* Description    : Filter a source line along x
+* Input          : - line: cache entry
+*                  - row: source line index
+*                  - pixels: source line
+*                  - x0, x1, fx: positions and weights of the columns
+*                  - n: number of columns
+*                  - tmp: 2 * n pixels of scratch
+* Output         : - line: filtered line
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Blit_Filter(BlitLine *line, int row, const unsigned short *pixels, const unsigned short *x0,
+                        const unsigned short *x1, const unsigned short *fx, unsigned int n, unsigned short *tmp)
+{
+    unsigned int c;
+
+    for (c = 0; c < n; c++)
+    {
+        tmp[c] = pixels[x0[c]];
+        tmp[n + c] = pixels[x1[c]];
+    }
+    Kernel_Lerp(line->px, tmp, tmp + n, fx, n);
+    line->row = row;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_BlitScaled
+* Description    : Copy a rectangle of an image to a rectangle of the
+*                  screen, scaled to its size
+* Input          : - src: image
+*                  - srcRect: part of the image, 0 for all of it; cut to
+*                    the image
+*                  - dstRect: where it goes, any size
+*                  - filter: BLIT_NEAREST or BLIT_BILINEAR, plus BLIT_FLIP_X
+*                    and BLIT_FLIP_Y
+* Output         : None
+* Return         : 1 success, 0 nothing visible or empty rectangle
+* Attention      : The clip and the viewport apply to dstRect and are
+*                  applied before anything is sampled. Whole lines are
+*                  gathered into bursts of up to BLIT_PIXELS pixels
+*******************************************************************************/
+int LCD_BlitScaled(const BlitImage *src, const BlitRect *srcRect, const BlitRect *dstRect, unsigned int filter)
+{
+    BlitLine lines[2], *l0 = &lines[0], *l1 = &lines[1], *t;
+    unsigned short x0[LINE_MAX], x1[LINE_MAX], fx[LINE_MAX], fy[LINE_MAX], tmp[2 * LINE_MAX];
+    unsigned short out[BLIT_PIXELS], y0, y1, wy, *dst;
+    const unsigned short *p;
+    LCD_ImageSpan span;
+    unsigned int stride = src->stride ? src->stride : src->w, line, c, fill = 0;
+    int sx = 0, sy = 0, sw = src->w, sh = src->h;
+    int bilinear = (filter & 0x0F) == BLIT_BILINEAR;
+
+    if (srcRect)
+    {
+        sx = srcRect->x;
+        sy = srcRect->y;
+        sw = srcRect->w;
+        sh = srcRect->h;
+        if (sx < 0) { sw += sx; sx = 0; }
+        if (sy < 0) { sh += sy; sy = 0; }
+        if (sx + sw > src->w) sw = src->w - sx;
+        if (sy + sh > src->h) sh = src->h - sy;
+    }
+    if (sw <= 0 || sh <= 0 || !dstRect->w || !dstRect->h)
+        return 0;
+
+    STATS_ENTER(STATS_LCD_BLITSCALED);
+    LCD_Lock();
+    if (!LCD_ImageWindow(dstRect->x, dstRect->y, dstRect->w, dstRect->h, &span))
+    {
+        LCD_Unlock();
+        STATS_LEAVE();
+        return 0;
+    }
+    Blit_Axis(span.sx, span.w, dstRect->w, sw, sx, bilinear, filter & BLIT_FLIP_X, x0, x1, fx);
+    l0->row = l1->row = -1;
+
+    for (line = 0; line < span.h; line++)
+    {
+        Blit_Axis(span.sy + line, 1, dstRect->h, sh, sy, bilinear, filter & BLIT_FLIP_Y, &y0, &y1, &wy);
+        dst = out + fill;
+        if (!bilinear)
+        {
+            p = src->pixels + (unsigned long)y0 * stride;
+            for (c = 0; c < span.w; c++)
+                dst[c] = p[x0[c]];
+        }
+        else
+        {
+            /* each source line is filtered along x once */
+            if (l0->row != y0 && l1->row == y0)
+            {
+                t = l0;
+                l0 = l1;
+                l1 = t;
+            }
+            if (l0->row != y0)
+                Blit_Filter(l0, y0, src->pixels + (unsigned long)y0 * stride, x0, x1, fx, span.w, tmp);
+            if (!wy)
+                memcpy(dst, l0->px, span.w * sizeof(unsigned short));
+            else
+            {
+                if (l1->row != y1)
+                    Blit_Filter(l1, y1, src->pixels + (unsigned long)y1 * stride, x0, x1, fx, span.w, tmp);
+                for (c = 0; c < span.w; c++)
+                    fy[c] = wy;
+                Kernel_Lerp(dst, l0->px, l1->px, fy, span.w);
+            }
+        }
+        fill += span.w;
+        if (fill + span.w > BLIT_PIXELS)
+        {
+            LCD_WritePixels(out, fill);
+            fill = 0;
+        }
+    }
+    if (fill)
+        LCD_WritePixels(out, fill);
+    LCD_Unlock();
+    STATS_LEAVE();
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_BlitKernel
+* Description    : Blending kernels compiled in
+* Input          : None
+* Output         : None
+* Return         : "neon", "sse2" or "scalar"
+* Attention      : None
+*******************************************************************************/
+const char *LCD_BlitKernel(void)
+{
+#if defined(BLIT_NEON)
+    return "neon";
+#elif defined(BLIT_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,43 @@
+/*******************************************************************************
+* File Name      : lcd_blit.h
+* Description    : Scaled, cropped and flipped copies of an RGB565 image to
+*                  the screen, nearest or bilinear, in 16.16 fixed point
+*                  The destination is clipped first: only the visible lines
+*                  and columns are sampled, and sent through one window
+*******************************************************************************/
+#ifndef __LCD_BLIT_H
+#define __LCD_BLIT_H
+
+
+/* Defines */
+#define BLIT_NEAREST 0              /* filter */
+#define BLIT_BILINEAR 1
+#define BLIT_FLIP_X 0x10            /* added to the filter: mirror left right */
+#define BLIT_FLIP_Y 0x20            /* upside down */
+
+
+/* Types */
+typedef struct
+{
+    const unsigned short *pixels;   /* RGB565, line by line, owned by the caller */
+    unsigned short w, h;
+    unsigned int stride;            /* pixels from one line to the next, 0 for w */
+} BlitImage;
+
+typedef struct
+{
+    short x, y;
+    unsigned short w, h;
+} BlitRect;
+
+
+/* Function declarations */
+int LCD_BlitScaled(const BlitImage *src, const BlitRect *srcRect, const BlitRect *dstRect, unsigned int filter);
+const char *LCD_BlitKernel(void);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,576 @@
+/*******************************************************************************
+* File Name      : lcd_display.hpp
+* Description    : Header only C++17 driver of the ILI9320 specialized at
+*                  compile time: Display<Width, Height, Rotation, Transport>
+*                  Resolution, orientation and transport are template
+*                  arguments, the coordinate transform is constexpr and the
+*                  pixel paths are chosen with if constexpr, so a product
+*                  shipping one orientation gets a driver with no runtime
+*                  dispatch, the bus calls inlined with Bcm2835Transport
+*                  The C API (lcd.h) is unchanged and shares the power on
+*                  sequence (lcd_ili9320.h); the C++ driver keeps its own
+*                  register shadow, call LCD_ShadowInvalidate before going
+*                  back to the C API on the same panel
+* Compile/link   : gcc -c lcd_spi0.c
+*                  g++ -std=c++17 -O2 -o app app.cpp lcd_spi0.o -lbcm2835
+*                  With the C API or a C transport, its objects built by gcc:
+*                  gcc -c lcd.c lcd_trace.c lcd_bcm2835.c lcd_spi0.c
+*                  g++ -std=c++17 -O2 -o app app.cpp lcd.o lcd_trace.o lcd_bcm2835.o lcd_spi0.o -lbcm2835 -lrt -lm -lpthread
+*******************************************************************************/
+#ifndef __LCD_DISPLAY_HPP
+#define __LCD_DISPLAY_HPP
+
+/* Includes */
+#include <type_traits>
+extern "C" {
+#include "lcd.h"
+#include "lcd_ili9320.h"
+#include "lcd_spi0.h"
+}
+#include "fonts.h"
+#ifndef LCD_NO_BCM2835
+#include <bcm2835.h>
+#endif
+
+
+namespace lcd
+{
+
+/* Defines */
+constexpr unsigned char SpiStart = 0x70;        /* start byte for SPI transfer */
+constexpr unsigned char SpiRead = 0x01;         /* RW bit within start */
+constexpr unsigned char SpiData = 0x02;         /* RS bit within start */
+constexpr unsigned short DividerCs0 = 8;        /* BCM2835_SPI_CLOCK_DIVIDER_8 */
+constexpr unsigned BurstPixels = 2048;          /* pixels sent per transfer */
+
+
+/* Types */
+struct Rgb888
+{
+    unsigned char r, g, b;
+};
+
+struct GramPoint
+{
+    unsigned x, y;                  /* GRAM column and row, registers 0x20/0x21 */
+};
+
+
+/*******************************************************************************
+* Class Name     : BusTransport
+* Description    : Transport of a Display over a C LCD_Transport, one call
+*                  through a pointer per transfer
+* Attention      : LCD_EmuTransport with the context of an EmuPanel drives
+*                  an emulated panel, 0 for the default one
+*******************************************************************************/
+class BusTransport
+{
+public:
+    explicit BusTransport(const LCD_Transport *bus, void *ctx = 0) : bus(bus), ctx(ctx) { }
+
+    void Begin() { bus->spiBegin(ctx); }
+    void Select(unsigned char cs, unsigned short divider) { bus->spiSelect(ctx, cs, divider); }
+    void Transfer(char *buf, unsigned int len) { bus->spiTransfer(ctx, buf, len); }
+    void Write(char *buf, unsigned int len)
+    {
+        if (bus->spiWrite)
+            bus->spiWrite(ctx, buf, len, 0, 0);
+        else
+            bus->spiTransfer(ctx, buf, len);
+    }
+    void Gpio(unsigned char pin, unsigned char level) { bus->gpioWrite(ctx, pin, level); }
+    void Delay(unsigned int millis) { (bus->delay)(ctx, millis); }     /* bcm2835.h has a delay macro */
+
+private:
+    const LCD_Transport *bus;
+    void *ctx;
+};
+
+
+#ifndef LCD_NO_BCM2835
+/*******************************************************************************
+* Class Name     : Bcm2835Transport
+* Description    : Transport of a Display calling the bcm2835 library
+*                  directly, every call inlined
+* Attention      : bcm2835_init must have succeeded, as LCD_Open does
+*******************************************************************************/
+class Bcm2835Transport
+{
+public:
+    void Begin()
+    {
+        bcm2835_spi_begin();
+        bcm2835_spi_setBitOrder(BCM2835_SPI_BIT_ORDER_MSBFIRST);
+        bcm2835_spi_setDataMode(BCM2835_SPI_MODE3);
+        bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS0, LOW);
+    }
+    void Select(unsigned char cs, unsigned short divider)
+    {
+        bcm2835_spi_setClockDivider(divider);
+        bcm2835_spi_chipSelect(cs == LCD_CS_TOUCH ? BCM2835_SPI_CS1 : BCM2835_SPI_CS0);
+    }
+    void Transfer(char *buf, unsigned int len) { bcm2835_spi_transfern(buf, len); }
+    void Write(char *buf, unsigned int len)
+    {
+        SPI0_Port port = { bcm2835_spi0, 0, 0 };
+
+        SPI0_Write(&port, buf, len, 0, 0);
+    }
+    void Gpio(unsigned char pin, unsigned char level)
+    {
+        unsigned char gpio = pin == LCD_PIN_RESET ? RPI_GPIO_P1_22 : RPI_GPIO_P1_12;
+
+        bcm2835_gpio_fsel(gpio, BCM2835_GPIO_FSEL_OUTP);
+        bcm2835_gpio_write(gpio, level);
+    }
+    void Delay(unsigned int millis) { bcm2835_delay(millis); }
+};
+#endif
+
+
+/*******************************************************************************
+* Class Name     : Display
+* Description    : ILI9320 of a fixed configuration
+* Template       : - Width, Height: GRAM size of the glass, MAX_X x MAX_Y
+*                  - Rotation: LANDSCAPE_TOP, LANDSCAPE_FLIP, PORTRAIT or
+*                    PORTRAIT_FLIP, optionally | LCD_MIRROR. Not the
+*                    LANDSCAPE of the first driver
+*                  - Transport: Begin, Select, Transfer, Write, Gpio and
+*                    Delay as BusTransport; Write sends and reads nothing
+*                    back, the buffer may still be overwritten
+* Attention      : Screen coordinates as the C API: origin in the upper
+*                  left corner of the orientation. No clip stack or
+*                  viewport, drawing is clipped to the screen. The LCD chip
+*                  select is taken by Init, TP_ functions of the C API give
+*                  it back when they are done
+*******************************************************************************/
+template <unsigned Width, unsigned Height, unsigned Rotation, class Transport>
+class Display
+{
+    static_assert(Width > 0 && Width <= MAX_X && Height > 0 && Height <= MAX_Y,
+                  "the ILI9320 GRAM is MAX_X x MAX_Y");
+    static_assert((Rotation & ~(PORTRAIT | LCD_MIRROR | LANDSCAPE_TOP)) == 0 &&
+                  ((Rotation & PORTRAIT) != LANDSCAPE || (Rotation & LANDSCAPE_TOP)),
+                  "LANDSCAPE_TOP, LANDSCAPE_FLIP, PORTRAIT or PORTRAIT_FLIP, optionally | LCD_MIRROR");
+
+public:
+    static constexpr unsigned orient = Rotation & 3;
+    static constexpr bool mirror = (Rotation & LCD_MIRROR) != 0;
+    static constexpr int width = (orient & 1) ? Width : Height;     /* as LCD_GetWidth */
+    static constexpr int height = (orient & 1) ? Height : Width;
+
+    /*******************************************************************************
+    * Function Name  : EntryMode
+    * Description    : Entry mode of the orientation, register 0x03
+    * Input          : None
+    * Output         : None
+    * Return         : register value
+    * Attention      : The address counter follows the x axis of the
+    *                  orientation first, then its y axis
+    *******************************************************************************/
+    static constexpr unsigned short EntryMode()
+    {
+        unsigned short mode = orient == LANDSCAPE ? ILI9320_ENTRY_LANDSCAPE
+                            : orient == PORTRAIT_FLIP ? ILI9320_ENTRY_PORTRAIT_FLIP
+                            : orient == LANDSCAPE_FLIP ? ILI9320_ENTRY_LANDSCAPE_FLIP
+                            : ILI9320_ENTRY_PORTRAIT;
+
+        if (mirror)                 /* reverse the direction along a line */
+            mode ^= (mode & ENTRY_AM) ? ENTRY_ID1 : ENTRY_ID0;
+        return mode;
+    }
+
+    /*******************************************************************************
+    * Function Name  : Map
+    * Description    : Screen coordinates of the orientation to GRAM address
+    * Input          : - x: 0 to width - 1
+    *                  - y: 0 to height - 1
+    * Output         : None
+    * Return         : GRAM column and row
+    * Attention      : Same mapping as LCD_MapPoint, resolved at compile time
+    *******************************************************************************/
+    static constexpr GramPoint Map(unsigned x, unsigned y)
+    {
+        if constexpr (mirror)
+            x = width - 1 - x;
+        if constexpr (orient == LANDSCAPE)
+            return GramPoint{ Width - 1 - y, x };
+        else if constexpr (orient == PORTRAIT_FLIP)
+            return GramPoint{ Width - 1 - x, Height - 1 - y };
+        else if constexpr (orient == LANDSCAPE_FLIP)
+            return GramPoint{ y, Height - 1 - x };
+        else
+            return GramPoint{ x, y };
+    }
+
+    explicit Display(Transport transport = Transport()) : bus(transport) { Invalidate(); }
+
+    /*******************************************************************************
+    * Function Name  : Reset
+    * Description    : Pulse the reset pin of the panel
+    * Input          : None
+    * Output         : None
+    * Return         : None
+    * Attention      : Registers back to their reset values, call Init after
+    *******************************************************************************/
+    void Reset()
+    {
+        bus.Gpio(LCD_PIN_RESET, 1);
+        bus.Delay(5);
+        bus.Gpio(LCD_PIN_RESET, 0);
+        bus.Delay(15);
+        bus.Gpio(LCD_PIN_RESET, 1);
+        bus.Delay(15);
+        Invalidate();
+    }
+
+    /*******************************************************************************
+    * Function Name  : Init
+    * Description    : Backlight on and power on sequence of the orientation
+    * Input          : None
+    * Output         : None
+    * Return         : device code, 0x9320 or 0x9300 for the ILI9320
+    * Attention      : Same register writes as LCD_Init
+    *******************************************************************************/
+    unsigned short Init()
+    {
+        unsigned short code;
+
+        bus.Gpio(LCD_PIN_BACKLIGHT, 1);
+        bus.Begin();
+        bus.Select(LCD_CS_LCD, DividerCs0);
+        Invalidate();
+        code = ReadReg(0x00);
+#define DISPLAY_INIT_WRITE(reg, value, ms) \
+        WriteReg(reg, value); \
+        if (ms) bus.Delay(ms);
+        ILI9320_INIT_LIST(DISPLAY_INIT_WRITE, EntryMode(), Width - 1, Height - 1)
+#undef DISPLAY_INIT_WRITE
+        return code;
+    }
+
+    /*******************************************************************************
+    * Function Name  : Invalidate
+    * Description    : Forget the register shadow
+    * Input          : None
+    * Output         : None
+    * Return         : None
+    * Attention      : Call it when the C API wrote to the same panel
+    *******************************************************************************/
+    void Invalidate()
+    {
+        index = -1;
+        for (int i = 0; i < 5; i++)
+            shadowValid[i] = false;
+    }
+
+    /*******************************************************************************
+    * Function Name  : SetPoint
+    * Description    : Draw a point
+    * Input          : - x, y: screen coordinates
+    *                  - color: RGB565 color
+    * Output         : None
+    * Return         : None
+    * Attention      : Points out of the screen are skipped
+    *******************************************************************************/
+    void SetPoint(int x, int y, unsigned short color)
+    {
+        if (x < 0 || x >= width || y < 0 || y >= height)
+            return;
+        Window(x, y, 1, 1);
+        WriteReg(0x22, color);
+    }
+
+    /*******************************************************************************
+    * Function Name  : FillRect
+    * Description    : Fill a rectangle with one color
+    * Input          : - x, y: upper left corner
+    *                  - w, h: size
+    *                  - color: RGB565 color
+    * Output         : None
+    * Return         : None
+    * Attention      : Clipped to the screen, one window and one stream
+    *******************************************************************************/
+    void FillRect(int x, int y, int w, int h, unsigned short color)
+    {
+        unsigned long n;
+        unsigned int i, len;
+
+        if (!Clip(x, y, w, h, 0))
+            return;
+        Window(x, y, w, h);
+        WriteIndex(0x22);
+        for (n = (unsigned long)w * h; n; n -= len)
+        {
+            /* the transfer reads back into the buffer: fill it each time */
+            len = n < BurstPixels ? n : BurstPixels;
+            for (i = 0; i < len; i++)
+            {
+                burst[1 + 2 * i] = color >> 8;
+                burst[2 + 2 * i] = color & 0xFF;
+            }
+            Flush(len);
+        }
+    }
+
+    void Clear(unsigned short color) { FillRect(0, 0, width, height, color); }
+
+    /*******************************************************************************
+    * Function Name  : Blit
+    * Description    : Copy a rectangle of pixels to the screen
+    * Input          : - x, y: upper left corner
+    *                  - w, h: size
+    *                  - pixels: w x h pixels line by line, unsigned short
+    *                    RGB565 or Rgb888
+    *                  - stride: pixels from one line to the next, 0 for w
+    * Output         : None
+    * Return         : None
+    * Attention      : Clipped to the screen. The pixel format is resolved
+    *                  at compile time, the orientation by the window: the
+    *                  pixels stream in their order
+    *******************************************************************************/
+    template <class Pixel>
+    void Blit(int x, int y, int w, int h, const Pixel *pixels, int stride = 0)
+    {
+        static_assert(std::is_same<Pixel, unsigned short>::value || std::is_same<Pixel, Rgb888>::value,
+                      "RGB565 unsigned short or Rgb888 pixels");
+        unsigned int len = 0, i;
+        int skip, row;
+
+        if (!stride)
+            stride = w;
+        if (!Clip(x, y, w, h, &skip))
+            return;
+        pixels += (skip >> 16) * stride + (skip & 0xFFFF);
+        Window(x, y, w, h);
+        WriteIndex(0x22);
+        for (row = 0; row < h; row++, pixels += stride)
+        {
+            for (i = 0; i < (unsigned)w; i++)
+            {
+                unsigned short color;
+
+                if constexpr (std::is_same<Pixel, unsigned short>::value)
+                    color = pixels[i];
+                else
+                    color = RGB565CONVERT(pixels[i].r, pixels[i].g, pixels[i].b);
+                burst[1 + 2 * len] = color >> 8;
+                burst[2 + 2 * len] = color & 0xFF;
+                if (++len == BurstPixels)
+                {
+                    Flush(len);
+                    len = 0;
+                }
+            }
+        }
+        if (len)
+            Flush(len);
+    }
+
+    /*******************************************************************************
+    * Function Name  : PutChar
+    * Description    : Draw an 8 x 16 character of AsciiLib
+    * Input          : - x, y: upper left corner
+    *                  - c: character, ' ' to '~'
+    *                  - fg, bg: character and background colors
+    * Output         : None
+    * Return         : None
+    * Attention      : Other characters are skipped
+    *******************************************************************************/
+    void PutChar(int x, int y, unsigned char c, unsigned short fg, unsigned short bg)
+    {
+        unsigned short cell[16 * 8];
+        int i, j;
+
+        if (c < ' ' || c > '~')
+            return;
+        for (i = 0; i < 16; i++)
+            for (j = 0; j < 8; j++)
+                cell[i * 8 + j] = (AsciiLib[c - ' '][i] >> (7 - j)) & 1 ? fg : bg;
+        Blit(x, y, 8, 16, cell);
+    }
+
+    /*******************************************************************************
+    * Function Name  : Text
+    * Description    : Draw a string
+    * Input          : - x, y: upper left corner of the first character
+    *                  - str: string
+    *                  - fg, bg: character and background colors
+    * Output         : None
+    * Return         : None
+    * Attention      : Wraps at the right and bottom edges as LCD_Text
+    *******************************************************************************/
+    void Text(int x, int y, const char *str, unsigned short fg, unsigned short bg)
+    {
+        for (; *str; str++)
+        {
+            PutChar(x, y, *str, fg, bg);
+            if (x < width - 8)
+                x += 8;
+            else if (y < height - 16)
+            {
+                x = 0;
+                y += 16;
+            }
+            else
+                x = y = 0;
+        }
+    }
+
+private:
+    /*******************************************************************************
+    * Function Name  : Clip
+    * Description    : Clip a rectangle to the screen
+    * Input          : - x, y, w, h: rectangle
+    * Output         : - x, y, w, h: part on the screen
+    *                  - skip: (lines << 16) | columns cut at the top left,
+    *                    may be 0
+    * Return         : 1 something left, 0 nothing
+    * Attention      : None
+    *******************************************************************************/
+    static bool Clip(int &x, int &y, int &w, int &h, int *skip)
+    {
+        int sx = x < 0 ? -x : 0, sy = y < 0 ? -y : 0;
+
+        w -= sx;
+        h -= sy;
+        x += sx;
+        y += sy;
+        if (x + w > width)
+            w = width - x;
+        if (y + h > height)
+            h = height - y;
+        if (skip)
+            *skip = (sy << 16) | sx;
+        return w > 0 && h > 0;
+    }
+
+    /*******************************************************************************
+    * Function Name  : Window
+    * Description    : Restrict GRAM writes to a rectangle of the screen and
+    *                  place the cursor on its first pixel
+    * Input          : - x, y, w, h: rectangle, on the screen
+    * Output         : None
+    * Return         : None
+    * Attention      : Only the window registers that change are written
+    *******************************************************************************/
+    void Window(unsigned x, unsigned y, unsigned w, unsigned h)
+    {
+        constexpr GramPoint origin = Map(0, 0), end = Map(width - 1, height - 1);
+        GramPoint a = Map(x, y), b = Map(x + w - 1, y + h - 1);
+
+        /* the corners keep the order of the screen corners */
+        if constexpr (origin.x <= end.x)
+        {
+            WriteReg(0x50, a.x);
+            WriteReg(0x51, b.x);
+        }
+        else
+        {
+            WriteReg(0x50, b.x);
+            WriteReg(0x51, a.x);
+        }
+        if constexpr (origin.y <= end.y)
+        {
+            WriteReg(0x52, a.y);
+            WriteReg(0x53, b.y);
+        }
+        else
+        {
+            WriteReg(0x52, b.y);
+            WriteReg(0x53, a.y);
+        }
+        WriteReg(0x20, a.x);
+        WriteReg(0x21, a.y);
+    }
+
+    /*******************************************************************************
+    * Function Name  : WriteIndex
+    * Description    : Select a register
+    * Input          : - reg: register address
+    * Output         : None
+    * Return         : None
+    * Attention      : Skipped if the index register already holds it
+    *******************************************************************************/
+    void WriteIndex(unsigned char reg)
+    {
+        char buf[] = { (char)SpiStart, 0, (char)reg };
+
+        if (index == reg)
+            return;
+        bus.Write(buf, sizeof(buf));
+        index = reg;
+    }
+
+    /*******************************************************************************
+    * Function Name  : WriteReg
+    * Description    : Write a register
+    * Input          : - reg: register address
+    *                  - value: register value
+    * Output         : None
+    * Return         : None
+    * Attention      : Window writes whose value is already in place are
+    *                  skipped
+    *******************************************************************************/
+    void WriteReg(unsigned char reg, unsigned short value)
+    {
+        char buf[] = { (char)(SpiStart | SpiData), (char)(value >> 8), (char)(value & 0xFF) };
+        int s = reg >= 0x50 && reg <= 0x53 ? reg - 0x50 : reg == 0x03 ? 4 : -1;
+
+        if (s >= 0)
+        {
+            if (shadowValid[s] && shadow[s] == value)
+                return;
+            shadow[s] = value;
+            shadowValid[s] = true;
+        }
+        WriteIndex(reg);
+        bus.Write(buf, sizeof(buf));
+    }
+
+    /*******************************************************************************
+    * Function Name  : ReadReg
+    * Description    : Read a register
+    * Input          : - reg: register address
+    * Output         : None
+    * Return         : register value
+    * Attention      : None
+    *******************************************************************************/
+    unsigned short ReadReg(unsigned char reg)
+    {
+        char buf[] = { (char)(SpiStart | SpiRead | SpiData), 0, 0, 0 };
+
+        WriteIndex(reg);
+        bus.Transfer(buf, sizeof(buf));
+        return ((unsigned char)buf[2] << 8) | (unsigned char)buf[3];
+    }
+
+    /*******************************************************************************
+    * Function Name  : Flush
+    * Description    : Send the pixels gathered in the burst buffer
+    * Input          : - len: number of pixels
+    * Output         : None
+    * Return         : None
+    * Attention      : None
+    *******************************************************************************/
+    void Flush(unsigned int len)
+    {
+        burst[0] = SpiStart | SpiData;
+        bus.Write(burst, 1 + 2 * len);
+    }
+
+    Transport bus;
+    int index;                          /* register selected, -1 unknown */
+    unsigned short shadow[5];           /* 0x50 to 0x53, 0x03 */
+    bool shadowValid[5];
+    char burst[1 + 2 * BurstPixels];
+};
+
+}
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
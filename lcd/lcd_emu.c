@@ -0,0 +1,801 @@
+/*******************************************************************************
+* File Name      : lcd_emu.c
+* Description    : Software emulation of the HY28A-LCDB behind the driver
+*                  ILI9320 SPI protocol: start byte 0111 0 ID RS RW, then
+*                  16-bit words; a read returns one dummy byte first
+*                  GRAM reads are pipelined: each word returns the pixel
+*                  latched by the previous read, so the first one is a dummy
+*******************************************************************************/
+/* Includes */
+#include <stdlib.h>
+#include <string.h>
+#include "lcd.h"
+#include "lcd_emu.h"
+#include "lcd_spi0.h"
+
+
+/* Defines */
+#define SPI_START (0x70)   /* Start byte for SPI transfer */
+#define SPI_RD (0x01)      /* WR bit 1 within start */
+#define SPI_DATA (0x02)    /* RS bit 1 within start byte */
+
+#define	CHY 0x90           /* channel Y+ selection command */
+#define	CHX 0xd0	       /* channel X+ selection command */
+
+/* Entry mode bits of register 0x03 */
+#define EMU_AM  (1<<3)     /* 1 = address counter moves vertically first */
+#define EMU_ID0 (1<<4)     /* 1 = horizontal increment */
+#define EMU_ID1 (1<<5)     /* 1 = vertical increment */
+
+#define EMU_NOISE_RATE 16  /* one GRAM word in this many is hit above the limit */
+
+/* ADS7843 raw values at the panel edges */
+#define EMU_RAW_MIN 300
+#define EMU_RAW_MAX 3800
+
+
+/* Types */
+struct EmuPanel
+{
+    unsigned short gram[MAX_X * MAX_Y];
+    unsigned short regs[256];
+    unsigned char index;
+    unsigned short acX, acY;
+    unsigned short latch;
+    unsigned char latchValid;
+    unsigned char cs;
+    unsigned short divider;
+    unsigned long writeHz, readHz;  /* GRAM clock limits, 0 none */
+    unsigned long noise;            /* state of the error generator */
+    unsigned char penDown;
+    unsigned short penX, penY;
+    unsigned long long touchNs;
+    const EmuTouchEvent *trace;
+    unsigned int traceCount;
+    unsigned long long busNs;
+    unsigned long long clockNs;
+    SPI0_Standin spi0;              /* registers of LCD_EmuSpi0Transport */
+    SPI0_Port spi0Port;             /* regs 0 until first used */
+};
+
+
+/* Function declarations */
+static void Emu_Reset(EmuPanel *p);
+
+
+/* Public declarations */
+static EmuPanel Default;                /* panel of a 0 context */
+static EmuPanel *Selected = &Default;   /* panel of the LCD_Emu functions */
+
+
+/*******************************************************************************
+* Function Name  : Emu_Panel
+* Description    : Panel of a transport call
+* Input          : - ctx: context of the call
+* Output         : None
+* Return         : panel
+* Attention      : None
+*******************************************************************************/
+static EmuPanel *Emu_Panel(void *ctx)
+{
+    return ctx ? (EmuPanel *)ctx : &Default;
+}
+
+
+/*******************************************************************************
+* Function Name  : Emu_Pen
+* Description    : Place or lift the pen of a panel
+* Input          : - p: panel
+*                  - Xpos, Ypos: GRAM column and row touched
+*                  - pressed: 1 pen down, 0 pen up
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Emu_Pen(EmuPanel *p, unsigned short Xpos, unsigned short Ypos, unsigned char pressed)
+{
+    p->penX = Xpos < MAX_X ? Xpos : MAX_X - 1;
+    p->penY = Ypos < MAX_Y ? Ypos : MAX_Y - 1;
+    p->penDown = pressed;
+    p->touchNs = p->clockNs;
+}
+
+
+
+/*******************************************************************************
+* Function Name  : Emu_RegsDefault
+* Description    : ILI9320 register values after reset
+* Input          : - p: panel
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Emu_RegsDefault(EmuPanel *p)
+{
+    memset(p->regs, 0, sizeof(p->regs));
+    p->regs[0x00] = 0x9320;            /* Device code */
+    p->regs[0x03] = EMU_ID1 | EMU_ID0;
+    p->regs[0x51] = MAX_X - 1;
+    p->regs[0x53] = MAX_Y - 1;
+    p->index = 0;
+    p->acX = p->acY = 0;
+    p->latchValid = 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : Emu_Advance
+* Description    : Move the address counter after a GRAM access
+* Input          : - p: panel
+* Output         : None
+* Return         : None
+* Attention      : Wraps inside the window 0x50-0x53 as the ILI9320 does
+*******************************************************************************/
+static void Emu_Advance(EmuPanel *p)
+{
+    unsigned short mode = p->regs[0x03];
+    unsigned short hsa = p->regs[0x50], hea = p->regs[0x51];
+    unsigned short vsa = p->regs[0x52], vea = p->regs[0x53];
+    int wrapH = 0, wrapV = 0;
+
+    if (mode & EMU_AM)
+    {
+        if (mode & EMU_ID1) { if (p->acY >= vea) { p->acY = vsa; wrapV = 1; } else p->acY++; }
+        else                { if (p->acY <= vsa) { p->acY = vea; wrapV = 1; } else p->acY--; }
+        if (wrapV)
+        {
+            if (mode & EMU_ID0) p->acX = p->acX >= hea ? hsa : p->acX + 1;
+            else                p->acX = p->acX <= hsa ? hea : p->acX - 1;
+        }
+    }
+    else
+    {
+        if (mode & EMU_ID0) { if (p->acX >= hea) { p->acX = hsa; wrapH = 1; } else p->acX++; }
+        else                { if (p->acX <= hsa) { p->acX = hea; wrapH = 1; } else p->acX--; }
+        if (wrapH)
+        {
+            if (mode & EMU_ID1) p->acY = p->acY >= vea ? vsa : p->acY + 1;
+            else                p->acY = p->acY <= vsa ? vea : p->acY - 1;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Emu_WriteData
+* Description    : Data word written to the register selected by the index
+* Input          : - p: panel
+*                  - data: 16-bit word
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Emu_WriteData(EmuPanel *p, unsigned short data)
+{
+    switch (p->index)
+    {
+    case 0x22:
+        if (p->acX < MAX_X && p->acY < MAX_Y)
+            p->gram[p->acY * MAX_X + p->acX] = data;
+        Emu_Advance(p);
+        break;
+    case 0x20:
+        p->acX = data & 0xFF;
+        p->latchValid = 0;
+        break;
+    case 0x21:
+        p->acY = data & 0x1FF;
+        p->latchValid = 0;
+        break;
+    case 0x00:
+        break;                      /* device code is read only */
+    default:
+        p->regs[p->index] = data;
+        break;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Emu_ReadData
+* Description    : Data word read from the register selected by the index
+* Input          : - p: panel
+* Output         : None
+* Return         : Register value, or the latched pixel in BGR order for GRAM
+* Attention      : None
+*******************************************************************************/
+static unsigned short Emu_ReadData(EmuPanel *p)
+{
+    unsigned short value, c;
+
+    switch (p->index)
+    {
+    case 0x22:
+        value = p->latchValid ? p->latch : 0;
+        c = p->acX < MAX_X && p->acY < MAX_Y ? p->gram[p->acY * MAX_X + p->acX] : 0;
+        p->latch = ((c & 0x1f) << 11) | (c & 0x07e0) | (c >> 11);
+        p->latchValid = 1;
+        Emu_Advance(p);
+        return value;
+    case 0x20:
+        return p->acX;
+    case 0x21:
+        return p->acY;
+    default:
+        return p->regs[p->index];
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Emu_Noise
+* Description    : Error of one word clocked too fast
+* Input          : - p: panel
+* Output         : None
+* Return         : mask of the bit flipped, 0 most of the time
+* Attention      : Pseudo random, the same on every run
+*******************************************************************************/
+static unsigned short Emu_Noise(EmuPanel *p)
+{
+    p->noise = p->noise * 1103515245 + 12345;
+    if ((p->noise >> 16) % EMU_NOISE_RATE)
+        return 0;
+    return 1 << ((p->noise >> 8) & 15);
+}
+
+
+/*******************************************************************************
+* Function Name  : Emu_LcdWrite
+* Description    : Payload of a write transfer on CS0
+* Input          : - p: panel
+*                  - start: start byte
+*                  - data: 16-bit words, MSB first
+*                  - len: number of bytes
+*                  - noisy: 1 if the clock is above the write limit
+* Output         : None
+* Return         : None
+* Attention      : An odd last byte is ignored
+*******************************************************************************/
+static void Emu_LcdWrite(EmuPanel *p, unsigned char start, const char *data, unsigned int len,
+                         int noisy)
+{
+    unsigned short value;
+    unsigned int i;
+
+    for (i = 0; i + 1 < len; i += 2)
+    {
+        value = ((unsigned char)data[i] << 8) | (unsigned char)data[i + 1];
+        if (start & SPI_DATA)
+        {
+            if (noisy && p->index == 0x22)
+                value ^= Emu_Noise(p);
+            Emu_WriteData(p, value);
+        }
+        else
+        {
+            p->index = value & 0xFF;
+            p->latchValid = 0;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Emu_Bus
+* Description    : Bus time of one transfer
+* Input          : - p: panel
+*                  - len: number of bytes
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Emu_Bus(EmuPanel *p, unsigned int len)
+{
+    unsigned long long ns;
+
+    ns = (unsigned long long)len * 8 * p->divider * 1000000000ULL / EMU_CORE_CLOCK + EMU_XFER_NS;
+    p->busNs += ns;
+    p->clockNs += ns;
+}
+
+
+/*******************************************************************************
+* Function Name  : Emu_Lcd
+* Description    : One transfer on CS0
+* Input          : - p: panel
+*                  - buf: start byte followed by the payload
+*                  - len: number of bytes
+*                  - noisy: 1 if the clock is above the limit of the transfer
+* Output         : - buf: dummy byte and words read back on a read
+* Return         : None
+* Attention      : Only GRAM words are hit by the errors of a noisy
+*                  transfer, registers stay right
+*******************************************************************************/
+static void Emu_Lcd(EmuPanel *p, char *buf, unsigned int len, int noisy)
+{
+    unsigned char start = buf[0];
+    unsigned short value;
+    unsigned int i;
+
+    if (len < 2 || (start & 0xFC) != SPI_START)
+        return;
+
+    if (start & SPI_RD)
+    {
+        buf[1] = 0;                 /* dummy byte */
+        for (i = 2; i + 1 < len; i += 2)
+        {
+            value = (start & SPI_DATA) ? Emu_ReadData(p) : 0;
+            if (noisy && p->index == 0x22)
+                value ^= Emu_Noise(p);
+            buf[i] = value >> 8;
+            buf[i + 1] = value & 0xFF;
+        }
+        return;
+    }
+
+    Emu_LcdWrite(p, start, buf + 1, len - 1, noisy);
+}
+
+
+/*******************************************************************************
+* Function Name  : Emu_TraceAdvance
+* Description    : Apply the touch trace events that are due
+* Input          : - p: panel
+* Output         : None
+* Return         : None
+* Attention      : Called when the pen is looked at, an event is applied
+*                  late but keeps its own time in TouchNs
+*******************************************************************************/
+static void Emu_TraceAdvance(EmuPanel *p)
+{
+    while (p->traceCount && p->trace->tNs <= p->clockNs)
+    {
+        Emu_Pen(p, p->trace->x, p->trace->y, p->trace->pressed);
+        p->touchNs = p->trace->tNs;
+        p->trace++;
+        p->traceCount--;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Emu_Touch
+* Description    : One transfer on CS1, an ADS7843 conversion
+* Input          : - p: panel
+*                  - buf: command byte followed by two zero bytes
+*                  - len: number of bytes
+* Output         : - buf: 12-bit conversion in bits 14..3 of bytes 1 and 2
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Emu_Touch(EmuPanel *p, char *buf, unsigned int len)
+{
+    unsigned short raw = 0;
+
+    if (len < 3)
+        return;
+    Emu_TraceAdvance(p);
+    if ((unsigned char)buf[0] == CHX)
+        raw = EMU_RAW_MIN + (unsigned long)p->penX * (EMU_RAW_MAX - EMU_RAW_MIN) / (MAX_X - 1);
+    else if ((unsigned char)buf[0] == CHY)
+        raw = EMU_RAW_MIN + (unsigned long)p->penY * (EMU_RAW_MAX - EMU_RAW_MIN) / (MAX_Y - 1);
+    if (!p->penDown)
+        raw = 0;
+    buf[1] = raw >> 4;
+    buf[2] = (raw & 0x0F) << 4;
+}
+
+
+/*******************************************************************************
+* Function Name  : Emu_Open ... Emu_Spi0Write
+* Description    : LCD_Transport callbacks of the emulation
+* Input          : See LCD_Transport
+* Output         : None
+* Return         : None
+* Attention      : Delays advance the modeled clock, they never sleep
+*                  Emu_Spi0Write runs SPI0_Write on registers in memory,
+*                  whose transfers reach the panel by Emu_SpiTransfer
+*******************************************************************************/
+static int Emu_Open(void *ctx)
+{
+    Emu_Reset(Emu_Panel(ctx));
+    return 1;
+}
+
+
+static void Emu_Close(void *ctx)
+{
+}
+
+
+static void Emu_SpiBegin(void *ctx)
+{
+}
+
+
+static void Emu_SpiSelect(void *ctx, unsigned char cs, unsigned short divider)
+{
+    EmuPanel *p = Emu_Panel(ctx);
+
+    p->cs = cs;
+    p->divider = divider ? divider : 65536U;
+}
+
+
+static void Emu_SpiTransfer(void *ctx, char *buf, unsigned int len)
+{
+    EmuPanel *p = Emu_Panel(ctx);
+    unsigned long hz, limit;
+
+    Emu_Bus(p, len);
+    if (p->cs == LCD_CS_TOUCH)
+    {
+        Emu_Touch(p, buf, len);
+        return;
+    }
+    hz = EMU_CORE_CLOCK / p->divider;
+    limit = len && (buf[0] & SPI_RD) ? p->readHz : p->writeHz;
+    Emu_Lcd(p, buf, len, limit && hz > limit);
+}
+
+
+static void Emu_SpiWrite(void *ctx, const char *head, unsigned int headLen,
+                         const char *buf, unsigned int len)
+{
+    EmuPanel *p = Emu_Panel(ctx);
+    unsigned long hz;
+    char *joined;
+
+    if (p->cs == LCD_CS_LCD && headLen && (headLen == 1 || !len))
+    {
+        /* start byte apart from the words: no copy */
+        Emu_Bus(p, headLen + len);
+        if (((unsigned char)head[0] & 0xFC) != SPI_START || (head[0] & SPI_RD) || headLen + len < 2)
+            return;
+        hz = EMU_CORE_CLOCK / p->divider;
+        Emu_LcdWrite(p, head[0], headLen == 1 ? buf : head + 1, headLen == 1 ? len : headLen - 1,
+                     p->writeHz && hz > p->writeHz);
+        return;
+    }
+    joined = malloc(headLen + len);
+    if (!joined)
+        return;
+    memcpy(joined, head, headLen);
+    if (len)
+        memcpy(joined + headLen, buf, len);
+    Emu_SpiTransfer(ctx, joined, headLen + len);
+    free(joined);
+}
+
+
+static void Emu_Spi0Sink(void *ctx, char *buf, unsigned int len)
+{
+    Emu_SpiTransfer(ctx, buf, len);
+}
+
+
+static void Emu_Spi0Write(void *ctx, const char *head, unsigned int headLen,
+                          const char *buf, unsigned int len)
+{
+    EmuPanel *p = Emu_Panel(ctx);
+
+    if (!p->spi0Port.regs)
+        SPI0_StandinInit(&p->spi0, &p->spi0Port, Emu_Spi0Sink, p);
+    SPI0_Write(&p->spi0Port, head, headLen, buf, len);
+}
+
+
+static void Emu_GpioWrite(void *ctx, unsigned char pin, unsigned char level)
+{
+    if (pin == LCD_PIN_RESET && !level)
+        Emu_RegsDefault(Emu_Panel(ctx));
+}
+
+
+static void Emu_IrqInit(void *ctx)
+{
+}
+
+
+static void Emu_IrqClear(void *ctx)
+{
+}
+
+
+static unsigned char Emu_IrqTest(void *ctx)
+{
+    EmuPanel *p = Emu_Panel(ctx);
+
+    Emu_TraceAdvance(p);
+    return p->penDown ? 0 : 1;
+}
+
+
+static void Emu_Delay(void *ctx, unsigned int millis)
+{
+    Emu_Panel(ctx)->clockNs += millis * 1000000ULL;
+}
+
+
+const LCD_Transport LCD_EmuTransport = {
+    "emu",
+    Emu_Open,
+    Emu_Close,
+    Emu_SpiBegin,
+    Emu_SpiSelect,
+    Emu_SpiTransfer,
+    Emu_GpioWrite,
+    Emu_IrqInit,
+    Emu_IrqClear,
+    Emu_IrqTest,
+    Emu_Delay,
+    Emu_SpiWrite
+};
+
+
+const LCD_Transport LCD_EmuSpi0Transport = {
+    "emu-spi0",
+    Emu_Open,
+    Emu_Close,
+    Emu_SpiBegin,
+    Emu_SpiSelect,
+    Emu_SpiTransfer,
+    Emu_GpioWrite,
+    Emu_IrqInit,
+    Emu_IrqClear,
+    Emu_IrqTest,
+    Emu_Delay,
+    Emu_Spi0Write
+};
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuReset
+* Description    : Power on state of the selected panel
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_EmuReset(void)
+{
+    Emu_Reset(Selected);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuCreate
+* Description    : One more emulated panel
+* Input          : None
+* Output         : None
+* Return         : panel, to give with LCD_EmuTransport to LCD_DeviceOpen;
+*                  0 if out of memory
+* Attention      : None
+*******************************************************************************/
+EmuPanel *LCD_EmuCreate(void)
+{
+    EmuPanel *p;
+
+    p = calloc(1, sizeof(*p));
+    if (p)
+        Emu_Reset(p);
+    return p;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuDestroy
+* Description    : Free a panel of LCD_EmuCreate
+* Input          : - panel: panel, its device closed
+* Output         : None
+* Return         : None
+* Attention      : Selects the default panel if it was selected
+*******************************************************************************/
+void LCD_EmuDestroy(EmuPanel *panel)
+{
+    if (!panel || panel == &Default)
+        return;
+    if (Selected == panel)
+        Selected = &Default;
+    SPI0_StandinFree(&panel->spi0);
+    free(panel);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuSelect
+* Description    : Panel the other LCD_Emu functions look at and touch
+* Input          : - panel: panel of LCD_EmuCreate, 0 for the default one
+* Output         : None
+* Return         : panel selected before
+* Attention      : The default panel is the one of a 0 context, LCD_Open
+*******************************************************************************/
+EmuPanel *LCD_EmuSelect(EmuPanel *panel)
+{
+    EmuPanel *prev = Selected;
+
+    Selected = panel ? panel : &Default;
+    return prev;
+}
+
+
+/*******************************************************************************
+* Function Name  : Emu_Reset
+* Description    : Power on state: registers at reset values, GRAM black,
+*                  pen up and bus time zeroed
+* Input          : - p: panel
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Emu_Reset(EmuPanel *p)
+{
+    memset(p->gram, 0, sizeof(p->gram));
+    Emu_RegsDefault(p);
+    p->cs = LCD_CS_LCD;
+    p->divider = 8;
+    p->penDown = 0;
+    p->traceCount = 0;
+    p->busNs = p->clockNs = p->touchNs = 0;
+    p->noise = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuGram
+* Description    : Emulated GRAM
+* Input          : None
+* Output         : None
+* Return         : MAX_X * MAX_Y pixels as written, index y * MAX_X + x
+* Attention      : Addresses are GRAM ones, not rotated by the orientation
+*******************************************************************************/
+const unsigned short *LCD_EmuGram(void)
+{
+    EmuPanel *p = Selected;
+
+    return p->gram;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuReg
+* Description    : Current value of an emulated register
+* Input          : - reg: register address
+* Output         : None
+* Return         : Register value
+* Attention      : None
+*******************************************************************************/
+unsigned short LCD_EmuReg(unsigned char reg)
+{
+    EmuPanel *p = Selected;
+
+    if (reg == 0x20) return p->acX;
+    if (reg == 0x21) return p->acY;
+    return p->regs[reg];
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuTouch
+* Description    : Place or lift the emulated pen
+* Input          : - Xpos: GRAM column touched
+*                  - Ypos: GRAM row touched
+*                  - pressed: 1 pen down, 0 pen up
+* Output         : None
+* Return         : None
+* Attention      : Raw conversions are linear between EMU_RAW_MIN and EMU_RAW_MAX
+*******************************************************************************/
+void LCD_EmuTouch(unsigned short Xpos, unsigned short Ypos, unsigned char pressed)
+{
+    Emu_Pen(Selected, Xpos, Ypos, pressed);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuTouchTrace
+* Description    : Play a touch trace on the modeled clock
+* Input          : - trace: pen changes in time order, kept until played
+*                  - count: number of changes
+* Output         : None
+* Return         : None
+* Attention      : Replaces the trace being played; the driver sees each
+*                  change at its first pen IRQ test or conversion after it
+*******************************************************************************/
+void LCD_EmuTouchTrace(const EmuTouchEvent *trace, unsigned int count)
+{
+    EmuPanel *p = Selected;
+
+    p->trace = trace;
+    p->traceCount = count;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuSpiLimit
+* Description    : Fastest SPI clocks the panel and its cable take without
+*                  error, beyond them GRAM words are corrupted
+* Input          : - writeHz: limit of the writes, 0 none
+*                  - readHz: limit of the reads, 0 none
+* Output         : None
+* Return         : None
+* Attention      : One word in EMU_NOISE_RATE has a bit flipped, in GRAM on
+*                  a write, on the bus on a read. Kept across resets
+*******************************************************************************/
+void LCD_EmuSpiLimit(unsigned long writeHz, unsigned long readHz)
+{
+    EmuPanel *p = Selected;
+
+    p->writeHz = writeHz;
+    p->readHz = readHz;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuSpi0Accesses
+* Description    : SPI0 register reads and writes of the transfers made
+*                  through LCD_EmuSpi0Transport
+* Input          : None
+* Output         : None
+* Return         : number of register accesses since the first transfer
+* Attention      : What the CPU does for them on the chip, polled mode
+*******************************************************************************/
+unsigned long LCD_EmuSpi0Accesses(void)
+{
+    EmuPanel *p = Selected;
+
+    return p->spi0.reads + p->spi0.writes;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuTouchNs
+* Description    : Modeled time of the last pen change
+* Input          : None
+* Output         : None
+* Return         : nanoseconds
+* Attention      : Clock source of LCD_LatencyClock for the touch time
+*******************************************************************************/
+unsigned long long LCD_EmuTouchNs(void)
+{
+    EmuPanel *p = Selected;
+
+    return p->touchNs;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuBusNs
+* Description    : Modeled time the SPI bus was busy since reset
+* Input          : None
+* Output         : None
+* Return         : nanoseconds
+* Attention      : None
+*******************************************************************************/
+unsigned long long LCD_EmuBusNs(void)
+{
+    EmuPanel *p = Selected;
+
+    return p->busNs;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_EmuClockNs
+* Description    : Modeled time since reset, bus time plus delays
+* Input          : None
+* Output         : None
+* Return         : nanoseconds
+* Attention      : None
+*******************************************************************************/
+unsigned long long LCD_EmuClockNs(void)
+{
+    EmuPanel *p = Selected;
+
+    return p->clockNs;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,61 @@
+/*******************************************************************************
+* File Name      : lcd_emu.h
+* Description    : Software emulation of the HY28A-LCDB behind the driver:
+*                  ILI9320 registers, GRAM and address counter on CS0,
+*                  ADS7843 conversions and pen IRQ on CS1
+*                  Bus time is modeled from the bytes clocked and the divider
+*                  A touch trace moves the pen on the modeled clock
+*                  GRAM words clocked above the limits of LCD_EmuSpiLimit
+*                  get bit errors, as a panel or cable too slow for them
+*                  LCD_EmuSpi0Transport sends the writes through the SPI0
+*                  FIFO code of lcd_spi0.c, on registers in memory
+*******************************************************************************/
+#ifndef __LCD_EMU_H
+#define __LCD_EMU_H
+
+/* Includes */
+#include "lcd_transport.h"
+
+
+/* Defines */
+#define EMU_CORE_CLOCK 250000000UL  /* SPI clock = EMU_CORE_CLOCK / divider */
+#define EMU_XFER_NS 2000            /* CS and FIFO setup cost of one transfer */
+
+
+/* Types */
+typedef struct EmuPanel EmuPanel;
+
+typedef struct
+{
+    unsigned long long tNs;     /* modeled time of the change */
+    unsigned short x, y;        /* GRAM column and row */
+    unsigned char pressed;      /* 1 pen down, 0 pen up */
+} EmuTouchEvent;
+
+
+/* Public declarations */
+extern const LCD_Transport LCD_EmuTransport;
+extern const LCD_Transport LCD_EmuSpi0Transport;   /* writes through the SPI0 FIFO code */
+
+
+/* Function declarations */
+EmuPanel *LCD_EmuCreate(void);
+void LCD_EmuDestroy(EmuPanel *panel);
+EmuPanel *LCD_EmuSelect(EmuPanel *panel);
+void LCD_EmuReset(void);
+const unsigned short *LCD_EmuGram(void);
+unsigned short LCD_EmuReg(unsigned char reg);
+void LCD_EmuTouch(unsigned short Xpos, unsigned short Ypos, unsigned char pressed);
+void LCD_EmuTouchTrace(const EmuTouchEvent *trace, unsigned int count);
+void LCD_EmuSpiLimit(unsigned long writeHz, unsigned long readHz);
+unsigned long LCD_EmuSpi0Accesses(void);
+unsigned long long LCD_EmuTouchNs(void);
+unsigned long long LCD_EmuBusNs(void);
+unsigned long long LCD_EmuClockNs(void);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
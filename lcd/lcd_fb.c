@@ -0,0 +1,227 @@
+/*******************************************************************************
+* File Name      : lcd_fb.c
+* Description    : Client side of the framebuffer daemon fbd
+*                  Needs neither root nor the bcm2835 library: the client
+*                  only maps its surface and talks to fbd over the socket
+* Compile/link   : gcc -o client client.c lcd_fb.c
+*******************************************************************************/
+/* Includes */
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "lcd_fb.h"
+
+
+/*******************************************************************************
+* Function Name  : Fb_Recv
+* Description    : Receive one message from fbd
+* Input          : - client: connection
+*                  - flags: MSG_DONTWAIT or 0
+* Output         : - msg: message
+*                  - fd: descriptor passed with it, -1 if none; may be 0
+* Return         : 1 message, 0 none yet with MSG_DONTWAIT, -1 connection lost
+* Attention      : FB_DONE updates client->done
+*******************************************************************************/
+static int Fb_Recv(FbClient *client, int flags, FbMsg *msg, int *fd)
+{
+    struct msghdr mh;
+    struct iovec iov;
+    struct cmsghdr *cm;
+    char control[CMSG_SPACE(sizeof(int))];
+    ssize_t n;
+
+    memset(&mh, 0, sizeof(mh));
+    iov.iov_base = msg;
+    iov.iov_len = sizeof(*msg);
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = control;
+    mh.msg_controllen = sizeof(control);
+    n = recvmsg(client->sock, &mh, flags);
+    if (n < 0 && flags)
+        return 0;
+    if (n != sizeof(*msg))
+        return -1;
+    if (fd)
+        *fd = -1;
+    for (cm = CMSG_FIRSTHDR(&mh); cm; cm = CMSG_NXTHDR(&mh, cm))
+        if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS)
+        {
+            if (fd)
+                memcpy(fd, CMSG_DATA(cm), sizeof(int));
+            else
+                close(*(int *)CMSG_DATA(cm));
+        }
+    if (msg->type == FB_DONE && (int)(msg->seq - client->done) > 0)
+        client->done = msg->seq;
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : Fb_Send
+* Description    : Send one message to fbd
+* Input          : - client: connection
+*                  - type: FB_x
+*                  - seq, x, y, w, h: fields of the message
+* Output         : None
+* Return         : 1 success, 0 connection lost
+* Attention      : None
+*******************************************************************************/
+static int Fb_Send(FbClient *client, unsigned int type, unsigned int seq,
+                   short x, short y, unsigned short w, unsigned short h)
+{
+    FbMsg msg;
+
+    msg.type = type;
+    msg.seq = seq;
+    msg.x = x;
+    msg.y = y;
+    msg.w = w;
+    msg.h = h;
+    return send(client->sock, &msg, sizeof(msg), MSG_NOSIGNAL) == sizeof(msg);
+}
+
+
+/*******************************************************************************
+* Function Name  : FB_Connect
+* Description    : Connect to fbd and map a surface on the screen
+* Input          : - path: socket of fbd, 0 for FB_SOCKET
+*                  - Xpos, Ypos: upper left corner on the screen
+*                  - w, h: size, 0 * 0 for the whole screen
+* Output         : - client: connection, with the surface granted
+* Return         : 1 success, 0 fail
+* Attention      : The surface is clipped to the screen by fbd: w and h may
+*                  be smaller than asked. It starts black, over the surfaces
+*                  of the clients connected before
+*******************************************************************************/
+int FB_Connect(FbClient *client, const char *path, short Xpos, short Ypos, unsigned short w, unsigned short h)
+{
+    struct sockaddr_un addr;
+    FbMsg msg;
+    void *map;
+    int fd = -1;
+
+    memset(client, 0, sizeof(*client));
+    client->sock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (client->sock < 0)
+        return 0;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path ? path : FB_SOCKET, sizeof(addr.sun_path) - 1);
+    if (connect(client->sock, (struct sockaddr *)&addr, sizeof(addr)) < 0
+        || !Fb_Send(client, FB_HELLO, 0, Xpos, Ypos, w, h)
+        || Fb_Recv(client, 0, &msg, &fd) != 1 || msg.type != FB_SURFACE || fd < 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        close(client->sock);
+        return 0;
+    }
+    map = mmap(0, (size_t)msg.w * msg.h * 2, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        close(client->sock);
+        return 0;
+    }
+    client->pixels = map;
+    client->x = msg.x;
+    client->y = msg.y;
+    client->w = msg.w;
+    client->h = msg.h;
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : FB_Disconnect
+* Description    : Unmap the surface and leave fbd
+* Input          : - client: connection
+* Output         : None
+* Return         : None
+* Attention      : fbd removes the surface from the screen
+*******************************************************************************/
+void FB_Disconnect(FbClient *client)
+{
+    munmap(client->pixels, (size_t)client->w * client->h * 2);
+    close(client->sock);
+    client->pixels = 0;
+    client->sock = -1;
+}
+
+
+/*******************************************************************************
+* Function Name  : FB_Damage
+* Description    : Tell fbd a rectangle of the surface changed
+* Input          : - client: connection
+*                  - Xpos, Ypos: upper left corner in the surface
+*                  - w, h: size
+* Output         : None
+* Return         : number of this damage for FB_Wait, 0 connection lost
+* Attention      : Does not wait: fbd flushes at its pace and merges the
+*                  damage sent meanwhile. Acknowledgements already received
+*                  are read on the way
+*******************************************************************************/
+unsigned int FB_Damage(FbClient *client, unsigned short Xpos, unsigned short Ypos, unsigned short w, unsigned short h)
+{
+    FbMsg msg;
+
+    while (Fb_Recv(client, MSG_DONTWAIT, &msg, 0) == 1)
+        ;
+    if (Xpos >= client->w || Ypos >= client->h || !w || !h)
+        return client->seq;
+    if (w > client->w - Xpos) w = client->w - Xpos;
+    if (h > client->h - Ypos) h = client->h - Ypos;
+    if (!++client->seq)
+        client->seq = 1;        /* 0 is the error */
+    return Fb_Send(client, FB_DAMAGE, client->seq, Xpos, Ypos, w, h) ? client->seq : 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : FB_Move
+* Description    : Move the surface on the screen
+* Input          : - client: connection
+*                  - Xpos, Ypos: upper left corner on the screen
+* Output         : None
+* Return         : number of this move for FB_Wait, 0 connection lost
+* Attention      : fbd damages the old and the new place
+*******************************************************************************/
+unsigned int FB_Move(FbClient *client, short Xpos, short Ypos)
+{
+    if (!++client->seq)
+        client->seq = 1;
+    if (!Fb_Send(client, FB_MOVE, client->seq, Xpos, Ypos, 0, 0))
+        return 0;
+    client->x = Xpos;
+    client->y = Ypos;
+    return client->seq;
+}
+
+
+/*******************************************************************************
+* Function Name  : FB_Wait
+* Description    : Wait until a damage is on the panel
+* Input          : - client: connection
+*                  - seq: number returned by FB_Damage
+* Output         : None
+* Return         : 1 flushed, 0 connection lost
+* Attention      : Drawing again in the rectangle after it avoids tearing
+*******************************************************************************/
+int FB_Wait(FbClient *client, unsigned int seq)
+{
+    FbMsg msg;
+
+    while ((int)(client->done - seq) < 0)
+        if (Fb_Recv(client, 0, &msg, 0) != 1)
+            return 0;
+    return 1;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
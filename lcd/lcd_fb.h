@@ -0,0 +1,62 @@
+/*******************************************************************************
+* File Name      : lcd_fb.h
+* Description    : Client side of the framebuffer daemon fbd
+*                  fbd owns the panel; each client gets a POSIX shared memory
+*                  RGB565 surface for a rectangle of the screen, draws in it
+*                  directly and sends the rectangles it changed over a Unix
+*                  socket. fbd composites the surfaces as layers, bottom to
+*                  top in the order they connected, and flushes only the
+*                  damaged rectangles, then acknowledges them
+*                  One fixed size FbMsg per SOCK_SEQPACKET message; the
+*                  surface comes with FB_SURFACE as an SCM_RIGHTS descriptor
+*******************************************************************************/
+#ifndef __LCD_FB_H
+#define __LCD_FB_H
+
+
+/* Defines */
+#define FB_SOCKET "/tmp/lcd-fb.sock"  /* default socket of fbd */
+#define FB_CLIENTS 7                  /* LAYER_MAX less the background */
+
+/* FbMsg types */
+#define FB_HELLO 1              /* client: surface wanted at x, y, w * h; 0 * 0 whole screen */
+#define FB_SURFACE 2            /* fbd: surface granted at x, y, w * h, with its descriptor */
+#define FB_DAMAGE 3             /* client: x, y, w * h of the surface changed, numbered seq */
+#define FB_DONE 4               /* fbd: damage up to seq is on the panel */
+#define FB_MOVE 5               /* client: surface moved to x, y, numbered seq */
+#define FB_REFUSED 6            /* fbd: no layer left, or bad request */
+
+
+/* Types */
+typedef struct
+{
+    unsigned int type;          /* FB_x */
+    unsigned int seq;
+    short x, y;
+    unsigned short w, h;
+} FbMsg;
+
+typedef struct
+{
+    int sock;
+    unsigned short *pixels;     /* w * h RGB565, line by line, shared with fbd */
+    unsigned short w, h;
+    short x, y;                 /* upper left corner on the screen */
+    unsigned int seq;           /* last damage or move sent */
+    unsigned int done;          /* last damage acknowledged */
+} FbClient;
+
+
+/* Function declarations */
+int FB_Connect(FbClient *client, const char *path, short Xpos, short Ypos, unsigned short w, unsigned short h);
+void FB_Disconnect(FbClient *client);
+unsigned int FB_Damage(FbClient *client, unsigned short Xpos, unsigned short Ypos, unsigned short w, unsigned short h);
+unsigned int FB_Move(FbClient *client, short Xpos, short Ypos);
+int FB_Wait(FbClient *client, unsigned int seq);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,292 @@
+/*******************************************************************************
+* File Name      : lcd_gesture.c
+* Description    : Gesture recognizer
+*                  A state machine moved by each sample (GS_Feed) and by the
+*                  time (GS_Tick) for the events decided by a timeout: long
+*                  press, and a tap held back to exclude a double tap.
+*                  The last GS_HISTORY pen down samples give the velocity
+*******************************************************************************/
+/* Includes */
+#include <stdlib.h>
+#include <string.h>
+#include "lcd_gesture.h"
+
+
+/*******************************************************************************
+* Function Name  : GS_Emit
+* Description    : Pass an event to the handler
+* Input          : - gs: recognizer
+*                  - event: event, latencyUs is set here
+*                  - nowUs: time the event is decided
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void GS_Emit(GsRecognizer *gs, GsEvent *event, unsigned long long nowUs)
+{
+    event->latencyUs = nowUs > event->tUs ? nowUs - event->tUs : 0;
+    if (gs->handler)
+        gs->handler(gs, event);
+}
+
+
+/*******************************************************************************
+* Function Name  : GS_Event
+* Description    : Pass an event without move or velocity
+* Input          : - gs: recognizer
+*                  - type: GS_x
+*                  - x, y: pen position
+*                  - tUs: time of the sample that decided it
+*                  - nowUs: time the event is decided
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void GS_Event(GsRecognizer *gs, GsType type, short x, short y,
+                     unsigned long long tUs, unsigned long long nowUs)
+{
+    GsEvent event;
+
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.x = x;
+    event.y = y;
+    event.tUs = tUs;
+    GS_Emit(gs, &event, nowUs);
+}
+
+
+/*******************************************************************************
+* Function Name  : GS_FlushTap
+* Description    : Pass the tap held back for a double tap that did not come
+* Input          : - gs: recognizer
+*                  - nowUs: current time
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void GS_FlushTap(GsRecognizer *gs, unsigned long long nowUs)
+{
+    if (!gs->tapPending)
+        return;
+    gs->tapPending = 0;
+    GS_Event(gs, GS_TAP, gs->tapX, gs->tapY, gs->tapUs, nowUs);
+}
+
+
+/*******************************************************************************
+* Function Name  : GS_Velocity
+* Description    : Pen velocity at the last pen down sample
+* Input          : - gs: recognizer
+* Output         : - vx, vy: pixels per second
+* Return         : None
+* Attention      : Measured over the samples of the last GS_VELOCITY_US
+*******************************************************************************/
+static void GS_Velocity(const GsRecognizer *gs, int *vx, int *vy)
+{
+    const TouchSample *last, *old, *s;
+    unsigned long long dt;
+    int i;
+
+    *vx = *vy = 0;
+    if (gs->count < 2)
+        return;
+    last = &gs->history[(gs->head + GS_HISTORY - 1) % GS_HISTORY];
+    old = last;
+    for (i = 2; i <= gs->count; i++)
+    {
+        s = &gs->history[(gs->head + GS_HISTORY - i) % GS_HISTORY];
+        if (last->tUs - s->tUs > GS_VELOCITY_US)
+            break;
+        old = s;
+    }
+    dt = last->tUs - old->tUs;
+    if (!dt)
+        return;
+    *vx = (long long)(last->x - old->x) * 1000000 / (long long)dt;
+    *vy = (long long)(last->y - old->y) * 1000000 / (long long)dt;
+}
+
+
+/*******************************************************************************
+* Function Name  : GS_Init
+* Description    : Start a recognizer
+* Input          : - handler: called with each event, may be 0
+*                  - exclusive: 1 to hold a tap back until no double tap can
+*                    follow, 0 to pass it at once and the double tap after it
+* Output         : - gs: recognizer
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void GS_Init(GsRecognizer *gs, GsHandler handler, unsigned char exclusive)
+{
+    memset(gs, 0, sizeof(*gs));
+    gs->handler = handler;
+    gs->exclusive = exclusive;
+}
+
+
+/*******************************************************************************
+* Function Name  : GS_Tick
+* Description    : Pass the events decided by the time
+* Input          : - gs: recognizer
+*                  - nowUs: current time, CLOCK_MONOTONIC microseconds
+* Output         : None
+* Return         : None
+* Attention      : Called by GS_Feed; call it too when no sample comes, the
+*                  delay between calls adds to the latency of a long press
+*                  and of an exclusive tap
+*******************************************************************************/
+void GS_Tick(GsRecognizer *gs, unsigned long long nowUs)
+{
+    GsEvent event;
+
+    if (gs->tapPending && !gs->down && nowUs - gs->tapUs > GS_DOUBLE_US)
+        GS_FlushTap(gs, nowUs);
+    if (gs->down && !gs->dragging && !gs->longDone && nowUs - gs->downUs >= GS_LONG_US)
+    {
+        gs->longDone = 1;
+        GS_FlushTap(gs, nowUs);
+        gs->tapUs = 0;                  /* no double tap across it */
+        memset(&event, 0, sizeof(event));
+        event.type = GS_LONG_PRESS;
+        event.x = gs->downX;
+        event.y = gs->downY;
+        event.tUs = gs->downUs + GS_LONG_US;
+        GS_Emit(gs, &event, nowUs);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : GS_Feed
+* Description    : Process one touch sample
+* Input          : - gs: recognizer
+*                  - sample: sample, as read by TP_ReadSample
+* Output         : None
+* Return         : None
+* Attention      : Samples must come in time order. The first sample beyond
+*                  GS_SLOP starts the drag with the whole move since the press
+*******************************************************************************/
+void GS_Feed(GsRecognizer *gs, const TouchSample *sample)
+{
+    unsigned long long t = sample->tUs;
+    GsEvent event;
+    int near;
+
+    GS_Tick(gs, t);
+    memset(&event, 0, sizeof(event));
+    event.x = sample->x;
+    event.y = sample->y;
+    event.tUs = t;
+
+    if (sample->pen)
+    {
+        if (!gs->down)
+        {
+            /* a press far from the held back tap, or too late, is no
+               second tap */
+            near = abs(sample->x - gs->tapX) <= GS_DOUBLE_SLOP
+                   && abs(sample->y - gs->tapY) <= GS_DOUBLE_SLOP;
+            if (gs->tapPending && (!near || t - gs->tapUs > GS_DOUBLE_US))
+                GS_FlushTap(gs, t);
+            gs->down = 1;
+            gs->dragging = 0;
+            gs->longDone = 0;
+            gs->downX = gs->lastX = sample->x;
+            gs->downY = gs->lastY = sample->y;
+            gs->downUs = t;
+            gs->history[0] = *sample;
+            gs->head = gs->count = 1;
+            event.type = GS_PRESS;
+            GS_Emit(gs, &event, t);
+            return;
+        }
+
+        gs->history[gs->head] = *sample;
+        gs->head = (gs->head + 1) % GS_HISTORY;
+        if (gs->count < GS_HISTORY)
+            gs->count++;
+        if (!gs->dragging)
+        {
+            if (abs(sample->x - gs->downX) <= GS_SLOP && abs(sample->y - gs->downY) <= GS_SLOP)
+                return;
+            GS_FlushTap(gs, t);
+            gs->tapUs = 0;              /* no double tap across it */
+            gs->dragging = 1;
+            event.type = GS_DRAG_START;
+            event.dx = sample->x - gs->downX;
+            event.dy = sample->y - gs->downY;
+        }
+        else
+        {
+            if (sample->x == gs->lastX && sample->y == gs->lastY)
+                return;
+            event.type = GS_DRAG;
+            event.dx = sample->x - gs->lastX;
+            event.dy = sample->y - gs->lastY;
+        }
+        gs->lastX = sample->x;
+        gs->lastY = sample->y;
+        GS_Velocity(gs, &event.vx, &event.vy);
+        GS_Emit(gs, &event, t);
+        return;
+    }
+
+    if (!gs->down)
+        return;
+    gs->down = 0;
+    event.x = gs->lastX;                /* a pen up sample has no position */
+    event.y = gs->lastY;
+    event.type = GS_RELEASE;
+    GS_Emit(gs, &event, t);
+
+    if (gs->dragging)
+    {
+        GS_FlushTap(gs, t);
+        GS_Velocity(gs, &event.vx, &event.vy);
+        event.type = GS_DRAG_END;
+        GS_Emit(gs, &event, t);
+        if ((long long)event.vx * event.vx + (long long)event.vy * event.vy
+            >= (long long)GS_FLING_SPEED * GS_FLING_SPEED)
+        {
+            event.type = GS_FLING;
+            GS_Emit(gs, &event, t);
+        }
+        return;
+    }
+    if (gs->longDone || t - gs->downUs > GS_TAP_US)
+    {
+        GS_FlushTap(gs, t);
+        gs->tapUs = 0;
+        return;
+    }
+
+    /* a tap: second one of a double tap, or the first */
+    if (gs->tapUs && gs->downUs - gs->tapUs <= GS_DOUBLE_US
+        && abs(gs->downX - gs->tapX) <= GS_DOUBLE_SLOP
+        && abs(gs->downY - gs->tapY) <= GS_DOUBLE_SLOP)
+    {
+        gs->tapPending = 0;
+        gs->tapUs = 0;
+        event.type = GS_DOUBLE_TAP;
+        GS_Emit(gs, &event, t);
+        return;
+    }
+    GS_FlushTap(gs, t);
+    gs->tapX = event.x;
+    gs->tapY = event.y;
+    gs->tapUs = t;
+    if (gs->exclusive)
+    {
+        gs->tapPending = 1;
+        return;
+    }
+    event.type = GS_TAP;
+    GS_Emit(gs, &event, t);
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,83 @@
+/*******************************************************************************
+* File Name      : lcd_gesture.h
+* Description    : Gesture recognizer over timestamped touch samples: tap,
+*                  double tap, long press, drag and fling with velocity
+*                  Each sample is processed when it is fed, the memory used
+*                  is the GsRecognizer structure
+*                  Latency of each event after the sample that decides it:
+*                  press, release, drag, drag end, fling, double tap   0
+*                  tap                           0, GS_DOUBLE_US if exclusive
+*                  long press                    GS_LONG_US after the press
+*******************************************************************************/
+#ifndef __LCD_GESTURE_H
+#define __LCD_GESTURE_H
+
+/* Includes */
+#include "lcd.h"
+
+
+/* Defines */
+#define GS_SLOP 6               /* pixels the pen may move in a tap */
+#define GS_TAP_US 300000        /* longest tap */
+#define GS_DOUBLE_US 300000     /* longest gap between two taps of a double tap */
+#define GS_DOUBLE_SLOP 20       /* pixels between two taps of a double tap */
+#define GS_LONG_US 600000       /* long press */
+#define GS_FLING_SPEED 400      /* pixels per second at the release for a fling */
+#define GS_VELOCITY_US 80000    /* samples the velocity is measured over */
+#define GS_HISTORY 8            /* samples kept for the velocity */
+
+
+/* Types */
+typedef enum
+{
+    GS_PRESS,                   /* pen down */
+    GS_RELEASE,                 /* pen up */
+    GS_TAP,
+    GS_DOUBLE_TAP,
+    GS_LONG_PRESS,
+    GS_DRAG_START,              /* moved beyond GS_SLOP, dx dy since the press */
+    GS_DRAG,                    /* dx dy since the last drag event */
+    GS_DRAG_END,                /* vx vy at the release */
+    GS_FLING                    /* after GS_DRAG_END when fast enough */
+} GsType;
+
+typedef struct
+{
+    GsType type;
+    short x, y;                 /* pen position */
+    short dx, dy;               /* drag move */
+    int vx, vy;                 /* pixels per second */
+    unsigned long long tUs;     /* time of the sample that decided it */
+    unsigned long latencyUs;    /* time from that sample to the event */
+} GsEvent;
+
+typedef struct GsRecognizer GsRecognizer;
+typedef void (*GsHandler)(GsRecognizer *gs, const GsEvent *event);
+
+struct GsRecognizer
+{
+    GsHandler handler;
+    void *user;                 /* free for the application */
+    unsigned char exclusive;    /* 1: no GS_TAP before a GS_DOUBLE_TAP */
+    unsigned char down, dragging, longDone, tapPending;
+    short downX, downY;         /* press */
+    unsigned long long downUs;
+    short lastX, lastY;         /* last pen down sample, or drag event */
+    short tapX, tapY;           /* last tap, for the double tap */
+    unsigned long long tapUs;
+    TouchSample history[GS_HISTORY];
+    unsigned char head, count;
+};
+
+
+/* Function declarations */
+void GS_Init(GsRecognizer *gs, GsHandler handler, unsigned char exclusive);
+void GS_Feed(GsRecognizer *gs, const TouchSample *sample);
+void GS_Tick(GsRecognizer *gs, unsigned long long nowUs);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
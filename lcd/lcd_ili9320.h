@@ -0,0 +1,72 @@
+/*******************************************************************************
+* File Name      : lcd_ili9320.h
+* Description    : Power on sequence and entry modes of the ILI9320, shared
+*                  by LCD_Init and the C++ Display template (lcd_display.hpp)
+*                  X(reg, value, ms) is expanded once per register write,
+*                  ms is the delay after the write. The expansion gives:
+*                  entry   entry mode of the orientation, register 0x03
+*                  xEnd    last GRAM column, register 0x51
+*                  yEnd    last GRAM row, register 0x53
+*******************************************************************************/
+#ifndef __LCD_ILI9320_H
+#define __LCD_ILI9320_H
+
+/* Defines */
+#define ILI9320_INIT_LIST(X, entry, xEnd, yEnd) \
+    X(0x00, 0x0000, 0)                                                      \
+    X(0x01, 0x0100, 0)      /* Driver Output Contral */                     \
+    X(0x02, 0x0700, 0)      /* LCD Driver Waveform Contral */               \
+    X(0x03, entry, 0)       /* Entry Mode */                                \
+    X(0x04, 0x0000, 0)      /* Scalling Contral */                          \
+    X(0x08, 0x0202, 0)      /* Display Contral 2 */                         \
+    X(0x09, 0x0000, 0)      /* Display Contral 3 */                         \
+    X(0x0a, 0x0000, 0)      /* Frame Cycle Contal */                        \
+    X(0x0c, (1<<0), 0)      /* Extern Display Interface Contral 1 */        \
+    X(0x0d, 0x0000, 0)      /* Frame Maker Position */                      \
+    X(0x0f, 0x0000, 50)     /* Extern Display Interface Contral 2 */        \
+    X(0x07, 0x0101, 50)     /* Display Contral */                           \
+    X(0x10, (1<<12)|(0<<8)|(1<<7)|(1<<6)|(0<<4), 0) /* Power Control 1 */   \
+    X(0x11, 0x0007, 0)                              /* Power Control 2 */   \
+    X(0x12, (1<<8)|(1<<4)|(0<<0), 0)                /* Power Control 3 */   \
+    X(0x13, 0x0b00, 0)                              /* Power Control 4 */   \
+    X(0x29, 0x0000, 0)                              /* Power Control 7 */   \
+    X(0x2b, (1<<14)|(1<<4), 0)                                              \
+    X(0x50, 0, 0)           /* Set X Start */                               \
+    X(0x51, xEnd, 0)        /* Set X End */                                 \
+    X(0x52, 0, 0)           /* Set Y Start */                               \
+    X(0x53, yEnd, 50)       /* Set Y End */                                 \
+    X(0x60, 0x2700, 0)      /* Driver Output Control */                     \
+    X(0x61, 0x0001, 0)      /* Driver Output Control */                     \
+    X(0x6a, 0x0000, 0)      /* Vertical Scroll Control */                   \
+    X(0x80, 0x0000, 0)      /* Display Position? Partial Display 1 */       \
+    X(0x81, 0x0000, 0)      /* RAM Address Start? Partial Display 1 */      \
+    X(0x82, 0x0000, 0)      /* RAM Address End-Partial Display 1 */         \
+    X(0x83, 0x0000, 0)      /* Display Position? Partial Display 2 */       \
+    X(0x84, 0x0000, 0)      /* RAM Address Start? Partial Display 2 */      \
+    X(0x85, 0x0000, 0)      /* RAM Address End? Partial Display 2 */        \
+    X(0x90, (0<<7)|(16<<0), 0)  /* Frame Cycle Contral */                   \
+    X(0x92, 0x0000, 0)          /* Panel Interface Contral 2 */             \
+    X(0x93, 0x0001, 0)          /* Panel Interface Contral 3 */             \
+    X(0x95, 0x0110, 0)          /* Frame Cycle Contral */                   \
+    X(0x97, (0<<8), 0)                                                      \
+    X(0x98, 0x0000, 0)          /* Frame Cycle Contral */                   \
+    X(0x07, 0x0133, 100)        /* Display Contral, display on */
+
+/* Entry mode bits of register 0x03 */
+#define ENTRY_AM  (1<<3)   /* 1 = address counter moves vertically first */
+#define ENTRY_ID0 (1<<4)   /* 1 = horizontal increment */
+#define ENTRY_ID1 (1<<5)   /* 1 = vertical increment */
+
+/* Entry mode of each orientation, before LCD_MIRROR: the address counter
+   follows the x axis of the orientation first, then its y axis */
+#define ILI9320_ENTRY_LANDSCAPE      0x1028    /* AM=1, y increment, x decrement */
+#define ILI9320_ENTRY_PORTRAIT_FLIP  0x1000    /* x decrement, y decrement */
+#define ILI9320_ENTRY_LANDSCAPE_FLIP 0x1018    /* AM=1, y decrement, x increment */
+#define ILI9320_ENTRY_PORTRAIT       0x1030    /* x increment, y increment */
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
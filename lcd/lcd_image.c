@@ -0,0 +1,328 @@
+/*******************************************************************************
+* File Name      : lcd_image.c
+* Description    : JPEG and PNG pictures decoded straight to the screen, see
+*                  lcd_image.h
+* Compile/link   : gcc -c lcd_image.c, link with -ljpeg -lpng
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include <png.h>
+#include "lcd.h"
+#include "lcd_image.h"
+
+
+/* Types */
+typedef struct
+{
+    struct jpeg_error_mgr mgr;      /* first: libjpeg sees this one */
+    jmp_buf jump;
+} JpegError;
+
+
+/*******************************************************************************
+* Function Name  : Image_Scale
+* Description    : Scale denominator of a picture
+* Input          : - w, h: size of the picture
+*                  - scale: 1, 2, 4, 8 or IMAGE_FIT
+* Output         : None
+* Return         : 1, 2, 4 or 8, 0 for a scale not supported
+* Attention      : IMAGE_FIT keeps 1/8 for a picture too big even then
+*******************************************************************************/
+static unsigned int Image_Scale(unsigned long w, unsigned long h, unsigned char scale)
+{
+    unsigned int d;
+
+    if (scale != IMAGE_FIT)
+        return scale == 1 || scale == 2 || scale == 4 || scale == 8 ? scale : 0;
+    for (d = 1; d < IMAGE_SCALE_MAX; d *= 2)
+        if ((w + d - 1) / d <= LCD_GetWidth() && (h + d - 1) / d <= LCD_GetHeight())
+            break;
+    return d;
+}
+
+
+/*******************************************************************************
+* Function Name  : Jpeg_Exit
+* Description    : libjpeg fatal error: back to LCD_PutJpeg
+* Input          : - cinfo: decoder
+* Output         : None
+* Return         : None
+* Attention      : Replaces the default, which exits the program
+*******************************************************************************/
+static void Jpeg_Exit(j_common_ptr cinfo)
+{
+    JpegError *err = (JpegError *)cinfo->err;
+
+    (*cinfo->err->output_message)(cinfo);
+    longjmp(err->jump, 1);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_PutJpeg
+* Description    : Show a JPEG picture, scaled down while decoding
+* Input          : - Xpos, Ypos: upper left corner
+*                  - file: path
+*                  - scale: 1, 2, 4, 8 for 1/scale of the size, or
+*                    IMAGE_FIT for the largest that fits the screen
+* Output         : None
+* Return         : 0 success, -1 fail
+* Attention      : The IDCT of libjpeg does the scaling, so 1/8 costs about
+*                  a DC coefficient per block. Lines above the clip are
+*                  skipped, those below are not decoded at all; with
+*                  libjpeg-turbo the columns outside are not decoded either
+*                  Grayscale, YCbCr and RGB pictures, not CMYK
+*******************************************************************************/
+int LCD_PutJpeg(short Xpos, short Ypos, const char *file, unsigned char scale)
+{
+    struct jpeg_decompress_struct cinfo;
+    JpegError err;
+    LCD_ImageSpan span;
+    FILE *volatile f;
+    unsigned char *volatile row = 0;
+    unsigned short *volatile pixels = 0;
+    volatile int locked = 0;
+    JDIMENSION xoff, cw, line;
+    unsigned char *p;
+    unsigned int d, c;
+
+    f = fopen(file, "rb");
+    if (!f)
+        return -1;
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = Jpeg_Exit;
+    if (setjmp(err.jump))
+    {
+        if (locked)
+            LCD_Unlock();
+        jpeg_destroy_decompress(&cinfo);
+        free(row);
+        free(pixels);
+        fclose(f);
+        return -1;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, f);
+    jpeg_read_header(&cinfo, TRUE);
+
+    d = Image_Scale(cinfo.image_width, cinfo.image_height, scale);
+    if (!d)
+        longjmp(err.jump, 1);
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = d;
+    cinfo.out_color_space = JCS_RGB;
+    cinfo.dct_method = JDCT_IFAST;
+    jpeg_calc_output_dimensions(&cinfo);
+
+    LCD_Lock();
+    locked = 1;
+    if (LCD_ImageWindow(Xpos, Ypos, cinfo.output_width, cinfo.output_height, &span))
+    {
+        jpeg_start_decompress(&cinfo);
+        xoff = span.sx;
+        cw = span.w;
+#ifdef LIBJPEG_TURBO_VERSION
+        /* columns from the iMCU before the clip, lines from the clip on;
+           one more column on the right, for the chroma upsampling of the
+           last one shown */
+        if (span.sx + span.w < cinfo.output_width)
+            cw++;
+        jpeg_crop_scanline(&cinfo, &xoff, &cw);
+        jpeg_skip_scanlines(&cinfo, span.sy);
+#else
+        xoff = 0;
+        while (cinfo.output_scanline < span.sy)
+        {
+            if (!row)
+                row = malloc(cinfo.output_width * 3);
+            if (!row)
+                longjmp(err.jump, 1);
+            p = row;
+            jpeg_read_scanlines(&cinfo, &p, 1);
+        }
+#endif
+        if (!row)
+            row = malloc(cinfo.output_width * 3);
+        pixels = malloc(span.w * sizeof(unsigned short));
+        if (!row || !pixels)
+            longjmp(err.jump, 1);
+        for (line = 0; line < span.h; line++)
+        {
+            p = row;
+            jpeg_read_scanlines(&cinfo, &p, 1);
+            p = row + (span.sx - xoff) * 3;
+            for (c = 0; c < span.w; c++, p += 3)
+                pixels[c] = RGB565CONVERT(p[0], p[1], p[2]);
+            LCD_WritePixels(pixels, span.w);
+        }
+    }
+    LCD_Unlock();
+    locked = 0;
+
+    /* the lines below the clip are left in the file */
+    jpeg_destroy_decompress(&cinfo);
+    free(row);
+    free(pixels);
+    fclose(f);
+    return 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_PutPng
+* Description    : Show a PNG picture, scaled down while decoding
+* Input          : - Xpos, Ypos: upper left corner
+*                  - file: path
+*                  - scale: 1, 2, 4, 8 for 1/scale of the size, or
+*                    IMAGE_FIT for the largest that fits the screen
+* Output         : None
+* Return         : 0 success, -1 fail
+* Attention      : Each pixel shown is the average of the scale * scale
+*                  pixels it covers, summed as the lines are read; decoding
+*                  stops after the last visible line. Alpha is dropped.
+*                  Interlaced pictures are refused: their lines are only
+*                  complete once the whole picture is in memory
+*******************************************************************************/
+int LCD_PutPng(short Xpos, short Ypos, const char *file, unsigned char scale)
+{
+    png_structp png;
+    png_infop info;
+    LCD_ImageSpan span;
+    FILE *volatile f;
+    unsigned char *volatile row = 0;
+    unsigned int *volatile sums = 0;
+    unsigned short *volatile pixels = 0;
+    volatile int locked = 0;
+    unsigned char head[8];
+    png_uint_32 w, h, line, last;
+    unsigned int d, c, x, x0, x1, n, rows;
+    unsigned int *s;
+    unsigned char *p;
+
+    f = fopen(file, "rb");
+    if (!f)
+        return -1;
+    if (fread(head, 1, 8, f) != 8 || png_sig_cmp(head, 0, 8))
+    {
+        fclose(f);
+        return -1;
+    }
+    png = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+    info = png ? png_create_info_struct(png) : 0;
+    if (!info || setjmp(png_jmpbuf(png)))
+    {
+        if (locked)
+            LCD_Unlock();
+        png_destroy_read_struct(png ? &png : 0, info ? &info : 0, 0);
+        free(row);
+        free(sums);
+        free(pixels);
+        fclose(f);
+        return -1;
+    }
+    png_init_io(png, f);
+    png_set_sig_bytes(png, 8);
+    png_read_info(png, info);
+    w = png_get_image_width(png, info);
+    h = png_get_image_height(png, info);
+    d = Image_Scale(w, h, scale);
+    if (!d || png_get_interlace_type(png, info) != PNG_INTERLACE_NONE)
+        png_error(png, "scale or interlace not supported");
+
+    /* any format to 8-bit RGB */
+    png_set_expand(png);
+    png_set_strip_16(png);
+    png_set_strip_alpha(png);
+    png_set_gray_to_rgb(png);
+    png_read_update_info(png, info);
+
+    LCD_Lock();
+    locked = 1;
+    if (LCD_ImageWindow(Xpos, Ypos, (w + d - 1) / d, (h + d - 1) / d, &span))
+    {
+        row = malloc(png_get_rowbytes(png, info));
+        sums = malloc(span.w * 3 * sizeof(unsigned int));
+        pixels = malloc(span.w * sizeof(unsigned short));
+        if (!row || !sums || !pixels)
+            png_error(png, "out of memory");
+        for (line = 0; line < (png_uint_32)span.sy * d; line++)
+            png_read_row(png, row, 0);
+        for (; line < (png_uint_32)(span.sy + span.h) * d && line < h; line += rows)
+        {
+            memset(sums, 0, span.w * 3 * sizeof(unsigned int));
+            last = line + d < h ? line + d : h;
+            for (rows = 0; line + rows < last; rows++)
+            {
+                png_read_row(png, row, 0);
+                for (c = 0, s = sums; c < span.w; c++, s += 3)
+                {
+                    x0 = (span.sx + c) * d;
+                    x1 = x0 + d < w ? x0 + d : w;
+                    for (x = x0, p = row + x0 * 3; x < x1; x++, p += 3)
+                    {
+                        s[0] += p[0];
+                        s[1] += p[1];
+                        s[2] += p[2];
+                    }
+                }
+            }
+            for (c = 0, s = sums; c < span.w; c++, s += 3)
+            {
+                x0 = (span.sx + c) * d;
+                n = ((x0 + d < w ? x0 + d : w) - x0) * rows;
+                pixels[c] = RGB565CONVERT(s[0] / n, s[1] / n, s[2] / n);
+            }
+            LCD_WritePixels(pixels, span.w);
+        }
+    }
+    LCD_Unlock();
+    locked = 0;
+
+    /* the lines below the clip are left in the file */
+    png_destroy_read_struct(&png, &info, 0);
+    free(row);
+    free(sums);
+    free(pixels);
+    fclose(f);
+    return 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_PutPicture
+* Description    : Show a JPEG, PNG or BMP picture, by its first bytes
+* Input          : - Xpos, Ypos: upper left corner
+*                  - file: path
+*                  - scale: 1, 2, 4, 8 or IMAGE_FIT, see LCD_PutJpeg
+* Output         : None
+* Return         : 0 success, -1 fail
+* Attention      : BMP goes to LCD_PutImage, at scale 1 only
+*******************************************************************************/
+int LCD_PutPicture(short Xpos, short Ypos, const char *file, unsigned char scale)
+{
+    unsigned char head[4];
+    FILE *f;
+    size_t n;
+
+    f = fopen(file, "rb");
+    if (!f)
+        return -1;
+    n = fread(head, 1, sizeof(head), f);
+    fclose(f);
+    if (n >= 3 && head[0] == 0xFF && head[1] == 0xD8 && head[2] == 0xFF)
+        return LCD_PutJpeg(Xpos, Ypos, file, scale);
+    if (n >= 4 && head[0] == 0x89 && head[1] == 'P' && head[2] == 'N' && head[3] == 'G')
+        return LCD_PutPng(Xpos, Ypos, file, scale);
+    if (n >= 2 && head[0] == 'B' && head[1] == 'M' && (scale == 1 || scale == IMAGE_FIT))
+        return LCD_PutImage(Xpos, Ypos, (char *)file);
+    return -1;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
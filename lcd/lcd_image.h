@@ -0,0 +1,30 @@
+/*******************************************************************************
+* File Name      : lcd_image.h
+* Description    : JPEG and PNG pictures decoded straight to the screen
+*                  The picture is scaled down while decoding: libjpeg scales
+*                  in its IDCT, PNG lines are averaged as they are read. Only
+*                  the visible lines are converted and sent, one line at a
+*                  time, never the whole picture in memory
+*                  Needs libjpeg (libjpeg-turbo skips the hidden lines and
+*                  columns without decoding them) and libpng
+*******************************************************************************/
+#ifndef __LCD_IMAGE_H
+#define __LCD_IMAGE_H
+
+
+/* Defines */
+#define IMAGE_FIT 0                 /* scale: largest of 1, 1/2, 1/4, 1/8 that fits */
+#define IMAGE_SCALE_MAX 8           /* smallest scale 1/8 */
+
+
+/* Function declarations */
+int LCD_PutJpeg(short Xpos, short Ypos, const char *file, unsigned char scale);
+int LCD_PutPng(short Xpos, short Ypos, const char *file, unsigned char scale);
+int LCD_PutPicture(short Xpos, short Ypos, const char *file, unsigned char scale);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
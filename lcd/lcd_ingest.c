@@ -0,0 +1,304 @@
+/*******************************************************************************
+* File Name      : lcd_ingest.c
+* Description    : Sender side of the frame ingest daemon ingestd
+*                  The sender keeps a copy of what it sent, the previous
+*                  frame of ingestd, to XOR the next rectangles with
+*                  The decoder is here too, for ingestd and the checks
+*                  Needs neither root nor the bcm2835 library
+* Compile/link   : gcc -o renderer renderer.c lcd_ingest.c
+*******************************************************************************/
+/* Includes */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "lcd_ingest.h"
+
+
+/*******************************************************************************
+* Function Name  : Ingest_Write
+* Description    : Write all the bytes to the socket
+* Input          : - sock: socket
+*                  - buf, len: bytes
+* Output         : None
+* Return         : 1 success, 0 connection lost
+* Attention      : None
+*******************************************************************************/
+static int Ingest_Write(int sock, const void *buf, unsigned int len)
+{
+    const char *p = buf;
+    ssize_t n;
+
+    while (len)
+    {
+        n = send(sock, p, len, MSG_NOSIGNAL);
+        if (n <= 0)
+            return 0;
+        p += n;
+        len -= n;
+    }
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : Ingest_Read
+* Description    : Read a header from the socket
+* Input          : - sock: socket
+* Output         : - head: header
+* Return         : 1 success, 0 connection lost
+* Attention      : None
+*******************************************************************************/
+static int Ingest_Read(int sock, IngestHeader *head)
+{
+    return recv(sock, head, sizeof(*head), MSG_WAITALL) == sizeof(*head);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_IngestRle
+* Description    : Run length encoding of 16-bit values, see lcd_ingest.h
+* Input          : - values: values
+*                  - n: number of values
+*                  - out: INGEST_RLE_WORDS(n) words, or 0 to only measure
+* Output         : - out: runs
+* Return         : words of the runs
+* Attention      : Three equal values or more make a repeated run
+*******************************************************************************/
+unsigned int LCD_IngestRle(const unsigned short *values, unsigned int n, unsigned short *out)
+{
+    unsigned int i = 0, j, run, words = 0;
+
+    while (i < n)
+    {
+        for (run = 1; i + run < n && run < INGEST_RUN_MAX && values[i + run] == values[i]; run++)
+            ;
+        if (run >= 3)
+        {
+            if (out)
+            {
+                out[words] = 0x8000 | (run - 1);
+                out[words + 1] = values[i];
+            }
+            words += 2;
+            i += run;
+            continue;
+        }
+        /* literal up to the next three equal values */
+        for (j = i + 1; j < n && j - i < INGEST_RUN_MAX; j++)
+            if (j + 2 < n && values[j] == values[j + 1] && values[j] == values[j + 2])
+                break;
+        if (out)
+        {
+            out[words] = j - i - 1;
+            memcpy(out + words + 1, values + i, (j - i) * sizeof(*values));
+        }
+        words += 1 + j - i;
+        i = j;
+    }
+    return words;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_IngestConnect
+* Description    : Connect to ingestd
+* Input          : - path: socket of ingestd, 0 for INGEST_SOCKET
+* Output         : - sender: connection, with the screen size of ingestd
+* Return         : 1 success, 0 fail
+* Attention      : ingestd clears the screen for each sender: the previous
+*                  frame starts black on both sides
+*******************************************************************************/
+int LCD_IngestConnect(IngestSender *sender, const char *path)
+{
+    struct sockaddr_un addr;
+    IngestHeader hello;
+    unsigned int n;
+
+    memset(sender, 0, sizeof(*sender));
+    sender->sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sender->sock < 0)
+        return 0;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path ? path : INGEST_SOCKET, sizeof(addr.sun_path) - 1);
+    if (connect(sender->sock, (struct sockaddr *)&addr, sizeof(addr)) < 0
+        || !Ingest_Read(sender->sock, &hello) || hello.encoding != INGEST_SYNC)
+    {
+        close(sender->sock);
+        return 0;
+    }
+    sender->width = hello.w;
+    sender->height = hello.h;
+    n = hello.w * hello.h;
+    sender->prev = calloc(n, sizeof(unsigned short));
+    sender->raw = malloc(n * sizeof(unsigned short));
+    sender->delta = malloc(n * sizeof(unsigned short));
+    sender->runs = malloc(INGEST_RLE_WORDS(n) * sizeof(unsigned short));
+    if (!sender->prev || !sender->raw || !sender->delta || !sender->runs)
+    {
+        LCD_IngestClose(sender);
+        return 0;
+    }
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_IngestClose
+* Description    : Leave ingestd
+* Input          : - sender: connection
+* Output         : None
+* Return         : None
+* Attention      : The screen keeps the last frame
+*******************************************************************************/
+void LCD_IngestClose(IngestSender *sender)
+{
+    close(sender->sock);
+    free(sender->prev);
+    free(sender->raw);
+    free(sender->delta);
+    free(sender->runs);
+    memset(sender, 0, sizeof(*sender));
+    sender->sock = -1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_IngestSend
+* Description    : Send a dirty rectangle of the frame
+* Input          : - sender: connection
+*                  - encoding: INGEST_RAW, INGEST_RLE, INGEST_XOR, or
+*                    INGEST_AUTO for the smallest
+*                  - Xpos, Ypos: upper left corner on the screen
+*                  - w, h: size
+*                  - pixels: RGB565 colors of the rectangle
+*                  - stride: pixels from one line of pixels to the next
+* Output         : None
+* Return         : 1 success, 0 rectangle not on the screen or connection
+*                  lost
+* Attention      : Does not wait for the panel, see LCD_IngestSync
+*******************************************************************************/
+int LCD_IngestSend(IngestSender *sender, unsigned short encoding, unsigned short Xpos, unsigned short Ypos,
+                   unsigned short w, unsigned short h, const unsigned short *pixels, unsigned int stride)
+{
+    IngestHeader head;
+    unsigned int n = w * h, x, y, rleWords, xorWords;
+    unsigned short *raw = sender->raw, *delta = sender->delta, *prev;
+    const void *payload;
+
+    if (!w || !h || Xpos + w > sender->width || Ypos + h > sender->height || (encoding > INGEST_XOR && encoding != INGEST_AUTO))
+        return 0;
+    for (y = 0; y < h; y++)
+    {
+        prev = sender->prev + (Ypos + y) * sender->width + Xpos;
+        for (x = 0; x < w; x++)
+        {
+            *raw = pixels[y * stride + x];
+            *delta++ = *raw ^ prev[x];
+            prev[x] = *raw++;
+        }
+    }
+
+    if (encoding == INGEST_AUTO)
+    {
+        rleWords = LCD_IngestRle(sender->raw, n, 0);
+        xorWords = LCD_IngestRle(sender->delta, n, 0);
+        encoding = n <= rleWords && n <= xorWords ? INGEST_RAW : rleWords <= xorWords ? INGEST_RLE : INGEST_XOR;
+    }
+    head.encoding = encoding;
+    head.x = Xpos;
+    head.y = Ypos;
+    head.w = w;
+    head.h = h;
+    head.reserved = 0;
+    if (encoding == INGEST_RAW)
+    {
+        payload = sender->raw;
+        head.length = n * sizeof(unsigned short);
+    }
+    else
+    {
+        payload = sender->runs;
+        head.length = LCD_IngestRle(encoding == INGEST_RLE ? sender->raw : sender->delta, n, sender->runs)
+                      * sizeof(unsigned short);
+    }
+    sender->bytesIn += n * sizeof(unsigned short);
+    sender->bytesOut += head.length;
+    return Ingest_Write(sender->sock, &head, sizeof(head))
+           && Ingest_Write(sender->sock, payload, head.length);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_IngestSync
+* Description    : Wait until the rectangles sent are on the panel
+* Input          : - sender: connection
+* Output         : None
+* Return         : 1 success, 0 connection lost
+* Attention      : Once per frame paces the renderer on the panel
+*******************************************************************************/
+int LCD_IngestSync(IngestSender *sender)
+{
+    IngestHeader head;
+
+    memset(&head, 0, sizeof(head));
+    head.encoding = INGEST_SYNC;
+    return Ingest_Write(sender->sock, &head, sizeof(head))
+           && Ingest_Read(sender->sock, &head) && head.encoding == INGEST_SYNC;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_IngestDecode
+* Description    : Decode the payload of a rectangle, run by run
+* Input          : - head: rectangle, INGEST_RAW, INGEST_RLE or INGEST_XOR
+*                  - data: payload, head->length bytes
+*                  - run, target: output, called with each run in order
+* Output         : None
+* Return         : 1 success, 0 malformed payload
+* Attention      : A payload of the wrong size, a run cut short, a run past
+*                  w * h pixels or words after them are malformed; the runs
+*                  before the bad one are passed already. INGEST_RAW is one
+*                  run of w * h values
+*******************************************************************************/
+int LCD_IngestDecode(const IngestHeader *head, const unsigned short *data, IngestRun run, void *target)
+{
+    unsigned int n = head->w * head->h, words = head->length / 2, i = 0, done = 0, count;
+
+    if (head->encoding == INGEST_RAW)
+    {
+        if (words != n || head->length & 1)
+            return 0;
+        if (n)
+            run(target, data, n, 0);
+        return 1;
+    }
+    while (i < words && done < n)
+    {
+        if (data[i] & 0x8000)
+        {
+            count = (data[i] & 0x7FFF) + 1;
+            if (i + 2 > words || done + count > n)
+                return 0;
+            run(target, data + i + 1, count, 1);
+            i += 2;
+        }
+        else
+        {
+            count = data[i] + 1;
+            if (i + 1 + count > words || done + count > n)
+                return 0;
+            run(target, data + i + 1, count, 0);
+            i += 1 + count;
+        }
+        done += count;
+    }
+    return done == n && i == words && !(head->length & 1);
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,75 @@
+/*******************************************************************************
+* File Name      : lcd_ingest.h
+* Description    : Sender side of the frame ingest daemon ingestd, and the
+*                  decoder of its rectangles
+*                  A renderer process streams dirty rectangles of RGB565
+*                  frames over a Unix stream socket; ingestd decodes each one
+*                  straight into the window burst of its rectangle
+*                  Each rectangle is an IngestHeader followed by length bytes:
+*                  INGEST_RAW  w * h pixels
+*                  INGEST_RLE  runs of the pixels
+*                  INGEST_XOR  runs of the pixels XOR the previous frame, the
+*                              last pixels sent at the same place
+*                  A run is a 16-bit word n then: if bit 15 is set, one pixel
+*                  repeated (n & 0x7FFF) + 1 times, else n + 1 pixels
+*                  Pixels and headers in the byte order of the host: sender
+*                  and ingestd run on the same machine
+*******************************************************************************/
+#ifndef __LCD_INGEST_H
+#define __LCD_INGEST_H
+
+
+/* Defines */
+#define INGEST_SOCKET "/tmp/lcd-ingest.sock"   /* default socket of ingestd */
+
+/* IngestHeader encodings */
+#define INGEST_RAW 0
+#define INGEST_RLE 1
+#define INGEST_XOR 2
+#define INGEST_SYNC 3           /* no payload: ingestd echoes the header once
+                                   the rectangles before are on the panel */
+#define INGEST_AUTO 0xFFFF      /* LCD_IngestSend: smallest of the three */
+
+#define INGEST_RUN_MAX 0x8000   /* pixels of one run */
+#define INGEST_RLE_WORDS(n) ((n) + (n) / INGEST_RUN_MAX + 2)  /* longest RLE of n pixels */
+
+
+/* Types */
+typedef struct
+{
+    unsigned short encoding;    /* INGEST_x */
+    unsigned short x, y, w, h;  /* rectangle on the screen; screen size in the greeting */
+    unsigned short reserved;
+    unsigned int length;        /* payload bytes */
+} IngestHeader;
+
+typedef struct
+{
+    int sock;
+    unsigned short width, height;   /* screen of ingestd */
+    unsigned short *prev;           /* width * height, last pixels sent */
+    unsigned short *raw, *delta;    /* pixels of the rectangle, and XOR prev */
+    unsigned short *runs;           /* INGEST_RLE_WORDS(width * height) */
+    unsigned long bytesIn, bytesOut;    /* pixels given, payload sent */
+} IngestSender;
+
+/* Output of LCD_IngestDecode: count values, or values[0] count times if
+   repeat, the next pixels of the rectangle or their XOR */
+typedef void (*IngestRun)(void *target, const unsigned short *values, unsigned int count, int repeat);
+
+
+/* Function declarations */
+unsigned int LCD_IngestRle(const unsigned short *values, unsigned int n, unsigned short *out);
+int LCD_IngestConnect(IngestSender *sender, const char *path);
+void LCD_IngestClose(IngestSender *sender);
+int LCD_IngestSend(IngestSender *sender, unsigned short encoding, unsigned short Xpos, unsigned short Ypos,
+                   unsigned short w, unsigned short h, const unsigned short *pixels, unsigned int stride);
+int LCD_IngestSync(IngestSender *sender);
+int LCD_IngestDecode(const IngestHeader *head, const unsigned short *data, IngestRun run, void *target);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,365 @@
+/*******************************************************************************
+* File Name      : lcd_latency.c
+* Description    : Touch-to-photon latency of the touch panel path
+*                  One record at a time is followed from the pen seen down
+*                  to the end of its drawing; a record not drawn is dropped
+*                  when the next one starts
+* Compile/link   : gcc -DLCD_LATENCY -o latency -lrt latency.c lcd.c lcd_trace.c lcd_stats.c lcd_latency.c lcd_emu.c lcd_spi0.c lcd_bcm2835.c -lbcm2835 -lm -lpthread
+*******************************************************************************/
+/* Includes */
+#include <string.h>
+#include <time.h>
+#include "lcd_latency.h"
+
+
+/* Types */
+typedef enum
+{
+    REC_IDLE,
+    REC_SAMPLING,               /* pen seen down, conversions running */
+    REC_POINT,                  /* raw point ready */
+    REC_CALIBRATED,
+    REC_DRAWING
+} RecState;
+
+
+/* Public declarations */
+static const char *LatNames[LAT_STAGE_COUNT] = {
+#define LAT_NAME(id, name) name,
+    LAT_STAGE_LIST(LAT_NAME)
+#undef LAT_NAME
+};
+
+#ifdef LCD_LATENCY
+static LatHistogram Histograms[LAT_STAGE_COUNT];
+static unsigned long Dropped;
+static LatClock ClockNs;
+static LatClock TouchNs;
+static RecState State;
+static unsigned long long TTouch, TIrq, TLast, TPoint, TCal, TDraw;
+static unsigned long long LastIrq;
+
+
+/*******************************************************************************
+* Function Name  : Lat_Now
+* Description    : Current time of the latency clock
+* Input          : None
+* Output         : None
+* Return         : nanoseconds
+* Attention      : CLOCK_MONOTONIC unless LCD_LatencyClock gave another one
+*******************************************************************************/
+static unsigned long long Lat_Now(void)
+{
+    struct timespec now;
+
+    if (ClockNs)
+        return ClockNs();
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/*******************************************************************************
+* Function Name  : Lat_Bucket
+* Description    : Histogram bucket of a duration
+* Input          : - ns: duration
+* Output         : None
+* Return         : bucket index
+* Attention      : Durations beyond the last bucket are counted in it
+*******************************************************************************/
+static int Lat_Bucket(unsigned long long ns)
+{
+    int e = 0;
+
+    if (ns < LAT_LINEAR)
+        return (int)ns;
+    while (ns >> (e + 1))
+        e++;
+    if (e >= 40)
+        return LAT_BUCKETS - 1;
+    return LAT_LINEAR + (e - 4) * LAT_SUB + (int)((ns >> (e - 3)) & (LAT_SUB - 1));
+}
+
+
+/*******************************************************************************
+* Function Name  : Lat_Add
+* Description    : Count a duration in a histogram
+* Input          : - stage: histogram
+*                  - from, to: start and end of the duration
+* Output         : None
+* Return         : None
+* Attention      : A clock going back counts as 0
+*******************************************************************************/
+static void Lat_Add(LatStage stage, unsigned long long from, unsigned long long to)
+{
+    LatHistogram *h = &Histograms[stage];
+    unsigned long long ns = to > from ? to - from : 0;
+
+    h->count++;
+    h->sumNs += ns;
+    if (ns > h->maxNs)
+        h->maxNs = ns;
+    h->buckets[Lat_Bucket(ns)]++;
+}
+
+
+/*******************************************************************************
+* Function Name  : Lat_Mark
+* Description    : Step of the touch panel path reached
+* Input          : - mark: LAT_x
+* Output         : None
+* Return         : None
+* Attention      : Marks out of order are ignored, so drawing that does not
+*                  answer a sample, or a calibration, is never counted
+*******************************************************************************/
+void Lat_Mark(LatMark mark)
+{
+    unsigned long long now = Lat_Now(), touch;
+
+    switch (mark)
+    {
+    case LAT_IRQ:
+        if (State != REC_IDLE)
+            Dropped++;
+        /* a touch already seen by the previous record is nothing new:
+           this record starts at the poll */
+        touch = TouchNs ? TouchNs() : now;
+        if (touch > now || touch <= LastIrq)
+            touch = now;
+        TTouch = touch;
+        TIrq = TLast = LastIrq = now;
+        State = REC_SAMPLING;
+        break;
+    case LAT_SAMPLE:
+        if (State != REC_SAMPLING)
+            break;
+        Lat_Add(LAT_STAGE_CONVERSION, TLast, now);
+        TLast = now;
+        break;
+    case LAT_POINT:
+        if (State != REC_SAMPLING)
+            break;
+        TPoint = now;
+        State = REC_POINT;
+        break;
+    case LAT_CAL:
+        if (State != REC_POINT)
+            break;
+        TCal = now;
+        State = REC_CALIBRATED;
+        break;
+    case LAT_DRAW:
+        if (State != REC_CALIBRATED)
+            break;
+        TDraw = now;
+        State = REC_DRAWING;
+        break;
+    case LAT_SPI:
+        if (State != REC_DRAWING)
+            break;
+        Lat_Add(LAT_STAGE_IRQ, TTouch, TIrq);
+        Lat_Add(LAT_STAGE_SAMPLE, TIrq, TPoint);
+        Lat_Add(LAT_STAGE_CAL, TPoint, TCal);
+        Lat_Add(LAT_STAGE_DISPATCH, TCal, TDraw);
+        Lat_Add(LAT_STAGE_SPI, TDraw, now);
+        Lat_Add(LAT_STAGE_TOTAL, TTouch, now);
+        State = REC_IDLE;
+        break;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LatencyClock
+* Description    : Clocks of the records
+* Input          : - clockNs: current time in ns, 0 for CLOCK_MONOTONIC
+*                  - touchNs: time in ns of the last pen down or move, 0 when
+*                    unknown: a record then starts when the pen is seen down
+* Output         : None
+* Return         : None
+* Attention      : LCD_EmuClockNs and LCD_EmuTouchNs give records that do
+*                  not depend on the host
+*******************************************************************************/
+void LCD_LatencyClock(LatClock clockNs, LatClock touchNs)
+{
+    ClockNs = clockNs;
+    TouchNs = touchNs;
+    LastIrq = 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LatencyReset
+* Description    : Empty the histograms and drop the current record
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : Call it after TP_Cal, whose samples are never drawn
+*******************************************************************************/
+void LCD_LatencyReset(void)
+{
+    memset(Histograms, 0, sizeof(Histograms));
+    Dropped = 0;
+    State = REC_IDLE;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LatencyGet
+* Description    : Copy the histogram of one stage
+* Input          : - stage: LAT_STAGE_x
+* Output         : - histogram: copy of the histogram
+* Return         : 1 success, 0 if latency is not compiled in
+* Attention      : None
+*******************************************************************************/
+int LCD_LatencyGet(LatStage stage, LatHistogram *histogram)
+{
+    if (stage >= LAT_STAGE_COUNT)
+        return 0;
+    *histogram = Histograms[stage];
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LatencyDropped
+* Description    : Records started and never drawn
+* Input          : None
+* Output         : None
+* Return         : number of records
+* Attention      : Samples lost to noise or a lifted pen are dropped
+*******************************************************************************/
+unsigned long LCD_LatencyDropped(void)
+{
+    return Dropped;
+}
+
+#else
+
+void Lat_Mark(LatMark mark) { (void)mark; }
+void LCD_LatencyClock(LatClock clockNs, LatClock touchNs) { (void)clockNs; (void)touchNs; }
+void LCD_LatencyReset(void) { }
+unsigned long LCD_LatencyDropped(void) { return 0; }
+
+int LCD_LatencyGet(LatStage stage, LatHistogram *histogram)
+{
+    (void)stage;
+    memset(histogram, 0, sizeof(*histogram));
+    return 0;
+}
+
+#endif
+
+
+/*******************************************************************************
+* Function Name  : LCD_LatencyPercentile
+* Description    : Duration a given share of a histogram is below
+* Input          : - histogram: histogram
+*                  - percent: share, 50 for the median
+* Output         : None
+* Return         : nanoseconds, upper bound of the bucket, 0 if empty
+* Attention      : Exact below LAT_LINEAR ns, 12.5% above
+*******************************************************************************/
+unsigned long long LCD_LatencyPercentile(const LatHistogram *histogram, double percent)
+{
+    unsigned long long rank, seen = 0, top;
+    int i, e;
+
+    if (!histogram->count)
+        return 0;
+    rank = (unsigned long long)(histogram->count * percent / 100.0 + 0.999999);
+    if (rank < 1)
+        rank = 1;
+    for (i = 0; i < LAT_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= rank)
+            break;
+    }
+    if (i < LAT_LINEAR)
+        return i;
+    e = (i - LAT_LINEAR) / LAT_SUB + 4;
+    top = ((unsigned long long)(LAT_SUB + (i - LAT_LINEAR) % LAT_SUB + 1) << (e - 3)) - 1;
+    return top < histogram->maxNs ? top : histogram->maxNs;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LatencyDumpText
+* Description    : Print count, mean, p50, p99 and max of each stage
+* Input          : - out: destination stream
+* Output         : None
+* Return         : None
+* Attention      : Times in microseconds
+*******************************************************************************/
+void LCD_LatencyDumpText(FILE *out)
+{
+    LatHistogram h;
+    int i;
+
+    if (!LCD_LatencyGet(LAT_STAGE_TOTAL, &h))
+    {
+        fprintf(out, "latency disabled, rebuild with -DLCD_LATENCY\n");
+        return;
+    }
+    fprintf(out, "%-12s %8s %10s %10s %10s %10s\n",
+            "stage", "count", "mean us", "p50 us", "p99 us", "max us");
+    for (i = 0; i < LAT_STAGE_COUNT; i++)
+    {
+        LCD_LatencyGet((LatStage)i, &h);
+        fprintf(out, "%-12s %8lu %10.1f %10.1f %10.1f %10.1f\n", LatNames[i], h.count,
+                h.count ? h.sumNs / 1000.0 / h.count : 0.0,
+                LCD_LatencyPercentile(&h, 50) / 1000.0,
+                LCD_LatencyPercentile(&h, 99) / 1000.0, h.maxNs / 1000.0);
+    }
+    fprintf(out, "dropped %lu\n", LCD_LatencyDropped());
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LatencyDumpJSON
+* Description    : Print the summary and the non empty buckets of each stage
+* Input          : - out: destination stream
+* Output         : None
+* Return         : None
+* Attention      : Buckets are [lower bound ns, count] pairs
+*******************************************************************************/
+void LCD_LatencyDumpJSON(FILE *out)
+{
+    LatHistogram h;
+    unsigned long long low;
+    int i, b, e, first;
+
+    fprintf(out, "{\"enabled\": %s, \"dropped\": %lu, \"stages\": [",
+            LCD_LatencyGet(LAT_STAGE_TOTAL, &h) ? "true" : "false", LCD_LatencyDropped());
+    for (i = 0; i < LAT_STAGE_COUNT; i++)
+    {
+        LCD_LatencyGet((LatStage)i, &h);
+        fprintf(out, "%s\n  {\"name\": \"%s\", \"count\": %lu, \"sum_ns\": %llu, "
+                "\"p50_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu, \"buckets\": [",
+                i ? "," : "", LatNames[i], h.count, h.sumNs,
+                LCD_LatencyPercentile(&h, 50), LCD_LatencyPercentile(&h, 99), h.maxNs);
+        first = 1;
+        for (b = 0; b < LAT_BUCKETS; b++)
+        {
+            if (!h.buckets[b])
+                continue;
+            if (b < LAT_LINEAR)
+                low = b;
+            else
+            {
+                e = (b - LAT_LINEAR) / LAT_SUB + 4;
+                low = (unsigned long long)(LAT_SUB + (b - LAT_LINEAR) % LAT_SUB) << (e - 3);
+            }
+            fprintf(out, "%s[%llu, %lu]", first ? "" : ", ", low, h.buckets[b]);
+            first = 0;
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "\n]}\n");
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
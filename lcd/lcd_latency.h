@@ -0,0 +1,95 @@
+/*******************************************************************************
+* File Name      : lcd_latency.h
+* Description    : Touch-to-photon latency of the touch panel path
+*                  Compiled in with -DLCD_LATENCY, without it every hook is
+*                  empty and the report functions print that it is disabled
+*                  A record follows one touch sample through the driver:
+*                  touch        pen put down or moved (clock source, or poll)
+*                  LAT_IRQ      pen seen down by Read_Ads7846
+*                  LAT_SAMPLE   each ADS7843 conversion
+*                  LAT_POINT    filtered raw point ready
+*                  LAT_CAL      calibrated by getDisplayPoint
+*                  LAT_DRAW     draw command (TP_DrawPoint entry)
+*                  LAT_SPI      last SPI transfer of its pixels done
+*                  Transfers are blocking, LAT_SPI is marked on the return
+*                  of the drawing. An application drawing its own answer
+*                  marks it with LAT_MARK(LAT_DRAW) and LAT_MARK(LAT_SPI)
+*                  Records follow one touch panel: sample a single device
+*******************************************************************************/
+#ifndef __LCD_LATENCY_H
+#define __LCD_LATENCY_H
+
+/* Includes */
+#include <stdio.h>
+
+
+/* Defines */
+#define LAT_LINEAR 16           /* buckets of 1 ns below this */
+#define LAT_SUB 8               /* buckets per power of two above, 12.5% wide */
+#define LAT_BUCKETS (LAT_LINEAR + (40 - 4) * LAT_SUB)   /* up to 2^40 ns */
+
+/* Histograms: id, printable name */
+#define LAT_STAGE_LIST(X) \
+    X(LAT_STAGE_IRQ,        "irq")          /* touch to pen seen down */ \
+    X(LAT_STAGE_CONVERSION, "conversion")   /* one conversion, each */  \
+    X(LAT_STAGE_SAMPLE,     "sample")       /* pen seen to point ready */ \
+    X(LAT_STAGE_CAL,        "calibrate")    /* point to display point */ \
+    X(LAT_STAGE_DISPATCH,   "dispatch")     /* display point to draw */ \
+    X(LAT_STAGE_SPI,        "spi")          /* draw to last transfer */ \
+    X(LAT_STAGE_TOTAL,      "total")        /* touch to last transfer */
+
+#ifdef LCD_LATENCY
+#define LAT_MARK(mark)          Lat_Mark(mark)
+#else
+#define LAT_MARK(mark)          do { } while (0)
+#endif
+
+
+/* Types */
+typedef enum
+{
+    LAT_IRQ,
+    LAT_SAMPLE,
+    LAT_POINT,
+    LAT_CAL,
+    LAT_DRAW,
+    LAT_SPI
+} LatMark;
+
+typedef enum
+{
+#define LAT_ENUM(id, name) id,
+    LAT_STAGE_LIST(LAT_ENUM)
+#undef LAT_ENUM
+    LAT_STAGE_COUNT
+} LatStage;
+
+/* Log-linear histogram of nanoseconds */
+typedef struct
+{
+    unsigned long count;
+    unsigned long long sumNs;
+    unsigned long long maxNs;
+    unsigned long buckets[LAT_BUCKETS];
+} LatHistogram;
+
+typedef unsigned long long (*LatClock)(void);
+
+
+/* Function declarations */
+void Lat_Mark(LatMark mark);
+
+void LCD_LatencyClock(LatClock clockNs, LatClock touchNs);
+void LCD_LatencyReset(void);
+int LCD_LatencyGet(LatStage stage, LatHistogram *histogram);
+unsigned long long LCD_LatencyPercentile(const LatHistogram *histogram, double percent);
+unsigned long LCD_LatencyDropped(void);
+void LCD_LatencyDumpText(FILE *out);
+void LCD_LatencyDumpJSON(FILE *out);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
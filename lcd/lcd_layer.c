@@ -0,0 +1,534 @@
+/*******************************************************************************
+* File Name      : lcd_layer.c
+* Description    : Compositor of RGB565 layers
+*                  Each damaged rectangle is composited bottom to top into a
+*                  scanline buffer and streamed through one window.
+*                  Blending kernels use NEON on ARM when the compiler targets
+*                  it (-mfpu=neon), SSE2 on x86, plain C otherwise; build
+*                  with -DLAYER_SCALAR to force plain C
+*                  Blend: d + ((s - d) * a >> 8) per channel, a = 0..256
+*                  from the 8-bit alpha v as v + (v >> 7): 0 and 255 are
+*                  exact, 256 levels in between
+*******************************************************************************/
+/* Includes */
+#include <string.h>
+#include "lcd.h"
+#include "lcd_stats.h"
+#include "lcd_layer.h"
+
+#if !defined(LAYER_SCALAR) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define LAYER_NEON
+#include <arm_neon.h>
+#elif !defined(LAYER_SCALAR) && defined(__SSE2__)
+#define LAYER_SSE2
+#include <emmintrin.h>
+#endif
+
+
+/* Defines */
+#define LINE_MAX MAX_Y          /* longest line, landscape width */
+
+
+/* Types */
+typedef struct
+{
+    int x0, y0, x1, y1;         /* x1, y1 excluded */
+} LayerRect;
+
+
+/* Public declarations */
+static Layer *Layers[LAYER_MAX];
+static int LayerCount;
+static LayerRect Damage[LAYER_DAMAGE_MAX];
+static int DamageCount;
+static unsigned short Line[LINE_MAX];
+static unsigned short AlphaLine[LINE_MAX];
+
+
+/*******************************************************************************
+* Function Name  : Kernel_Key
+* Description    : Copy the pixels of a line that are not the key color
+* Input          : - src: layer pixels
+*                  - n: number of pixels
+*                  - key: transparent color
+* Output         : - dst: scanline
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Kernel_Key(unsigned short *dst, const unsigned short *src, unsigned int n, unsigned short key)
+{
+    unsigned int i = 0;
+
+#if defined(LAYER_NEON)
+    uint16x8_t k = vdupq_n_u16(key), s, d;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        s = vld1q_u16(src + i);
+        d = vld1q_u16(dst + i);
+        vst1q_u16(dst + i, vbslq_u16(vceqq_u16(s, k), d, s));
+    }
+#elif defined(LAYER_SSE2)
+    __m128i k = _mm_set1_epi16((short)key), s, d, eq;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        s = _mm_loadu_si128((const __m128i *)(src + i));
+        d = _mm_loadu_si128((const __m128i *)(dst + i));
+        eq = _mm_cmpeq_epi16(s, k);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(_mm_and_si128(eq, d), _mm_andnot_si128(eq, s)));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        if (src[i] != key)
+            dst[i] = src[i];
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Kernel_Blend
+* Description    : Blend a line of layer pixels over the scanline
+* Input          : - src: layer pixels
+*                  - a: alpha of each pixel, 0 to 256
+*                  - n: number of pixels
+* Output         : - dst: scanline
+* Return         : None
+* Attention      : Every kernel gives the same result as the C loop
+*******************************************************************************/
+static void Kernel_Blend(unsigned short *dst, const unsigned short *src, const unsigned short *a, unsigned int n)
+{
+    unsigned int i = 0;
+    int s, d, k, r, g, b;
+
+#if defined(LAYER_NEON)
+    uint16x8_t s8, d8, m5 = vdupq_n_u16(0x1F), m6 = vdupq_n_u16(0x3F);
+    int16x8_t k8, sr, dr, sg, dg, sb, db, r8, g8, b8;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        s8 = vld1q_u16(src + i);
+        d8 = vld1q_u16(dst + i);
+        k8 = vreinterpretq_s16_u16(vld1q_u16(a + i));
+        sr = vreinterpretq_s16_u16(vshrq_n_u16(s8, 11));
+        dr = vreinterpretq_s16_u16(vshrq_n_u16(d8, 11));
+        sg = vreinterpretq_s16_u16(vandq_u16(vshrq_n_u16(s8, 5), m6));
+        dg = vreinterpretq_s16_u16(vandq_u16(vshrq_n_u16(d8, 5), m6));
+        sb = vreinterpretq_s16_u16(vandq_u16(s8, m5));
+        db = vreinterpretq_s16_u16(vandq_u16(d8, m5));
+        r8 = vaddq_s16(dr, vshrq_n_s16(vmulq_s16(vsubq_s16(sr, dr), k8), 8));
+        g8 = vaddq_s16(dg, vshrq_n_s16(vmulq_s16(vsubq_s16(sg, dg), k8), 8));
+        b8 = vaddq_s16(db, vshrq_n_s16(vmulq_s16(vsubq_s16(sb, db), k8), 8));
+        vst1q_u16(dst + i, vorrq_u16(vorrq_u16(vshlq_n_u16(vreinterpretq_u16_s16(r8), 11),
+                                               vshlq_n_u16(vreinterpretq_u16_s16(g8), 5)),
+                                     vreinterpretq_u16_s16(b8)));
+    }
+#elif defined(LAYER_SSE2)
+    __m128i s8, d8, k8, sr, dr, sg, dg, sb, db, r8, g8, b8;
+    __m128i m5 = _mm_set1_epi16(0x1F), m6 = _mm_set1_epi16(0x3F);
+
+    for (; i + 8 <= n; i += 8)
+    {
+        s8 = _mm_loadu_si128((const __m128i *)(src + i));
+        d8 = _mm_loadu_si128((const __m128i *)(dst + i));
+        k8 = _mm_loadu_si128((const __m128i *)(a + i));
+        sr = _mm_srli_epi16(s8, 11);
+        dr = _mm_srli_epi16(d8, 11);
+        sg = _mm_and_si128(_mm_srli_epi16(s8, 5), m6);
+        dg = _mm_and_si128(_mm_srli_epi16(d8, 5), m6);
+        sb = _mm_and_si128(s8, m5);
+        db = _mm_and_si128(d8, m5);
+        r8 = _mm_add_epi16(dr, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(sr, dr), k8), 8));
+        g8 = _mm_add_epi16(dg, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(sg, dg), k8), 8));
+        b8 = _mm_add_epi16(db, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(sb, db), k8), 8));
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r8, 11), _mm_slli_epi16(g8, 5)), b8));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        s = src[i];
+        d = dst[i];
+        k = a[i];
+        r = (d >> 11) + ((((s >> 11) - (d >> 11)) * k) >> 8);
+        g = ((d >> 5) & 0x3F) + (((((s >> 5) & 0x3F) - ((d >> 5) & 0x3F)) * k) >> 8);
+        b = (d & 0x1F) + ((((s & 0x1F) - (d & 0x1F)) * k) >> 8);
+        dst[i] = (r << 11) | (g << 5) | b;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Layer_AlphaLine
+* Description    : Alpha of each pixel of a layer line, 0 to 256
+* Input          : - layer: layer
+*                  - src: layer pixels of the line
+*                  - map: per-pixel alpha of the line or 0
+*                  - n: number of pixels
+* Output         : - a: alpha of each pixel
+* Return         : None
+* Attention      : Key colored pixels get 0. All 256 levels of the 8-bit
+*                  alpha are kept: 255 gives 256, the source unchanged
+*******************************************************************************/
+static void Layer_AlphaLine(const Layer *layer, const unsigned short *src, const unsigned char *map,
+                            unsigned int n, unsigned short *a)
+{
+    unsigned int i, v;
+
+    for (i = 0; i < n; i++)
+    {
+        v = map ? (map[i] * layer->alpha + 127) / 255 : layer->alpha;
+        a[i] = layer->keyed && src[i] == layer->key ? 0 : v + (v >> 7);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Layer_ComposeLine
+* Description    : Composite one line of a rectangle from all the layers
+* Input          : - x0, x1: columns of the line, x1 excluded
+*                  - y: screen line
+* Output         : - line: x1 - x0 pixels
+* Return         : None
+* Attention      : Black where no layer covers the screen
+*******************************************************************************/
+static void Layer_ComposeLine(unsigned short *line, int x0, int x1, int y)
+{
+    const Layer *l;
+    const unsigned short *src;
+    int i, xs, xe, ly;
+
+    memset(line, 0, (x1 - x0) * sizeof(unsigned short));
+    for (i = 0; i < LayerCount; i++)
+    {
+        l = Layers[i];
+        ly = y - l->y;
+        if (!l->visible || !l->alpha || ly < 0 || ly >= l->h)
+            continue;
+        xs = l->x > x0 ? l->x : x0;
+        xe = l->x + l->w < x1 ? l->x + l->w : x1;
+        if (xs >= xe)
+            continue;
+        src = l->pixels + (long)ly * l->w + (xs - l->x);
+
+        if (l->alphaMap || l->alpha < 255)
+        {
+            Layer_AlphaLine(l, src, l->alphaMap ? l->alphaMap + (long)ly * l->w + (xs - l->x) : 0,
+                            xe - xs, AlphaLine);
+            Kernel_Blend(line + xs - x0, src, AlphaLine, xe - xs);
+        }
+        else if (l->keyed)
+        {
+            Kernel_Key(line + xs - x0, src, xe - xs, l->key);
+        }
+        else
+        {
+            memcpy(line + xs - x0, src, (xe - xs) * sizeof(unsigned short));
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Damage_Add
+* Description    : Add a screen rectangle to the damage to composite
+* Input          : - x0, y0, x1, y1: rectangle, x1 and y1 excluded
+* Output         : None
+* Return         : None
+* Attention      : Clipped to the screen; rectangles that overlap or touch
+*                  are merged into their bounding box, and all of them are
+*                  when the list is full
+*******************************************************************************/
+static void Damage_Add(int x0, int y0, int x1, int y1)
+{
+    LayerRect *r;
+    int i;
+
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > LCD_GetWidth()) x1 = LCD_GetWidth();
+    if (y1 > LCD_GetHeight()) y1 = LCD_GetHeight();
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    i = 0;
+    while (i < DamageCount)
+    {
+        r = &Damage[i];
+        if (x0 <= r->x1 && r->x0 <= x1 && y0 <= r->y1 && r->y0 <= y1)
+        {
+            if (r->x0 < x0) x0 = r->x0;
+            if (r->y0 < y0) y0 = r->y0;
+            if (r->x1 > x1) x1 = r->x1;
+            if (r->y1 > y1) y1 = r->y1;
+            Damage[i] = Damage[--DamageCount];
+            i = 0;              /* the larger rectangle may touch others */
+            continue;
+        }
+        i++;
+    }
+    if (DamageCount == LAYER_DAMAGE_MAX)
+    {
+        for (i = 0; i < DamageCount; i++)
+        {
+            r = &Damage[i];
+            if (r->x0 < x0) x0 = r->x0;
+            if (r->y0 < y0) y0 = r->y0;
+            if (r->x1 > x1) x1 = r->x1;
+            if (r->y1 > y1) y1 = r->y1;
+        }
+        DamageCount = 0;
+    }
+    Damage[DamageCount].x0 = x0;
+    Damage[DamageCount].y0 = y0;
+    Damage[DamageCount].x1 = x1;
+    Damage[DamageCount].y1 = y1;
+    DamageCount++;
+}
+
+
+/*******************************************************************************
+* Function Name  : Layer_DamageAll
+* Description    : Damage the screen rectangle of a visible layer
+* Input          : - layer: layer
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Layer_DamageAll(const Layer *layer)
+{
+    if (layer->visible)
+        Damage_Add(layer->x, layer->y, layer->x + layer->w, layer->y + layer->h);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LayerInit
+* Description    : Set up a visible, opaque layer at the origin
+* Input          : - pixels: w * h RGB565 colors, line by line
+*                  - w, h: size
+* Output         : - layer: layer to add to the stack
+* Return         : None
+* Attention      : The pixels are kept by reference, call LCD_LayerDamage
+*                  after drawing into them
+*******************************************************************************/
+void LCD_LayerInit(Layer *layer, unsigned short *pixels, unsigned short w, unsigned short h)
+{
+    memset(layer, 0, sizeof(*layer));
+    layer->pixels = pixels;
+    layer->w = w;
+    layer->h = h;
+    layer->visible = 1;
+    layer->alpha = 255;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LayerAdd
+* Description    : Put a layer on top of the stack
+* Input          : - layer: layer set up by LCD_LayerInit
+* Output         : None
+* Return         : 1 success, 0 stack full
+* Attention      : None
+*******************************************************************************/
+int LCD_LayerAdd(Layer *layer)
+{
+    if (LayerCount == LAYER_MAX)
+        return 0;
+    Layers[LayerCount++] = layer;
+    Layer_DamageAll(layer);
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LayerRemove
+* Description    : Take a layer out of the stack
+* Input          : - layer: layer
+* Output         : None
+* Return         : None
+* Attention      : What it covered is composited again by LCD_Compose
+*******************************************************************************/
+void LCD_LayerRemove(Layer *layer)
+{
+    int i;
+
+    for (i = 0; i < LayerCount; i++)
+    {
+        if (Layers[i] == layer)
+        {
+            Layer_DamageAll(layer);
+            memmove(Layers + i, Layers + i + 1, (LayerCount - i - 1) * sizeof(Layer *));
+            LayerCount--;
+            return;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LayerMove
+* Description    : Move a layer on the screen
+* Input          : - layer: layer
+*                  - Xpos, Ypos: new upper left corner, may be off the screen
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_LayerMove(Layer *layer, short Xpos, short Ypos)
+{
+    if (layer->x == Xpos && layer->y == Ypos)
+        return;
+    Layer_DamageAll(layer);
+    layer->x = Xpos;
+    layer->y = Ypos;
+    Layer_DamageAll(layer);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LayerShow
+* Description    : Show or hide a layer
+* Input          : - layer: layer
+*                  - visible: 1 show, 0 hide
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_LayerShow(Layer *layer, unsigned char visible)
+{
+    visible = visible != 0;
+    if (layer->visible == visible)
+        return;
+    layer->visible = 1;
+    Layer_DamageAll(layer);
+    layer->visible = visible;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LayerSetAlpha
+* Description    : Set the transparency of a layer
+* Input          : - layer: layer
+*                  - alpha: global alpha, 255 opaque
+*                  - alphaMap: w * h alpha of each pixel, scaled by alpha, or 0
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_LayerSetAlpha(Layer *layer, unsigned char alpha, const unsigned char *alphaMap)
+{
+    layer->alpha = alpha;
+    layer->alphaMap = alphaMap;
+    Layer_DamageAll(layer);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LayerSetKey
+* Description    : Set the transparent color of a layer
+* Input          : - layer: layer
+*                  - keyed: 1 to enable the color key, 0 to disable it
+*                  - key: transparent color
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_LayerSetKey(Layer *layer, unsigned char keyed, unsigned short key)
+{
+    layer->keyed = keyed;
+    layer->key = key;
+    Layer_DamageAll(layer);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LayerDamage
+* Description    : Mark a part of a layer as changed
+* Input          : - layer: layer
+*                  - Xpos, Ypos: upper left corner in the layer
+*                  - w, h: size
+* Output         : None
+* Return         : None
+* Attention      : Nothing is damaged while the layer is hidden
+*******************************************************************************/
+void LCD_LayerDamage(Layer *layer, unsigned short Xpos, unsigned short Ypos, unsigned short w, unsigned short h)
+{
+    if (layer->visible)
+        Damage_Add(layer->x + Xpos, layer->y + Ypos, layer->x + Xpos + w, layer->y + Ypos + h);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Damage
+* Description    : Mark a rectangle of the screen to be composited again
+* Input          : - Xpos, Ypos: upper left corner
+*                  - w, h: size
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_Damage(short Xpos, short Ypos, unsigned short w, unsigned short h)
+{
+    Damage_Add(Xpos, Ypos, Xpos + w, Ypos + h);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_Compose
+* Description    : Composite the damaged rectangles and send them to the panel
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : One window and one line burst per scanline for each
+*                  rectangle; the damage is cleared. The windows and bursts
+*                  are one LCD_Lock section
+*******************************************************************************/
+void LCD_Compose(void)
+{
+    LayerRect *r;
+    int i, y;
+
+    STATS_ENTER(STATS_LCD_COMPOSE);
+    LCD_Lock();
+    for (i = 0; i < DamageCount; i++)
+    {
+        r = &Damage[i];
+        if (!LCD_SetWindow(r->x0, r->y0, r->x1 - r->x0, r->y1 - r->y0))
+            continue;           /* orientation changed since the damage */
+        for (y = r->y0; y < r->y1; y++)
+        {
+            Layer_ComposeLine(Line, r->x0, r->x1, y);
+            LCD_WritePixels(Line, r->x1 - r->x0);
+        }
+    }
+    DamageCount = 0;
+    LCD_Unlock();
+    STATS_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_LayerKernel
+* Description    : Blending kernels compiled in
+* Input          : None
+* Output         : None
+* Return         : "neon", "sse2" or "scalar"
+* Attention      : None
+*******************************************************************************/
+const char *LCD_LayerKernel(void)
+{
+#if defined(LAYER_NEON)
+    return "neon";
+#elif defined(LAYER_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,50 @@
+/*******************************************************************************
+* File Name      : lcd_layer.h
+* Description    : Compositor of RGB565 layers with offset, visibility, color
+*                  key and global or per-pixel 8-bit alpha
+*                  Layers are stacked bottom to top in the order they are
+*                  added; only damaged screen rectangles are composited, one
+*                  scanline at a time, and streamed to the panel
+*******************************************************************************/
+#ifndef __LCD_LAYER_H
+#define __LCD_LAYER_H
+
+
+/* Defines */
+#define LAYER_MAX 8             /* layers in the stack */
+#define LAYER_DAMAGE_MAX 16     /* damaged rectangles kept before merging all */
+
+
+/* Types */
+typedef struct
+{
+    unsigned short *pixels;         /* w * h RGB565, line by line, owned by the caller */
+    const unsigned char *alphaMap;  /* w * h alpha or 0, scaled by alpha */
+    unsigned short w, h;
+    short x, y;                     /* upper left corner on the screen */
+    unsigned char visible;
+    unsigned char alpha;            /* 255 opaque, 0 invisible */
+    unsigned char keyed;            /* 1 if pixels equal to key are transparent */
+    unsigned short key;
+} Layer;
+
+
+/* Function declarations */
+void LCD_LayerInit(Layer *layer, unsigned short *pixels, unsigned short w, unsigned short h);
+int LCD_LayerAdd(Layer *layer);
+void LCD_LayerRemove(Layer *layer);
+void LCD_LayerMove(Layer *layer, short Xpos, short Ypos);
+void LCD_LayerShow(Layer *layer, unsigned char visible);
+void LCD_LayerSetAlpha(Layer *layer, unsigned char alpha, const unsigned char *alphaMap);
+void LCD_LayerSetKey(Layer *layer, unsigned char keyed, unsigned short key);
+void LCD_LayerDamage(Layer *layer, unsigned short Xpos, unsigned short Ypos, unsigned short w, unsigned short h);
+void LCD_Damage(short Xpos, short Ypos, unsigned short w, unsigned short h);
+void LCD_Compose(void);
+const char *LCD_LayerKernel(void);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,888 @@
+/*******************************************************************************
+* File Name      : lcd_scene.c
+* Description    : Tiled rendering of a display list on several cores
+*                  Each worker owns a range of the tiles of the frame and
+*                  takes them from its front; a worker out of tiles steals
+*                  from the back of the fullest range. A finished tile goes
+*                  through a lock-free ring to the calling thread, the only
+*                  one on the bus, which sends it with one window and one
+*                  burst in bus byte order, and gives its buffer back
+*                  through a second ring
+*                  Without workers the calling thread renders and sends the
+*                  tiles one after the other
+*******************************************************************************/
+/* Includes */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include "lcd.h"
+#include "lcd_stats.h"
+#include "lcd_scene.h"
+#include "AsciiLib.h"
+
+
+/* Defines */
+#define SCENE_BUFFERS (2 * SCENE_WORKERS_MAX + 2)   /* tiles rendered or in flight */
+#define RING_SIZE 32                                /* power of 2, > SCENE_BUFFERS */
+
+/* RGB565 in the byte order of the bus, for LCD_WritePixelsBE */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define BUS_ORDER(c) ((unsigned short)(c))
+#else
+#define BUS_ORDER(c) ((unsigned short)((c) << 8 | (c) >> 8))
+#endif
+
+
+/* Types */
+typedef struct
+{
+    int x0, y0, x1, y1;             /* screen rectangle, x1 y1 excluded */
+    unsigned short *pixels;         /* (x1 - x0) * (y1 - y0), bus order */
+} SceneTile;
+
+/* Target of the rasterizers of lcd.c in a tile */
+typedef struct
+{
+    const SceneTile *tile;
+    unsigned short color;           /* bus order */
+} TileTarget;
+
+/* Bounded lock-free queue: a slot is free for the push of position pos
+   when its sequence is pos, full for the pop of pos when it is pos + 1.
+   Positions and sequences are only read and changed by atomic operations,
+   which also order the value before and after them */
+typedef struct
+{
+    volatile unsigned long seq[RING_SIZE];
+    unsigned int value[RING_SIZE];
+    volatile unsigned long head, tail;
+} SceneRing;
+
+
+/* Public declarations */
+static pthread_mutex_t FrameLock = PTHREAD_MUTEX_INITIALIZER;  /* one frame at a time */
+static pthread_mutex_t PoolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t PoolWake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t PoolIdle = PTHREAD_COND_INITIALIZER;
+static pthread_t Workers[SCENE_WORKERS_MAX];
+static unsigned int WorkerCount;
+static unsigned long Generation;    /* frames started */
+static unsigned int Busy;           /* workers not done with the frame */
+static int Quit;
+
+static const Scene *Frame;
+static int FrameX0, FrameY0, FrameX1, FrameY1;
+static unsigned int TilesX;
+static volatile unsigned long long Ranges[SCENE_WORKERS_MAX];  /* first | end << 32 */
+
+static int PoolReady;
+static SceneRing FreeRing, ReadyRing;
+static sem_t FreeSem, ReadySem;
+static unsigned short Buffers[SCENE_BUFFERS][SCENE_TILE_W * SCENE_TILE_H];
+
+
+/*******************************************************************************
+* Function Name  : Ring_Init
+* Description    : Empty a ring
+* Input          : - ring: ring
+* Output         : None
+* Return         : None
+* Attention      : No thread may use it meanwhile
+*******************************************************************************/
+static void Ring_Init(SceneRing *ring)
+{
+    unsigned int i;
+
+    for (i = 0; i < RING_SIZE; i++)
+        ring->seq[i] = i;
+    ring->head = ring->tail = 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : Ring_Push
+* Description    : Append a value, any number of threads pushing
+* Input          : - ring: ring
+*                  - value: value
+* Output         : None
+* Return         : 1 success, 0 ring full
+* Attention      : None
+*******************************************************************************/
+static int Ring_Push(SceneRing *ring, unsigned int value)
+{
+    unsigned long pos, seq;
+
+    for (;;)
+    {
+        pos = __sync_fetch_and_add(&ring->tail, 0);
+        seq = __sync_fetch_and_add(&ring->seq[pos % RING_SIZE], 0);
+        if (seq == pos)
+        {
+            if (__sync_bool_compare_and_swap(&ring->tail, pos, pos + 1))
+                break;
+        }
+        else if ((long)(seq - pos) < 0)
+            return 0;
+    }
+    ring->value[pos % RING_SIZE] = value;
+    __sync_fetch_and_add(&ring->seq[pos % RING_SIZE], 1);          /* full */
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : Ring_Pop
+* Description    : Take the oldest value, any number of threads popping
+* Input          : - ring: ring
+* Output         : - value: value
+* Return         : 1 success, 0 ring empty
+* Attention      : None
+*******************************************************************************/
+static int Ring_Pop(SceneRing *ring, unsigned int *value)
+{
+    unsigned long pos, seq;
+
+    for (;;)
+    {
+        pos = __sync_fetch_and_add(&ring->head, 0);
+        seq = __sync_fetch_and_add(&ring->seq[pos % RING_SIZE], 0);
+        if (seq == pos + 1)
+        {
+            if (__sync_bool_compare_and_swap(&ring->head, pos, pos + 1))
+                break;
+        }
+        else if ((long)(seq - (pos + 1)) < 0)
+            return 0;
+    }
+    *value = ring->value[pos % RING_SIZE];
+    __sync_fetch_and_add(&ring->seq[pos % RING_SIZE], RING_SIZE - 1);   /* free for pos + RING_SIZE */
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : Ring_Take
+* Description    : Take the oldest value of a ring counted by a semaphore,
+*                  waiting for one
+* Input          : - ring: ring
+*                  - sem: values pushed and not taken
+* Output         : - value: value
+* Return         : None
+* Attention      : The semaphore is posted after the push is done, but a
+*                  push that claimed an earlier slot may not be done yet:
+*                  wait for the slot at the head to be filled
+*******************************************************************************/
+static void Ring_Take(SceneRing *ring, sem_t *sem, unsigned int *value)
+{
+    while (sem_wait(sem))
+        ;
+    while (!Ring_Pop(ring, value))
+        sched_yield();
+}
+
+
+/*******************************************************************************
+* Function Name  : Tile_Take
+* Description    : Next tile for a worker: from the front of its own range,
+*                  else from the back of the fullest other range
+* Input          : - self: worker
+* Output         : - tile: tile index
+* Return         : 1 success, 0 no tile left in the frame
+* Attention      : Ranges are read with an atomic operation: a torn read
+*                  would make a worker give up while tiles are left
+*******************************************************************************/
+static int Tile_Take(unsigned int self, unsigned int *tile)
+{
+    unsigned long long r;
+    unsigned int v, best, first, end, left, bestLeft;
+
+    for (;;)
+    {
+        r = __sync_fetch_and_add(&Ranges[self], 0);
+        first = (unsigned int)r;
+        end = (unsigned int)(r >> 32);
+        if (first >= end)
+            break;
+        if (__sync_bool_compare_and_swap(&Ranges[self], r, r + 1))
+        {
+            *tile = first;
+            return 1;
+        }
+    }
+
+    for (;;)
+    {
+        best = self;
+        bestLeft = 0;
+        for (v = 0; v < WorkerCount; v++)
+        {
+            r = __sync_fetch_and_add(&Ranges[v], 0);
+            first = (unsigned int)r;
+            end = (unsigned int)(r >> 32);
+            left = end > first ? end - first : 0;
+            if (v != self && left > bestLeft)
+            {
+                best = v;
+                bestLeft = left;
+            }
+        }
+        if (!bestLeft)
+            return 0;
+        r = __sync_fetch_and_add(&Ranges[best], 0);
+        first = (unsigned int)r;
+        end = (unsigned int)(r >> 32);
+        if (first < end && __sync_bool_compare_and_swap(&Ranges[best], r, r - (1ULL << 32)))
+        {
+            *tile = end - 1;
+            return 1;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Tile_Rect
+* Description    : Screen rectangle of a tile of the frame
+* Input          : - index: tile index, line by line
+* Output         : - tile: x0, y0, x1, y1 of the tile
+* Return         : None
+* Attention      : Tiles of the right and bottom edges may be smaller
+*******************************************************************************/
+static void Tile_Rect(unsigned int index, SceneTile *tile)
+{
+    tile->x0 = FrameX0 + (int)(index % TilesX) * SCENE_TILE_W;
+    tile->y0 = FrameY0 + (int)(index / TilesX) * SCENE_TILE_H;
+    tile->x1 = tile->x0 + SCENE_TILE_W < FrameX1 ? tile->x0 + SCENE_TILE_W : FrameX1;
+    tile->y1 = tile->y0 + SCENE_TILE_H < FrameY1 ? tile->y0 + SCENE_TILE_H : FrameY1;
+}
+
+
+/*******************************************************************************
+* Function Name  : Tile_Fill
+* Description    : Fill a rectangle clipped to the tile
+* Input          : - t: tile
+*                  - x, y: upper left corner on the screen
+*                  - w, h: size
+*                  - color: bus order
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Tile_Fill(const SceneTile *t, int x, int y, int w, int h, unsigned short color)
+{
+    int x1 = x + w, y1 = y + h, tw = t->x1 - t->x0, i;
+    unsigned short *p;
+
+    if (x < t->x0) x = t->x0;
+    if (y < t->y0) y = t->y0;
+    if (x1 > t->x1) x1 = t->x1;
+    if (y1 > t->y1) y1 = t->y1;
+    for (; y < y1; y++)
+    {
+        p = t->pixels + (y - t->y0) * tw + (x - t->x0);
+        for (i = x; i < x1; i++)
+            *p++ = color;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Tile_Emit
+* Description    : LCD_RasterEmit of the tiles: fill in the tile
+* Input          : - target: TileTarget
+*                  - x, y, w, h: rectangle inside the tile
+* Output         : None
+* Return         : None
+* Attention      : A single point is stored straight
+*******************************************************************************/
+static void Tile_Emit(void *target, int x, int y, int w, int h)
+{
+    const TileTarget *tt = (const TileTarget *)target;
+    const SceneTile *t = tt->tile;
+
+    if (w == 1 && h == 1)
+        t->pixels[(y - t->y0) * (t->x1 - t->x0) + (x - t->x0)] = tt->color;
+    else
+        Tile_Fill(t, x, y, w, h, tt->color);
+}
+
+
+/*******************************************************************************
+* Function Name  : Tile_Text
+* Description    : 8x16 characters of a string clipped to the tile
+* Input          : - t: tile
+*                  - c: SCENE_TEXT command
+* Output         : None
+* Return         : None
+* Attention      : No wrapping, characters past the screen are clipped
+*******************************************************************************/
+static void Tile_Text(const SceneTile *t, const SceneCmd *c)
+{
+    const char *str = c->data;
+    unsigned short fg = BUS_ORDER(c->color), bg = BUS_ORDER(c->color2);
+    unsigned char glyph[16];
+    int x, i, j, j0, j1, i0, i1;
+    unsigned short *p;
+
+    i0 = t->y0 - c->y > 0 ? t->y0 - c->y : 0;
+    i1 = t->y1 - c->y < 16 ? t->y1 - c->y : 16;
+    for (x = c->x; *str; str++, x += 8)
+    {
+        if (x + 8 <= t->x0)
+            continue;
+        if (x >= t->x1)
+            break;
+        GetASCIICode(glyph, (unsigned char)*str);
+        j0 = t->x0 - x > 0 ? t->x0 - x : 0;
+        j1 = t->x1 - x < 8 ? t->x1 - x : 8;
+        for (i = i0; i < i1; i++)
+        {
+            p = t->pixels + (c->y + i - t->y0) * (t->x1 - t->x0) + (x + j0 - t->x0);
+            for (j = j0; j < j1; j++)
+                *p++ = (glyph[i] >> (7 - j)) & 1 ? fg : bg;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Tile_Image
+* Description    : Copy the part of an image inside the tile
+* Input          : - t: tile
+*                  - c: SCENE_IMAGE command
+* Output         : None
+* Return         : None
+* Attention      : Swapped to bus order on the way
+*******************************************************************************/
+static void Tile_Image(const SceneTile *t, const SceneCmd *c)
+{
+    const unsigned short *src;
+    unsigned short *p;
+    int x0, y0, x1, y1, x, y;
+
+    x0 = c->x > t->x0 ? c->x : t->x0;
+    y0 = c->y > t->y0 ? c->y : t->y0;
+    x1 = c->x + c->w < t->x1 ? c->x + c->w : t->x1;
+    y1 = c->y + c->h < t->y1 ? c->y + c->h : t->y1;
+    for (y = y0; y < y1; y++)
+    {
+        src = (const unsigned short *)c->data + (long)(y - c->y) * c->w + (x0 - c->x);
+        p = t->pixels + (y - t->y0) * (t->x1 - t->x0) + (x0 - t->x0);
+        for (x = x0; x < x1; x++)
+        {
+            *p++ = BUS_ORDER(*src);
+            src++;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Tile_Render
+* Description    : Render the commands of the frame that touch a tile
+* Input          : - t: tile, its pixels to fill
+* Output         : None
+* Return         : None
+* Attention      : Runs on the workers, touches no device
+*******************************************************************************/
+static void Tile_Render(const SceneTile *t)
+{
+    const SceneCmd *c;
+    LCD_RasterClip clip;
+    TileTarget target;
+    unsigned int i;
+
+    clip.x0 = t->x0;
+    clip.y0 = t->y0;
+    clip.x1 = t->x1;
+    clip.y1 = t->y1;
+    target.tile = t;
+    Tile_Fill(t, t->x0, t->y0, t->x1 - t->x0, t->y1 - t->y0, BUS_ORDER(Frame->background));
+    for (i = 0; i < Frame->count; i++)
+    {
+        c = &Frame->cmds[i];
+        if (c->bx1 <= t->x0 || c->bx0 >= t->x1 || c->by1 <= t->y0 || c->by0 >= t->y1)
+            continue;
+        switch (c->op)
+        {
+        case SCENE_FILL:
+            Tile_Fill(t, c->x, c->y, c->w, c->h, BUS_ORDER(c->color));
+            break;
+        case SCENE_LINE:
+            target.color = BUS_ORDER(c->color);
+            LCD_RasterLine(&clip, c->x, c->y, c->x2, c->y2, Tile_Emit, &target);
+            break;
+        case SCENE_CIRCLE:
+            target.color = BUS_ORDER(c->color);
+            LCD_RasterCircle(&clip, c->x, c->y, c->w, Tile_Emit, &target);
+            break;
+        case SCENE_CIRCLE_FILL:
+            /* the spans of LCD_DrawCircleFill, then its border */
+            target.color = BUS_ORDER(c->color2);
+            LCD_RasterCircleFill(&clip, c->x, c->y, c->w, Tile_Emit, &target);
+            if (c->color != c->color2)
+            {
+                target.color = BUS_ORDER(c->color);
+                LCD_RasterCircle(&clip, c->x, c->y, c->w, Tile_Emit, &target);
+            }
+            break;
+        case SCENE_TEXT:
+            Tile_Text(t, c);
+            break;
+        case SCENE_IMAGE:
+            Tile_Image(t, c);
+            break;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Tile_Send
+* Description    : Send a rendered tile to the panel
+* Input          : - t: tile
+* Output         : None
+* Return         : None
+* Attention      : Calling thread only
+*******************************************************************************/
+static void Tile_Send(const SceneTile *t)
+{
+    if (LCD_SetWindow(t->x0, t->y0, t->x1 - t->x0, t->y1 - t->y0))
+        LCD_WritePixelsBE(t->pixels, (t->x1 - t->x0) * (t->y1 - t->y0));
+}
+
+
+/*******************************************************************************
+* Function Name  : Scene_Worker
+* Description    : Worker thread: render the tiles of each frame while
+*                  there are buffers and tiles left
+* Input          : - arg: worker index
+* Output         : None
+* Return         : 0
+* Attention      : None
+*******************************************************************************/
+static void *Scene_Worker(void *arg)
+{
+    unsigned int self = (unsigned int)(unsigned long)arg, index, buf;
+    unsigned long seen = 0;
+    SceneTile t;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&PoolLock);
+        while (Generation == seen && !Quit)
+            pthread_cond_wait(&PoolWake, &PoolLock);
+        if (Quit)
+        {
+            pthread_mutex_unlock(&PoolLock);
+            return 0;
+        }
+        seen = Generation;
+        pthread_mutex_unlock(&PoolLock);
+
+        for (;;)
+        {
+            Ring_Take(&FreeRing, &FreeSem, &buf);
+            if (!Tile_Take(self, &index))
+            {
+                Ring_Push(&FreeRing, buf);
+                sem_post(&FreeSem);
+                break;
+            }
+            Tile_Rect(index, &t);
+            t.pixels = Buffers[buf];
+            Tile_Render(&t);
+            Ring_Push(&ReadyRing, index << 8 | buf);
+            sem_post(&ReadySem);
+        }
+
+        pthread_mutex_lock(&PoolLock);
+        if (!--Busy)
+            pthread_cond_signal(&PoolIdle);
+        pthread_mutex_unlock(&PoolLock);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Scene_Add
+* Description    : Append a command to a display list
+* Input          : - scene: display list
+*                  - op: SCENE_x
+*                  - bx0, by0, bx1, by1: box the command draws in, bx1 by1
+*                    excluded
+* Output         : None
+* Return         : the command, 0 if out of memory
+* Attention      : The other fields are zeroed
+*******************************************************************************/
+static SceneCmd *Scene_Add(Scene *scene, SceneOp op, int bx0, int by0, int bx1, int by1)
+{
+    SceneCmd *c;
+    unsigned int size;
+
+    if (scene->count == scene->size)
+    {
+        size = scene->size ? 2 * scene->size : 32;
+        c = realloc(scene->cmds, size * sizeof(*c));
+        if (!c)
+            return 0;
+        scene->cmds = c;
+        scene->size = size;
+    }
+    c = &scene->cmds[scene->count++];
+    memset(c, 0, sizeof(*c));
+    c->op = op;
+    c->bx0 = bx0 > -32768 ? bx0 : -32768;
+    c->by0 = by0 > -32768 ? by0 : -32768;
+    c->bx1 = bx1 < 32767 ? bx1 : 32767;
+    c->by1 = by1 < 32767 ? by1 : 32767;
+    return c;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SceneInit
+* Description    : Set up an empty display list
+* Input          : - background: color under the commands
+* Output         : - scene: display list
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_SceneInit(Scene *scene, unsigned short background)
+{
+    memset(scene, 0, sizeof(*scene));
+    scene->background = background;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SceneReset
+* Description    : Remove all the commands, to build the next frame
+* Input          : - scene: display list
+* Output         : None
+* Return         : None
+* Attention      : The memory of the list is kept
+*******************************************************************************/
+void LCD_SceneReset(Scene *scene)
+{
+    unsigned int i;
+
+    for (i = 0; i < scene->count; i++)
+        if (scene->cmds[i].op == SCENE_TEXT)
+            free((void *)scene->cmds[i].data);
+    scene->count = 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SceneFree
+* Description    : Release the memory of a display list
+* Input          : - scene: display list
+* Output         : None
+* Return         : None
+* Attention      : The list is empty afterwards
+*******************************************************************************/
+void LCD_SceneFree(Scene *scene)
+{
+    LCD_SceneReset(scene);
+    free(scene->cmds);
+    scene->cmds = 0;
+    scene->size = 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SceneFill
+* Description    : Add a filled rectangle
+* Input          : - scene: display list
+*                  - Xpos, Ypos: upper left corner on the screen
+*                  - w, h: size
+*                  - color: RGB565 color
+* Output         : None
+* Return         : 1 success, 0 if out of memory
+* Attention      : None
+*******************************************************************************/
+int LCD_SceneFill(Scene *scene, short Xpos, short Ypos, unsigned short w, unsigned short h, unsigned short color)
+{
+    SceneCmd *c = Scene_Add(scene, SCENE_FILL, Xpos, Ypos, Xpos + w, Ypos + h);
+
+    if (!c)
+        return 0;
+    c->x = Xpos;
+    c->y = Ypos;
+    c->w = w;
+    c->h = h;
+    c->color = color;
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SceneLine
+* Description    : Add a line
+* Input          : - scene: display list
+*                  - x1, y1: first end
+*                  - x2, y2: second end
+*                  - color: RGB565 color
+* Output         : None
+* Return         : 1 success, 0 if out of memory
+* Attention      : The pixels of LCD_DrawLine
+*******************************************************************************/
+int LCD_SceneLine(Scene *scene, short x1, short y1, short x2, short y2, unsigned short color)
+{
+    SceneCmd *c = Scene_Add(scene, SCENE_LINE, x1 < x2 ? x1 : x2, y1 < y2 ? y1 : y2,
+                            (x1 > x2 ? x1 : x2) + 1, (y1 > y2 ? y1 : y2) + 1);
+
+    if (!c)
+        return 0;
+    c->x = x1;
+    c->y = y1;
+    c->x2 = x2;
+    c->y2 = y2;
+    c->color = color;
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SceneCircle
+* Description    : Add a circle
+* Input          : - scene: display list
+*                  - xc, yc: center
+*                  - r: radius
+*                  - color: RGB565 color
+* Output         : None
+* Return         : 1 success, 0 if out of memory
+* Attention      : The pixels of LCD_DrawCircle
+*******************************************************************************/
+int LCD_SceneCircle(Scene *scene, short xc, short yc, unsigned short r, unsigned short color)
+{
+    SceneCmd *c = Scene_Add(scene, SCENE_CIRCLE, xc - r, yc - r, xc + r + 1, yc + r + 1);
+
+    if (!c)
+        return 0;
+    c->x = xc;
+    c->y = yc;
+    c->w = r;
+    c->color = color;
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SceneCircleFill
+* Description    : Add a filled circle
+* Input          : - scene: display list
+*                  - xc, yc: center
+*                  - r: radius
+*                  - bcolor: border color
+*                  - color: fill color
+* Output         : None
+* Return         : 1 success, 0 if out of memory
+* Attention      : The pixels of LCD_DrawCircleFill
+*******************************************************************************/
+int LCD_SceneCircleFill(Scene *scene, short xc, short yc, unsigned short r, unsigned short bcolor, unsigned short color)
+{
+    SceneCmd *c = Scene_Add(scene, SCENE_CIRCLE_FILL, xc - r, yc - r, xc + r + 1, yc + r + 1);
+
+    if (!c)
+        return 0;
+    c->x = xc;
+    c->y = yc;
+    c->w = r;
+    c->color = bcolor;
+    c->color2 = color;
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SceneText
+* Description    : Add a string of 8x16 characters
+* Input          : - scene: display list
+*                  - Xpos, Ypos: upper left corner of the first character
+*                  - str: string, copied
+*                  - color: character color
+*                  - bkColor: background color
+* Output         : None
+* Return         : 1 success, 0 if out of memory
+* Attention      : One line: unlike LCD_Text the string does not wrap
+*******************************************************************************/
+int LCD_SceneText(Scene *scene, short Xpos, short Ypos, const char *str, unsigned short color, unsigned short bkColor)
+{
+    size_t len = strlen(str);
+    char *copy = malloc(len + 1);
+    SceneCmd *c;
+
+    if (!copy)
+        return 0;
+    c = Scene_Add(scene, SCENE_TEXT, Xpos, Ypos, Xpos + 8 * (long)len, Ypos + 16);
+    if (!c)
+    {
+        free(copy);
+        return 0;
+    }
+    memcpy(copy, str, len + 1);
+    c->x = Xpos;
+    c->y = Ypos;
+    c->color = color;
+    c->color2 = bkColor;
+    c->data = copy;
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SceneImage
+* Description    : Add an RGB565 image
+* Input          : - scene: display list
+*                  - Xpos, Ypos: upper left corner on the screen
+*                  - w, h: size
+*                  - pixels: w * h colors, line by line
+* Output         : None
+* Return         : 1 success, 0 if out of memory
+* Attention      : The pixels are kept by reference until the last render
+*******************************************************************************/
+int LCD_SceneImage(Scene *scene, short Xpos, short Ypos, unsigned short w, unsigned short h, const unsigned short *pixels)
+{
+    SceneCmd *c = Scene_Add(scene, SCENE_IMAGE, Xpos, Ypos, Xpos + w, Ypos + h);
+
+    if (!c)
+        return 0;
+    c->x = Xpos;
+    c->y = Ypos;
+    c->w = w;
+    c->h = h;
+    c->data = pixels;
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SceneWorkers
+* Description    : Set the number of threads rendering the tiles
+* Input          : - count: worker threads, SCENE_WORKERS_MAX at most; 0
+*                    renders on the calling thread
+* Output         : None
+* Return         : number of workers running
+* Attention      : One less than the cores leaves one to the sender
+*******************************************************************************/
+int LCD_SceneWorkers(unsigned int count)
+{
+    unsigned int i;
+
+    pthread_mutex_lock(&FrameLock);
+    if (!PoolReady)
+    {
+        Ring_Init(&FreeRing);
+        Ring_Init(&ReadyRing);
+        for (i = 0; i < SCENE_BUFFERS; i++)
+            Ring_Push(&FreeRing, i);
+        sem_init(&FreeSem, 0, SCENE_BUFFERS);
+        sem_init(&ReadySem, 0, 0);
+        PoolReady = 1;
+    }
+
+    pthread_mutex_lock(&PoolLock);
+    Quit = 1;
+    pthread_cond_broadcast(&PoolWake);
+    pthread_mutex_unlock(&PoolLock);
+    for (i = 0; i < WorkerCount; i++)
+        pthread_join(Workers[i], 0);
+    Quit = 0;
+    Generation = 0;                 /* the new workers have seen none */
+
+    if (count > SCENE_WORKERS_MAX)
+        count = SCENE_WORKERS_MAX;
+    for (WorkerCount = 0; WorkerCount < count; WorkerCount++)
+        if (pthread_create(&Workers[WorkerCount], 0, Scene_Worker, (void *)(unsigned long)WorkerCount))
+            break;
+    pthread_mutex_unlock(&FrameLock);
+    return WorkerCount;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SceneRender
+* Description    : Render a display list over a rectangle of the screen and
+*                  send it to the panel
+* Input          : - scene: display list
+*                  - Xpos, Ypos: upper left corner on the screen
+*                  - w, h: size, clipped to the screen
+* Output         : None
+* Return         : number of tiles sent
+* Attention      : The device is locked for the frame, the workers never
+*                  touch it; tiles are sent in the order they are done
+*******************************************************************************/
+int LCD_SceneRender(const Scene *scene, short Xpos, short Ypos, unsigned short w, unsigned short h)
+{
+    unsigned int tiles, i, v;
+    SceneTile t;
+
+    pthread_mutex_lock(&FrameLock);
+    LCD_Lock();
+    STATS_ENTER(STATS_LCD_SCENERENDER);
+    FrameX0 = Xpos > 0 ? Xpos : 0;
+    FrameY0 = Ypos > 0 ? Ypos : 0;
+    FrameX1 = Xpos + w < LCD_GetWidth() ? Xpos + w : LCD_GetWidth();
+    FrameY1 = Ypos + h < LCD_GetHeight() ? Ypos + h : LCD_GetHeight();
+    if (FrameX0 >= FrameX1 || FrameY0 >= FrameY1)
+    {
+        STATS_LEAVE();
+        LCD_Unlock();
+        pthread_mutex_unlock(&FrameLock);
+        return 0;
+    }
+    Frame = scene;
+    TilesX = (FrameX1 - FrameX0 + SCENE_TILE_W - 1) / SCENE_TILE_W;
+    tiles = TilesX * ((FrameY1 - FrameY0 + SCENE_TILE_H - 1) / SCENE_TILE_H);
+
+    if (!WorkerCount)
+    {
+        for (i = 0; i < tiles; i++)
+        {
+            Tile_Rect(i, &t);
+            t.pixels = Buffers[0];
+            Tile_Render(&t);
+            Tile_Send(&t);
+        }
+    }
+    else
+    {
+        for (i = 0; i < WorkerCount; i++)
+            Ranges[i] = (unsigned long long)(tiles * i / WorkerCount)
+                        | (unsigned long long)(tiles * (i + 1) / WorkerCount) << 32;
+        pthread_mutex_lock(&PoolLock);
+        Busy = WorkerCount;
+        Generation++;
+        pthread_cond_broadcast(&PoolWake);
+        pthread_mutex_unlock(&PoolLock);
+
+        for (i = 0; i < tiles; i++)
+        {
+            Ring_Take(&ReadyRing, &ReadySem, &v);
+            Tile_Rect(v >> 8, &t);
+            t.pixels = Buffers[v & 0xFF];
+            Tile_Send(&t);
+            Ring_Push(&FreeRing, v & 0xFF);
+            sem_post(&FreeSem);
+        }
+
+        pthread_mutex_lock(&PoolLock);
+        while (Busy)
+            pthread_cond_wait(&PoolIdle, &PoolLock);
+        pthread_mutex_unlock(&PoolLock);
+    }
+    Frame = 0;
+    STATS_LEAVE();
+    LCD_Unlock();
+    pthread_mutex_unlock(&FrameLock);
+    return tiles;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,69 @@
+/*******************************************************************************
+* File Name      : lcd_scene.h
+* Description    : Display list of a screen, rendered in tiles by a pool of
+*                  worker threads into host buffers; the calling thread
+*                  alone sends the finished tiles, so the rendering of the
+*                  next tiles overlaps the transfer of the last one
+*                  Pixels drawn are the ones of the LCD_x function of each
+*                  command, in screen coordinates, without the viewport
+*******************************************************************************/
+#ifndef __LCD_SCENE_H
+#define __LCD_SCENE_H
+
+
+/* Defines */
+#define SCENE_TILE_W 64
+#define SCENE_TILE_H 32             /* one burst per tile */
+#define SCENE_WORKERS_MAX 8
+
+
+/* Types */
+typedef enum
+{
+    SCENE_FILL,
+    SCENE_LINE,
+    SCENE_CIRCLE,
+    SCENE_CIRCLE_FILL,
+    SCENE_TEXT,
+    SCENE_IMAGE
+} SceneOp;
+
+typedef struct
+{
+    unsigned char op;               /* SCENE_x */
+    short x, y;                     /* corner, first end of a line, center of a circle */
+    short x2, y2;                   /* second end of a line */
+    unsigned short w, h;            /* size; radius of a circle in w */
+    unsigned short color;           /* fill, line, border or text color */
+    unsigned short color2;          /* circle fill or text background */
+    const void *data;               /* copy of the text, or pixels of the caller */
+    short bx0, by0, bx1, by1;       /* screen box the command draws in, bx1 by1 excluded */
+} SceneCmd;
+
+typedef struct
+{
+    SceneCmd *cmds;                 /* drawn in this order over the background */
+    unsigned int count, size;
+    unsigned short background;
+} Scene;
+
+
+/* Function declarations */
+void LCD_SceneInit(Scene *scene, unsigned short background);
+void LCD_SceneReset(Scene *scene);
+void LCD_SceneFree(Scene *scene);
+int LCD_SceneFill(Scene *scene, short Xpos, short Ypos, unsigned short w, unsigned short h, unsigned short color);
+int LCD_SceneLine(Scene *scene, short x1, short y1, short x2, short y2, unsigned short color);
+int LCD_SceneCircle(Scene *scene, short xc, short yc, unsigned short r, unsigned short color);
+int LCD_SceneCircleFill(Scene *scene, short xc, short yc, unsigned short r, unsigned short bcolor, unsigned short color);
+int LCD_SceneText(Scene *scene, short Xpos, short Ypos, const char *str, unsigned short color, unsigned short bkColor);
+int LCD_SceneImage(Scene *scene, short Xpos, short Ypos, unsigned short w, unsigned short h, const unsigned short *pixels);
+int LCD_SceneWorkers(unsigned int count);
+int LCD_SceneRender(const Scene *scene, short Xpos, short Ypos, unsigned short w, unsigned short h);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,264 @@
+/*******************************************************************************
+* File Name      : lcd_spi0.c
+* Description    : Write only transfers on the SPI0 registers of the BCM2835,
+*                  and a stand-in of the registers for the host
+*                  Polled mode: one FIFO register access per byte sent, the
+*                  RX FIFO is read only to make room, SPI0_RX_BULK bytes at
+*                  a time when RXR says they are there
+*******************************************************************************/
+/* Includes */
+#include <stdlib.h>
+#include <string.h>
+#include "lcd_spi0.h"
+
+
+/*******************************************************************************
+* Function Name  : SPI0_Get
+* Description    : Read a register
+* Input          : - port: registers
+*                  - reg: SPI0_x
+* Output         : None
+* Return         : register value
+* Attention      : A read of SPI0_FIFO pops the RX FIFO
+*******************************************************************************/
+static inline unsigned int SPI0_Get(const SPI0_Port *port, unsigned int reg)
+{
+    if (port->sync)
+        port->sync(port->ctx, reg, 0);
+    return port->regs[reg];
+}
+
+
+/*******************************************************************************
+* Function Name  : SPI0_Put
+* Description    : Write a register
+* Input          : - port: registers
+*                  - reg: SPI0_x
+*                  - value: register value
+* Output         : None
+* Return         : None
+* Attention      : A write of SPI0_FIFO pushes the TX FIFO
+*******************************************************************************/
+static inline void SPI0_Put(const SPI0_Port *port, unsigned int reg, unsigned int value)
+{
+    port->regs[reg] = value;
+    if (port->sync)
+        port->sync(port->ctx, reg, 1);
+}
+
+
+/*******************************************************************************
+* Function Name  : SPI0_Drain
+* Description    : Discard the bytes received so far
+* Input          : - port: registers
+* Output         : None
+* Return         : None
+* Attention      : A full RX FIFO stops the clock, it must be emptied while
+*                  the TX FIFO is fed
+*******************************************************************************/
+static void SPI0_Drain(const SPI0_Port *port)
+{
+    unsigned int i;
+
+    if (SPI0_Get(port, SPI0_CS) & SPI0_CS_RXR)
+        for (i = 0; i < SPI0_RX_BULK; i++)
+            (void)SPI0_Get(port, SPI0_FIFO);
+    while (SPI0_Get(port, SPI0_CS) & SPI0_CS_RXD)
+        (void)SPI0_Get(port, SPI0_FIFO);
+}
+
+
+/*******************************************************************************
+* Function Name  : SPI0_Fill
+* Description    : Send bytes, the TX FIFO kept as full as it takes
+* Input          : - port: registers
+*                  - p: bytes
+*                  - n: number of bytes
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void SPI0_Fill(const SPI0_Port *port, const char *p, unsigned int n)
+{
+    while (n)
+    {
+        while (n && (SPI0_Get(port, SPI0_CS) & SPI0_CS_TXD))
+        {
+            SPI0_Put(port, SPI0_FIFO, (unsigned char)*p++);
+            n--;
+        }
+        SPI0_Drain(port);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : SPI0_Write
+* Description    : One write only transfer, chip select held across both
+*                  parts
+* Input          : - port: registers
+*                  - head: first bytes, a start byte
+*                  - headLen: number of bytes of head
+*                  - buf: bytes sent after head, may be 0 if len is 0
+*                  - len: number of bytes of buf
+* Output         : None
+* Return         : None
+* Attention      : Slave, clock and mode as set before by the library
+*******************************************************************************/
+void SPI0_Write(const SPI0_Port *port, const char *head, unsigned int headLen,
+                const char *buf, unsigned int len)
+{
+    unsigned int cs;
+
+    __sync_synchronize();
+    cs = SPI0_Get(port, SPI0_CS) & ~SPI0_CS_TA;
+    SPI0_Put(port, SPI0_CS, cs | SPI0_CS_CLEAR_TX | SPI0_CS_CLEAR_RX);
+    SPI0_Put(port, SPI0_CS, cs | SPI0_CS_TA);
+    SPI0_Fill(port, head, headLen);
+    SPI0_Fill(port, buf, len);
+    while (!(SPI0_Get(port, SPI0_CS) & SPI0_CS_DONE))
+        SPI0_Drain(port);
+    SPI0_Put(port, SPI0_CS, cs);
+    __sync_synchronize();
+}
+
+
+/*******************************************************************************
+* Function Name  : Standin_Shift
+* Description    : Clock the bytes of the TX FIFO out while the RX FIFO has
+*                  room for the bytes clocked in
+* Input          : - s: stand-in
+* Output         : None
+* Return         : None
+* Attention      : The slave answers 0 to every byte
+*******************************************************************************/
+static void Standin_Shift(SPI0_Standin *s)
+{
+    while (s->txCount && s->rxCount < SPI0_FIFO_DEPTH)
+    {
+        if (s->len == s->size)
+        {
+            s->size = s->size ? 2 * s->size : 4096;
+            s->data = realloc(s->data, s->size);
+        }
+        s->data[s->len++] = s->tx[s->txHead];
+        s->txHead = (s->txHead + 1) % SPI0_FIFO_DEPTH;
+        s->txCount--;
+        s->rx[(s->rxHead + s->rxCount) % SPI0_FIFO_DEPTH] = 0;
+        s->rxCount++;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Standin_Sync
+* Description    : Model of the SPI0 block around a register access
+* Input          : - ctx: stand-in
+*                  - reg: SPI0_x
+*                  - write: 1 after a write, 0 before a read
+* Output         : None
+* Return         : None
+* Attention      : The clock is instantaneous: bytes move as soon as the
+*                  FIFOs allow
+*******************************************************************************/
+static void Standin_Sync(void *ctx, unsigned int reg, int write)
+{
+    SPI0_Standin *s = ctx;
+    unsigned int cs = s->regs[SPI0_CS];
+
+    if (write)
+    {
+        s->writes++;
+        if (reg == SPI0_CS)
+        {
+            if (cs & SPI0_CS_CLEAR_TX)
+                s->txCount = 0;
+            if (cs & SPI0_CS_CLEAR_RX)
+                s->rxCount = 0;
+            cs &= ~(SPI0_CS_CLEAR_TX | SPI0_CS_CLEAR_RX);
+            if (!s->active && (cs & SPI0_CS_TA))
+                s->len = 0;
+            if (s->active && !(cs & SPI0_CS_TA) && s->sink)
+                s->sink(s->sinkCtx, s->data, s->len);
+            s->active = (cs & SPI0_CS_TA) != 0;
+            s->regs[SPI0_CS] = cs;
+        }
+        else if (reg == SPI0_FIFO && (cs & SPI0_CS_TA) && s->txCount < SPI0_FIFO_DEPTH)
+        {
+            s->tx[(s->txHead + s->txCount) % SPI0_FIFO_DEPTH] = s->regs[SPI0_FIFO] & 0xFF;
+            s->txCount++;
+        }
+        Standin_Shift(s);
+        return;
+    }
+
+    s->reads++;
+    Standin_Shift(s);
+    if (reg == SPI0_FIFO)
+    {
+        s->regs[SPI0_FIFO] = s->rxCount ? s->rx[s->rxHead] : 0;
+        if (s->rxCount)
+        {
+            s->rxHead = (s->rxHead + 1) % SPI0_FIFO_DEPTH;
+            s->rxCount--;
+        }
+        Standin_Shift(s);
+        return;
+    }
+    cs &= ~(SPI0_CS_DONE | SPI0_CS_RXD | SPI0_CS_TXD | SPI0_CS_RXR | SPI0_CS_RXF);
+    if (!s->txCount)
+        cs |= SPI0_CS_DONE;
+    if (s->txCount < SPI0_FIFO_DEPTH)
+        cs |= SPI0_CS_TXD;
+    if (s->rxCount)
+        cs |= SPI0_CS_RXD;
+    if (s->rxCount >= SPI0_FIFO_DEPTH * 3 / 4)
+        cs |= SPI0_CS_RXR;
+    if (s->rxCount == SPI0_FIFO_DEPTH)
+        cs |= SPI0_CS_RXF;
+    s->regs[SPI0_CS] = cs;
+}
+
+
+/*******************************************************************************
+* Function Name  : SPI0_StandinInit
+* Description    : Registers in memory behaving as SPI0 for SPI0_Write
+* Input          : - standin: stand-in
+*                  - sink: called with the bytes of each transfer
+*                  - ctx: first argument of sink
+* Output         : - port: registers to give SPI0_Write
+* Return         : None
+* Attention      : Only SPI0_CS and SPI0_FIFO are modelled, the stand-in
+*                  has no DMA
+*******************************************************************************/
+void SPI0_StandinInit(SPI0_Standin *standin, SPI0_Port *port, SPI0_Sink sink, void *ctx)
+{
+    memset(standin, 0, sizeof(*standin));
+    standin->regs[SPI0_CS] = SPI0_CS_DONE | SPI0_CS_TXD;
+    standin->sink = sink;
+    standin->sinkCtx = ctx;
+    port->regs = standin->regs;
+    port->sync = Standin_Sync;
+    port->ctx = standin;
+}
+
+
+/*******************************************************************************
+* Function Name  : SPI0_StandinFree
+* Description    : Release the transfer buffer of a stand-in
+* Input          : - standin: stand-in
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void SPI0_StandinFree(SPI0_Standin *standin)
+{
+    free(standin->data);
+    standin->data = 0;
+    standin->len = standin->size = 0;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
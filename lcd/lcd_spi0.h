@@ -0,0 +1,72 @@
+/*******************************************************************************
+* File Name      : lcd_spi0.h
+* Description    : Write only transfers on the SPI0 registers of the BCM2835
+*                  The TX FIFO is kept full and the bytes the RX FIFO
+*                  receives meanwhile are discarded in bulk, nothing is
+*                  stored back into the buffer
+*                  The registers are the ones mapped by the bcm2835 library,
+*                  or a stand-in in memory running the same code on a host
+*******************************************************************************/
+#ifndef __LCD_SPI0_H
+#define __LCD_SPI0_H
+
+/* Defines */
+/* Registers, word offsets from the SPI0 base */
+#define SPI0_CS 0
+#define SPI0_FIFO 1
+#define SPI0_CLK 2
+#define SPI0_DLEN 3
+
+/* Bits of SPI0_CS */
+#define SPI0_CS_CLEAR_TX 0x00000010
+#define SPI0_CS_CLEAR_RX 0x00000020
+#define SPI0_CS_TA       0x00000080     /* transfer active, CS asserted */
+#define SPI0_CS_DONE     0x00010000     /* TX FIFO empty, last byte clocked */
+#define SPI0_CS_RXD      0x00020000     /* RX FIFO holds a byte */
+#define SPI0_CS_TXD      0x00040000     /* TX FIFO has room for a byte */
+#define SPI0_CS_RXR      0x00080000     /* RX FIFO 3/4 full */
+#define SPI0_CS_RXF      0x00100000     /* RX FIFO full, the clock stops */
+
+#define SPI0_FIFO_DEPTH 16
+#define SPI0_RX_BULK 12             /* bytes sure to be in the RX FIFO when RXR is set */
+
+
+/* Types */
+typedef struct
+{
+    volatile unsigned int *regs;    /* SPI0 register block */
+    /* model of a stand-in, called before each register read and after
+       each register write; 0 on the chip */
+    void (*sync)(void *ctx, unsigned int reg, int write);
+    void *ctx;
+} SPI0_Port;
+
+typedef void (*SPI0_Sink)(void *ctx, char *buf, unsigned int len);
+
+/* Registers in memory and the FIFOs behind them */
+typedef struct
+{
+    unsigned int regs[4];
+    unsigned char tx[SPI0_FIFO_DEPTH], rx[SPI0_FIFO_DEPTH];
+    unsigned int txHead, txCount, rxHead, rxCount;
+    int active;                     /* TA set by the last CS write */
+    char *data;                     /* bytes clocked out by the transfer */
+    unsigned int len, size;
+    SPI0_Sink sink;                 /* gets each transfer when TA drops */
+    void *sinkCtx;
+    unsigned long reads, writes;    /* register accesses, the CPU work */
+} SPI0_Standin;
+
+
+/* Function declarations */
+void SPI0_Write(const SPI0_Port *port, const char *head, unsigned int headLen,
+                const char *buf, unsigned int len);
+void SPI0_StandinInit(SPI0_Standin *standin, SPI0_Port *port, SPI0_Sink sink, void *ctx);
+void SPI0_StandinFree(SPI0_Standin *standin);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
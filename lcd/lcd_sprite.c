@@ -0,0 +1,295 @@
+/*******************************************************************************
+* File Name      : lcd_sprite.c
+* Description    : Sprites with host cached save-under backgrounds
+*                  A move sends the rectangle covering the old and the new
+*                  position once, composited in memory; only the part of it
+*                  that the sprite did not cover is read back from the panel
+*******************************************************************************/
+/* Includes */
+#include <stdlib.h>
+#include <string.h>
+#include "lcd.h"
+#include "lcd_stats.h"
+#include "lcd_sprite.h"
+
+
+/* Types */
+typedef struct
+{
+    unsigned short x, y, w, h;
+} SpriteRect;
+
+
+/*******************************************************************************
+* Function Name  : Sprite_Copy
+* Description    : Copy a rectangle between two pixel buffers
+* Input          : - src: source buffer, srcW pixels per line
+*                  - sx, sy: upper left corner in the source
+*                  - w, h: size of the rectangle
+*                  - dstW: pixels per line of the destination
+*                  - dx, dy: upper left corner in the destination
+* Output         : - dst: destination buffer
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Sprite_Copy(const unsigned short *src, unsigned short srcW, unsigned short sx, unsigned short sy,
+                        unsigned short w, unsigned short h,
+                        unsigned short *dst, unsigned short dstW, unsigned short dx, unsigned short dy)
+{
+    unsigned short j;
+
+    for (j = 0; j < h; j++)
+        memcpy(dst + (unsigned long)(dy + j) * dstW + dx,
+               src + (unsigned long)(sy + j) * srcW + sx, w * sizeof(unsigned short));
+}
+
+
+/*******************************************************************************
+* Function Name  : Sprite_Draw
+* Description    : Draw the opaque pixels of the sprite into a buffer
+* Input          : - sprite: sprite
+*                  - dstW: pixels per line of the destination
+*                  - dx, dy: position of the sprite in the destination
+* Output         : - dst: destination buffer
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Sprite_Draw(const Sprite *sprite, unsigned short *dst, unsigned short dstW,
+                        unsigned short dx, unsigned short dy)
+{
+    const unsigned short *src = sprite->pixels;
+    unsigned short *line;
+    unsigned short i, j;
+
+    for (j = 0; j < sprite->h; j++)
+    {
+        line = dst + (unsigned long)(dy + j) * dstW + dx;
+        for (i = 0; i < sprite->w; i++, src++)
+        {
+            if (*src != sprite->key)
+                line[i] = *src;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Sprite_ReadBand
+* Description    : Read a rectangle of the screen into a larger buffer
+* Input          : - band: rectangle on the screen, may be empty
+*                  - area: rectangle the buffer covers
+*                  - tmp: buffer for the read, band size at least
+* Output         : - dst: buffer of area size
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Sprite_ReadBand(SpriteRect band, SpriteRect area, unsigned short *dst, unsigned short *tmp)
+{
+    if (!band.w || !band.h)
+        return;
+    if (band.w == area.w)       /* whole lines, read in place */
+    {
+        LCD_ReadRect(band.x, band.y, band.w, band.h, dst + (unsigned long)(band.y - area.y) * area.w);
+        return;
+    }
+    LCD_ReadRect(band.x, band.y, band.w, band.h, tmp);
+    Sprite_Copy(tmp, band.w, 0, 0, band.w, band.h, dst, area.w, band.x - area.x, band.y - area.y);
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SpriteCreate
+* Description    : Create a hidden sprite
+* Input          : - pixels: w * h RGB565 colors, line by line, kept by
+*                    reference and read on every show and move
+*                  - w, h: size
+*                  - key: color drawn as transparent
+* Output         : - sprite: sprite to use with the other functions
+* Return         : 1 success, 0 out of memory
+* Attention      : Free it with LCD_SpriteFree
+*******************************************************************************/
+int LCD_SpriteCreate(Sprite *sprite, const unsigned short *pixels, unsigned short w, unsigned short h, unsigned short key)
+{
+    unsigned long size = (unsigned long)w * h;
+
+    memset(sprite, 0, sizeof(*sprite));
+    if (!size)
+        return 0;
+    sprite->w = w;
+    sprite->h = h;
+    sprite->pixels = pixels;
+    sprite->key = key;
+    sprite->under = malloc(size * sizeof(unsigned short));
+    /* a move is done at once while the union is at most 2 sprites large,
+       bands read need as much again */
+    sprite->work = malloc(4 * size * sizeof(unsigned short));
+    if (!sprite->under || !sprite->work)
+    {
+        LCD_SpriteFree(sprite);
+        return 0;
+    }
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SpriteFree
+* Description    : Release the memory of a sprite
+* Input          : - sprite: sprite
+* Output         : None
+* Return         : None
+* Attention      : The sprite is left on the screen if visible
+*******************************************************************************/
+void LCD_SpriteFree(Sprite *sprite)
+{
+    free(sprite->under);
+    free(sprite->work);
+    sprite->under = 0;
+    sprite->work = 0;
+    sprite->visible = 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SpriteShow
+* Description    : Save the screen under a position and draw the sprite there
+* Input          : - sprite: sprite
+*                  - Xpos, Ypos: upper left corner
+* Output         : None
+* Return         : 1 success, 0 not entirely on the screen
+* Attention      : A visible sprite is moved instead. The read, the window
+*                  and the burst are one LCD_Lock section
+*******************************************************************************/
+int LCD_SpriteShow(Sprite *sprite, unsigned short Xpos, unsigned short Ypos)
+{
+    unsigned long size = (unsigned long)sprite->w * sprite->h;
+
+    if (sprite->visible)
+        return LCD_SpriteMove(sprite, Xpos, Ypos);
+
+    STATS_ENTER(STATS_LCD_SPRITESHOW);
+    LCD_Lock();
+    if (!LCD_ReadRect(Xpos, Ypos, sprite->w, sprite->h, sprite->under))
+    {
+        LCD_Unlock();
+        STATS_LEAVE();
+        return 0;
+    }
+    memcpy(sprite->work, sprite->under, size * sizeof(unsigned short));
+    Sprite_Draw(sprite, sprite->work, sprite->w, 0, 0);
+    LCD_SetWindow(Xpos, Ypos, sprite->w, sprite->h);
+    LCD_WritePixels(sprite->work, size);
+    sprite->x = Xpos;
+    sprite->y = Ypos;
+    sprite->visible = 1;
+    LCD_Unlock();
+    STATS_LEAVE();
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SpriteHide
+* Description    : Put back the screen saved under the sprite
+* Input          : - sprite: sprite
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_SpriteHide(Sprite *sprite)
+{
+    if (!sprite->visible)
+        return;
+    STATS_ENTER(STATS_LCD_SPRITEHIDE);
+    LCD_Lock();
+    LCD_SetWindow(sprite->x, sprite->y, sprite->w, sprite->h);
+    LCD_WritePixels(sprite->under, (unsigned long)sprite->w * sprite->h);
+    sprite->visible = 0;
+    LCD_Unlock();
+    STATS_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_SpriteMove
+* Description    : Move a sprite, or just set its position if hidden
+* Input          : - sprite: sprite
+*                  - Xpos, Ypos: new upper left corner
+* Output         : None
+* Return         : 1 success, 0 not entirely on the screen
+* Attention      : The rectangle covering both positions is written once;
+*                  if it is larger than the two sprites together the move is
+*                  a hide and a show. Sprites that overlap each other must be
+*                  moved hidden, in the reverse order of their showing. The
+*                  reads of the bands, the window and the burst are one
+*                  LCD_Lock section
+*******************************************************************************/
+int LCD_SpriteMove(Sprite *sprite, unsigned short Xpos, unsigned short Ypos)
+{
+    SpriteRect o, u, band;
+    unsigned long size = (unsigned long)sprite->w * sprite->h;
+    unsigned short *bg = sprite->work, *tmp = sprite->work + 2 * size;
+
+    if (Xpos + sprite->w > LCD_GetWidth() || Ypos + sprite->h > LCD_GetHeight())
+        return 0;
+    if (!sprite->visible)
+    {
+        sprite->x = Xpos;
+        sprite->y = Ypos;
+        return 1;
+    }
+    if (Xpos == sprite->x && Ypos == sprite->y)
+        return 1;
+
+    STATS_ENTER(STATS_LCD_SPRITEMOVE);
+    LCD_Lock();
+    o.x = sprite->x;
+    o.y = sprite->y;
+    o.w = sprite->w;
+    o.h = sprite->h;
+    u.x = Xpos < o.x ? Xpos : o.x;
+    u.y = Ypos < o.y ? Ypos : o.y;
+    u.w = (Xpos > o.x ? Xpos : o.x) + o.w - u.x;
+    u.h = (Ypos > o.y ? Ypos : o.y) + o.h - u.y;
+
+    if ((unsigned long)u.w * u.h > 2 * size)
+    {
+        /* far jump: the union would mostly be background read for nothing */
+        LCD_SpriteHide(sprite);
+        LCD_SpriteShow(sprite, Xpos, Ypos);
+        LCD_Unlock();
+        STATS_LEAVE();
+        return 1;
+    }
+
+    /* background of the union: saved under the old position, read from
+       the screen around it (bands above, below, left and right) */
+    Sprite_Copy(sprite->under, o.w, 0, 0, o.w, o.h, bg, u.w, o.x - u.x, o.y - u.y);
+    band.x = u.x; band.w = u.w;
+    band.y = u.y; band.h = o.y - u.y;
+    Sprite_ReadBand(band, u, bg, tmp);
+    band.y = o.y + o.h; band.h = u.y + u.h - band.y;
+    Sprite_ReadBand(band, u, bg, tmp);
+    band.y = o.y; band.h = o.h;
+    band.x = u.x; band.w = o.x - u.x;
+    Sprite_ReadBand(band, u, bg, tmp);
+    band.x = o.x + o.w; band.w = u.x + u.w - band.x;
+    Sprite_ReadBand(band, u, bg, tmp);
+
+    /* save under the new position, then composite and send the union */
+    Sprite_Copy(bg, u.w, Xpos - u.x, Ypos - u.y, o.w, o.h, sprite->under, o.w, 0, 0);
+    Sprite_Draw(sprite, bg, u.w, Xpos - u.x, Ypos - u.y);
+    LCD_SetWindow(u.x, u.y, u.w, u.h);
+    LCD_WritePixels(bg, (unsigned long)u.w * u.h);
+
+    sprite->x = Xpos;
+    sprite->y = Ypos;
+    LCD_Unlock();
+    STATS_LEAVE();
+    return 1;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
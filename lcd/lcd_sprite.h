@@ -0,0 +1,36 @@
+/*******************************************************************************
+* File Name      : lcd_sprite.h
+* Description    : Sprites: small RGB565 images with a color key moved over
+*                  the screen; the background under each visible sprite is
+*                  kept in host memory so that it never has to be redrawn
+*******************************************************************************/
+#ifndef __LCD_SPRITE_H
+#define __LCD_SPRITE_H
+
+
+/* Types */
+typedef struct
+{
+    unsigned short x, y;            /* upper left corner on the screen */
+    unsigned short w, h;
+    const unsigned short *pixels;   /* w * h RGB565, line by line */
+    unsigned short key;             /* color of the transparent pixels */
+    unsigned char visible;
+    unsigned short *under;          /* w * h screen pixels under the sprite */
+    unsigned short *work;           /* union of two positions, and bands read */
+} Sprite;
+
+
+/* Function declarations */
+int LCD_SpriteCreate(Sprite *sprite, const unsigned short *pixels, unsigned short w, unsigned short h, unsigned short key);
+void LCD_SpriteFree(Sprite *sprite);
+int LCD_SpriteShow(Sprite *sprite, unsigned short Xpos, unsigned short Ypos);
+void LCD_SpriteHide(Sprite *sprite);
+int LCD_SpriteMove(Sprite *sprite, unsigned short Xpos, unsigned short Ypos);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,385 @@
+/*******************************************************************************
+* File Name      : lcd_stats.c
+* Description    : SPI traffic accounting per public API of the driver
+* Compile/link   : gcc -DLCD_STATS -o spi -lrt main.c lcd.c lcd_trace.c lcd_bcm2835.c lcd_spi0.c lcd_stats.c -lbcm2835 -lm -lpthread
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "lcd.h"
+#include "lcd_stats.h"
+
+
+/* Defines */
+#define STATS_DEPTH 16      /* deepest nesting of public APIs tracked */
+
+/* Counters are shared by the threads, each drawing on its own device or
+   on one device in turn: they only change by atomic adds */
+#define STATS_ADD(counter, n)   __sync_fetch_and_add(&(counter), (n))
+#define STATS_READ(counter)     __sync_fetch_and_add(&(counter), 0)
+#define STATS_ZERO(counter)     __sync_fetch_and_and(&(counter), 0)
+
+
+/* Types */
+typedef struct
+{
+    StatsApi api;
+    unsigned char counted;  /* 0 if api is already active lower in the stack */
+    struct timespec start;
+} StatsFrame;
+
+
+/* Public declarations */
+static const char *StatsNames[STATS_API_COUNT] = {
+#define STATS_NAME(id, name) name,
+    STATS_API_LIST(STATS_NAME)
+#undef STATS_NAME
+};
+
+#ifdef LCD_STATS
+static StatsCounter Counters[STATS_API_COUNT];
+/* call stack of each thread */
+static __thread unsigned char Active[STATS_API_COUNT];
+static __thread StatsFrame Stack[STATS_DEPTH];
+static __thread int Depth;
+static __thread int Suspended;
+static __thread int LastCs = -1;
+
+
+/*******************************************************************************
+* Function Name  : Stats_Enter
+* Description    : Mark the entry in a public API
+* Input          : - api: API being entered
+* Output         : None
+* Return         : None
+* Attention      : Must be paired with Stats_Leave before every return
+*******************************************************************************/
+void Stats_Enter(StatsApi api)
+{
+    StatsFrame *frame;
+
+    if (Depth >= STATS_DEPTH)
+    {
+        Depth++;
+        return;
+    }
+    frame = &Stack[Depth++];
+    frame->api = api;
+    frame->counted = !Suspended && Active[api]++ == 0;
+    if (frame->counted)
+    {
+        STATS_ADD(Counters[api].calls, 1);
+        clock_gettime(CLOCK_MONOTONIC, &frame->start);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Stats_Leave
+* Description    : Mark the exit from the last entered public API
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void Stats_Leave(void)
+{
+    StatsFrame *frame;
+    struct timespec now;
+
+    if (Depth == 0)
+        return;
+    if (--Depth >= STATS_DEPTH)
+        return;
+    frame = &Stack[Depth];
+    if (frame->counted)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        STATS_ADD(Counters[frame->api].ns, (now.tv_sec - frame->start.tv_sec) * 1000000000LL
+                                           + (now.tv_nsec - frame->start.tv_nsec));
+        Active[frame->api]--;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Stats_Transfer
+* Description    : Account one SPI transfer to every active API
+* Input          : - len: bytes clocked on the bus
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void Stats_Transfer(unsigned int len)
+{
+    int i, top;
+
+    if (Suspended)
+        return;
+    top = Depth < STATS_DEPTH ? Depth : STATS_DEPTH;
+    if (top == 0)
+    {
+        STATS_ADD(Counters[STATS_OTHER].bytes, len);
+        STATS_ADD(Counters[STATS_OTHER].transactions, 1);
+        return;
+    }
+    for (i = 0; i < top; i++)
+    {
+        if (Stack[i].counted)
+        {
+            STATS_ADD(Counters[Stack[i].api].bytes, len);
+            STATS_ADD(Counters[Stack[i].api].transactions, 1);
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Stats_RegWrite
+* Description    : Account one register write to every active API
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void Stats_RegWrite(void)
+{
+    int i, top;
+
+    if (Suspended)
+        return;
+    top = Depth < STATS_DEPTH ? Depth : STATS_DEPTH;
+    if (top == 0)
+        STATS_ADD(Counters[STATS_OTHER].regWrites, 1);
+    for (i = 0; i < top; i++)
+    {
+        if (Stack[i].counted)
+            STATS_ADD(Counters[Stack[i].api].regWrites, 1);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : Stats_ChipSelect
+* Description    : Account a chip select change to every active API
+* Input          : - cs: chip select now driven
+* Output         : None
+* Return         : None
+* Attention      : Selecting the chip already selected is not a switch
+*******************************************************************************/
+void Stats_ChipSelect(unsigned char cs)
+{
+    int i, top;
+
+    if (LastCs == cs)
+        return;
+    LastCs = cs;
+    if (Suspended)
+        return;
+    top = Depth < STATS_DEPTH ? Depth : STATS_DEPTH;
+    if (top == 0)
+        STATS_ADD(Counters[STATS_OTHER].csSwitches, 1);
+    for (i = 0; i < top; i++)
+    {
+        if (Stack[i].counted)
+            STATS_ADD(Counters[Stack[i].api].csSwitches, 1);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_StatsReset
+* Description    : Zero all counters
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : APIs active at the time keep being measured
+*******************************************************************************/
+void LCD_StatsReset(void)
+{
+    int i;
+
+    for (i = 0; i < STATS_API_COUNT; i++)
+    {
+        STATS_ZERO(Counters[i].calls);
+        STATS_ZERO(Counters[i].bytes);
+        STATS_ZERO(Counters[i].transactions);
+        STATS_ZERO(Counters[i].regWrites);
+        STATS_ZERO(Counters[i].csSwitches);
+        STATS_ZERO(Counters[i].ns);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_StatsGet
+* Description    : Copy the counters of one API
+* Input          : - api: API to query
+* Output         : - counter: copy of the counters
+* Return         : 1 success, 0 if stats are not compiled in
+* Attention      : Each counter is read whole, not all of them at one time
+*******************************************************************************/
+int LCD_StatsGet(StatsApi api, StatsCounter *counter)
+{
+    StatsCounter *c;
+
+    if (api >= STATS_API_COUNT)
+        return 0;
+    c = &Counters[api];
+    counter->calls = STATS_READ(c->calls);
+    counter->bytes = STATS_READ(c->bytes);
+    counter->transactions = STATS_READ(c->transactions);
+    counter->regWrites = STATS_READ(c->regWrites);
+    counter->csSwitches = STATS_READ(c->csSwitches);
+    counter->ns = STATS_READ(c->ns);
+    return 1;
+}
+
+#else
+
+void Stats_Enter(StatsApi api) { (void)api; }
+void Stats_Leave(void) { }
+void Stats_Transfer(unsigned int len) { (void)len; }
+void Stats_RegWrite(void) { }
+void Stats_ChipSelect(unsigned char cs) { (void)cs; }
+void LCD_StatsReset(void) { }
+
+int LCD_StatsGet(StatsApi api, StatsCounter *counter)
+{
+    (void)api;
+    memset(counter, 0, sizeof(*counter));
+    return 0;
+}
+
+#endif
+
+
+/*******************************************************************************
+* Function Name  : LCD_StatsName
+* Description    : Printable name of an API
+* Input          : - api: API to query
+* Output         : None
+* Return         : API name
+* Attention      : None
+*******************************************************************************/
+const char *LCD_StatsName(StatsApi api)
+{
+    if (api >= STATS_API_COUNT)
+        return "?";
+    return StatsNames[api];
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_StatsDumpText
+* Description    : Print a table of the APIs that were called
+* Input          : - out: destination stream
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_StatsDumpText(FILE *out)
+{
+    StatsCounter c;
+    int i;
+
+    if (!LCD_StatsGet(STATS_OTHER, &c))
+    {
+        fprintf(out, "stats disabled, rebuild with -DLCD_STATS\n");
+        return;
+    }
+    fprintf(out, "%-20s %8s %12s %10s %9s %6s %12s\n",
+            "api", "calls", "bytes", "xfers", "regs", "cs", "us");
+    for (i = 0; i < STATS_API_COUNT; i++)
+    {
+        LCD_StatsGet((StatsApi)i, &c);
+        if (c.calls == 0 && c.transactions == 0)
+            continue;
+        fprintf(out, "%-20s %8lu %12llu %10lu %9lu %6lu %12llu\n",
+                StatsNames[i], c.calls, c.bytes, c.transactions,
+                c.regWrites, c.csSwitches, c.ns / 1000);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_StatsDumpJSON
+* Description    : Print all counters as a JSON object
+* Input          : - out: destination stream
+* Output         : None
+* Return         : None
+* Attention      : APIs never called are left out
+*******************************************************************************/
+void LCD_StatsDumpJSON(FILE *out)
+{
+    StatsCounter c;
+    int i, first = 1;
+
+    fprintf(out, "{\"enabled\": %s, \"apis\": [", LCD_StatsGet(STATS_OTHER, &c) ? "true" : "false");
+    for (i = 0; i < STATS_API_COUNT; i++)
+    {
+        LCD_StatsGet((StatsApi)i, &c);
+        if (c.calls == 0 && c.transactions == 0)
+            continue;
+        fprintf(out, "%s\n  {\"name\": \"%s\", \"calls\": %lu, \"bytes\": %llu, "
+                "\"transactions\": %lu, \"reg_writes\": %lu, \"cs_switches\": %lu, \"ns\": %llu}",
+                first ? "" : ",", StatsNames[i], c.calls, c.bytes, c.transactions,
+                c.regWrites, c.csSwitches, c.ns);
+        first = 0;
+    }
+    fprintf(out, "\n]}\n");
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_StatsOverlay
+* Description    : Draw the busiest APIs as text on the display
+* Input          : - Xpos: Horizontal coordinate of the upper left corner
+*                  - Ypos: Vertical coordinate of the upper left corner
+*                  - lines: number of APIs to show, ordered by SPI bytes
+* Output         : None
+* Return         : None
+* Attention      : The overlay traffic itself is not accounted
+*******************************************************************************/
+void LCD_StatsOverlay(unsigned short Xpos, unsigned short Ypos, unsigned char lines)
+{
+    StatsCounter c, best;
+    unsigned char shown[STATS_API_COUNT];
+    char text[48];
+    int i, n, pick;
+
+#ifdef LCD_STATS
+    Suspended++;
+#endif
+    memset(shown, 0, sizeof(shown));
+    LCD_Text(Xpos, Ypos, "api          kbytes      ms", Yellow, Black);
+    for (n = 0; n < lines; n++)
+    {
+        pick = -1;
+        memset(&best, 0, sizeof(best));
+        for (i = 0; i < STATS_API_COUNT; i++)
+        {
+            LCD_StatsGet((StatsApi)i, &c);
+            if (!shown[i] && c.bytes > best.bytes)
+            {
+                best = c;
+                pick = i;
+            }
+        }
+        if (pick < 0)
+            break;
+        shown[pick] = 1;
+        snprintf(text, sizeof(text), "%-12.12s %7llu %7llu",
+                 StatsNames[pick], best.bytes / 1024, best.ns / 1000000);
+        LCD_Text(Xpos, Ypos + 16 * (n + 1), text, White, Black);
+    }
+#ifdef LCD_STATS
+    Suspended--;
+#endif
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,111 @@
+/*******************************************************************************
+* File Name      : lcd_stats.h
+* Description    : SPI traffic accounting per public API of the driver
+*                  Compiled in with -DLCD_STATS, without it every hook is empty
+*                  and the report functions print that stats are disabled
+*                  The counters add up the traffic of all the devices
+*******************************************************************************/
+#ifndef __LCD_STATS_H
+#define __LCD_STATS_H
+
+/* Includes */
+#include <stdio.h>
+
+
+/* Defines */
+
+/* Public APIs the traffic is attributed to: id, printable name */
+#define STATS_API_LIST(X) \
+    X(STATS_OTHER,              "(other)")              \
+    X(STATS_LCD_RESET,          "LCD_Reset")            \
+    X(STATS_LCD_INIT,           "LCD_Init")             \
+    X(STATS_LCD_CLEAR,          "LCD_Clear")            \
+    X(STATS_LCD_TEXT,           "LCD_Text")             \
+    X(STATS_PUTCHAR,            "PutChar")              \
+    X(STATS_LCD_SETPOINT,       "LCD_SetPoint")         \
+    X(STATS_LCD_SETPOINTS,      "LCD_SetPoints")        \
+    X(STATS_LCD_GETPOINT,       "LCD_GetPoint")         \
+    X(STATS_LCD_DRAWLINE,       "LCD_DrawLine")         \
+    X(STATS_LCD_DRAWBOX,        "LCD_DrawBox")          \
+    X(STATS_LCD_DRAWCIRCLE,     "LCD_DrawCircle")       \
+    X(STATS_LCD_DRAWCIRCLEFILL, "LCD_DrawCircleFill")   \
+    X(STATS_LCD_PUTIMAGE,       "LCD_PutImage")         \
+    X(STATS_LCD_FILLRECT,       "LCD_FillRect")         \
+    X(STATS_LCD_READRECT,       "LCD_ReadRect")         \
+    X(STATS_LCD_SCREENSHOT,     "LCD_Screenshot")       \
+    X(STATS_LCD_SPRITESHOW,     "LCD_SpriteShow")       \
+    X(STATS_LCD_SPRITEHIDE,     "LCD_SpriteHide")       \
+    X(STATS_LCD_SPRITEMOVE,     "LCD_SpriteMove")       \
+    X(STATS_LCD_COMPOSE,        "LCD_Compose")          \
+    X(STATS_UI_UPDATE,          "UI_Update")            \
+    X(STATS_LCD_READREG,        "LCD_ReadReg")          \
+    X(STATS_LCD_DISPLAYON,      "LCD_DisplayOn")        \
+    X(STATS_LCD_DISPLAYOFF,     "LCD_DisplayOff")       \
+    X(STATS_READ_ADS7846,       "Read_Ads7846")         \
+    X(STATS_READ_X,             "Read_X")               \
+    X(STATS_READ_Y,             "Read_Y")               \
+    X(STATS_TP_CAL,             "TP_Cal")               \
+    X(STATS_TP_DRAWPOINT,       "TP_DrawPoint")         \
+    X(STATS_DRAWCROSS,          "DrawCross")            \
+    X(STATS_LCD_TUNEDIVIDERS,   "LCD_TuneDividers")     \
+    X(STATS_LCD_SCENERENDER,    "LCD_SceneRender")      \
+    X(STATS_LCD_BLITSCALED,     "LCD_BlitScaled")       \
+    X(STATS_TM_FLUSH,           "TM_Flush")
+
+#ifdef LCD_STATS
+#define STATS_ENTER(api)        Stats_Enter(api)
+#define STATS_LEAVE()           Stats_Leave()
+#define STATS_TRANSFER(len)     Stats_Transfer(len)
+#define STATS_REGWRITE()        Stats_RegWrite()
+#define STATS_CHIPSELECT(cs)    Stats_ChipSelect(cs)
+#else
+#define STATS_ENTER(api)        do { } while (0)
+#define STATS_LEAVE()           do { } while (0)
+#define STATS_TRANSFER(len)     do { } while (0)
+#define STATS_REGWRITE()        do { } while (0)
+#define STATS_CHIPSELECT(cs)    do { } while (0)
+#endif
+
+
+/* Types */
+typedef enum
+{
+#define STATS_ENUM(id, name) id,
+    STATS_API_LIST(STATS_ENUM)
+#undef STATS_ENUM
+    STATS_API_COUNT
+} StatsApi;
+
+/* Counters are inclusive: traffic of LCD_SetPoint called by LCD_DrawLine
+   is also accounted to LCD_DrawLine */
+typedef struct
+{
+    unsigned long calls;
+    unsigned long long bytes;           /* SPI bytes, start bytes included */
+    unsigned long transactions;         /* SPI transfers, one CS assertion each */
+    unsigned long regWrites;            /* LCD_WriteReg calls */
+    unsigned long csSwitches;           /* changes between CS0 and CS1 */
+    unsigned long long ns;              /* wall time spent inside the API */
+} StatsCounter;
+
+
+/* Function declarations */
+void Stats_Enter(StatsApi api);
+void Stats_Leave(void);
+void Stats_Transfer(unsigned int len);
+void Stats_RegWrite(void);
+void Stats_ChipSelect(unsigned char cs);
+
+void LCD_StatsReset(void);
+const char *LCD_StatsName(StatsApi api);
+int LCD_StatsGet(StatsApi api, StatsCounter *counter);
+void LCD_StatsDumpText(FILE *out);
+void LCD_StatsDumpJSON(FILE *out);
+void LCD_StatsOverlay(unsigned short Xpos, unsigned short Ypos, unsigned char lines);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
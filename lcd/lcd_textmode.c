@@ -0,0 +1,215 @@
+/*******************************************************************************
+* File Name      : lcd_textmode.c
+* Description    : Text mode of 8x16 character cells, see lcd_textmode.h
+*                  A run of changed cells of a row is drawn into one buffer
+*                  and sent through one window: a changed digit costs 128
+*                  pixels, not the line or the screen
+*******************************************************************************/
+/* Includes */
+#include <string.h>
+#include "lcd.h"
+#include "lcd_stats.h"
+#include "lcd_textmode.h"
+#include "AsciiLib.h"
+
+
+/*******************************************************************************
+* Function Name  : TM_Same
+* Description    : Two cells look the same
+* Input          : - a, b: cells
+* Output         : None
+* Return         : 1 same pixels, 0 different
+* Attention      : The character color of a space does not show
+*******************************************************************************/
+static int TM_Same(const TextCell *a, const TextCell *b)
+{
+    return a->ch == b->ch && a->bg == b->bg && (a->fg == b->fg || a->ch == ' ');
+}
+
+
+/*******************************************************************************
+* Function Name  : TM_Render
+* Description    : Draw the visible part of a run of cells
+* Input          : - cells: first cell of the run
+*                  - n: number of cells
+*                  - span: visible part of the run, from LCD_ImageWindow
+* Output         : - pixels: span->w * span->h colors, line by line
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void TM_Render(const TextCell *cells, int n, const LCD_ImageSpan *span, unsigned short *pixels)
+{
+    unsigned char glyph[TM_COLS][16];
+    const TextCell *c;
+    unsigned int i, x;
+    int k;
+
+    for (k = 0; k < n; k++)
+        GetASCIICode(glyph[k], cells[k].ch);
+    for (i = span->sy; i < (unsigned int)span->sy + span->h; i++)
+    {
+        for (x = span->sx; x < (unsigned int)span->sx + span->w; x++)
+        {
+            c = cells + (x >> 3);
+            *pixels++ = (glyph[x >> 3][i] >> (7 - (x & 7))) & 1 ? c->fg : c->bg;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : TM_Init
+* Description    : Blank grid, drawn whole by the next TM_Flush
+* Input          : - tm: grid
+*                  - Xpos, Ypos: upper left corner on the screen
+*                  - fg, bg: colors of the cells
+* Output         : None
+* Return         : None
+* Attention      : TM_COLS x TM_ROWS fills the screen in portrait; in
+*                  landscape the rows below the screen are clipped
+*******************************************************************************/
+void TM_Init(TextMode *tm, short Xpos, short Ypos, unsigned short fg, unsigned short bg)
+{
+    tm->x = Xpos;
+    tm->y = Ypos;
+    TM_Clear(tm, fg, bg);
+    tm->valid = 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : TM_Clear
+* Description    : Set every cell to a space
+* Input          : - tm: grid
+*                  - fg, bg: colors of the cells
+* Output         : None
+* Return         : None
+* Attention      : Drawn by the next TM_Flush
+*******************************************************************************/
+void TM_Clear(TextMode *tm, unsigned short fg, unsigned short bg)
+{
+    int row, col;
+
+    for (row = 0; row < TM_ROWS; row++)
+    {
+        for (col = 0; col < TM_COLS; col++)
+        {
+            tm->cells[row][col].ch = ' ';
+            tm->cells[row][col].fg = fg;
+            tm->cells[row][col].bg = bg;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : TM_Put
+* Description    : Set one cell
+* Input          : - tm: grid
+*                  - col, row: cell
+*                  - ch: character
+*                  - fg, bg: character and background colors
+* Output         : None
+* Return         : None
+* Attention      : Ignored outside the grid. Drawn by the next TM_Flush
+*******************************************************************************/
+void TM_Put(TextMode *tm, unsigned char col, unsigned char row, char ch, unsigned short fg, unsigned short bg)
+{
+    TextCell *c;
+
+    if (col >= TM_COLS || row >= TM_ROWS)
+        return;
+    c = &tm->cells[row][col];
+    c->ch = ch >= ' ' && ch <= '~' ? ch : ' ';
+    c->fg = fg;
+    c->bg = bg;
+}
+
+
+/*******************************************************************************
+* Function Name  : TM_Print
+* Description    : Set the cells of a string, left to right
+* Input          : - tm: grid
+*                  - col, row: first cell
+*                  - str: characters
+*                  - fg, bg: character and background colors
+* Output         : None
+* Return         : number of cells set
+* Attention      : Stops at the end of the row, no wrap. Drawn by the next
+*                  TM_Flush
+*******************************************************************************/
+unsigned int TM_Print(TextMode *tm, unsigned char col, unsigned char row, const char *str,
+                      unsigned short fg, unsigned short bg)
+{
+    unsigned int n = 0;
+
+    if (row >= TM_ROWS)
+        return 0;
+    for (; *str && col < TM_COLS; str++, col++, n++)
+        TM_Put(tm, col, row, *str, fg, bg);
+    return n;
+}
+
+
+/*******************************************************************************
+* Function Name  : TM_Invalidate
+* Description    : Forget what the panel shows, the next TM_Flush redraws
+*                  every cell
+* Input          : - tm: grid
+* Output         : None
+* Return         : None
+* Attention      : After something else drew over the grid, or the clip,
+*                  the viewport or the orientation changed
+*******************************************************************************/
+void TM_Invalidate(TextMode *tm)
+{
+    tm->valid = 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : TM_Flush
+* Description    : Draw the cells that changed since the last flush
+* Input          : - tm: grid
+* Output         : None
+* Return         : number of cells drawn
+* Attention      : Changed cells next to each other on a row go in one
+*                  window and one burst. The clip and the viewport apply
+*******************************************************************************/
+unsigned int TM_Flush(TextMode *tm)
+{
+    unsigned short pixels[TM_COLS * 8 * 16];
+    LCD_ImageSpan span;
+    unsigned int drawn = 0;
+    int row, c0, c1;
+
+    STATS_ENTER(STATS_TM_FLUSH);
+    LCD_Lock();
+    for (row = 0; row < TM_ROWS; row++)
+    {
+        for (c0 = 0; c0 < TM_COLS; c0 = c1)
+        {
+            c1 = c0 + 1;
+            if (tm->valid && TM_Same(&tm->cells[row][c0], &tm->sent[row][c0]))
+                continue;
+            while (c1 < TM_COLS && !(tm->valid && TM_Same(&tm->cells[row][c1], &tm->sent[row][c1])))
+                c1++;
+            if (LCD_ImageWindow(tm->x + c0 * 8, tm->y + row * 16, (c1 - c0) * 8, 16, &span))
+            {
+                TM_Render(&tm->cells[row][c0], c1 - c0, &span, pixels);
+                LCD_WritePixels(pixels, span.w * span.h);
+            }
+            memcpy(&tm->sent[row][c0], &tm->cells[row][c0], (c1 - c0) * sizeof(TextCell));
+            drawn += c1 - c0;
+        }
+    }
+    tm->valid = 1;
+    LCD_Unlock();
+    STATS_LEAVE();
+    return drawn;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,50 @@
+/*******************************************************************************
+* File Name      : lcd_textmode.h
+* Description    : Text mode: a grid of 8x16 AsciiLib character cells, each
+*                  with its own character and background colors, kept in
+*                  host memory
+*                  TM_Flush compares the grid with the copy of what was last
+*                  sent and redraws only the cells that changed, the changed
+*                  cells next to each other on a row in one window and one
+*                  burst
+*******************************************************************************/
+#ifndef __LCD_TEXTMODE_H
+#define __LCD_TEXTMODE_H
+
+
+/* Defines */
+#define TM_COLS 30                  /* MAX_X / 8, the width in portrait */
+#define TM_ROWS 20                  /* MAX_Y / 16 */
+
+
+/* Types */
+typedef struct
+{
+    unsigned char ch;               /* ' ' to '~', others show as ' ' */
+    unsigned short fg, bg;          /* character and background colors */
+} TextCell;
+
+typedef struct
+{
+    short x, y;                     /* upper left corner on the screen */
+    TextCell cells[TM_ROWS][TM_COLS];   /* what the grid should show */
+    TextCell sent[TM_ROWS][TM_COLS];    /* what the panel shows */
+    unsigned char valid;            /* 0: sent is unknown, redraw all */
+} TextMode;
+
+
+/* Function declarations */
+void TM_Init(TextMode *tm, short Xpos, short Ypos, unsigned short fg, unsigned short bg);
+void TM_Clear(TextMode *tm, unsigned short fg, unsigned short bg);
+void TM_Put(TextMode *tm, unsigned char col, unsigned char row, char ch, unsigned short fg, unsigned short bg);
+unsigned int TM_Print(TextMode *tm, unsigned char col, unsigned char row, const char *str,
+                      unsigned short fg, unsigned short bg);
+void TM_Invalidate(TextMode *tm);
+unsigned int TM_Flush(TextMode *tm);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
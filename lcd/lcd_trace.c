@@ -0,0 +1,359 @@
+/*******************************************************************************
+* File Name      : lcd_trace.c
+* Description    : Recording of the SPI command stream into a binary trace
+*                  and reading it back, layout in lcd_trace.h
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lcd_trace.h"
+
+
+/* Defines */
+#define SPI_START (0x70)   /* Start byte for SPI transfer */
+#define SPI_DATA (0x02)    /* RS bit 1 within start byte */
+
+#define TRACE_BUFFER 65536
+
+
+/* Public declarations */
+FILE *TraceFile;
+static unsigned long long TraceLastUs;
+static struct timespec TraceStart;
+
+
+/*******************************************************************************
+* Function Name  : Trace_Us
+* Description    : Microseconds since LCD_TraceStart
+* Input          : None
+* Output         : None
+* Return         : microseconds
+* Attention      : None
+*******************************************************************************/
+static unsigned long long Trace_Us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - TraceStart.tv_sec) * 1000000ULL
+           + now.tv_nsec / 1000 - TraceStart.tv_nsec / 1000;
+}
+
+
+/*******************************************************************************
+* Function Name  : Trace_Varint
+* Description    : Write a value 7 bits per byte, low bits first
+* Input          : - value: value to write
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Trace_Varint(unsigned long long value)
+{
+    while (value >= 0x80)
+    {
+        putc((value & 0x7F) | 0x80, TraceFile);
+        value >>= 7;
+    }
+    putc(value, TraceFile);
+}
+
+
+/*******************************************************************************
+* Function Name  : Trace_Header
+* Description    : Write the type and the time delta of a record
+* Input          : - type: TRACE_x
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Trace_Header(unsigned char type)
+{
+    unsigned long long now = Trace_Us();
+
+    putc(type, TraceFile);
+    Trace_Varint(now - TraceLastUs);
+    TraceLastUs = now;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_TraceStart
+* Description    : Start recording every bus access of the driver
+* Input          : - path: trace file to create
+* Output         : None
+* Return         : 1 success, 0 fail
+* Attention      : A running recording is stopped first
+*******************************************************************************/
+int LCD_TraceStart(const char *path)
+{
+    LCD_TraceStop();
+    TraceFile = fopen(path, "wb");
+    if (!TraceFile)
+        return 0;
+    setvbuf(TraceFile, 0, _IOFBF, TRACE_BUFFER);
+    fwrite(TRACE_MAGIC, 1, 4, TraceFile);
+    putc(TRACE_VERSION, TraceFile);
+    clock_gettime(CLOCK_MONOTONIC, &TraceStart);
+    TraceLastUs = 0;
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_TraceStop
+* Description    : Stop recording and close the trace file
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_TraceStop(void)
+{
+    if (TraceFile)
+        fclose(TraceFile);
+    TraceFile = 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : Trace_Transfer
+* Description    : Record the bytes of one transfer before they are sent
+* Input          : - buf: bytes to send
+*                  - len: number of bytes
+* Output         : None
+* Return         : None
+* Attention      : Index and data writes of one word take 4 bytes or less
+*******************************************************************************/
+void Trace_Transfer(const char *buf, unsigned int len)
+{
+    unsigned char start = buf[0];
+
+    if (len == 3 && (start & 0xFD) == SPI_START)
+    {
+        Trace_Header(start & SPI_DATA ? TRACE_DATA : TRACE_INDEX);
+        putc(buf[1], TraceFile);
+        putc(buf[2], TraceFile);
+        return;
+    }
+    Trace_Header(TRACE_TRANSFER);
+    Trace_Varint(len);
+    fwrite(buf, 1, len, TraceFile);
+}
+
+
+/*******************************************************************************
+* Function Name  : Trace_Write
+* Description    : Record the bytes of one write only transfer
+* Input          : - head: first bytes
+*                  - headLen: number of bytes of head
+*                  - buf: bytes sent after head
+*                  - len: number of bytes of buf
+* Output         : None
+* Return         : None
+* Attention      : Same record as Trace_Transfer of head and buf joined
+*******************************************************************************/
+void Trace_Write(const char *head, unsigned int headLen, const char *buf, unsigned int len)
+{
+    char word[3];
+
+    if (!len)
+    {
+        Trace_Transfer(head, headLen);
+        return;
+    }
+    if (headLen + len == 3)
+    {
+        memcpy(word, head, headLen);
+        memcpy(word + headLen, buf, len);
+        Trace_Transfer(word, 3);
+        return;
+    }
+    Trace_Header(TRACE_TRANSFER);
+    Trace_Varint(headLen + len);
+    fwrite(head, 1, headLen, TraceFile);
+    fwrite(buf, 1, len, TraceFile);
+}
+
+
+/*******************************************************************************
+* Function Name  : Trace_Select
+* Description    : Record a chip select and divider change
+* Input          : - cs: slave selected
+*                  - divider: SPI clock divider
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void Trace_Select(unsigned char cs, unsigned short divider)
+{
+    Trace_Header(TRACE_SELECT);
+    putc(cs, TraceFile);
+    putc(divider & 0xFF, TraceFile);
+    putc(divider >> 8, TraceFile);
+}
+
+
+/*******************************************************************************
+* Function Name  : Trace_Gpio
+* Description    : Record a reset or backlight pin change
+* Input          : - pin: LCD_PIN_RESET or LCD_PIN_BACKLIGHT
+*                  - level: HIGH or LOW
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void Trace_Gpio(unsigned char pin, unsigned char level)
+{
+    Trace_Header(TRACE_GPIO);
+    putc(pin, TraceFile);
+    putc(level, TraceFile);
+}
+
+
+/*******************************************************************************
+* Function Name  : Trace_ReadVarint
+* Description    : Read a value written by Trace_Varint
+* Input          : - in: trace file
+* Output         : - value: value read
+* Return         : 1 success, 0 end of file
+* Attention      : None
+*******************************************************************************/
+static int Trace_ReadVarint(FILE *in, unsigned long long *value)
+{
+    int c, shift = 0;
+
+    *value = 0;
+    do
+    {
+        c = getc(in);
+        if (c == EOF || shift > 63)
+            return 0;
+        *value |= (unsigned long long)(c & 0x7F) << shift;
+        shift += 7;
+    }
+    while (c & 0x80);
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_TraceOpen
+* Description    : Open a trace for reading
+* Input          : - path: trace file
+* Output         : - reader: reader positioned on the first record
+* Return         : 1 success, 0 fail
+* Attention      : None
+*******************************************************************************/
+int LCD_TraceOpen(TraceReader *reader, const char *path)
+{
+    char magic[5];
+
+    memset(reader, 0, sizeof(*reader));
+    reader->file = fopen(path, "rb");
+    if (!reader->file)
+        return 0;
+    if (fread(magic, 1, 5, reader->file) != 5 || memcmp(magic, TRACE_MAGIC, 4)
+        || magic[4] != TRACE_VERSION)
+    {
+        fclose(reader->file);
+        reader->file = 0;
+        return 0;
+    }
+    reader->divider = 8;
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_TraceNext
+* Description    : Read the next record
+* Input          : - reader: opened by LCD_TraceOpen
+* Output         : - reader: fields of the record, data holds the bytes to send
+* Return         : 1 record read, 0 end of trace, -1 corrupt trace
+* Attention      : None
+*******************************************************************************/
+int LCD_TraceNext(TraceReader *reader)
+{
+    unsigned long long dt, len;
+    int type, a, b, c;
+
+    type = getc(reader->file);
+    if (type == EOF)
+        return 0;
+    if (!Trace_ReadVarint(reader->file, &dt))
+        return -1;
+    reader->type = type;
+    reader->tUs += dt;
+
+    switch (type)
+    {
+    case TRACE_SELECT:
+        a = getc(reader->file);
+        b = getc(reader->file);
+        c = getc(reader->file);
+        if (c == EOF)
+            return -1;
+        reader->cs = a;
+        reader->divider = b | (c << 8);
+        reader->len = 0;
+        return 1;
+    case TRACE_GPIO:
+        a = getc(reader->file);
+        b = getc(reader->file);
+        if (b == EOF)
+            return -1;
+        reader->pin = a;
+        reader->level = b;
+        reader->len = 0;
+        return 1;
+    case TRACE_INDEX:
+    case TRACE_DATA:
+        len = 3;
+        break;
+    case TRACE_TRANSFER:
+        if (!Trace_ReadVarint(reader->file, &len) || len > 0x7FFFFFFF)
+            return -1;
+        break;
+    default:
+        return -1;
+    }
+
+    if (len > reader->size)
+    {
+        reader->data = realloc(reader->data, len);
+        if (!reader->data)
+            return -1;
+        reader->size = len;
+    }
+    reader->len = len;
+    if (type == TRACE_TRANSFER)
+        return fread(reader->data, 1, len, reader->file) == len ? 1 : -1;
+
+    reader->data[0] = SPI_START | (type == TRACE_DATA ? SPI_DATA : 0);
+    return fread(reader->data + 1, 1, 2, reader->file) == 2 ? 1 : -1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_TraceClose
+* Description    : Close a trace opened by LCD_TraceOpen
+* Input          : - reader: trace reader
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_TraceClose(TraceReader *reader)
+{
+    if (reader->file)
+        fclose(reader->file);
+    free(reader->data);
+    memset(reader, 0, sizeof(*reader));
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
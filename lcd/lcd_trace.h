@@ -0,0 +1,74 @@
+/*******************************************************************************
+* File Name      : lcd_trace.h
+* Description    : Recording of the SPI command stream into a binary trace
+*                  and reading it back for replay and analysis
+*
+*                  File layout: "HYTR", version byte, then records of
+*                    type byte, time since previous record in us (varint)
+*                    TRACE_SELECT   cs, divider (2 bytes LE)
+*                    TRACE_INDEX    index word (2 bytes BE)   start 0x70
+*                    TRACE_DATA     data word (2 bytes BE)    start 0x72
+*                    TRACE_TRANSFER length (varint), bytes sent
+*                    TRACE_GPIO     pin, level
+*******************************************************************************/
+#ifndef __LCD_TRACE_H
+#define __LCD_TRACE_H
+
+/* Includes */
+#include <stdio.h>
+
+
+/* Defines */
+#define TRACE_MAGIC "HYTR"
+#define TRACE_VERSION 1
+
+#define TRACE_SELECT 0
+#define TRACE_INDEX 1
+#define TRACE_DATA 2
+#define TRACE_TRANSFER 3
+#define TRACE_GPIO 4
+
+#define TRACE_TRANSFER_HOOK(buf, len)   do { if (TraceFile) Trace_Transfer(buf, len); } while (0)
+#define TRACE_WRITE_HOOK(head, headLen, buf, len) \
+                                        do { if (TraceFile) Trace_Write(head, headLen, buf, len); } while (0)
+#define TRACE_SELECT_HOOK(cs, divider)  do { if (TraceFile) Trace_Select(cs, divider); } while (0)
+#define TRACE_GPIO_HOOK(pin, level)     do { if (TraceFile) Trace_Gpio(pin, level); } while (0)
+
+
+/* Types */
+typedef struct
+{
+    FILE *file;
+    unsigned char type;             /* TRACE_x of the last record */
+    unsigned long long tUs;         /* time of the record since the start */
+    unsigned char cs;               /* slave selected, also on transfers */
+    unsigned short divider;         /* divider selected, also on transfers */
+    unsigned char pin, level;       /* TRACE_GPIO */
+    unsigned int len;               /* bytes sent, TRACE_INDEX/DATA/TRANSFER */
+    unsigned int size;
+    char *data;
+} TraceReader;
+
+
+/* Public declarations */
+extern FILE *TraceFile;
+
+
+/* Function declarations */
+int LCD_TraceStart(const char *path);
+void LCD_TraceStop(void);
+void Trace_Transfer(const char *buf, unsigned int len);
+void Trace_Write(const char *head, unsigned int headLen, const char *buf, unsigned int len);
+void Trace_Select(unsigned char cs, unsigned short divider);
+void Trace_Gpio(unsigned char pin, unsigned char level);
+
+int LCD_TraceOpen(TraceReader *reader, const char *path);
+int LCD_TraceNext(TraceReader *reader);
+void LCD_TraceClose(TraceReader *reader);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
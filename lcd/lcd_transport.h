@@ -0,0 +1,51 @@
+/*******************************************************************************
+* File Name      : lcd_transport.h
+* Description    : Bus and GPIO access used by the driver
+*                  LCD_Bcm2835Transport drives the real panel through the
+*                  bcm2835 library, LCD_EmuTransport (lcd_emu.h) emulates it
+*                  ctx is the context given with the transport to
+*                  LCD_DeviceOpen, it tells apart the panels of one transport
+*******************************************************************************/
+#ifndef __LCD_TRANSPORT_H
+#define __LCD_TRANSPORT_H
+
+/* Defines */
+#define LCD_CS_LCD 0            /* BCM2835_SPI_CS0, ILI9320 */
+#define LCD_CS_TOUCH 1          /* BCM2835_SPI_CS1, ADS7843 */
+
+#define LCD_PIN_RESET 0         /* GPIO25, low active */
+#define LCD_PIN_BACKLIGHT 1     /* GPIO18, HIGH=on, LOW=off */
+
+
+/* Types */
+typedef struct LCD_Transport
+{
+    const char *name;
+    int (*open)(void *ctx);                                         /* 1 success, 0 failure */
+    void (*close)(void *ctx);
+    void (*spiBegin)(void *ctx);                                    /* MSB first, mode 3, CS low active */
+    void (*spiSelect)(void *ctx, unsigned char cs, unsigned short divider);
+    void (*spiTransfer)(void *ctx, char *buf, unsigned int len);    /* send buf, receive into buf */
+    void (*gpioWrite)(void *ctx, unsigned char pin, unsigned char level);
+    void (*irqInit)(void *ctx);                                     /* touch IRQ falling edge detect */
+    void (*irqClear)(void *ctx);
+    unsigned char (*irqTest)(void *ctx);                            /* 0 while the panel is touched */
+    void (*delay)(void *ctx, unsigned int millis);
+    /* send head then buf in one transfer, nothing received; 0 when the
+       transport has no such path, spiTransfer is used */
+    void (*spiWrite)(void *ctx, const char *head, unsigned int headLen,
+                     const char *buf, unsigned int len);
+} LCD_Transport;
+
+
+/* Public declarations */
+#ifndef LCD_NO_BCM2835
+extern const LCD_Transport LCD_Bcm2835Transport;
+#endif
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,959 @@
+/*******************************************************************************
+* File Name      : lcd_ui.c
+* Description    : Retained widgets
+*                  Every widget is painted inside its own viewport and clip
+*                  rectangle (LCD_PushViewport), so a widget draws in its own
+*                  coordinates and never outside its parent. Changes mark
+*                  widgets dirty or expose the screen rectangle a widget
+*                  left; UI_Update repaints only those.
+*                  Buttons, sliders and lists are entered in a grid of
+*                  UI_CELL screen cells, a touch point looks at one cell
+*******************************************************************************/
+/* Includes */
+#include <string.h>
+#include "lcd.h"
+#include "lcd_stats.h"
+#include "lcd_ui.h"
+
+
+/* Defines */
+#define UI_DAMAGE_MAX 8         /* exposed rectangles kept before merging all */
+#define UI_KNOB 12              /* width of the slider knob */
+#define GRID_SIDE ((MAX_Y + UI_CELL - 1) / UI_CELL)
+
+
+/* Types */
+typedef struct
+{
+    int x0, y0, x1, y1;         /* x1, y1 excluded */
+} UiRect;
+
+
+/* Public declarations */
+static UiWidget *Root;
+static UiRect Damage[UI_DAMAGE_MAX];
+static int DamageCount;
+static UiWidget *Grid[GRID_SIDE * GRID_SIDE][UI_CELL_WIDGETS];
+static unsigned char GridCount[GRID_SIDE * GRID_SIDE];  /* > UI_CELL_WIDGETS: overflow */
+static int GridCols;
+static unsigned char GridStale;
+static UiWidget *Capture;       /* widget that got the pen down */
+static unsigned char PenDown;
+static int DragY, DragTop;      /* list scrolling */
+
+
+/*******************************************************************************
+* Function Name  : UI_Intersect
+* Description    : Intersection of two rectangles
+* Input          : - a, b: rectangles
+* Output         : - r: intersection
+* Return         : 1 if not empty
+* Attention      : r may be a or b
+*******************************************************************************/
+static int UI_Intersect(UiRect *r, const UiRect *a, const UiRect *b)
+{
+    UiRect i;
+
+    i.x0 = a->x0 > b->x0 ? a->x0 : b->x0;
+    i.y0 = a->y0 > b->y0 ? a->y0 : b->y0;
+    i.x1 = a->x1 < b->x1 ? a->x1 : b->x1;
+    i.y1 = a->y1 < b->y1 ? a->y1 : b->y1;
+    *r = i;
+    return i.x0 < i.x1 && i.y0 < i.y1;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Shown
+* Description    : Screen position of a widget on the screen
+* Input          : - widget: widget
+* Output         : - ax, ay: upper left corner on the screen
+*                  - clip: part of the screen its parents let it draw on
+* Return         : 1 if the widget and its parents are visible under the
+*                  root, 0 otherwise
+* Attention      : None
+*******************************************************************************/
+static int UI_Shown(const UiWidget *widget, int *ax, int *ay, UiRect *clip)
+{
+    const UiWidget *p;
+    UiRect r;
+
+    if (!Root)
+        return 0;
+    *ax = *ay = 0;
+    for (p = widget; p != Root; p = p->parent)
+    {
+        if (!p || !p->visible)
+            return 0;
+        *ax += p->x;
+        *ay += p->y;
+    }
+    if (!Root->visible)
+        return 0;
+
+    /* intersection of the rectangles of the parents */
+    clip->x0 = clip->y0 = 0;
+    clip->x1 = Root->w;
+    clip->y1 = Root->h;
+    r.x0 = *ax;
+    r.y0 = *ay;
+    for (p = widget; p != Root; p = p->parent)
+    {
+        /* rectangle of parent p->parent on the screen */
+        r.x0 -= p->x;
+        r.y0 -= p->y;
+        r.x1 = r.x0 + p->parent->w;
+        r.y1 = r.y0 + p->parent->h;
+        UI_Intersect(clip, clip, &r);
+    }
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Expose
+* Description    : Note a screen rectangle to repaint from the root
+* Input          : - r: rectangle
+* Output         : None
+* Return         : None
+* Attention      : When the list is full everything is merged into one box
+*******************************************************************************/
+static void UI_Expose(const UiRect *r)
+{
+    int i;
+
+    if (r->x0 >= r->x1 || r->y0 >= r->y1)
+        return;
+    if (DamageCount == UI_DAMAGE_MAX)
+    {
+        for (i = 1; i < DamageCount; i++)
+        {
+            if (Damage[i].x0 < Damage[0].x0) Damage[0].x0 = Damage[i].x0;
+            if (Damage[i].y0 < Damage[0].y0) Damage[0].y0 = Damage[i].y0;
+            if (Damage[i].x1 > Damage[0].x1) Damage[0].x1 = Damage[i].x1;
+            if (Damage[i].y1 > Damage[0].y1) Damage[0].y1 = Damage[i].y1;
+        }
+        DamageCount = 1;
+    }
+    Damage[DamageCount++] = *r;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_ExposeWidget
+* Description    : Repaint from the root what a widget covers now
+* Input          : - widget: widget about to be moved, hidden or removed
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void UI_ExposeWidget(const UiWidget *widget)
+{
+    UiRect clip, r;
+    int ax, ay;
+
+    if (!UI_Shown(widget, &ax, &ay, &clip))
+        return;
+    r.x0 = ax;
+    r.y0 = ay;
+    r.x1 = ax + widget->w;
+    r.y1 = ay + widget->h;
+    if (UI_Intersect(&r, &r, &clip))
+        UI_Expose(&r);
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Text
+* Description    : Draw a string on one line, cut at a width
+* Input          : - x, y: upper left corner in the widget
+*                  - text: string, may be 0
+*                  - maxw: characters stop before this x
+*                  - fg, bg: colors
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void UI_Text(int x, int y, const char *text, int maxw, unsigned short fg, unsigned short bg)
+{
+    if (!text)
+        return;
+    for (; *text && x + 8 <= maxw; text++, x += 8)
+        PutChar(x, y, *text, fg, bg);
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_TextWidth
+* Description    : Width of a string in pixels
+* Input          : - text: string, may be 0
+* Output         : None
+* Return         : 8 pixels per character
+* Attention      : None
+*******************************************************************************/
+static int UI_TextWidth(const char *text)
+{
+    return text ? 8 * (int)strlen(text) : 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Paint
+* Description    : Draw one widget, without its children
+* Input          : - widget: widget
+* Output         : None
+* Return         : None
+* Attention      : The viewport is the widget
+*******************************************************************************/
+static void UI_Paint(const UiWidget *widget)
+{
+    int w = widget->w, h = widget->h, i, y, k;
+    unsigned short fg = widget->fg, bg = widget->bg;
+
+    switch (widget->type)
+    {
+    case UI_ROOT:
+        LCD_FillRect(0, 0, w, h, bg);
+        break;
+    case UI_LABEL:
+        LCD_FillRect(0, 0, w, h, bg);
+        UI_Text(2, (h - 16) / 2, widget->text, w - 2, fg, bg);
+        break;
+    case UI_BUTTON:
+        if (widget->pressed)
+        {
+            fg = widget->bg;
+            bg = widget->fg;
+        }
+        LCD_DrawBox(0, 0, w - 1, h - 1, widget->fg, bg);
+        k = UI_TextWidth(widget->text);
+        UI_Text(k < w - 4 ? (w - k) / 2 : 2, (h - 16) / 2, widget->text, w - 2, fg, bg);
+        break;
+    case UI_SLIDER:
+        k = widget->max > widget->min
+            ? (widget->value - widget->min) * (w - UI_KNOB) / (widget->max - widget->min) : 0;
+        LCD_FillRect(0, 0, k, h, bg);
+        LCD_FillRect(k + UI_KNOB, 0, w - k - UI_KNOB, h, bg);
+        LCD_FillRect(0, h / 2 - 1, k, 3, fg);               /* track */
+        LCD_FillRect(k + UI_KNOB, h / 2 - 1, w - k - UI_KNOB, 3, fg);
+        LCD_DrawBox(k, 0, k + UI_KNOB - 1, h - 1, fg, bg);  /* knob */
+        break;
+    case UI_PROGRESS:
+        k = widget->max > widget->min
+            ? (widget->value - widget->min) * (w - 2) / (widget->max - widget->min) : 0;
+        LCD_DrawBox(0, 0, w - 1, h - 1, fg, -1);
+        LCD_FillRect(1, 1, k, h - 2, fg);
+        LCD_FillRect(1 + k, 1, w - 2 - k, h - 2, bg);
+        break;
+    case UI_LIST:
+        for (i = widget->top, y = 0; i < widget->count && y < h; i++, y += UI_LINE)
+        {
+            fg = i == widget->value ? widget->bg : widget->fg;
+            bg = i == widget->value ? widget->fg : widget->bg;
+            LCD_FillRect(0, y, w, UI_LINE, bg);
+            UI_Text(2, y + (UI_LINE - 16) / 2, widget->items[i], w - 2, fg, bg);
+        }
+        if (y < h)
+            LCD_FillRect(0, y, w, h - y, widget->bg);
+        break;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_PaintTree
+* Description    : Draw a widget and its children inside a rectangle
+* Input          : - widget: widget
+*                  - ax, ay: its upper left corner on the screen
+*                  - clip: screen rectangle to draw in
+*                  - clean: 1 if clip holds all of the widget that can be
+*                    seen, its dirty flags are then cleared
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void UI_PaintTree(UiWidget *widget, int ax, int ay, const UiRect *clip, int clean)
+{
+    UiWidget *c;
+    UiRect r;
+
+    r.x0 = ax;
+    r.y0 = ay;
+    r.x1 = ax + widget->w;
+    r.y1 = ay + widget->h;
+    if (!UI_Intersect(&r, &r, clip))
+        return;
+    LCD_PushClip(r.x0, r.y0, r.x1 - r.x0, r.y1 - r.y0);
+    LCD_PushViewport(ax, ay, widget->w, widget->h);
+    UI_Paint(widget);
+    LCD_PopClip();
+    LCD_PopClip();
+    if (clean)
+        widget->dirty = 0;
+    for (c = widget->child; c; c = c->next)
+    {
+        if (c->visible)
+            UI_PaintTree(c, ax + c->x, ay + c->y, &r, clean);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_PaintAbove
+* Description    : Draw again the widgets stacked above a widget
+* Input          : - widget: widget just drawn
+*                  - rect: its screen rectangle
+* Output         : None
+* Return         : None
+* Attention      : Later siblings of the widget and of its parents
+*******************************************************************************/
+static void UI_PaintAbove(const UiWidget *widget, const UiRect *rect)
+{
+    const UiWidget *p;
+    UiWidget *s;
+    UiRect clip;
+    int ax, ay;
+
+    for (p = widget; p != Root; p = p->parent)
+    {
+        if (!p->next || !UI_Shown(p->parent, &ax, &ay, &clip) || !UI_Intersect(&clip, &clip, rect))
+            continue;
+        for (s = p->next; s; s = s->next)
+        {
+            if (s->visible)
+                UI_PaintTree(s, ax + s->x, ay + s->y, &clip, 0);
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_UpdateTree
+* Description    : Draw the dirty widgets of a tree
+* Input          : - widget: visible widget
+*                  - ax, ay: its upper left corner on the screen
+*                  - clip: screen rectangle of its parents
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void UI_UpdateTree(UiWidget *widget, int ax, int ay, const UiRect *clip)
+{
+    UiWidget *c;
+    UiRect r;
+
+    r.x0 = ax;
+    r.y0 = ay;
+    r.x1 = ax + widget->w;
+    r.y1 = ay + widget->h;
+    if (widget->dirty)
+    {
+        UI_PaintTree(widget, ax, ay, clip, 1);
+        if (UI_Intersect(&r, &r, clip))
+            UI_PaintAbove(widget, &r);
+        return;
+    }
+    if (!UI_Intersect(&r, &r, clip))
+        return;
+    for (c = widget->child; c; c = c->next)
+    {
+        if (c->visible)
+            UI_UpdateTree(c, ax + c->x, ay + c->y, &r);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Widget
+* Description    : Common part of the widget initializations
+* Input          : - type: UI_x
+*                  - x, y: upper left corner in the parent
+*                  - w, h: size
+* Output         : - widget: widget, not in a tree
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void UI_Widget(UiWidget *widget, UiType type, short x, short y, unsigned short w, unsigned short h)
+{
+    memset(widget, 0, sizeof(*widget));
+    widget->type = type;
+    widget->x = x;
+    widget->y = y;
+    widget->w = w;
+    widget->h = h;
+    widget->fg = White;
+    widget->bg = Black;
+    widget->visible = 1;
+    widget->dirty = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Init
+* Description    : Start a widget tree that covers the screen
+* Input          : - root: root widget, filled with bg
+*                  - bg: background color
+* Output         : None
+* Return         : None
+* Attention      : Call it again after LCD_Init changed the orientation
+*******************************************************************************/
+void UI_Init(UiWidget *root, unsigned short bg)
+{
+    UI_Widget(root, UI_ROOT, 0, 0, LCD_GetWidth(), LCD_GetHeight());
+    root->bg = bg;
+    Root = root;
+    DamageCount = 0;
+    GridCols = (root->w + UI_CELL - 1) / UI_CELL;
+    GridStale = 1;
+    Capture = 0;
+    PenDown = 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_LabelInit
+* Description    : Text on one line, fg on bg
+* Input          : - x, y: upper left corner in the parent
+*                  - w, h: size
+*                  - text: string kept by the caller
+* Output         : - widget: label, to add with UI_Add
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void UI_LabelInit(UiWidget *widget, short x, short y, unsigned short w, unsigned short h, const char *text)
+{
+    UI_Widget(widget, UI_LABEL, x, y, w, h);
+    widget->text = text;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_ButtonInit
+* Description    : Framed text that calls its handler when released inside
+* Input          : - x, y: upper left corner in the parent
+*                  - w, h: size
+*                  - text: string kept by the caller
+*                  - handler: called with UI_EVENT_CLICK, may be 0
+* Output         : - widget: button, to add with UI_Add
+* Return         : None
+* Attention      : Colors are swapped while it is held down
+*******************************************************************************/
+void UI_ButtonInit(UiWidget *widget, short x, short y, unsigned short w, unsigned short h, const char *text, UiHandler handler)
+{
+    UI_Widget(widget, UI_BUTTON, x, y, w, h);
+    widget->bg = Blue;
+    widget->text = text;
+    widget->handler = handler;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_SliderInit
+* Description    : Horizontal slider with a knob dragged along a track
+* Input          : - x, y: upper left corner in the parent
+*                  - w, h: size
+*                  - min, max: range of the value
+*                  - value: initial value
+*                  - handler: called with UI_EVENT_CHANGE, may be 0
+* Output         : - widget: slider, to add with UI_Add
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void UI_SliderInit(UiWidget *widget, short x, short y, unsigned short w, unsigned short h, int min, int max, int value, UiHandler handler)
+{
+    UI_Widget(widget, UI_SLIDER, x, y, w, h);
+    widget->min = min;
+    widget->max = max;
+    widget->handler = handler;
+    widget->value = min;
+    UI_SetValue(widget, value);
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_ProgressInit
+* Description    : Framed bar filled in proportion to a value
+* Input          : - x, y: upper left corner in the parent
+*                  - w, h: size
+*                  - min, max: range of the value
+*                  - value: initial value
+* Output         : - widget: progress bar, to add with UI_Add
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void UI_ProgressInit(UiWidget *widget, short x, short y, unsigned short w, unsigned short h, int min, int max, int value)
+{
+    UI_Widget(widget, UI_PROGRESS, x, y, w, h);
+    widget->fg = Green;
+    widget->min = min;
+    widget->max = max;
+    widget->value = min;
+    UI_SetValue(widget, value);
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_ListInit
+* Description    : Scrolled list of strings with one selected item
+* Input          : - x, y: upper left corner in the parent
+*                  - w, h: size
+*                  - items: count strings kept by the caller
+*                  - count: number of items
+*                  - handler: called with UI_EVENT_CHANGE when the selection
+*                    changes, may be 0
+* Output         : - widget: list, to add with UI_Add
+* Return         : None
+* Attention      : value is the selected item, -1 none; dragging scrolls
+*******************************************************************************/
+void UI_ListInit(UiWidget *widget, short x, short y, unsigned short w, unsigned short h, const char * const *items, int count, UiHandler handler)
+{
+    UI_Widget(widget, UI_LIST, x, y, w, h);
+    widget->items = items;
+    widget->count = count;
+    widget->value = -1;
+    widget->handler = handler;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Add
+* Description    : Put a widget on top of the children of a parent
+* Input          : - parent: widget of the tree
+*                  - widget: widget not in a tree
+* Output         : None
+* Return         : None
+* Attention      : Children are drawn in the order they are added
+*******************************************************************************/
+void UI_Add(UiWidget *parent, UiWidget *widget)
+{
+    UiWidget **p;
+
+    for (p = &parent->child; *p; p = &(*p)->next)
+        ;
+    *p = widget;
+    widget->next = 0;
+    widget->parent = parent;
+    widget->dirty = 1;
+    GridStale = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Remove
+* Description    : Take a widget and its children out of the tree
+* Input          : - widget: widget of the tree
+* Output         : None
+* Return         : None
+* Attention      : What was under it is drawn again by UI_Update
+*******************************************************************************/
+void UI_Remove(UiWidget *widget)
+{
+    UiWidget **p, *c;
+
+    if (!widget->parent)
+        return;
+    UI_ExposeWidget(widget);
+    for (p = &widget->parent->child; *p && *p != widget; p = &(*p)->next)
+        ;
+    if (*p)
+        *p = widget->next;
+    for (c = Capture; c; c = c->parent)
+    {
+        if (c == widget)
+            Capture = 0;
+    }
+    widget->parent = widget->next = 0;
+    GridStale = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Move
+* Description    : Move a widget in its parent
+* Input          : - widget: widget
+*                  - x, y: new upper left corner in the parent
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void UI_Move(UiWidget *widget, short x, short y)
+{
+    if (widget->x == x && widget->y == y)
+        return;
+    UI_ExposeWidget(widget);
+    widget->x = x;
+    widget->y = y;
+    widget->dirty = 1;
+    GridStale = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Show
+* Description    : Show or hide a widget and its children
+* Input          : - widget: widget
+*                  - visible: 1 shown, 0 hidden
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void UI_Show(UiWidget *widget, unsigned char visible)
+{
+    if (!widget->visible == !visible)
+        return;
+    if (!visible)
+        UI_ExposeWidget(widget);
+    widget->visible = visible != 0;
+    widget->dirty = 1;
+    GridStale = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_SetText
+* Description    : Change the string of a label or a button
+* Input          : - widget: widget
+*                  - text: string kept by the caller
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void UI_SetText(UiWidget *widget, const char *text)
+{
+    if (widget->text == text)
+        return;
+    widget->text = text;
+    widget->dirty = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_SetValue
+* Description    : Change the value of a slider or a progress bar, or the
+*                  selected item of a list
+* Input          : - widget: widget
+*                  - value: new value, limited to the range
+* Output         : None
+* Return         : None
+* Attention      : A list scrolls to show the selected item
+*******************************************************************************/
+void UI_SetValue(UiWidget *widget, int value)
+{
+    int rows;
+
+    if (widget->type == UI_LIST)
+    {
+        if (value < -1) value = -1;
+        if (value >= widget->count) value = widget->count - 1;
+        rows = widget->h / UI_LINE;
+        if (value >= 0 && value < widget->top)
+            widget->top = value;
+        else if (rows > 0 && value >= widget->top + rows)
+            widget->top = value - rows + 1;
+    }
+    else
+    {
+        if (value < widget->min) value = widget->min;
+        if (value > widget->max) value = widget->max;
+    }
+    if (widget->value == value)
+        return;
+    widget->value = value;
+    widget->dirty = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_SetColors
+* Description    : Change the colors of a widget
+* Input          : - widget: widget
+*                  - fg: text, frame and bar color
+*                  - bg: background color
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void UI_SetColors(UiWidget *widget, unsigned short fg, unsigned short bg)
+{
+    if (widget->fg == fg && widget->bg == bg)
+        return;
+    widget->fg = fg;
+    widget->bg = bg;
+    widget->dirty = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Invalidate
+* Description    : Have a widget drawn again by the next UI_Update
+* Input          : - widget: widget
+* Output         : None
+* Return         : None
+* Attention      : For changes made to the fields directly
+*******************************************************************************/
+void UI_Invalidate(UiWidget *widget)
+{
+    widget->dirty = 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Update
+* Description    : Draw what changed since the last update
+* Input          : None
+* Output         : None
+* Return         : None
+* Attention      : Exposed rectangles are drawn from the root, clipped to the
+*                  rectangle; then each dirty widget is drawn with its
+*                  children and the widgets stacked above it
+*******************************************************************************/
+void UI_Update(void)
+{
+    UiRect screen;
+    int i;
+
+    if (!Root || !Root->visible)
+        return;
+    STATS_ENTER(STATS_UI_UPDATE);
+    screen.x0 = screen.y0 = 0;
+    screen.x1 = Root->w;
+    screen.y1 = Root->h;
+    if (Root->dirty)
+        DamageCount = 0;
+    for (i = 0; i < DamageCount; i++)
+        UI_PaintTree(Root, 0, 0, &Damage[i], 0);
+    DamageCount = 0;
+    UI_UpdateTree(Root, 0, 0, &screen);
+    STATS_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_GridBuild
+* Description    : Enter the touchable widgets of a tree in the grid cells
+*                  they cover
+* Input          : - widget: visible widget
+*                  - ax, ay: its upper left corner on the screen
+*                  - clip: screen rectangle of its parents
+* Output         : None
+* Return         : None
+* Attention      : Visited in drawing order, the last widget of a cell is on
+*                  top
+*******************************************************************************/
+static void UI_GridBuild(UiWidget *widget, int ax, int ay, const UiRect *clip)
+{
+    UiWidget *c;
+    UiRect r;
+    int cx, cy, cell;
+
+    r.x0 = ax;
+    r.y0 = ay;
+    r.x1 = ax + widget->w;
+    r.y1 = ay + widget->h;
+    if (!UI_Intersect(&r, &r, clip))
+        return;
+    if (widget->type == UI_BUTTON || widget->type == UI_SLIDER || widget->type == UI_LIST)
+    {
+        widget->hx0 = r.x0;
+        widget->hy0 = r.y0;
+        widget->hx1 = r.x1;
+        widget->hy1 = r.y1;
+        for (cy = r.y0 / UI_CELL; cy <= (r.y1 - 1) / UI_CELL; cy++)
+        {
+            for (cx = r.x0 / UI_CELL; cx <= (r.x1 - 1) / UI_CELL; cx++)
+            {
+                cell = cy * GridCols + cx;
+                if (GridCount[cell] < UI_CELL_WIDGETS)
+                    Grid[cell][GridCount[cell]] = widget;
+                if (GridCount[cell] <= UI_CELL_WIDGETS)
+                    GridCount[cell]++;
+            }
+        }
+    }
+    for (c = widget->child; c; c = c->next)
+    {
+        if (c->visible)
+            UI_GridBuild(c, ax + c->x, ay + c->y, &r);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Find
+* Description    : Search a tree for the top touchable widget at a point
+* Input          : - widget: visible widget
+*                  - x, y: screen point
+* Output         : None
+* Return         : widget or 0
+* Attention      : For the cells with more than UI_CELL_WIDGETS widgets
+*******************************************************************************/
+static UiWidget *UI_Find(UiWidget *widget, int x, int y)
+{
+    UiWidget *c, *hit = 0, *h;
+
+    if ((widget->type == UI_BUTTON || widget->type == UI_SLIDER || widget->type == UI_LIST)
+        && x >= widget->hx0 && x < widget->hx1 && y >= widget->hy0 && y < widget->hy1)
+        hit = widget;
+    for (c = widget->child; c; c = c->next)
+    {
+        if (c->visible && (h = UI_Find(c, x, y)) != 0)
+            hit = h;
+    }
+    return hit;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_HitTest
+* Description    : Touchable widget at a screen point
+* Input          : - x, y: screen point, as given by getDisplayPoint
+* Output         : None
+* Return         : top button, slider or list at the point, 0 none
+* Attention      : The grid is built again after the tree changed
+*******************************************************************************/
+UiWidget *UI_HitTest(short x, short y)
+{
+    UiRect screen;
+    int cell, i;
+
+    if (!Root || !Root->visible || x < 0 || y < 0 || x >= Root->w || y >= Root->h)
+        return 0;
+    if (GridStale)
+    {
+        memset(GridCount, 0, sizeof(GridCount));
+        screen.x0 = screen.y0 = 0;
+        screen.x1 = Root->w;
+        screen.y1 = Root->h;
+        UI_GridBuild(Root, 0, 0, &screen);
+        GridStale = 0;
+    }
+    cell = y / UI_CELL * GridCols + x / UI_CELL;
+    if (GridCount[cell] > UI_CELL_WIDGETS)
+        return UI_Find(Root, x, y);
+    for (i = GridCount[cell] - 1; i >= 0; i--)
+    {
+        if (x >= Grid[cell][i]->hx0 && x < Grid[cell][i]->hx1
+            && y >= Grid[cell][i]->hy0 && y < Grid[cell][i]->hy1)
+            return Grid[cell][i];
+    }
+    return 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Press
+* Description    : Pen down or dragged on the widget it went down on
+* Input          : - widget: widget that got the pen down
+*                  - x, y: screen point
+*                  - first: 1 when the pen just went down
+* Output         : None
+* Return         : None
+* Attention      : A widget hidden or moved out of its parents meanwhile
+*                  ignores the pen
+*******************************************************************************/
+static void UI_Press(UiWidget *widget, int x, int y, int first)
+{
+    UiRect clip;
+    int inside, value, old, ax, ay;
+
+    if (!UI_Shown(widget, &ax, &ay, &clip))
+        return;
+    inside = x >= widget->hx0 && x < widget->hx1 && y >= widget->hy0 && y < widget->hy1;
+    x -= ax;                    /* in the widget */
+    y -= ay;
+    switch (widget->type)
+    {
+    case UI_BUTTON:
+        if (widget->pressed != inside)
+        {
+            widget->pressed = inside;
+            widget->dirty = 1;
+        }
+        break;
+    case UI_SLIDER:
+        if (widget->w <= UI_KNOB)
+            break;
+        value = widget->min + (x - UI_KNOB / 2) * (widget->max - widget->min) / (widget->w - UI_KNOB);
+        old = widget->value;
+        UI_SetValue(widget, value);
+        if (widget->value != old && widget->handler)
+            widget->handler(widget, UI_EVENT_CHANGE);
+        break;
+    case UI_LIST:
+        if (first)
+        {
+            DragY = y;
+            DragTop = widget->top;
+            value = widget->top + y / UI_LINE;
+            if (value < widget->count && value != widget->value)
+            {
+                widget->value = value;
+                widget->dirty = 1;
+                if (widget->handler)
+                    widget->handler(widget, UI_EVENT_CHANGE);
+            }
+            break;
+        }
+        value = DragTop - (y - DragY) / UI_LINE;
+        if (value > widget->count - widget->h / UI_LINE)
+            value = widget->count - widget->h / UI_LINE;
+        if (value < 0)
+            value = 0;
+        if (value != widget->top)
+        {
+            widget->top = value;
+            widget->dirty = 1;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name  : UI_Touch
+* Description    : Feed a touch panel sample to the widgets
+* Input          : - x, y: screen point, as given by getDisplayPoint
+*                  - pressed: 1 pen down, 0 pen up
+* Output         : None
+* Return         : None
+* Attention      : The widget the pen went down on gets the moves and the
+*                  release; handlers are called from here, the changes they
+*                  make are drawn by the next UI_Update
+*******************************************************************************/
+void UI_Touch(short x, short y, unsigned char pressed)
+{
+    UiWidget *widget;
+
+    if (pressed)
+    {
+        if (!PenDown)
+        {
+            PenDown = 1;
+            Capture = UI_HitTest(x, y);
+            if (Capture)
+                UI_Press(Capture, x, y, 1);
+        }
+        else if (Capture)
+        {
+            UI_Press(Capture, x, y, 0);
+        }
+        return;
+    }
+    widget = Capture;
+    PenDown = 0;
+    Capture = 0;
+    if (widget && widget->type == UI_BUTTON && widget->pressed)
+    {
+        widget->pressed = 0;
+        widget->dirty = 1;
+        if (widget->handler)
+            widget->handler(widget, UI_EVENT_CLICK);
+    }
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,81 @@
+/*******************************************************************************
+* File Name      : lcd_ui.h
+* Description    : Retained widgets: label, button, slider, progress bar and
+*                  list in a tree under a root that covers the screen
+*                  A change only marks its widget dirty, UI_Update repaints
+*                  the dirty widgets; touch points are matched to widgets
+*                  through a grid of screen cells
+*******************************************************************************/
+#ifndef __LCD_UI_H
+#define __LCD_UI_H
+
+
+/* Defines */
+#define UI_CELL 32              /* side of a hit-test grid cell in pixels */
+#define UI_CELL_WIDGETS 8       /* widgets kept per cell, more are searched */
+#define UI_LINE 18              /* height of a list item */
+
+/* Events passed to the handlers */
+#define UI_EVENT_CLICK 1        /* button released inside */
+#define UI_EVENT_CHANGE 2       /* slider value or list selection changed */
+
+
+/* Types */
+typedef enum
+{
+    UI_ROOT,
+    UI_LABEL,
+    UI_BUTTON,
+    UI_SLIDER,
+    UI_PROGRESS,
+    UI_LIST
+} UiType;
+
+typedef struct UiWidget UiWidget;
+typedef void (*UiHandler)(UiWidget *widget, int event);
+
+struct UiWidget
+{
+    UiType type;
+    short x, y;                     /* upper left corner in the parent */
+    unsigned short w, h;
+    unsigned short fg, bg;
+    const char *text;               /* label, button */
+    const char * const *items;      /* list */
+    int value, min, max;            /* slider, progress; list selection */
+    int count, top;                 /* list items, first item shown */
+    unsigned char visible;
+    unsigned char dirty;
+    unsigned char pressed;          /* button held down */
+    UiHandler handler;
+    void *user;                     /* free for the application */
+    UiWidget *parent, *child, *next;
+    short hx0, hy0, hx1, hy1;       /* touchable screen rectangle, grid */
+};
+
+
+/* Function declarations */
+void UI_Init(UiWidget *root, unsigned short bg);
+void UI_LabelInit(UiWidget *widget, short x, short y, unsigned short w, unsigned short h, const char *text);
+void UI_ButtonInit(UiWidget *widget, short x, short y, unsigned short w, unsigned short h, const char *text, UiHandler handler);
+void UI_SliderInit(UiWidget *widget, short x, short y, unsigned short w, unsigned short h, int min, int max, int value, UiHandler handler);
+void UI_ProgressInit(UiWidget *widget, short x, short y, unsigned short w, unsigned short h, int min, int max, int value);
+void UI_ListInit(UiWidget *widget, short x, short y, unsigned short w, unsigned short h, const char * const *items, int count, UiHandler handler);
+void UI_Add(UiWidget *parent, UiWidget *widget);
+void UI_Remove(UiWidget *widget);
+void UI_Move(UiWidget *widget, short x, short y);
+void UI_Show(UiWidget *widget, unsigned char visible);
+void UI_SetText(UiWidget *widget, const char *text);
+void UI_SetValue(UiWidget *widget, int value);
+void UI_SetColors(UiWidget *widget, unsigned short fg, unsigned short bg);
+void UI_Invalidate(UiWidget *widget);
+void UI_Update(void);
+UiWidget *UI_HitTest(short x, short y);
+void UI_Touch(short x, short y, unsigned char pressed);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
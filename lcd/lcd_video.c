@@ -0,0 +1,499 @@
+/*******************************************************************************
+* File Name      : lcd_video.c
+* Description    : Playback of RGB565 animations from a file, and the writer
+*                  of the file
+*                  The player keeps the whole last frame: a dropped frame is
+*                  merged in it, and the next frame shown sends the union of
+*                  its rectangle and the dropped ones
+*******************************************************************************/
+/* Includes */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "lcd.h"
+#include "lcd_video.h"
+
+
+/* RGB565 in the byte order of the bus, for LCD_WritePixelsBE */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define BUS_ORDER(c) ((unsigned short)(c))
+#define LE16(v) ((unsigned short)((v) << 8 | (v) >> 8))
+#define LE32(v) __builtin_bswap32(v)
+#else
+#define BUS_ORDER(c) ((unsigned short)((c) << 8 | (c) >> 8))
+#define LE16(v) (v)
+#define LE32(v) (v)
+#endif
+
+
+/*******************************************************************************
+* Function Name  : Video_Now
+* Description    : Monotonic time
+* Input          : None
+* Output         : None
+* Return         : nanoseconds
+* Attention      : None
+*******************************************************************************/
+static unsigned long long Video_Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/*******************************************************************************
+* Function Name  : Video_HeaderOrder ... Video_FrameOrder
+* Description    : Swap the fields between the little endian order of the
+*                  file and the order of the host, both ways
+* Input          : - head, vf: fields in one order
+* Output         : - head, vf: fields in the other
+* Return         : None
+* Attention      : Nothing to do on a little endian host
+*******************************************************************************/
+static void Video_HeaderOrder(VideoHeader *head)
+{
+    head->version = LE16(head->version);
+    head->w = LE16(head->w);
+    head->h = LE16(head->h);
+    head->fps = LE16(head->fps);
+    head->frames = LE32(head->frames);
+}
+
+
+static void Video_FrameOrder(VideoFrame *vf)
+{
+    vf->x = LE16(vf->x);
+    vf->y = LE16(vf->y);
+    vf->w = LE16(vf->w);
+    vf->h = LE16(vf->h);
+    vf->flags = LE32(vf->flags);
+}
+
+
+/*******************************************************************************
+* Function Name  : Video_Read
+* Description    : Read exactly len bytes
+* Input          : - fd: file
+*                  - len: bytes
+* Output         : - buf: bytes
+* Return         : 1 success, 0 end of file or error
+* Attention      : None
+*******************************************************************************/
+static int Video_Read(int fd, void *buf, size_t len)
+{
+    char *p = buf;
+    ssize_t n;
+
+    while (len)
+    {
+        n = read(fd, p, len);
+        if (n <= 0)
+            return 0;
+        p += n;
+        len -= n;
+    }
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : Video_Prefetch
+* Description    : Prefetch thread: read the frames into the free slots
+* Input          : - arg: player
+* Output         : None
+* Return         : 0
+* Attention      : Asks the kernel for the next VIDEO_READAHEAD bytes when
+*                  the reads come within half of it of the last request, so
+*                  the SD card is read while the slots are still full
+*******************************************************************************/
+static void *Video_Prefetch(void *arg)
+{
+    VideoPlayer *p = arg;
+    VideoFrame *vf;
+    off_t pos = sizeof(VideoHeader);
+    unsigned char *slot;
+    size_t len;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&p->lock);
+        while (p->read - p->played == VIDEO_SLOTS && !p->stop)
+            pthread_cond_wait(&p->cond, &p->lock);
+        if (p->stop || p->read == p->head.frames)
+            break;
+        pthread_mutex_unlock(&p->lock);
+
+        if (pos + VIDEO_READAHEAD / 2 > p->advised)
+        {
+            posix_fadvise(p->fd, p->advised, VIDEO_READAHEAD, POSIX_FADV_WILLNEED);
+            p->advised += VIDEO_READAHEAD;
+        }
+        slot = p->slots[p->read % VIDEO_SLOTS];
+        vf = (VideoFrame *)slot;
+        if (!Video_Read(p->fd, vf, sizeof(*vf)))
+        {
+            pthread_mutex_lock(&p->lock);
+            break;
+        }
+        Video_FrameOrder(vf);
+        len = (size_t)vf->w * vf->h * 2;
+        if (vf->x + vf->w > p->head.w || vf->y + vf->h > p->head.h
+            || (len && !Video_Read(p->fd, slot + sizeof(*vf), len)))
+        {
+            pthread_mutex_lock(&p->lock);
+            break;
+        }
+        pos += sizeof(*vf) + len;
+
+        pthread_mutex_lock(&p->lock);
+        p->read++;
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+    }
+    p->eof = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+    return 0;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_VideoOpen
+* Description    : Open an animation and start reading it ahead
+* Input          : - path: file written by LCD_VideoFinish
+* Output         : - player: player
+* Return         : 1 success, 0 fail
+* Attention      : None
+*******************************************************************************/
+int LCD_VideoOpen(VideoPlayer *player, const char *path)
+{
+    unsigned int i, n;
+
+    memset(player, 0, sizeof(*player));
+    player->fd = open(path, O_RDONLY);
+    if (player->fd < 0)
+        return 0;
+    if (!Video_Read(player->fd, &player->head, sizeof(player->head)))
+    {
+        close(player->fd);
+        return 0;
+    }
+    Video_HeaderOrder(&player->head);
+    if (memcmp(player->head.magic, VIDEO_MAGIC, 4) || player->head.version != VIDEO_VERSION
+        || !player->head.w || !player->head.h)
+    {
+        close(player->fd);
+        return 0;
+    }
+    posix_fadvise(player->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    player->advised = sizeof(player->head);
+
+    n = player->head.w * player->head.h;
+    player->frame = calloc(n, sizeof(unsigned short));
+    player->gather = malloc(n * sizeof(unsigned short));
+    for (i = 0; i < VIDEO_SLOTS; i++)
+        player->slots[i] = malloc(sizeof(VideoFrame) + n * sizeof(unsigned short));
+    for (i = 0; i < VIDEO_SLOTS && player->slots[i]; i++)
+        ;
+    pthread_mutex_init(&player->lock, 0);
+    pthread_cond_init(&player->cond, 0);
+    if (!player->frame || !player->gather || i < VIDEO_SLOTS
+        || pthread_create(&player->thread, 0, Video_Prefetch, player))
+    {
+        player->thread = 0;
+        LCD_VideoClose(player);
+        return 0;
+    }
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_VideoClose
+* Description    : Stop the prefetch and release the player
+* Input          : - player: player
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+void LCD_VideoClose(VideoPlayer *player)
+{
+    unsigned int i;
+
+    if (player->thread)
+    {
+        pthread_mutex_lock(&player->lock);
+        player->stop = 1;
+        pthread_cond_broadcast(&player->cond);
+        pthread_mutex_unlock(&player->lock);
+        pthread_join(player->thread, 0);
+    }
+    pthread_mutex_destroy(&player->lock);
+    pthread_cond_destroy(&player->cond);
+    for (i = 0; i < VIDEO_SLOTS; i++)
+        free(player->slots[i]);
+    free(player->frame);
+    free(player->gather);
+    close(player->fd);
+    memset(player, 0, sizeof(*player));
+    player->fd = -1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_VideoPlay
+* Description    : Play the animation once
+* Input          : - player: player opened by LCD_VideoOpen
+*                  - Xpos, Ypos: upper left corner on the screen
+*                  - fps: frames per second, VIDEO_FILE_FPS for the one of
+*                    the file, 0 as fast as the bus goes, without drops
+* Output         : - stats: counters of the play, may be 0
+* Return         : 1 played to the end, 0 file truncated or not on the screen
+* Attention      : A frame is dropped when the one after it is due already,
+*                  never the last one. The window and the burst of a frame
+*                  are one LCD_Lock section, the wait for the frame is not
+*******************************************************************************/
+int LCD_VideoPlay(VideoPlayer *player, short Xpos, short Ypos, unsigned short fps, VideoStats *stats)
+{
+    VideoStats st;
+    VideoFrame *vf;
+    const unsigned short *src;
+    unsigned short *dst;
+    unsigned long long start, due, period, now;
+    int ready;
+    unsigned int i, row, x0 = 0, y0 = 0, x1 = 0, y1 = 0, dirty = 0, direct, w = player->head.w;
+    struct timespec ts;
+
+    if (Xpos < 0 || Ypos < 0 || Xpos + w > LCD_GetWidth() || Ypos + player->head.h > LCD_GetHeight())
+        return 0;
+    if (fps == VIDEO_FILE_FPS)
+        fps = player->head.fps;
+    period = fps ? 1000000000ULL / fps : 0;
+    memset(&st, 0, sizeof(st));
+    start = Video_Now();
+
+    for (i = 0; i < player->head.frames; i++)
+    {
+        pthread_mutex_lock(&player->lock);
+        if (player->read == player->played && !player->eof)
+        {
+            st.stalls++;
+            while (player->read == player->played && !player->eof)
+                pthread_cond_wait(&player->cond, &player->lock);
+        }
+        ready = player->read != player->played;
+        pthread_mutex_unlock(&player->lock);
+        if (!ready)
+            break;
+        vf = (VideoFrame *)player->slots[player->played % VIDEO_SLOTS];
+        src = (const unsigned short *)(vf + 1);
+
+        /* merge the rectangle in the last frame and the dirty one */
+        for (row = 0; row < vf->h; row++)
+            memcpy(player->frame + (vf->y + row) * w + vf->x, src + row * vf->w, vf->w * 2);
+        direct = !dirty;
+        if (vf->w && vf->h)
+        {
+            if (!dirty)
+            {
+                dirty = 1;
+                x0 = vf->x; y0 = vf->y; x1 = vf->x + vf->w; y1 = vf->y + vf->h;
+            }
+            else
+            {
+                if (vf->x < x0) x0 = vf->x;
+                if (vf->y < y0) y0 = vf->y;
+                if (vf->x + vf->w > x1) x1 = vf->x + vf->w;
+                if (vf->y + vf->h > y1) y1 = vf->y + vf->h;
+            }
+        }
+
+        if (period)
+        {
+            due = start + i * period;
+            now = Video_Now();
+            if (i + 1 < player->head.frames && now >= due + period)
+            {
+                st.dropped++;       /* the next frame shown sends the union */
+                goto next;
+            }
+            if (now < due)
+            {
+                ts.tv_sec = due / 1000000000ULL;
+                ts.tv_nsec = due % 1000000000ULL;
+                while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0))
+                    ;
+            }
+        }
+
+        if (dirty)
+        {
+            if (direct)
+                src = (const unsigned short *)(vf + 1);     /* straight from the slot */
+            else
+            {
+                for (row = y0, dst = player->gather; row < y1; row++, dst += x1 - x0)
+                    memcpy(dst, player->frame + row * w + x0, (x1 - x0) * 2);
+                src = player->gather;
+            }
+            LCD_Lock();
+            LCD_SetWindow(Xpos + x0, Ypos + y0, x1 - x0, y1 - y0);
+            LCD_WritePixelsBE(src, (x1 - x0) * (y1 - y0));
+            LCD_Unlock();
+            st.bytes += (x1 - x0) * (y1 - y0) * 2;
+            dirty = 0;
+        }
+        st.shown++;
+    next:
+        pthread_mutex_lock(&player->lock);
+        player->played++;
+        pthread_cond_broadcast(&player->cond);
+        pthread_mutex_unlock(&player->lock);
+    }
+
+    st.seconds = (Video_Now() - start) / 1e9;
+    if (stats)
+        *stats = st;
+    return i == player->head.frames;
+}
+
+
+/*******************************************************************************
+* Function Name  : Video_WriteHeader
+* Description    : Write the header at the current place of the file
+* Input          : - writer: writer
+* Output         : None
+* Return         : 1 success, 0 write error
+* Attention      : None
+*******************************************************************************/
+static int Video_WriteHeader(VideoWriter *writer)
+{
+    VideoHeader head = writer->head;
+
+    Video_HeaderOrder(&head);
+    return fwrite(&head, sizeof(head), 1, writer->f) == 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_VideoCreate
+* Description    : Start writing an animation
+* Input          : - path: file
+*                  - w, h: size of the frames
+*                  - fps: frames per second it is made for
+* Output         : - writer: writer
+* Return         : 1 success, 0 fail
+* Attention      : None
+*******************************************************************************/
+int LCD_VideoCreate(VideoWriter *writer, const char *path, unsigned short w, unsigned short h, unsigned short fps)
+{
+    memset(writer, 0, sizeof(*writer));
+    if (!w || !h)
+        return 0;
+    memcpy(writer->head.magic, VIDEO_MAGIC, 4);
+    writer->head.version = VIDEO_VERSION;
+    writer->head.w = w;
+    writer->head.h = h;
+    writer->head.fps = fps;
+    writer->prev = malloc((size_t)w * h * sizeof(unsigned short));
+    writer->rect = malloc((size_t)w * h * sizeof(unsigned short));
+    writer->f = fopen(path, "wb");
+    if (!writer->prev || !writer->rect || !writer->f
+        || !Video_WriteHeader(writer))
+    {
+        if (writer->f)
+            fclose(writer->f);
+        free(writer->prev);
+        free(writer->rect);
+        return 0;
+    }
+    return 1;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_VideoAddFrame
+* Description    : Append a frame: the bounding rectangle of what changed
+*                  since the frame before, the whole frame the first time
+* Input          : - writer: writer
+*                  - pixels: w * h RGB565 colors, line by line
+* Output         : None
+* Return         : 1 success, 0 write error
+* Attention      : An unchanged frame is written without pixels, it holds
+*                  the picture for one period
+*******************************************************************************/
+int LCD_VideoAddFrame(VideoWriter *writer, const unsigned short *pixels)
+{
+    VideoFrame vf;
+    unsigned int w = writer->head.w, h = writer->head.h, x, y, x0 = w, y0 = h, x1 = 0, y1 = 0;
+    size_t n;
+    unsigned short *dst = writer->rect;
+
+    if (!writer->head.frames)
+    {
+        x0 = y0 = 0;
+        x1 = w;
+        y1 = h;
+    }
+    else
+    {
+        for (y = 0; y < h; y++)
+            for (x = 0; x < w; x++)
+                if (pixels[y * w + x] != writer->prev[y * w + x])
+                {
+                    if (x < x0) x0 = x;
+                    if (x >= x1) x1 = x + 1;
+                    if (y < y0) y0 = y;
+                    y1 = y + 1;
+                }
+    }
+    memset(&vf, 0, sizeof(vf));
+    if (x0 < x1)
+    {
+        vf.x = x0;
+        vf.y = y0;
+        vf.w = x1 - x0;
+        vf.h = y1 - y0;
+    }
+    vf.flags = writer->head.frames ? 0 : VIDEO_KEY;
+    for (y = vf.y; y < (unsigned int)vf.y + vf.h; y++)
+        for (x = vf.x; x < (unsigned int)vf.x + vf.w; x++)
+            *dst++ = BUS_ORDER(pixels[y * w + x]);
+    memcpy(writer->prev, pixels, (size_t)w * h * sizeof(unsigned short));
+    writer->head.frames++;
+    n = (size_t)vf.w * vf.h;
+    Video_FrameOrder(&vf);
+    return fwrite(&vf, sizeof(vf), 1, writer->f) == 1
+           && fwrite(writer->rect, 2, n, writer->f) == n;
+}
+
+
+/*******************************************************************************
+* Function Name  : LCD_VideoFinish
+* Description    : Write the frame count and close the file
+* Input          : - writer: writer
+* Output         : None
+* Return         : 1 success, 0 write error
+* Attention      : None
+*******************************************************************************/
+int LCD_VideoFinish(VideoWriter *writer)
+{
+    int ok;
+
+    ok = fseek(writer->f, 0, SEEK_SET) == 0
+         && Video_WriteHeader(writer);
+    ok = !fclose(writer->f) && ok;
+    free(writer->prev);
+    free(writer->rect);
+    memset(writer, 0, sizeof(*writer));
+    return ok;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
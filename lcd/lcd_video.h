@@ -0,0 +1,97 @@
+/*******************************************************************************
+* File Name      : lcd_video.h
+* Description    : Playback of RGB565 animations from a file, and the writer
+*                  of the file
+*                  File: a VideoHeader then, per frame, a VideoFrame and the
+*                  w * h pixels of the rectangle that changed since the
+*                  frame before, line by line, high byte first so they go
+*                  to the bus as read. The first frame is a full one
+*                  A prefetch thread reads VIDEO_SLOTS frames ahead and asks
+*                  the kernel for the next VIDEO_READAHEAD bytes; the player
+*                  paces the frames and drops the late ones, each frame sent
+*                  is one window and one burst
+*                  VideoHeader and VideoFrame fields are little endian in the
+*                  file, whatever the host
+*******************************************************************************/
+#ifndef __LCD_VIDEO_H
+#define __LCD_VIDEO_H
+
+/* Includes */
+#include <stdio.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+
+/* Defines */
+#define VIDEO_MAGIC "LVID"
+#define VIDEO_VERSION 1
+#define VIDEO_SLOTS 4                   /* frames read ahead */
+#define VIDEO_READAHEAD (1024 * 1024)   /* bytes asked ahead to the kernel */
+
+#define VIDEO_KEY 1                     /* VideoFrame flags: full frame */
+#define VIDEO_FILE_FPS 0xFFFF           /* LCD_VideoPlay: fps of the file */
+
+
+/* Types */
+typedef struct
+{
+    char magic[4];              /* VIDEO_MAGIC */
+    unsigned short version;     /* VIDEO_VERSION */
+    unsigned short w, h;        /* size of the frames */
+    unsigned short fps;         /* frames per second it was made for */
+    unsigned int frames;
+} VideoHeader;
+
+typedef struct
+{
+    unsigned short x, y, w, h;  /* rectangle that changed, 0 * 0 none */
+    unsigned int flags;         /* VIDEO_x */
+} VideoFrame;
+
+typedef struct
+{
+    unsigned int shown;         /* frames sent to the panel */
+    unsigned int dropped;       /* frames late by a period, merged in the next */
+    unsigned int stalls;        /* frames not read yet when they were due */
+    unsigned long long bytes;   /* pixel bytes sent */
+    double seconds;             /* play time */
+} VideoStats;
+
+typedef struct
+{
+    int fd;
+    VideoHeader head;
+    pthread_t thread;           /* prefetch */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned char *slots[VIDEO_SLOTS];  /* VideoFrame and pixels */
+    unsigned int read, played;  /* frames in the slots: read - played */
+    unsigned char eof, stop;
+    off_t advised;              /* file read ahead up to there */
+    unsigned short *frame;      /* w * h, the whole last frame, bus order */
+    unsigned short *gather;     /* rectangle of frame sent after drops */
+} VideoPlayer;
+
+typedef struct
+{
+    FILE *f;
+    VideoHeader head;
+    unsigned short *prev;       /* w * h, last frame written */
+    unsigned short *rect;       /* changed rectangle, bus order */
+} VideoWriter;
+
+
+/* Function declarations */
+int LCD_VideoOpen(VideoPlayer *player, const char *path);
+int LCD_VideoPlay(VideoPlayer *player, short Xpos, short Ypos, unsigned short fps, VideoStats *stats);
+void LCD_VideoClose(VideoPlayer *player);
+int LCD_VideoCreate(VideoWriter *writer, const char *path, unsigned short w, unsigned short h, unsigned short fps);
+int LCD_VideoAddFrame(VideoWriter *writer, const unsigned short *pixels);
+int LCD_VideoFinish(VideoWriter *writer);
+
+#endif
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
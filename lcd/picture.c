@@ -0,0 +1,79 @@
+/*******************************************************************************
+* Function Name  : main
+* Description    : Show a JPEG, PNG or BMP picture decoded straight to the
+*                  screen with lcd_image.c, and the time it took
+* Input          : -H real panel, default is the emulated one
+*                  -s scale 1, 2, 4 or 8 for 1/scale of the size, default
+*                     the largest that fits the screen
+*                  -x, -y upper left corner, default 0 0
+*                  -o orientation for LCD_Init, default PORTRAIT
+* Output         : None
+* Return         : 0 success, 1 fail
+* Compile/link   : gcc -o picture -lrt picture.c lcd.c lcd_image.c lcd_trace.c lcd_emu.c lcd_spi0.c lcd_bcm2835.c -lbcm2835 -ljpeg -lpng -lm -lpthread
+*                  gcc -DLCD_NO_BCM2835 -o picture -lrt picture.c lcd.c lcd_image.c lcd_trace.c lcd_emu.c lcd_spi0.c -ljpeg -lpng -lm -lpthread
+* Execute        : sudo ./picture -H photo.jpg      sudo ./picture -H -s 8 photo.jpg
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "lcd.h"
+#include "lcd_emu.h"
+#include "lcd_image.h"
+
+
+int main(int argc, char *argv[])
+{
+    const LCD_Transport *transport = &LCD_EmuTransport;
+    int x = 0, y = 0, scale = IMAGE_FIT, orientation = PORTRAIT, opt, ret;
+    unsigned long long bus;
+    struct timespec t0, t1;
+
+    while ((opt = getopt(argc, argv, "Hs:x:y:o:")) != -1)
+    {
+        switch (opt)
+        {
+#ifndef LCD_NO_BCM2835
+        case 'H': transport = &LCD_Bcm2835Transport; break;
+#endif
+        case 's': scale = atoi(optarg); break;
+        case 'x': x = atoi(optarg); break;
+        case 'y': y = atoi(optarg); break;
+        case 'o': orientation = atoi(optarg) & 7; break;
+        default:
+            fprintf(stderr, "usage: %s [-H] [-s scale] [-x X] [-y Y] [-o orientation] file\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc)
+    {
+        fprintf(stderr, "no file to show\n");
+        return 1;
+    }
+
+    if (!LCD_Open(transport)) return 1;
+    LCD_Reset();
+    TP_Init();
+    LCD_Init(orientation);
+    LCD_Clear(Black);
+
+    bus = LCD_EmuBusNs();
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    ret = LCD_PutPicture(x, y, argv[optind], scale);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (ret < 0)
+        fprintf(stderr, "can't show %s\n", argv[optind]);
+    else
+        printf("%s shown in %.1f ms\n", argv[optind],
+               (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+    if (transport == &LCD_EmuTransport && LCD_EmuBusNs() > bus)
+        printf("modeled bus: %.1f ms\n", (LCD_EmuBusNs() - bus) / 1e6);
+    LCD_Close();
+    return ret < 0;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
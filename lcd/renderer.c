@@ -0,0 +1,135 @@
+/*******************************************************************************
+* Function Name  : main
+* Description    : Example renderer for the frame ingest daemon ingestd: a
+*                  ball bouncing over bands of color, drawn in a frame of
+*                  its own; each frame sends the rectangle of the old and
+*                  new ball only, and waits for it to be on the panel
+* Input          : -s socket path, default INGEST_SOCKET
+*                  -n frames, default 300
+*                  -e encoding raw, rle, xor or auto, default auto
+* Output         : None
+* Return         : 0 success, 1 fail
+* Compile/link   : gcc -o renderer renderer.c lcd_ingest.c
+* Execute        : sudo ./ingestd -H &      ./renderer      ./renderer -e raw
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "lcd_ingest.h"
+
+
+/* Defines */
+#define BALL 24                     /* ball diameter */
+#define BALL_COLOR 0xFFFF           /* RGB565 white */
+
+
+/*******************************************************************************
+* Function Name  : Renderer_Draw
+* Description    : Draw the rectangle of a frame: bands, and the ball over
+* Input          : - frame: width pixels per line
+*                  - width: frame width
+*                  - x0, y0, x1, y1: rectangle, x1 y1 excluded
+*                  - bx, by: upper left corner of the ball
+* Output         : - frame: pixels of the rectangle
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Renderer_Draw(unsigned short *frame, int width, int x0, int y0, int x1, int y1, int bx, int by)
+{
+    int x, y, dx, dy, r = BALL / 2;
+
+    for (y = y0; y < y1; y++)
+    {
+        for (x = x0; x < x1; x++)
+        {
+            dx = 2 * (x - bx - r) + 1;
+            dy = 2 * (y - by - r) + 1;
+            if (dx * dx + dy * dy <= BALL * BALL)
+                frame[y * width + x] = BALL_COLOR;
+            else
+                frame[y * width + x] = (unsigned short)((y / 40 & 1 ? 0x0010 : 0x8000) | (y / 40 << 6));
+        }
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char *path = INGEST_SOCKET;
+    unsigned short encoding = INGEST_AUTO, *frame;
+    int frames = 300, opt, i, ok, bx = 0, by = 0, vx = 3, vy = 2, px, py, x0, y0, x1, y1;
+    struct timespec t0, t1;
+    double s;
+    IngestSender sender;
+
+    while ((opt = getopt(argc, argv, "s:n:e:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's': path = optarg; break;
+        case 'n': frames = atoi(optarg); break;
+        case 'e':
+            if (!strcmp(optarg, "raw")) encoding = INGEST_RAW;
+            else if (!strcmp(optarg, "rle")) encoding = INGEST_RLE;
+            else if (!strcmp(optarg, "xor")) encoding = INGEST_XOR;
+            else encoding = INGEST_AUTO;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s socket] [-n frames] [-e raw|rle|xor|auto]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (!LCD_IngestConnect(&sender, path))
+    {
+        fprintf(stderr, "can't connect to ingestd on %s\n", path);
+        return 1;
+    }
+    frame = malloc(sender.width * sender.height * sizeof(unsigned short));
+    if (!frame || sender.width < BALL || sender.height < BALL)
+    {
+        LCD_IngestClose(&sender);
+        free(frame);
+        return 1;
+    }
+
+    /* whole frame once, then the rectangle of the ball's old and new place */
+    Renderer_Draw(frame, sender.width, 0, 0, sender.width, sender.height, bx, by);
+    ok = LCD_IngestSend(&sender, encoding, 0, 0, sender.width, sender.height, frame, sender.width);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < frames && ok; i++)
+    {
+        px = bx;
+        py = by;
+        if (bx + vx < 0 || bx + vx > sender.width - BALL) vx = -vx;
+        if (by + vy < 0 || by + vy > sender.height - BALL) vy = -vy;
+        bx += vx;
+        by += vy;
+        x0 = px < bx ? px : bx;
+        y0 = py < by ? py : by;
+        x1 = (px > bx ? px : bx) + BALL;
+        y1 = (py > by ? py : by) + BALL;
+        Renderer_Draw(frame, sender.width, x0, y0, x1, y1, bx, by);
+        ok = LCD_IngestSend(&sender, encoding, x0, y0, x1 - x0, y1 - y0,
+                            frame + y0 * sender.width + x0, sender.width)
+             && LCD_IngestSync(&sender);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    if (!ok)
+        fprintf(stderr, "connection to ingestd lost\n");
+    else
+        printf("%d frames in %.2f s, %.1f frames/s, %lu pixel bytes sent as %lu\n",
+               frames, s, s > 0 ? frames / s : 0, sender.bytesIn, sender.bytesOut);
+    LCD_IngestClose(&sender);
+    free(frame);
+    return !ok;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
@@ -0,0 +1,303 @@
+/*******************************************************************************
+* Function Name  : main
+* Description    : Replay or analyze a trace recorded with LCD_TraceStart
+* Input          : -H replay on the real panel, default is the emulated one
+*                  -t keep the original timing, default is full speed
+*                  -n replay the trace n times
+*                  -a analyze instead of replaying: count the index, cursor
+*                     and register writes that did not change anything
+* Output         : None
+* Return         : 0 success, 1 fail
+* Compile/link   : gcc -o replay -lrt replay.c lcd_trace.c lcd_emu.c lcd_spi0.c lcd_bcm2835.c -lbcm2835
+*                  gcc -DLCD_NO_BCM2835 -o replay -lrt replay.c lcd_trace.c lcd_emu.c lcd_spi0.c
+* Execute        : ./replay trace.bin      sudo ./replay -H trace.bin
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "lcd_transport.h"
+#include "lcd_emu.h"
+#include "lcd_trace.h"
+
+
+/* Defines */
+#define SPI_START (0x70)   /* Start byte for SPI transfer */
+#define SPI_RD (0x01)      /* WR bit 1 within start */
+#define SPI_DATA (0x02)    /* RS bit 1 within start byte */
+
+
+/* Types */
+typedef struct
+{
+    unsigned long records, transfers, reads, gpios, selects;
+    unsigned long long bytes;
+    unsigned long indexWrites, redundantIndex;
+    unsigned long dataWrites, gramWrites;
+    unsigned long cursorWrites, redundantCursor;
+    unsigned long regWrites, redundantReg;
+    unsigned long redundantPerReg[256];
+} TraceAnalysis;
+
+
+/*******************************************************************************
+* Function Name  : Replay_Now
+* Description    : Monotonic time
+* Input          : None
+* Output         : None
+* Return         : seconds
+* Attention      : None
+*******************************************************************************/
+static double Replay_Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/*******************************************************************************
+* Function Name  : Replay_Sleep
+* Description    : Wait until a time after the start of the replay
+* Input          : - start: replay start, CLOCK_MONOTONIC
+*                  - us: microseconds after start
+* Output         : None
+* Return         : None
+* Attention      : None
+*******************************************************************************/
+static void Replay_Sleep(const struct timespec *start, unsigned long long us)
+{
+    struct timespec at;
+
+    at.tv_sec = start->tv_sec + us / 1000000;
+    at.tv_nsec = start->tv_nsec + (us % 1000000) * 1000;
+    if (at.tv_nsec >= 1000000000)
+    {
+        at.tv_sec++;
+        at.tv_nsec -= 1000000000;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &at, 0))
+        ;
+}
+
+
+/*******************************************************************************
+* Function Name  : Replay_Run
+* Description    : Issue every record of a trace on a transport
+* Input          : - path: trace file
+*                  - bus: transport, already opened
+*                  - timed: 1 to keep the original timing
+* Output         : - duration: recorded duration of the trace in us
+* Return         : number of records, -1 on a corrupt trace
+* Attention      : None
+*******************************************************************************/
+static long Replay_Run(const char *path, const LCD_Transport *bus, int timed,
+                       unsigned long long *duration)
+{
+    TraceReader reader;
+    struct timespec start;
+    long records = 0;
+    int ret;
+
+    if (!LCD_TraceOpen(&reader, path))
+        return -1;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while ((ret = LCD_TraceNext(&reader)) > 0)
+    {
+        if (timed)
+            Replay_Sleep(&start, reader.tUs);
+        switch (reader.type)
+        {
+        case TRACE_SELECT:
+            bus->spiSelect(0, reader.cs, reader.divider);
+            break;
+        case TRACE_GPIO:
+            bus->gpioWrite(0, reader.pin, reader.level);
+            break;
+        default:
+            bus->spiTransfer(0, reader.data, reader.len);
+            break;
+        }
+        records++;
+    }
+    *duration = reader.tUs;
+    LCD_TraceClose(&reader);
+    return ret < 0 ? -1 : records;
+}
+
+
+/*******************************************************************************
+* Function Name  : Replay_Analyze
+* Description    : Find the writes of a trace that had no effect
+* Input          : - path: trace file
+* Output         : - an: counters
+* Return         : 1 success, 0 corrupt trace
+* Attention      : The emulated panel is the reference: each word is applied
+*                  to it on its own and compared with its state before
+*******************************************************************************/
+static int Replay_Analyze(const char *path, TraceAnalysis *an)
+{
+    TraceReader reader;
+    unsigned char written[256];
+    unsigned char start, index = 0;
+    unsigned short value;
+    char word[3];
+    unsigned int i;
+    int ret;
+
+    memset(an, 0, sizeof(*an));
+    memset(written, 0, sizeof(written));
+    if (!LCD_TraceOpen(&reader, path))
+        return 0;
+    LCD_EmuTransport.open(0);
+    while ((ret = LCD_TraceNext(&reader)) > 0)
+    {
+        an->records++;
+        if (reader.type == TRACE_SELECT)
+        {
+            an->selects++;
+            LCD_EmuTransport.spiSelect(0, reader.cs, reader.divider);
+            continue;
+        }
+        if (reader.type == TRACE_GPIO)
+        {
+            an->gpios++;
+            LCD_EmuTransport.gpioWrite(0, reader.pin, reader.level);
+            continue;
+        }
+        an->transfers++;
+        an->bytes += reader.len;
+        start = reader.data[0];
+        if (reader.cs != LCD_CS_LCD || (start & SPI_RD) || (start & 0xFC) != SPI_START)
+        {
+            if (start & SPI_RD)
+                an->reads++;
+            LCD_EmuTransport.spiTransfer(0, reader.data, reader.len);
+            if (reader.cs == LCD_CS_LCD && (start & SPI_RD))
+                index = 0xFF;       /* a GRAM read moves the address counter */
+            continue;
+        }
+        for (i = 1; i + 1 < reader.len; i += 2)
+        {
+            value = ((unsigned char)reader.data[i] << 8) | (unsigned char)reader.data[i + 1];
+            if (!(start & SPI_DATA))
+            {
+                an->indexWrites++;
+                if ((value & 0xFF) == index)
+                    an->redundantIndex++;
+                index = value & 0xFF;
+            }
+            else if (index == 0x22)
+            {
+                an->gramWrites++;
+            }
+            else if (index == 0x20 || index == 0x21)
+            {
+                an->cursorWrites++;
+                if (LCD_EmuReg(index) == value)
+                    an->redundantCursor++;
+            }
+            else
+            {
+                an->regWrites++;
+                if (written[index] && LCD_EmuReg(index) == value)
+                {
+                    an->redundantReg++;
+                    an->redundantPerReg[index]++;
+                }
+                written[index] = 1;
+            }
+            an->dataWrites += (start & SPI_DATA) ? 1 : 0;
+            word[0] = start;
+            word[1] = reader.data[i];
+            word[2] = reader.data[i + 1];
+            LCD_EmuTransport.spiTransfer(0, word, 3);
+        }
+    }
+    LCD_TraceClose(&reader);
+    return ret == 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+    const LCD_Transport *bus = &LCD_EmuTransport;
+    unsigned long long duration = 0;
+    TraceAnalysis an;
+    double t0, seconds;
+    long records = 0;
+    int opt, timed = 0, analyze = 0, repeat = 1, i;
+
+    while ((opt = getopt(argc, argv, "Htn:a")) != -1)
+    {
+        switch (opt)
+        {
+#ifndef LCD_NO_BCM2835
+        case 'H': bus = &LCD_Bcm2835Transport; break;
+#endif
+        case 't': timed = 1; break;
+        case 'n': repeat = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+        case 'a': analyze = 1; break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-H] [-t] [-n times] [-a] trace.bin\n", argv[0]);
+        return 1;
+    }
+
+    if (analyze)
+    {
+        if (!Replay_Analyze(argv[optind], &an))
+        {
+            fprintf(stderr, "can't read %s\n", argv[optind]);
+            return 1;
+        }
+        printf("records %lu, transfers %lu, bytes %llu, reads %lu, selects %lu, gpio %lu\n",
+               an.records, an.transfers, an.bytes, an.reads, an.selects, an.gpios);
+        printf("index writes    %10lu  redundant %10lu\n", an.indexWrites, an.redundantIndex);
+        printf("cursor writes   %10lu  redundant %10lu\n", an.cursorWrites, an.redundantCursor);
+        printf("register writes %10lu  redundant %10lu\n", an.regWrites, an.redundantReg);
+        printf("GRAM writes     %10lu\n", an.gramWrites);
+        for (i = 0; i < 256; i++)
+        {
+            if (an.redundantPerReg[i])
+                printf("  reg 0x%02X rewritten with the same value %lu times\n", i, an.redundantPerReg[i]);
+        }
+        return 0;
+    }
+
+    if (!bus->open(0))
+        return 1;
+    bus->spiBegin(0);
+    t0 = Replay_Now();
+    for (i = 0; i < repeat; i++)
+    {
+        records = Replay_Run(argv[optind], bus, timed, &duration);
+        if (records < 0)
+        {
+            fprintf(stderr, "can't read %s\n", argv[optind]);
+            bus->close(0);
+            return 1;
+        }
+    }
+    seconds = Replay_Now() - t0;
+    printf("%s: %ld records x %d in %.3f s, recorded %.3f s",
+           bus->name, records, repeat, seconds, duration / 1e6);
+    if (bus == &LCD_EmuTransport)
+        printf(", modeled bus %.3f s", LCD_EmuBusNs() / 1e9);
+    printf("\n");
+    bus->close(0);
+    return 0;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/
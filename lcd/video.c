@@ -0,0 +1,129 @@
+/*******************************************************************************
+* Function Name  : main
+* Description    : Play an animation written with lcd_video.c, or write a
+*                  test one: a box bouncing over a gradient
+* Input          : -H real panel, default is the emulated one
+*                  -f frames per second, 0 as fast as the bus goes, default
+*                     the one of the file
+*                  -x, -y upper left corner on the screen, default 0 0
+*                  -g write the test animation to the file instead
+*                  -n frames of the test animation, default 120
+* Output         : None
+* Return         : 0 success, 1 fail
+* Compile/link   : gcc -o video -lrt video.c lcd.c lcd_video.c lcd_trace.c lcd_emu.c lcd_spi0.c lcd_bcm2835.c -lbcm2835 -lm -lpthread
+*                  gcc -DLCD_NO_BCM2835 -o video -lrt video.c lcd.c lcd_video.c lcd_trace.c lcd_emu.c lcd_spi0.c -lm -lpthread
+* Execute        : ./video -g boot.lvid      sudo ./video -H boot.lvid
+*******************************************************************************/
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "lcd.h"
+#include "lcd_emu.h"
+#include "lcd_video.h"
+
+
+/* Defines */
+#define BOX 48                  /* side of the bouncing box */
+
+
+/*******************************************************************************
+* Function Name  : Video_Generate
+* Description    : Write the test animation
+* Input          : - path: file
+*                  - frames: number of frames
+* Output         : None
+* Return         : 1 success, 0 fail
+* Attention      : Full screen in PORTRAIT, 30 frames per second
+*******************************************************************************/
+static int Video_Generate(const char *path, unsigned int frames)
+{
+    static unsigned short pixels[MAX_X * MAX_Y];
+    VideoWriter writer;
+    unsigned int i, x, y;
+    int bx = 10, by = 20, dx = 5, dy = 7;
+
+    if (!LCD_VideoCreate(&writer, path, MAX_X, MAX_Y, 30))
+        return 0;
+    for (i = 0; i < frames; i++)
+    {
+        for (y = 0; y < MAX_Y; y++)
+            for (x = 0; x < MAX_X; x++)
+                pixels[y * MAX_X + x] = RGB565CONVERT(x, y * 255 / MAX_Y, 128);
+        for (y = by; y < (unsigned int)by + BOX; y++)
+            for (x = bx; x < (unsigned int)bx + BOX; x++)
+                pixels[y * MAX_X + x] = ((x - bx) / 8 + (y - by) / 8) & 1 ? Yellow : Red;
+        if (!LCD_VideoAddFrame(&writer, pixels))
+            return 0;
+        if (bx + dx < 0 || bx + dx + BOX > MAX_X) dx = -dx;
+        if (by + dy < 0 || by + dy + BOX > MAX_Y) dy = -dy;
+        bx += dx;
+        by += dy;
+    }
+    return LCD_VideoFinish(&writer);
+}
+
+
+int main(int argc, char *argv[])
+{
+    const LCD_Transport *transport = &LCD_EmuTransport;
+    const char *generate = 0;
+    unsigned int frames = 120, fps = VIDEO_FILE_FPS;
+    int x = 0, y = 0, opt;
+    VideoPlayer player;
+    VideoStats stats;
+
+    while ((opt = getopt(argc, argv, "Hf:x:y:g:n:")) != -1)
+    {
+        switch (opt)
+        {
+#ifndef LCD_NO_BCM2835
+        case 'H': transport = &LCD_Bcm2835Transport; break;
+#endif
+        case 'f': fps = atoi(optarg); break;
+        case 'x': x = atoi(optarg); break;
+        case 'y': y = atoi(optarg); break;
+        case 'g': generate = optarg; break;
+        case 'n': frames = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-H] [-f fps] [-x X] [-y Y] file.lvid | -g file.lvid [-n frames]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (generate)
+        return Video_Generate(generate, frames) ? 0 : 1;
+    if (optind >= argc)
+    {
+        fprintf(stderr, "no file to play\n");
+        return 1;
+    }
+
+    if (!LCD_VideoOpen(&player, argv[optind]))
+    {
+        fprintf(stderr, "can't open %s\n", argv[optind]);
+        return 1;
+    }
+    if (!LCD_Open(transport)) return 1;
+    LCD_Reset();
+    TP_Init();
+    LCD_Init(PORTRAIT);
+    memset(&stats, 0, sizeof(stats));
+    if (!LCD_VideoPlay(&player, x, y, fps, &stats))
+        fprintf(stderr, "playback stopped: file truncated or not on the screen\n");
+    if (stats.seconds > 0)
+        printf("%u frames shown, %u dropped, %u stalls on the file, %.1f fps, %.1f MB/s\n",
+               stats.shown, stats.dropped, stats.stalls, stats.shown / stats.seconds,
+               stats.bytes / stats.seconds / 1e6);
+    if (transport == &LCD_EmuTransport && LCD_EmuBusNs())
+        printf("modeled bus: %.1f ms, %.1f fps at most\n",
+               LCD_EmuBusNs() / 1e6, stats.shown / (LCD_EmuBusNs() / 1e9));
+    LCD_VideoClose(&player);
+    LCD_Close();
+    return 0;
+}
+
+
+/*******************************************************************************************
+      END FILE
+********************************************************************************************/